@@ -0,0 +1,532 @@
+#include "benchmark/driverBenchmarks.h"
+
+#include "common/utils/trace.h"
+
+#include "driver/bgiBase/blitCmds.h"
+#include "driver/bgiBase/blitCmdsOps.h"
+#include "driver/bgiBase/computeCmds.h"
+#include "driver/bgiBase/graphicsCmds.h"
+#include "driver/bgiBase/shaderFunction.h"
+#include "driver/bgiVulkan/bgi.h"
+#include "driver/bgiVulkan/device.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace benchmark {
+
+using namespace driver;
+
+// The draws cover a few pixels of a small target, the compute shader
+// writes one value per invocation.
+static const int _targetSize = 64;
+static const int _computeLocalSize = 64;
+
+static const char* _vertexShader =
+    "void main(void) {\n"
+    "    vec2 corner = vec2(float(vertexIndex & 1), float(vertexIndex >> 1));\n"
+    "    gl_Position = vec4(corner * 0.02 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* _fragmentShader =
+    "void main(void) {\n"
+    "    colorOut = vec4(1.0);\n"
+    "}\n";
+
+static const char* _computeShader =
+    "void main(void) {\n"
+    "    values[globalId.x] = float(globalId.x);\n"
+    "}\n";
+
+static BgiShaderFunctionHandle
+_CreateShaderFunction(Bgi* bgi, BgiShaderFunctionDesc const& desc)
+{
+    BgiShaderFunctionHandle function = bgi->CreateShaderFunction(desc);
+    if (function && !function->IsValid()) {
+        std::cerr << "Failed to compile " << desc.debugName << ":\n"
+                  << function->GetCompileErrors() << "\n";
+    }
+    return function;
+}
+
+DriverBenchmarks::DriverBenchmarks(
+    BgiVulkan* bgi,
+    DriverBenchmarkOptions const& options)
+    : _bgi(bgi)
+    , _options(options)
+{
+    _CreateResources();
+}
+
+DriverBenchmarks::~DriverBenchmarks()
+{
+    _DestroyResources();
+}
+
+bool
+DriverBenchmarks::IsValid() const
+{
+    return _graphicsProgram && _graphicsProgram->IsValid() &&
+        _graphicsPipeline && _computeProgram &&
+        _computeProgram->IsValid() && _computePipeline;
+}
+
+void
+DriverBenchmarks::Run(BenchmarkReport* report)
+{
+    _RunDraws(report);
+    _RunDispatches(report);
+    _RunResourceChurn(report);
+    _RunUploads(report);
+    _RunPipelineCreation(report);
+    _RunRecordingScaling(report);
+}
+
+void
+DriverBenchmarks::_CreateResources()
+{
+    //
+    // Graphics
+    //
+
+    BgiTextureDesc targetDesc;
+    targetDesc.debugName = "Benchmark Color Target";
+    targetDesc.usage = BgiTextureUsageBitsColorTarget;
+    targetDesc.format = BgiFormatUNorm8Vec4;
+    targetDesc.type = BgiTextureType2D;
+    targetDesc.dimensions = math::Vector3i(_targetSize, _targetSize, 1);
+    _colorTarget = _bgi->CreateTexture(targetDesc);
+
+    BgiAttachmentDesc attachmentDesc;
+    attachmentDesc.format = targetDesc.format;
+    attachmentDesc.usage = targetDesc.usage;
+    attachmentDesc.loadOp = BgiAttachmentLoadOpDontCare;
+    attachmentDesc.storeOp = BgiAttachmentStoreOpStore;
+
+    _graphicsCmdsDesc.colorAttachmentDescs.push_back(attachmentDesc);
+    _graphicsCmdsDesc.colorTextures.push_back(_colorTarget);
+
+    _graphicsProgram = _CreateGraphicsProgram();
+
+    _graphicsPipelineDesc.debugName = "Benchmark Graphics Pipeline";
+    _graphicsPipelineDesc.shaderProgram = _graphicsProgram;
+    _graphicsPipelineDesc.primitiveType = BgiPrimitiveTypeTriangleList;
+    _graphicsPipelineDesc.depthState.depthTestEnabled = false;
+    _graphicsPipelineDesc.depthState.depthWriteEnabled = false;
+    _graphicsPipelineDesc.rasterizationState.cullMode = BgiCullModeNone;
+    _graphicsPipelineDesc.colorAttachmentDescs.push_back(attachmentDesc);
+
+    if (_graphicsProgram && _graphicsProgram->IsValid()) {
+        _graphicsPipeline =
+            _bgi->CreateGraphicsPipeline(_graphicsPipelineDesc);
+    }
+
+    //
+    // Compute
+    //
+
+    BgiBufferDesc bufferDesc;
+    bufferDesc.debugName = "Benchmark Compute Values";
+    bufferDesc.usage = BgiBufferUsageStorage;
+    bufferDesc.byteSize = _computeLocalSize * sizeof(float);
+    _computeBuffer = _bgi->CreateBuffer(bufferDesc);
+
+    BgiBufferBindingDesc bindingDesc;
+    bindingDesc.buffers.push_back(_computeBuffer);
+    bindingDesc.offsets.push_back(0);
+    bindingDesc.resourceType = BgiBindResourceTypeStorageBuffer;
+    bindingDesc.bindingIndex = 0;
+    bindingDesc.stageUsage = BgiShaderStageCompute;
+    bindingDesc.writable = true;
+
+    BgiResourceBindingsDesc bindingsDesc;
+    bindingsDesc.debugName = "Benchmark Compute Bindings";
+    bindingsDesc.buffers.push_back(bindingDesc);
+    _computeBindings = _bgi->CreateResourceBindings(bindingsDesc);
+
+    _computeProgram = _CreateComputeProgram();
+
+    _computePipelineDesc.debugName = "Benchmark Compute Pipeline";
+    _computePipelineDesc.shaderProgram = _computeProgram;
+
+    if (_computeProgram && _computeProgram->IsValid()) {
+        _computePipeline = _bgi->CreateComputePipeline(_computePipelineDesc);
+    }
+}
+
+void
+DriverBenchmarks::_DestroyResources()
+{
+    if (_computePipeline) {
+        _bgi->DestroyComputePipeline(&_computePipeline);
+    }
+    _DestroyProgram(&_computeProgram);
+    if (_computeBindings) {
+        _bgi->DestroyResourceBindings(&_computeBindings);
+    }
+    if (_computeBuffer) {
+        _bgi->DestroyBuffer(&_computeBuffer);
+    }
+
+    if (_graphicsPipeline) {
+        _bgi->DestroyGraphicsPipeline(&_graphicsPipeline);
+    }
+    _DestroyProgram(&_graphicsProgram);
+    if (_colorTarget) {
+        _bgi->DestroyTexture(&_colorTarget);
+    }
+}
+
+BgiShaderProgramHandle
+DriverBenchmarks::_CreateGraphicsProgram()
+{
+    BgiShaderFunctionDesc vsDesc;
+    vsDesc.debugName = "Benchmark Vertex Shader";
+    vsDesc.shaderStage = BgiShaderStageVertex;
+    vsDesc.shaderCode = _vertexShader;
+    BgiShaderFunctionAddStageInput(
+        &vsDesc, "vertexIndex", "int", tokens::SHADER_KEYWORD::VertexID);
+    BgiShaderFunctionAddStageOutput(
+        &vsDesc, "gl_Position", "vec4", tokens::SHADER_KEYWORD::Position);
+
+    BgiShaderFunctionDesc fsDesc;
+    fsDesc.debugName = "Benchmark Fragment Shader";
+    fsDesc.shaderStage = BgiShaderStageFragment;
+    fsDesc.shaderCode = _fragmentShader;
+    BgiShaderFunctionAddStageOutput(&fsDesc, "colorOut", "vec4", 0u);
+
+    BgiShaderProgramDesc programDesc;
+    programDesc.debugName = "Benchmark Graphics Program";
+    programDesc.shaderFunctions.push_back(_CreateShaderFunction(_bgi, vsDesc));
+    programDesc.shaderFunctions.push_back(_CreateShaderFunction(_bgi, fsDesc));
+    return _bgi->CreateShaderProgram(programDesc);
+}
+
+BgiShaderProgramHandle
+DriverBenchmarks::_CreateComputeProgram()
+{
+    BgiShaderFunctionDesc csDesc;
+    csDesc.debugName = "Benchmark Compute Shader";
+    csDesc.shaderStage = BgiShaderStageCompute;
+    csDesc.shaderCode = _computeShader;
+    csDesc.computeDescriptor.localSize =
+        math::Vector3i(_computeLocalSize, 1, 1);
+    BgiShaderFunctionAddWritableBuffer(&csDesc, "values", "float", 0);
+    BgiShaderFunctionAddStageInput(
+        &csDesc, "globalId", "uvec3",
+        tokens::SHADER_KEYWORD::GlobalInvocationID);
+
+    BgiShaderProgramDesc programDesc;
+    programDesc.debugName = "Benchmark Compute Program";
+    programDesc.shaderFunctions.push_back(_CreateShaderFunction(_bgi, csDesc));
+    return _bgi->CreateShaderProgram(programDesc);
+}
+
+void
+DriverBenchmarks::_DestroyProgram(BgiShaderProgramHandle* program)
+{
+    if (!*program) {
+        return;
+    }
+
+    // Destroying a program does not destroy its functions.
+    BgiShaderFunctionHandleVector functions =
+        (*program)->GetShaderFunctions();
+    _bgi->DestroyShaderProgram(program);
+    for (BgiShaderFunctionHandle& function : functions) {
+        if (function) {
+            _bgi->DestroyShaderFunction(&function);
+        }
+    }
+}
+
+void
+DriverBenchmarks::_RecordDraws(BgiGraphicsCmds* cmds, uint32_t count)
+{
+    UTILS_TRACE_FUNCTION();
+
+    cmds->BindPipeline(_graphicsPipeline);
+    cmds->SetViewport(math::Vector4i(0, 0, _targetSize, _targetSize));
+    for (uint32_t i = 0; i < count; i++) {
+        cmds->Draw(3, 0, 1, 0);
+    }
+}
+
+void
+DriverBenchmarks::_WaitForGpu()
+{
+    // Ending the frame resets the consumed command buffers and destroys the
+    // trashed objects.
+    _bgi->GetPrimaryDevice()->WaitForIdle();
+    _bgi->EndFrame();
+}
+
+void
+DriverBenchmarks::_RunDraws(BenchmarkReport* report)
+{
+    UTILS_TRACE_FUNCTION();
+
+    uint32_t const count = _options.drawsPerRun;
+    double const seconds = BenchmarkMedianSeconds(_options.repetitions,
+        [&]() {
+            _bgi->StartFrame();
+            double const s = BenchmarkSeconds([&]() {
+                BgiGraphicsCmdsUniquePtr cmds =
+                    _bgi->CreateGraphicsCmds(_graphicsCmdsDesc);
+                _RecordDraws(cmds.get(), count);
+                _bgi->SubmitCmds(cmds.get());
+            });
+            _WaitForGpu();
+            return s;
+        });
+
+    report->AddMetric(
+        "graphics.drawsPerSecond", count / seconds, "draws/s", true);
+}
+
+void
+DriverBenchmarks::_RunDispatches(BenchmarkReport* report)
+{
+    UTILS_TRACE_FUNCTION();
+
+    uint32_t const count = _options.dispatchesPerRun;
+    double const seconds = BenchmarkMedianSeconds(_options.repetitions,
+        [&]() {
+            _bgi->StartFrame();
+            double const s = BenchmarkSeconds([&]() {
+                BgiComputeCmdsUniquePtr cmds =
+                    _bgi->CreateComputeCmds(BgiComputeCmdsDesc());
+                cmds->BindPipeline(_computePipeline);
+                cmds->BindResources(_computeBindings);
+                for (uint32_t i = 0; i < count; i++) {
+                    cmds->Dispatch(1, 1, 1);
+                }
+                _bgi->SubmitCmds(cmds.get());
+            });
+            _WaitForGpu();
+            return s;
+        });
+
+    report->AddMetric(
+        "compute.dispatchesPerSecond", count / seconds, "dispatches/s", true);
+}
+
+void
+DriverBenchmarks::_RunResourceChurn(BenchmarkReport* report)
+{
+    UTILS_TRACE_FUNCTION();
+
+    uint32_t const count = _options.resourcesPerRun;
+
+    // Destroyed objects are only deleted by the garbage collection at the
+    // end of the frame, which is part of the measured time.
+    BgiBufferDesc bufferDesc;
+    bufferDesc.usage = BgiBufferUsageStorage;
+    bufferDesc.byteSize = 64 * 1024;
+
+    std::vector<BgiBufferHandle> buffers(count);
+    double const bufferSeconds = BenchmarkMedianSeconds(_options.repetitions,
+        [&]() {
+            return BenchmarkSeconds([&]() {
+                _bgi->StartFrame();
+                for (BgiBufferHandle& buffer : buffers) {
+                    buffer = _bgi->CreateBuffer(bufferDesc);
+                }
+                for (BgiBufferHandle& buffer : buffers) {
+                    _bgi->DestroyBuffer(&buffer);
+                }
+                _bgi->EndFrame();
+            });
+        });
+
+    BgiTextureDesc textureDesc;
+    textureDesc.usage = BgiTextureUsageBitsShaderRead;
+    textureDesc.format = BgiFormatUNorm8Vec4;
+    textureDesc.type = BgiTextureType2D;
+    textureDesc.dimensions = math::Vector3i(128, 128, 1);
+
+    std::vector<BgiTextureHandle> textures(count);
+    double const textureSeconds = BenchmarkMedianSeconds(_options.repetitions,
+        [&]() {
+            return BenchmarkSeconds([&]() {
+                _bgi->StartFrame();
+                for (BgiTextureHandle& texture : textures) {
+                    texture = _bgi->CreateTexture(textureDesc);
+                }
+                for (BgiTextureHandle& texture : textures) {
+                    _bgi->DestroyTexture(&texture);
+                }
+                _bgi->EndFrame();
+            });
+        });
+
+    report->AddMetric("resources.bufferCreateDestroyPerSecond",
+        count / bufferSeconds, "buffers/s", true);
+    report->AddMetric("resources.textureCreateDestroyPerSecond",
+        count / textureSeconds, "textures/s", true);
+}
+
+void
+DriverBenchmarks::_RunUploads(BenchmarkReport* report)
+{
+    UTILS_TRACE_FUNCTION();
+
+    size_t const byteSize = _options.uploadByteSize;
+
+    BgiBufferDesc bufferDesc;
+    bufferDesc.debugName = "Benchmark Upload Destination";
+    bufferDesc.usage = BgiBufferUsageStorage;
+    bufferDesc.byteSize = byteSize;
+    BgiBufferHandle buffer = _bgi->CreateBuffer(bufferDesc);
+
+    std::vector<uint8_t> data(byteSize);
+    for (size_t i = 0; i < byteSize; i++) {
+        data[i] = uint8_t(i * 31);
+    }
+
+    // The copy goes through the staging buffer of the destination, so the
+    // time includes the copy into the staging buffer, the GPU copy and the
+    // wait for its completion.
+    double const seconds = BenchmarkMedianSeconds(_options.repetitions,
+        [&]() {
+            _bgi->StartFrame();
+            double const s = BenchmarkSeconds([&]() {
+                BgiBufferCpuToGpuOp copyOp;
+                copyOp.cpuSourceBuffer = data.data();
+                copyOp.gpuDestinationBuffer = buffer;
+                copyOp.byteSize = byteSize;
+
+                BgiBlitCmdsUniquePtr blitCmds = _bgi->CreateBlitCmds();
+                blitCmds->CopyBufferCpuToGpu(copyOp);
+                _bgi->SubmitCmds(
+                    blitCmds.get(), BgiSubmitWaitTypeWaitUntilCompleted);
+            });
+            _WaitForGpu();
+            return s;
+        });
+
+    _bgi->StartFrame();
+    _bgi->DestroyBuffer(&buffer);
+    _bgi->EndFrame();
+
+    double const megabytes = double(byteSize) / (1024.0 * 1024.0);
+    report->AddMetric("upload.stagingBandwidth",
+        megabytes / seconds, "MiB/s", true);
+}
+
+void
+DriverBenchmarks::_RunPipelineCreation(BenchmarkReport* report)
+{
+    UTILS_TRACE_FUNCTION();
+
+    uint32_t const count = _options.pipelinesPerRun;
+
+    std::vector<BgiGraphicsPipelineHandle> graphicsPipelines(count);
+    double const graphicsSeconds = BenchmarkMedianSeconds(
+        _options.repetitions,
+        [&]() {
+            _bgi->StartFrame();
+            double const s = BenchmarkSeconds([&]() {
+                for (BgiGraphicsPipelineHandle& pipeline : graphicsPipelines) {
+                    pipeline =
+                        _bgi->CreateGraphicsPipeline(_graphicsPipelineDesc);
+                }
+            });
+            for (BgiGraphicsPipelineHandle& pipeline : graphicsPipelines) {
+                _bgi->DestroyGraphicsPipeline(&pipeline);
+            }
+            _bgi->EndFrame();
+            return s;
+        });
+
+    std::vector<BgiComputePipelineHandle> computePipelines(count);
+    double const computeSeconds = BenchmarkMedianSeconds(
+        _options.repetitions,
+        [&]() {
+            _bgi->StartFrame();
+            double const s = BenchmarkSeconds([&]() {
+                for (BgiComputePipelineHandle& pipeline : computePipelines) {
+                    pipeline =
+                        _bgi->CreateComputePipeline(_computePipelineDesc);
+                }
+            });
+            for (BgiComputePipelineHandle& pipeline : computePipelines) {
+                _bgi->DestroyComputePipeline(&pipeline);
+            }
+            _bgi->EndFrame();
+            return s;
+        });
+
+    report->AddMetric("pipeline.graphicsCreateTime",
+        graphicsSeconds * 1000.0 / count, "ms", false);
+    report->AddMetric("pipeline.computeCreateTime",
+        computeSeconds * 1000.0 / count, "ms", false);
+}
+
+void
+DriverBenchmarks::_RunRecordingScaling(BenchmarkReport* report)
+{
+    UTILS_TRACE_FUNCTION();
+
+    // Each thread records the same number of draws, so ideal scaling keeps
+    // the time constant and multiplies the draw rate by the thread count.
+    uint32_t const drawsPerThread = _options.drawsPerRun;
+    uint32_t const maxThreads = std::max(1u, std::min(_options.maxThreads,
+        std::thread::hardware_concurrency()));
+
+    double singleThreadRate = 0.0;
+    for (uint32_t threadCount = 1; threadCount <= maxThreads;
+         threadCount *= 2) {
+        double const seconds = BenchmarkMedianSeconds(_options.repetitions,
+            [&]() {
+                _bgi->StartFrame();
+
+                // Cmds are created and submitted on the main thread and
+                // recorded on the worker threads.
+                std::vector<BgiGraphicsCmdsUniquePtr> cmds;
+                for (uint32_t i = 0; i < threadCount; i++) {
+                    cmds.push_back(
+                        _bgi->CreateGraphicsCmds(_graphicsCmdsDesc));
+                }
+
+                double const s = BenchmarkSeconds([&]() {
+                    std::vector<std::thread> threads;
+                    for (uint32_t i = 0; i < threadCount; i++) {
+                        threads.emplace_back([&, i]() {
+                            _RecordDraws(cmds[i].get(), drawsPerThread);
+                        });
+                    }
+                    for (std::thread& thread : threads) {
+                        thread.join();
+                    }
+                });
+
+                for (BgiGraphicsCmdsUniquePtr& c : cmds) {
+                    _bgi->SubmitCmds(c.get());
+                }
+                _WaitForGpu();
+                return s;
+            });
+
+        double const rate = threadCount * drawsPerThread / seconds;
+        if (threadCount == 1) {
+            singleThreadRate = rate;
+        }
+
+        std::string const prefix =
+            "scaling.threads" + std::to_string(threadCount);
+        report->AddMetric(prefix + ".drawsPerSecond", rate, "draws/s", true);
+        report->AddMetric(prefix + ".speedup",
+            singleThreadRate > 0.0 ? rate / singleThreadRate : 0.0,
+            "x", true);
+    }
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
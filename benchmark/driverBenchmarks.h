@@ -0,0 +1,129 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "benchmark/harness.h"
+
+#include "driver/bgiBase/buffer.h"
+#include "driver/bgiBase/computePipeline.h"
+#include "driver/bgiBase/graphicsCmds.h"
+#include "driver/bgiBase/graphicsCmdsDesc.h"
+#include "driver/bgiBase/graphicsPipeline.h"
+#include "driver/bgiBase/resourceBindings.h"
+#include "driver/bgiBase/shaderProgram.h"
+#include "driver/bgiBase/texture.h"
+
+#include <cstdint>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+class BgiVulkan;
+}
+
+namespace benchmark {
+
+/// \struct DriverBenchmarkOptions
+///
+/// How much work each driver benchmark does.
+///
+/// <ul>
+/// <li>repetitions:
+///   The number of measured runs of each benchmark, the median is
+///   reported.</li>
+/// <li>drawsPerRun, dispatchesPerRun:
+///   The commands recorded into one cmds object per run.</li>
+/// <li>resourcesPerRun:
+///   The buffers and textures created and destroyed per run.</li>
+/// <li>uploadByteSize:
+///   The bytes uploaded through the staging buffer per run.</li>
+/// <li>pipelinesPerRun:
+///   The graphics and compute pipelines created per run.</li>
+/// <li>maxThreads:
+///   The most threads recording cmds in the scaling benchmark. The thread
+///   counts double from 1 up to this number.</li>
+/// </ul>
+///
+struct DriverBenchmarkOptions
+{
+    int repetitions = 5;
+    uint32_t drawsPerRun = 20000;
+    uint32_t dispatchesPerRun = 20000;
+    uint32_t resourcesPerRun = 500;
+    size_t uploadByteSize = 16 * 1024 * 1024;
+    uint32_t pipelinesPerRun = 20;
+    uint32_t maxThreads = 8;
+};
+
+/// \class DriverBenchmarks
+///
+/// Measures the CPU overhead of BgiVulkan: recording and submitting draws
+/// and dispatches, creating and destroying resources, uploading through
+/// staging buffers, creating pipelines and recording cmds on several
+/// threads.
+///
+/// The draws render tiny triangles into a small target, so that on a
+/// software implementation like lavapipe the measured time is dominated by
+/// the driver instead of rasterization. Command recording is timed up to
+/// the submission; waiting for the GPU is not included.
+///
+class DriverBenchmarks final
+{
+public:
+    DriverBenchmarks(
+        driver::BgiVulkan* bgi,
+        DriverBenchmarkOptions const& options);
+
+    ~DriverBenchmarks();
+
+    /// Returns false if the shaders or pipelines could not be created.
+    bool IsValid() const;
+
+    /// Runs all benchmarks and adds their metrics to 'report'.
+    void Run(BenchmarkReport* report);
+
+private:
+    DriverBenchmarks() = delete;
+    DriverBenchmarks & operator=(const DriverBenchmarks&) = delete;
+    DriverBenchmarks(const DriverBenchmarks&) = delete;
+
+    void _CreateResources();
+    void _DestroyResources();
+
+    driver::BgiShaderProgramHandle _CreateGraphicsProgram();
+    driver::BgiShaderProgramHandle _CreateComputeProgram();
+    void _DestroyProgram(driver::BgiShaderProgramHandle* program);
+
+    // Records 'count' draws into a new graphics cmds object.
+    void _RecordDraws(driver::BgiGraphicsCmds* cmds, uint32_t count);
+
+    // Waits until the submitted work completed and its resources were
+    // garbage collected.
+    void _WaitForGpu();
+
+    void _RunDraws(BenchmarkReport* report);
+    void _RunDispatches(BenchmarkReport* report);
+    void _RunResourceChurn(BenchmarkReport* report);
+    void _RunUploads(BenchmarkReport* report);
+    void _RunPipelineCreation(BenchmarkReport* report);
+    void _RunRecordingScaling(BenchmarkReport* report);
+
+    driver::BgiVulkan* _bgi;
+    DriverBenchmarkOptions _options;
+
+    driver::BgiTextureHandle _colorTarget;
+    driver::BgiGraphicsCmdsDesc _graphicsCmdsDesc;
+    driver::BgiGraphicsPipelineDesc _graphicsPipelineDesc;
+    driver::BgiShaderProgramHandle _graphicsProgram;
+    driver::BgiGraphicsPipelineHandle _graphicsPipeline;
+
+    driver::BgiBufferHandle _computeBuffer;
+    driver::BgiResourceBindingsHandle _computeBindings;
+    driver::BgiComputePipelineDesc _computePipelineDesc;
+    driver::BgiShaderProgramHandle _computeProgram;
+    driver::BgiComputePipelineHandle _computePipeline;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
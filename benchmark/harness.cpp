@@ -0,0 +1,231 @@
+#include "benchmark/harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <regex>
+#include <sstream>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace benchmark {
+
+static void
+_WriteJsonString(std::ostream& out, std::string const& str)
+{
+    out << '"';
+    for (char c : str) {
+        switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if ((unsigned char) c >= 0x20) {
+                out << c;
+            }
+            break;
+        }
+    }
+    out << '"';
+}
+
+void
+BenchmarkReport::SetProperty(std::string const& key, std::string const& value)
+{
+    for (auto& property : _properties) {
+        if (property.first == key) {
+            property.second = value;
+            return;
+        }
+    }
+    _properties.emplace_back(key, value);
+}
+
+void
+BenchmarkReport::AddMetric(
+    std::string const& name,
+    double value,
+    std::string const& unit,
+    bool higherIsBetter)
+{
+    BenchmarkMetric metric;
+    metric.name = name;
+    metric.value = value;
+    metric.unit = unit;
+    metric.higherIsBetter = higherIsBetter;
+    _metrics.push_back(std::move(metric));
+}
+
+std::vector<BenchmarkMetric> const&
+BenchmarkReport::GetMetrics() const
+{
+    return _metrics;
+}
+
+void
+BenchmarkReport::WriteSummary(std::ostream& out) const
+{
+    std::ios_base::fmtflags const flags = out.flags();
+    std::streamsize const precision = out.precision();
+
+    for (auto const& property : _properties) {
+        out << property.first << ": " << property.second << "\n";
+    }
+
+    out << std::fixed << std::setprecision(3);
+    for (BenchmarkMetric const& metric : _metrics) {
+        out << "  " << std::left << std::setw(48) << metric.name
+            << std::right << std::setw(18) << metric.value
+            << " " << metric.unit << "\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void
+BenchmarkReport::WriteJson(std::ostream& out) const
+{
+    std::ios_base::fmtflags const flags = out.flags();
+    std::streamsize const precision = out.precision();
+    out << std::setprecision(9);
+
+    out << "{\n  \"properties\": {";
+    for (size_t i = 0; i < _properties.size(); i++) {
+        out << (i ? "," : "") << "\n    ";
+        _WriteJsonString(out, _properties[i].first);
+        out << ": ";
+        _WriteJsonString(out, _properties[i].second);
+    }
+
+    out << "\n  },\n  \"metrics\": {";
+    for (size_t i = 0; i < _metrics.size(); i++) {
+        BenchmarkMetric const& metric = _metrics[i];
+        out << (i ? "," : "") << "\n    ";
+        _WriteJsonString(out, metric.name);
+        out << ": {\"value\": "
+            << (std::isfinite(metric.value) ? metric.value : 0.0)
+            << ", \"unit\": ";
+        _WriteJsonString(out, metric.unit);
+        out << ", \"higherIsBetter\": "
+            << (metric.higherIsBetter ? "true" : "false") << "}";
+    }
+    out << "\n  }\n}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool
+BenchmarkReport::WriteJson(std::string const& path) const
+{
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    WriteJson(out);
+    return bool(out);
+}
+
+int
+BenchmarkReport::CompareWithBaseline(
+    std::string const& path,
+    double tolerance,
+    std::ostream& out) const
+{
+    std::ifstream in(path);
+    if (!in) {
+        return -1;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string const json = buffer.str();
+
+    // Only the metric values are needed, which WriteJson writes as
+    // "name": {"value": number, ...}.
+    static const std::regex metricRegex(
+        "\"([^\"]+)\"\\s*:\\s*\\{\\s*\"value\"\\s*:\\s*"
+        "([-+0-9.eE]+)");
+
+    std::map<std::string, double> baseline;
+    for (std::sregex_iterator it(json.begin(), json.end(), metricRegex), end;
+         it != end; ++it) {
+        baseline[(*it)[1].str()] =
+            std::strtod((*it)[2].str().c_str(), nullptr);
+    }
+
+    std::ios_base::fmtflags const flags = out.flags();
+    std::streamsize const precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    int regressions = 0;
+    for (BenchmarkMetric const& metric : _metrics) {
+        auto const it = baseline.find(metric.name);
+        if (it == baseline.end()) {
+            out << "  new        " << metric.name << "\n";
+            continue;
+        }
+
+        double const reference = it->second;
+        baseline.erase(it);
+        if (reference == 0.0) {
+            continue;
+        }
+
+        double const change = (metric.value - reference) / reference;
+        bool const regressed = metric.higherIsBetter ?
+            change < -tolerance : change > tolerance;
+        bool const improved = metric.higherIsBetter ?
+            change > tolerance : change < -tolerance;
+        regressions += regressed ? 1 : 0;
+
+        out << (regressed ? "  REGRESSED  " : (improved ? "  improved   " :
+                "  ok         "))
+            << metric.name << " " << std::showpos << change * 100.0
+            << std::noshowpos << "%\n";
+    }
+
+    for (auto const& missing : baseline) {
+        out << "  missing    " << missing.first << "\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+    return regressions;
+}
+
+double
+BenchmarkSeconds(std::function<void()> const& fn)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    fn();
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+double
+BenchmarkMedianSeconds(
+    int repetitions,
+    std::function<double()> const& fn)
+{
+    fn();
+
+    std::vector<double> seconds;
+    for (int i = 0; i < std::max(repetitions, 1); i++) {
+        seconds.push_back(fn());
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+    size_t const middle = seconds.size() / 2;
+    return (seconds.size() % 2) ? seconds[middle] :
+        0.5 * (seconds[middle - 1] + seconds[middle]);
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "common/base.h"
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace benchmark {
+
+/// \struct BenchmarkMetric
+///
+/// One measured value of a benchmark run.
+///
+/// <ul>
+/// <li>name:
+///   A unique dotted name, e.g. "graphics.drawsPerSecond".</li>
+/// <li>value:
+///   The median of the measured repetitions.</li>
+/// <li>unit:
+///   The unit of the value, for humans reading the report.</li>
+/// <li>higherIsBetter:
+///   True for throughputs, false for times. Decides which direction of a
+///   change against the baseline is a regression.</li>
+/// </ul>
+///
+struct BenchmarkMetric
+{
+    std::string name;
+    double value = 0.0;
+    std::string unit;
+    bool higherIsBetter = true;
+};
+
+/// \class BenchmarkReport
+///
+/// Collects the metrics of a run and writes them as JSON, which can be saved
+/// as the baseline of later runs.
+///
+/// The JSON holds a "properties" object of strings describing the run (e.g.
+/// the device) and a "metrics" object mapping each metric name to its value,
+/// unit and direction.
+///
+class BenchmarkReport final
+{
+public:
+    /// Sets a string describing the run, e.g. the device name.
+    void SetProperty(std::string const& key, std::string const& value);
+
+    /// Adds a metric. Metrics are written in the order they were added.
+    void AddMetric(
+        std::string const& name,
+        double value,
+        std::string const& unit,
+        bool higherIsBetter);
+
+    std::vector<BenchmarkMetric> const& GetMetrics() const;
+
+    /// Writes a human readable table of the metrics.
+    void WriteSummary(std::ostream& out) const;
+
+    /// Writes the report as JSON.
+    void WriteJson(std::ostream& out) const;
+
+    /// Writes the report as JSON to the file at 'path'.
+    bool WriteJson(std::string const& path) const;
+
+    /// Compares the metrics with those of a report previously written to
+    /// 'path'. A metric regressed if it is worse than its baseline value by
+    /// more than 'tolerance' (e.g. 0.1 for 10%). Metrics missing from either
+    /// report are listed but not counted.
+    /// Returns the number of regressions, or -1 if the baseline can not be
+    /// read.
+    int CompareWithBaseline(
+        std::string const& path,
+        double tolerance,
+        std::ostream& out) const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> _properties;
+    std::vector<BenchmarkMetric> _metrics;
+};
+
+/// Returns the wall clock seconds one call of 'fn' takes.
+double BenchmarkSeconds(std::function<void()> const& fn);
+
+/// Calls 'fn' once to warm up, then 'repetitions' times, and returns the
+/// median of the seconds it returned. 'fn' measures itself, typically with
+/// BenchmarkSeconds, so it can leave out setup and waiting for the GPU.
+double BenchmarkMedianSeconds(
+    int repetitions,
+    std::function<double()> const& fn);
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
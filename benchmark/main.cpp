@@ -0,0 +1,174 @@
+#include "common/base.h"
+
+#include "common/arch/defines.h"
+#include "common/utils/trace.h"
+
+#include "benchmark/driverBenchmarks.h"
+#include "benchmark/harness.h"
+
+#include "driver/bgiVulkan/bgi.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/device.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Measures the CPU overhead of the Vulkan driver and writes the results as
+// JSON. The numbers are only comparable on the same device, so runs meant
+// for regression tracking should use a software implementation like
+// lavapipe, selected through the Vulkan loader:
+//
+//   VK_DRIVER_FILES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json \
+//       xmake run benchmark --baseline baseline.json
+//
+// Options:
+//   --output <path>       Where to write the JSON report (benchmark.json).
+//   --baseline <path>     A previous report to compare against.
+//   --tolerance <ratio>   Allowed relative regression (0.1).
+//   --repetitions <n>     Measured runs per benchmark.
+//   --max-threads <n>     Most threads recording cmds in parallel.
+//   --quick               Less work per run, for smoke testing.
+//   --trace <path>        Also write a Chrome trace of the run.
+//
+// Exits with 1 if any metric regressed against the baseline and 2 if the
+// benchmarks could not run.
+
+using namespace gungnir;
+
+static void
+_PrintUsage()
+{
+    std::cerr << "usage: benchmark [--output <path>] [--baseline <path>] "
+                 "[--tolerance <ratio>]\n"
+                 "                 [--repetitions <n>] [--max-threads <n>] "
+                 "[--quick] [--trace <path>]\n";
+}
+
+static const char*
+_GetDeviceTypeName(VkPhysicalDeviceType type)
+{
+    switch (type) {
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return "cpu";
+    default:
+        return "other";
+    }
+}
+
+int
+main(int argc, char** argv)
+{
+    std::string outputPath = "benchmark.json";
+    std::string baselinePath;
+    std::string tracePath;
+    double tolerance = 0.1;
+    benchmark::DriverBenchmarkOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        bool const hasValue = i + 1 < argc;
+        if (arg == "--output" && hasValue) {
+            outputPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            tolerance = std::atof(argv[++i]);
+        } else if (arg == "--repetitions" && hasValue) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-threads" && hasValue) {
+            options.maxThreads = uint32_t(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--quick") {
+            options.repetitions = 1;
+            options.drawsPerRun = 2000;
+            options.dispatchesPerRun = 2000;
+            options.resourcesPerRun = 50;
+            options.uploadByteSize = 1024 * 1024;
+            options.pipelinesPerRun = 2;
+        } else {
+            _PrintUsage();
+            return 2;
+        }
+    }
+
+    // The benchmark renders offscreen only, so it runs without a display.
+    if (!std::getenv("GUNGNIR_VULKAN_HEADLESS")) {
+#if defined(ARCH_OS_WINDOWS)
+        _putenv_s("GUNGNIR_VULKAN_HEADLESS", "1");
+#else
+        setenv("GUNGNIR_VULKAN_HEADLESS", "1", 0);
+#endif
+    }
+
+    if (!tracePath.empty()) {
+        utils::Trace::SetEnabled(true);
+    }
+
+    benchmark::BenchmarkReport report;
+    {
+        driver::BgiVulkan bgi;
+
+        VkPhysicalDeviceProperties const& properties = bgi.GetPrimaryDevice()
+            ->GetDeviceCapabilities().vkDeviceProperties;
+        report.SetProperty("device", properties.deviceName);
+        report.SetProperty(
+            "deviceType", _GetDeviceTypeName(properties.deviceType));
+        report.SetProperty("hardwareThreads",
+            std::to_string(std::thread::hardware_concurrency()));
+        report.SetProperty(
+            "repetitions", std::to_string(options.repetitions));
+
+        if (properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU) {
+            std::cerr << "Warning: running on " << properties.deviceName
+                      << ", results are only comparable on the same device."
+                      << " Set VK_DRIVER_FILES to the lavapipe ICD for "
+                      << "reproducible numbers.\n";
+        }
+
+        benchmark::DriverBenchmarks benchmarks(&bgi, options);
+        if (!benchmarks.IsValid()) {
+            std::cerr << "Failed to create the benchmark pipelines.\n";
+            return 2;
+        }
+        benchmarks.Run(&report);
+    }
+
+    report.WriteSummary(std::cout);
+
+    if (!report.WriteJson(outputPath)) {
+        std::cerr << "Failed to write " << outputPath << "\n";
+        return 2;
+    }
+
+    if (!tracePath.empty() && !utils::Trace::WriteChromeTrace(tracePath)) {
+        std::cerr << "Failed to write " << tracePath << "\n";
+    }
+
+    if (baselinePath.empty()) {
+        return 0;
+    }
+
+    std::cout << "\nCompared with " << baselinePath << ":\n";
+    int const regressions =
+        report.CompareWithBaseline(baselinePath, tolerance, std::cout);
+    if (regressions < 0) {
+        std::cerr << "Failed to read " << baselinePath << "\n";
+        return 2;
+    }
+    if (regressions > 0) {
+        std::cout << regressions << " metric(s) regressed by more than "
+                  << tolerance * 100.0 << "%\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,9 @@
+target("benchmark")
+    set_kind("binary")
+    add_headerfiles("./*.h")
+    add_files("./*.cpp")
+    add_packages("eigen", "vulkan-hpp", "vulkan-memory-allocator-hpp", "spirv-reflect", "fmt")
+    add_deps("common", "driver")
+    add_links("common", "driver")
+    add_linkdirs("$(buildir)/$(plat)/$(arch)/$(mode)/common/", "$(buildir)/$(plat)/$(arch)/$(mode)/driver/")
+    add_includedirs("$(projectdir)/common/", "$(projectdir)/driver/")
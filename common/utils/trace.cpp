@@ -0,0 +1,304 @@
+#include "common/utils/trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace utils {
+
+std::atomic<bool> Trace::_enabled(false);
+
+// The number of zones each thread keeps, a power of two.
+static const uint64_t _eventCapacity = 1 << 14;
+
+// The fields are atomic so that writing the trace can read them while the
+// owning thread overwrites them. Relaxed accesses compile to plain loads and
+// stores.
+struct _TraceEvent
+{
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> begin;
+    std::atomic<uint64_t> end;
+};
+
+// A buffer is retired when its thread exits and becomes free once its zones
+// were written or cleared. Free buffers are handed to new threads.
+enum class _TraceBufferState
+{
+    Active,
+    Retired,
+    Free
+};
+
+// The ring buffer of one thread. Only the owning thread appends, 'count' is
+// the number of zones it ever recorded.
+struct _TraceThreadBuffer
+{
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> cleared{0};
+    uint32_t threadIndex = 0;
+    _TraceBufferState state = _TraceBufferState::Active;
+    std::string name;
+    _TraceEvent events[_eventCapacity];
+};
+
+// Buffers are kept after their thread exits, so its zones can still be
+// written, and are then reused by new threads.
+static std::mutex _registryMutex;
+static std::vector<std::unique_ptr<_TraceThreadBuffer>> _registry;
+static std::vector<_TraceThreadBuffer*> _freeBuffers;
+static uint32_t _nextThreadIndex = 0;
+
+// A tick and steady clock pair taken when recording was first enabled, to
+// convert ticks to microseconds.
+static std::atomic<bool> _calibrated(false);
+static uint64_t _calibrationTicks = 0;
+static std::chrono::steady_clock::time_point _calibrationTime;
+
+// Retires the buffer of a thread when the thread exits.
+struct _TraceThreadBufferOwner
+{
+    _TraceThreadBuffer* buffer = nullptr;
+
+    ~_TraceThreadBufferOwner();
+};
+
+static thread_local _TraceThreadBuffer* _threadBuffer = nullptr;
+static thread_local bool _threadExited = false;
+static thread_local _TraceThreadBufferOwner _threadBufferOwner;
+
+_TraceThreadBufferOwner::~_TraceThreadBufferOwner()
+{
+    if (buffer) {
+        std::lock_guard<std::mutex> lock(_registryMutex);
+        buffer->state = _TraceBufferState::Retired;
+    }
+    // Zones recorded by later thread_local destructors are dropped.
+    _threadBuffer = nullptr;
+    _threadExited = true;
+}
+
+// Returns the buffer of the calling thread, or null when the thread is
+// exiting.
+static _TraceThreadBuffer*
+_GetThreadBuffer()
+{
+    if (!_threadBuffer && !_threadExited) {
+        std::lock_guard<std::mutex> lock(_registryMutex);
+        _TraceThreadBuffer* buffer = nullptr;
+        if (!_freeBuffers.empty()) {
+            // The zones of the previous thread were already written or
+            // cleared.
+            buffer = _freeBuffers.back();
+            _freeBuffers.pop_back();
+            buffer->cleared.store(buffer->count.load());
+            buffer->name.clear();
+        } else {
+            _registry.push_back(std::make_unique<_TraceThreadBuffer>());
+            buffer = _registry.back().get();
+        }
+        buffer->state = _TraceBufferState::Active;
+        buffer->threadIndex = _nextThreadIndex++;
+        _threadBufferOwner.buffer = buffer;
+        _threadBuffer = buffer;
+    }
+    return _threadBuffer;
+}
+
+// Frees the retired buffers, whose zones were just written or cleared.
+// Requires '_registryMutex' to be held.
+static void
+_FreeRetiredBuffers()
+{
+    for (auto const& buffer : _registry) {
+        if (buffer->state == _TraceBufferState::Retired) {
+            buffer->state = _TraceBufferState::Free;
+            _freeBuffers.push_back(buffer.get());
+        }
+    }
+}
+
+static void
+_WriteJsonString(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (const char* c = str; c && *c; c++) {
+        switch (*c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if ((unsigned char) *c >= 0x20) {
+                out << *c;
+            }
+            break;
+        }
+    }
+    out << '"';
+}
+
+void
+Trace::SetEnabled(bool enabled)
+{
+    if (enabled && !_calibrated.load()) {
+        std::lock_guard<std::mutex> lock(_registryMutex);
+        if (!_calibrated.load()) {
+            _calibrationTicks = Now();
+            _calibrationTime = std::chrono::steady_clock::now();
+            _calibrated.store(true);
+        }
+    }
+    _enabled.store(enabled);
+}
+
+void
+Trace::SetThreadName(std::string const& name)
+{
+    _TraceThreadBuffer* buffer = _GetThreadBuffer();
+    if (!buffer) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    buffer->name = name;
+}
+
+void
+Trace::Clear()
+{
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    for (auto const& buffer : _registry) {
+        buffer->cleared.store(buffer->count.load());
+    }
+    _FreeRetiredBuffers();
+}
+
+void
+Trace::Record(const char* name, uint64_t begin, uint64_t end)
+{
+    _TraceThreadBuffer* buffer = _GetThreadBuffer();
+    if (!buffer) {
+        return;
+    }
+
+    // The fence orders the previous update of 'count' before overwriting
+    // the slot, so a reader that sees the new values also sees that the
+    // slot was reused.
+    uint64_t const index = buffer->count.load(std::memory_order_relaxed);
+    _TraceEvent& event = buffer->events[index & (_eventCapacity - 1)];
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void
+Trace::WriteChromeTrace(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(_registryMutex);
+
+    // Measure the tick rate over the whole time since calibration. Ticks
+    // are nanoseconds when rdtsc is not used.
+    double ticksPerUs = 1000.0;
+#if defined(ARCH_CPU_INTEL)
+    if (_calibrated.load()) {
+        auto const now = std::chrono::steady_clock::now();
+        uint64_t const ticks = Now();
+        double const us = std::chrono::duration<double, std::micro>(
+            now - _calibrationTime).count();
+        if (us > 0.0 && ticks > _calibrationTicks) {
+            ticksPerUs = double(ticks - _calibrationTicks) / us;
+        }
+    }
+#endif
+
+    auto toUs = [ticksPerUs](uint64_t ticks) {
+        return double(int64_t(ticks - _calibrationTicks)) / ticksPerUs;
+    };
+
+    std::ios_base::fmtflags const flags = out.flags();
+    std::streamsize const precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+
+    for (auto const& buffer : _registry) {
+        if (buffer->state == _TraceBufferState::Free) {
+            continue;
+        }
+
+        if (!buffer->name.empty()) {
+            out << (first ? "" : ",")
+                << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                << "\"tid\":" << buffer->threadIndex
+                << ",\"args\":{\"name\":";
+            _WriteJsonString(out, buffer->name.c_str());
+            out << "}}";
+            first = false;
+        }
+
+        uint64_t const count =
+            buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = buffer->cleared.load();
+        if (count > _eventCapacity) {
+            begin = std::max(begin, count - _eventCapacity);
+        }
+
+        for (uint64_t i = begin; i < count; i++) {
+            _TraceEvent const& event =
+                buffer->events[i & (_eventCapacity - 1)];
+            const char* name = event.name.load(std::memory_order_relaxed);
+            uint64_t const zoneBegin =
+                event.begin.load(std::memory_order_relaxed);
+            uint64_t const zoneEnd =
+                event.end.load(std::memory_order_relaxed);
+
+            // The owning thread may have wrapped around and be writing this
+            // slot (the slot of 'count' is written before 'count' is).
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t const latest =
+                buffer->count.load(std::memory_order_acquire);
+            if (latest + 1 > i + _eventCapacity) {
+                continue;
+            }
+
+            out << (first ? "" : ",") << "\n{\"name\":";
+            _WriteJsonString(out, name);
+            out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+                << buffer->threadIndex
+                << ",\"ts\":" << toUs(zoneBegin)
+                << ",\"dur\":" << toUs(zoneEnd) - toUs(zoneBegin) << "}";
+            first = false;
+        }
+    }
+
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    _FreeRetiredBuffers();
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool
+Trace::WriteChromeTrace(std::string const& path)
+{
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    WriteChromeTrace(out);
+    return bool(out);
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
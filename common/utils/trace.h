@@ -0,0 +1,146 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "common/arch/defines.h"
+#include "common/macros.h"
+#include "common/utils/api.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#if defined(ARCH_CPU_INTEL)
+#   if defined(ARCH_COMPILER_MSVC)
+#       include <intrin.h>
+#   else
+#       include <x86intrin.h>
+#   endif
+#endif
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+/// \file utils/trace.h
+/// Scoped CPU zones with Chrome trace export.
+///
+/// \c UTILS_TRACE_SCOPE("name") measures the CPU time from the macro to the
+/// end of the enclosing scope, \c UTILS_TRACE_FUNCTION() does the same with
+/// the name of the function. The name must outlive the trace (e.g. a string
+/// literal), only its pointer is recorded.
+///
+/// Zones are only recorded while utils::Trace is enabled; a disabled zone
+/// costs one relaxed load and a branch. Defining GUNGNIR_TRACE_DISABLED
+/// compiles the zones out entirely.
+
+#if defined(GUNGNIR_TRACE_DISABLED)
+#   define UTILS_TRACE_SCOPE(name)
+#else
+#   define UTILS_TRACE_SCOPE(name) \
+        utils::TraceZone GUNGNIR_CONCAT_STRINGS(_traceZone, __COUNTER__)(name)
+#endif
+
+#define UTILS_TRACE_FUNCTION() UTILS_TRACE_SCOPE(__func__)
+
+namespace utils {
+
+/// \class Trace
+///
+/// Records the zones of each thread into a ring buffer owned by the thread.
+/// Recording takes no locks; only the first zone of a thread registers its
+/// buffer. When a buffer is full the oldest zones are overwritten.
+///
+/// The buffer of an exited thread keeps its zones until the trace is written
+/// or cleared, and is then reused by the next new thread.
+///
+/// Timestamps are read with rdtsc where available and with the steady clock
+/// otherwise. They are converted to microseconds when the trace is written.
+///
+/// Thread safety: All functions may be called from any thread. Writing the
+/// trace while zones are recorded skips the zones being overwritten.
+///
+class Trace final
+{
+public:
+    /// Enables or disables recording. Zones that began before recording was
+    /// enabled are not recorded.
+    UTILS_API
+    static void SetEnabled(bool enabled);
+
+    static bool IsEnabled()
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Names the calling thread in the written trace.
+    UTILS_API
+    static void SetThreadName(std::string const& name);
+
+    /// Drops all zones recorded so far.
+    UTILS_API
+    static void Clear();
+
+    /// Writes the recorded zones as Chrome trace event JSON, which can be
+    /// opened by chrome://tracing and Perfetto.
+    UTILS_API
+    static void WriteChromeTrace(std::ostream& out);
+
+    /// Writes the Chrome trace to the file at 'path'.
+    UTILS_API
+    static bool WriteChromeTrace(std::string const& path);
+
+    /// Returns the current timestamp, in ticks.
+    static uint64_t Now()
+    {
+#if defined(ARCH_CPU_INTEL)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /// Appends a zone to the buffer of the calling thread.
+    UTILS_API
+    static void Record(const char* name, uint64_t begin, uint64_t end);
+
+private:
+    Trace() = delete;
+
+    UTILS_API
+    static std::atomic<bool> _enabled;
+};
+
+/// \class TraceZone
+///
+/// Records the time between its construction and destruction as a zone.
+/// Use UTILS_TRACE_SCOPE instead of creating zones directly.
+///
+class TraceZone final
+{
+public:
+    explicit TraceZone(const char* name)
+        : _name(Trace::IsEnabled() ? name : nullptr)
+        , _begin(_name ? Trace::Now() : 0)
+    {
+    }
+
+    ~TraceZone()
+    {
+        if (_name) {
+            Trace::Record(_name, _begin, Trace::Now());
+        }
+    }
+
+private:
+    TraceZone(const TraceZone&) = delete;
+    TraceZone & operator=(const TraceZone&) = delete;
+
+    const char* _name;
+    uint64_t _begin;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,135 @@
+#include "common/utils/workStealingPool.h"
+
+#include <algorithm>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace utils {
+
+// Identifies the pool and the deque owned by the current worker thread.
+static thread_local WorkStealingPool const* _currentPool = nullptr;
+static thread_local size_t _currentWorkerIndex = 0;
+
+WorkStealingPool::WorkStealingPool(size_t numThreads)
+    : _pendingTasks(0)
+    , _nextQueue(0)
+    , _stop(false)
+{
+    if (numThreads == 0) {
+        numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    _queues.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; i++) {
+        _queues.push_back(std::make_unique<_Queue>());
+    }
+
+    _threads.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; i++) {
+        _threads.emplace_back(&WorkStealingPool::_WorkerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _stop = true;
+    }
+    _wakeCondition.notify_all();
+
+    for (std::thread& thread : _threads) {
+        thread.join();
+    }
+}
+
+size_t
+WorkStealingPool::GetNumThreads() const
+{
+    return _threads.size();
+}
+
+void
+WorkStealingPool::_Push(_Task&& task)
+{
+    // Tasks spawned by a worker stay local to that worker (better cache
+    // locality), other tasks are spread over all deques.
+    const size_t index = (_currentPool == this) ?
+        _currentWorkerIndex : (_nextQueue++ % _queues.size());
+
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _pendingTasks++;
+    }
+    _wakeCondition.notify_one();
+}
+
+bool
+WorkStealingPool::_PopOrSteal(size_t workerIndex, _Task* task)
+{
+    // Own deque first, LIFO.
+    {
+        _Queue& queue = *_queues[workerIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            *task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal from the other deques, FIFO.
+    const size_t numQueues = _queues.size();
+    for (size_t i = 1; i < numQueues; i++) {
+        _Queue& queue = *_queues[(workerIndex + i) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            *task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+WorkStealingPool::_WorkerLoop(size_t workerIndex)
+{
+    _currentPool = this;
+    _currentWorkerIndex = workerIndex;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_wakeMutex);
+            _wakeCondition.wait(lock, [this] {
+                return _stop || _pendingTasks > 0;
+            });
+            if (_pendingTasks == 0) {
+                // Only reached when stopping and all work is done.
+                break;
+            }
+            _pendingTasks--;
+        }
+
+        // A task was reserved above, so one of the deques holds it (or a
+        // concurrent worker grabbed ours and left another one for us).
+        _Task task;
+        while (!_PopOrSteal(workerIndex, &task)) {
+            std::this_thread::yield();
+        }
+
+        task();
+    }
+
+    _currentPool = nullptr;
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "common/utils/api.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace utils {
+
+/// \class WorkStealingPool
+///
+/// A fixed size pool of worker threads with one task deque per worker.
+///
+/// Tasks submitted from a worker thread are pushed onto that worker's own
+/// deque, other tasks are distributed round-robin. Workers pop from the back
+/// of their own deque and, when it runs dry, steal from the front of the
+/// other workers' deques. This keeps every core busy when tasks have very
+/// uneven cost (e.g. compiling shaders of varying complexity).
+///
+/// Thread safety: Submit may be called from any thread, including from
+/// within a task running on the pool.
+///
+class WorkStealingPool final
+{
+public:
+    /// Creates a pool with 'numThreads' workers. When 'numThreads' is 0 the
+    /// number of hardware threads is used.
+    UTILS_API
+    explicit WorkStealingPool(size_t numThreads = 0);
+
+    /// Waits for the queued tasks to finish and joins the workers.
+    UTILS_API
+    ~WorkStealingPool();
+
+    /// Returns the number of worker threads.
+    UTILS_API
+    size_t GetNumThreads() const;
+
+    /// Queues 'fn' for execution and returns a future for its result.
+    template <class Fn>
+    std::future<std::invoke_result_t<Fn>> Submit(Fn&& fn)
+    {
+        using Result = std::invoke_result_t<Fn>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Fn>(fn));
+        std::future<Result> future = task->get_future();
+        _Push([task]() { (*task)(); });
+        return future;
+    }
+
+private:
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool & operator=(const WorkStealingPool&) = delete;
+
+    using _Task = std::function<void()>;
+
+    struct _Queue
+    {
+        std::mutex mutex;
+        std::deque<_Task> tasks;
+    };
+
+    UTILS_API
+    void _Push(_Task&& task);
+
+    // Pops a task from the worker's own deque or steals one from another.
+    bool _PopOrSteal(size_t workerIndex, _Task* task);
+
+    void _WorkerLoop(size_t workerIndex);
+
+    std::vector<std::unique_ptr<_Queue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCondition;
+    std::atomic<size_t> _pendingTasks;
+    std::atomic<size_t> _nextQueue;
+    bool _stop;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -77,6 +77,44 @@ Bgi::IsSupported()
     return false;
 }
 
+BgiShaderFunctionFutureVector
+Bgi::CreateShaderFunctions(BgiShaderFunctionDescVector const& descs)
+{
+    BgiShaderFunctionFutureVector futures;
+    futures.reserve(descs.size());
+
+    for (BgiShaderFunctionDesc const& desc : descs) {
+        std::promise<BgiShaderFunctionHandle> promise;
+        promise.set_value(CreateShaderFunction(desc));
+        futures.push_back(promise.get_future().share());
+    }
+
+    return futures;
+}
+
+void
+Bgi::SetGpuProfilingEnabled(bool enabled)
+{
+}
+
+bool
+Bgi::IsGpuProfilingEnabled() const
+{
+    return false;
+}
+
+bool
+Bgi::GetGpuFrameTimings(BgiGpuFrameTimings* timings) const
+{
+    return false;
+}
+
+bool
+Bgi::GetMemoryStats(BgiMemoryStats* stats) const
+{
+    return false;
+}
+
 uint64_t
 Bgi::GetUniqueId()
 {
@@ -8,8 +8,11 @@
 #include "driver/bgiBase/buffer.h"
 #include "driver/bgiBase/computeCmds.h"
 #include "driver/bgiBase/computeCmdsDesc.h"
+#include "driver/bgiBase/gpuTimings.h"
 #include "driver/bgiBase/graphicsCmds.h"
 #include "driver/bgiBase/graphicsCmdsDesc.h"
+#include "driver/bgiBase/memoryStats.h"
+#include "driver/bgiBase/queryPool.h"
 #include "driver/bgiBase/resourceBindings.h"
 #include "driver/bgiBase/sampler.h"
 #include "driver/bgiBase/shaderProgram.h"
@@ -206,6 +209,19 @@ public:
     virtual BgiShaderFunctionHandle CreateShaderFunction(
         BgiShaderFunctionDesc const& desc) = 0;
 
+    /// Create many shader functions at once.
+    /// Backends may compile the functions concurrently, so the returned
+    /// futures become ready independently (in any order). The futures are
+    /// returned in the same order as 'descs'.
+    /// The shader code pointers in 'descs' must remain valid until all
+    /// returned futures are ready.
+    /// The default implementation creates the functions one at a time via
+    /// CreateShaderFunction and returns futures that are already ready.
+    /// Thread safety: Creation must happen on main thread. See notes above.
+    BGI_API
+    virtual BgiShaderFunctionFutureVector CreateShaderFunctions(
+        BgiShaderFunctionDescVector const& descs);
+
     /// Destroy a shader function.
     /// Thread safety: Destruction must happen on main thread. See notes above.
     BGI_API
@@ -261,6 +277,17 @@ public:
     BGI_API
     virtual void DestroyComputePipeline(BgiComputePipelineHandle* pipeHandle)=0;
 
+    /// Create a new query pool.
+    /// Thread safety: Creation must happen on main thread. See notes above.
+    BGI_API
+    virtual BgiQueryPoolHandle CreateQueryPool(
+        BgiQueryPoolDesc const& desc) = 0;
+
+    /// Destroy a query pool.
+    /// Thread safety: Destruction must happen on main thread. See notes above.
+    BGI_API
+    virtual void DestroyQueryPool(BgiQueryPoolHandle* queryPoolHandle) = 0;
+
     /// Return the name of the api (e.g. "OpenGL").
     /// Thread safety: This call is thread safe.
     BGI_API
@@ -292,6 +319,32 @@ public:
     BGI_API
     virtual void EndFrame() = 0;
 
+    /// Enables measuring the GPU time of the debug groups pushed on cmds
+    /// objects between StartFrame and EndFrame. Does nothing if the backend
+    /// or device does not support GPU timestamps.
+    /// Thread safety: Not thread safe. Should be called on the main thread.
+    BGI_API
+    virtual void SetGpuProfilingEnabled(bool enabled);
+
+    /// Returns true if GPU profiling is enabled and supported.
+    /// Thread safety: This call is thread safe.
+    BGI_API
+    virtual bool IsGpuProfilingEnabled() const;
+
+    /// Fills 'timings' with the most recent frame whose GPU timings are
+    /// available. The GPU results are read back without waiting, so they lag
+    /// a few frames behind. Returns false if no frame has been resolved.
+    /// Thread safety: Not thread safe. Should be called on the main thread.
+    BGI_API
+    virtual bool GetGpuFrameTimings(BgiGpuFrameTimings* timings) const;
+
+    /// Fills 'stats' with the memory heap usage and the live resources of
+    /// the device. Returns false if the backend does not track memory.
+    /// Use BgiWriteMemoryStatsJson to dump the stats.
+    /// Thread safety: This call is thread safe.
+    BGI_API
+    virtual bool GetMemoryStats(BgiMemoryStats* stats) const;
+
 protected:
     // Returns a unique id for handle creation.
     // Thread safety: Thread-safe atomic increment.
@@ -17,6 +17,18 @@ BgiBuffer::GetDescriptor() const
     return _descriptor;
 }
 
+uint32_t
+BgiBuffer::GetBindlessIndex() const
+{
+    return BgiBindlessIndexInvalid;
+}
+
+uint64_t
+BgiBuffer::GetDeviceAddress() const
+{
+    return 0;
+}
+
 bool operator==(
     const BgiBufferDesc& lhs,
     const BgiBufferDesc& rhs)
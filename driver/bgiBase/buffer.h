@@ -98,6 +98,23 @@ public:
     BGI_API
     virtual uint64_t GetRawResource() const = 0;
 
+    /// Returns the stable index of the resource in the backend's bindless
+    /// descriptor heap, or BgiBindlessIndexInvalid if the backend does not
+    /// support bindless resources or the resource's usage does not allow it.
+    /// Shader functions that declare the resource as bindless access it
+    /// through this index.
+    BGI_API
+    virtual uint32_t GetBindlessIndex() const;
+
+    /// Returns the GPU address of the buffer, or 0 if the buffer was not
+    /// created with BgiBufferUsageDeviceAddress or the backend does not
+    /// support it. Shaders read buffers declared with
+    /// BgiShaderFunctionBufferDesc::deviceAddress from this address, which
+    /// lets them reach any number of buffers without binding them, e.g. to
+    /// pull vertices from a few large merged buffers.
+    BGI_API
+    virtual uint64_t GetDeviceAddress() const;
+
     /// Returns the 'staging area' in which new buffer data is copied before
     /// it is flushed to GPU.
     /// Some implementations (e.g. Metal) may have build in support for
@@ -0,0 +1,1281 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiBase/commandStream.h"
+#include "driver/bgiBase/bgi.h"
+#include "driver/bgiBase/blitCmdsOps.h"
+#include "driver/bgiBase/commandStreamCmds.h"
+#include "driver/bgiBase/commandStreamManifest.h"
+
+#include <cstring>
+#include <fstream>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+static const uint32_t _streamMagic = 0x53434247; // 'GBCS'
+
+// The header is followed by the blocks of cmds and then by the manifest of
+// the resources, if any.
+struct _StreamFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t cmdsCount;
+    uint64_t manifestByteSize;
+};
+
+struct _StreamFileCmdsHeader
+{
+    uint32_t type;
+    uint32_t wait;
+    uint64_t byteSize;
+    uint64_t readbackByteSize;
+};
+
+//
+// Resources
+//
+
+template <class T>
+static void
+_AddHandle(std::unordered_map<uint64_t, T>* handles, T const& handle)
+{
+    if (handle) {
+        (*handles)[handle.GetId()] = handle;
+    }
+}
+
+// Looks up the handle of 'id'. Returns false if the stream refers to a
+// resource that was not provided. Id zero is an empty handle.
+template <class T>
+static bool
+_Resolve(
+    std::unordered_map<uint64_t, T> const& handles,
+    uint64_t id,
+    T* handle)
+{
+    *handle = T();
+    if (id == 0) {
+        return true;
+    }
+
+    auto const it = handles.find(id);
+    if (it == handles.end()) {
+        UTILS_CODING_ERROR("Command stream resource %llu is missing",
+            (unsigned long long) id);
+        return false;
+    }
+
+    *handle = it->second;
+    return true;
+}
+
+void
+BgiCommandStreamResources::Add(BgiBufferHandle const& buffer)
+{
+    _AddHandle(&buffers, buffer);
+}
+
+void
+BgiCommandStreamResources::Add(BgiTextureHandle const& texture)
+{
+    _AddHandle(&textures, texture);
+}
+
+void
+BgiCommandStreamResources::Add(BgiGraphicsPipelineHandle const& pipeline)
+{
+    _AddHandle(&graphicsPipelines, pipeline);
+}
+
+void
+BgiCommandStreamResources::Add(BgiComputePipelineHandle const& pipeline)
+{
+    _AddHandle(&computePipelines, pipeline);
+}
+
+void
+BgiCommandStreamResources::Add(
+    BgiResourceBindingsHandle const& resourceBindings)
+{
+    _AddHandle(&this->resourceBindings, resourceBindings);
+}
+
+void
+BgiCommandStreamResources::Add(BgiQueryPoolHandle const& queryPool)
+{
+    _AddHandle(&queryPools, queryPool);
+}
+
+void
+BgiCommandStreamResources::Add(BgiSamplerHandle const& sampler)
+{
+    _AddHandle(&samplers, sampler);
+}
+
+void
+BgiCommandStreamResources::Add(BgiShaderFunctionHandle const& shaderFunction)
+{
+    _AddHandle(&shaderFunctions, shaderFunction);
+}
+
+void
+BgiCommandStreamResources::Add(BgiShaderProgramHandle const& shaderProgram)
+{
+    _AddHandle(&shaderPrograms, shaderProgram);
+}
+
+void
+BgiCommandStreamResources::Merge(BgiCommandStreamResources const& other)
+{
+    buffers.insert(other.buffers.begin(), other.buffers.end());
+    textures.insert(other.textures.begin(), other.textures.end());
+    graphicsPipelines.insert(
+        other.graphicsPipelines.begin(), other.graphicsPipelines.end());
+    computePipelines.insert(
+        other.computePipelines.begin(), other.computePipelines.end());
+    resourceBindings.insert(
+        other.resourceBindings.begin(), other.resourceBindings.end());
+    queryPools.insert(other.queryPools.begin(), other.queryPools.end());
+    samplers.insert(other.samplers.begin(), other.samplers.end());
+    shaderFunctions.insert(
+        other.shaderFunctions.begin(), other.shaderFunctions.end());
+    shaderPrograms.insert(
+        other.shaderPrograms.begin(), other.shaderPrograms.end());
+}
+
+void
+BgiCommandStreamResources::Clear()
+{
+    buffers.clear();
+    textures.clear();
+    graphicsPipelines.clear();
+    computePipelines.clear();
+    resourceBindings.clear();
+    queryPools.clear();
+    samplers.clear();
+    shaderFunctions.clear();
+    shaderPrograms.clear();
+}
+
+//
+// Writer
+//
+
+BgiCommandStreamWriter::BgiCommandStreamWriter() = default;
+
+void
+BgiCommandStreamWriter::Write(const void* data, size_t byteSize)
+{
+    if (byteSize == 0) {
+        return;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    _data.insert(_data.end(), bytes, bytes + byteSize);
+}
+
+void
+BgiCommandStreamWriter::WriteOp(BgiCommandStreamOp op)
+{
+    uint16_t const value = op;
+    Write(&value, sizeof(value));
+}
+
+void
+BgiCommandStreamWriter::WriteUInt32(uint32_t value)
+{
+    Write(&value, sizeof(value));
+}
+
+void
+BgiCommandStreamWriter::WriteUInt64(uint64_t value)
+{
+    Write(&value, sizeof(value));
+}
+
+void
+BgiCommandStreamWriter::WriteFloat(float value)
+{
+    Write(&value, sizeof(value));
+}
+
+void
+BgiCommandStreamWriter::WriteString(const char* str)
+{
+    uint32_t const size = str ? (uint32_t) strlen(str) : 0;
+    WriteUInt32(size);
+    Write(str, size);
+}
+
+void
+BgiCommandStreamWriter::WriteUInt32Vector(std::vector<uint32_t> const& values)
+{
+    WriteUInt32((uint32_t) values.size());
+    Write(values.data(), values.size() * sizeof(uint32_t));
+}
+
+void
+BgiCommandStreamWriter::WriteBytes(const void* data, size_t byteSize)
+{
+    if (!data) {
+        byteSize = 0;
+    }
+    WriteUInt64(byteSize);
+    Write(data, byteSize);
+}
+
+// Must match BgiCommandStreamReader::ReadAttachmentDesc.
+void
+BgiCommandStreamWriter::WriteAttachmentDesc(BgiAttachmentDesc const& desc)
+{
+    WriteUInt32(desc.format);
+    WriteUInt32(desc.usage);
+    WriteUInt32(desc.loadOp);
+    WriteUInt32(desc.storeOp);
+    for (int i = 0; i < 4; i++) {
+        WriteFloat(desc.clearValue[i]);
+    }
+    WriteUInt32(desc.colorMask);
+    WriteUInt32(desc.blendEnabled);
+    WriteUInt32(desc.srcColorBlendFactor);
+    WriteUInt32(desc.dstColorBlendFactor);
+    WriteUInt32(desc.colorBlendOp);
+    WriteUInt32(desc.srcAlphaBlendFactor);
+    WriteUInt32(desc.dstAlphaBlendFactor);
+    WriteUInt32(desc.alphaBlendOp);
+    for (int i = 0; i < 4; i++) {
+        WriteFloat(desc.blendConstantColor[i]);
+    }
+}
+
+std::vector<uint8_t> const&
+BgiCommandStreamWriter::GetData() const
+{
+    return _data;
+}
+
+void
+BgiCommandStreamWriter::Clear()
+{
+    _data.clear();
+}
+
+//
+// Reader
+//
+
+BgiCommandStreamReader::BgiCommandStreamReader(
+    const uint8_t* data,
+    size_t byteSize)
+    : _data(data)
+    , _byteSize(byteSize)
+    , _offset(0)
+    , _failed(false)
+{
+}
+
+bool
+BgiCommandStreamReader::Read(void* data, size_t byteSize)
+{
+    if (_failed || byteSize > _byteSize - _offset) {
+        _failed = true;
+        memset(data, 0, byteSize);
+        return false;
+    }
+    memcpy(data, _data + _offset, byteSize);
+    _offset += byteSize;
+    return true;
+}
+
+BgiCommandStreamOp
+BgiCommandStreamReader::ReadOp()
+{
+    uint16_t value = 0;
+    Read(&value, sizeof(value));
+    return BgiCommandStreamOp(value);
+}
+
+uint32_t
+BgiCommandStreamReader::ReadUInt32()
+{
+    uint32_t value = 0;
+    Read(&value, sizeof(value));
+    return value;
+}
+
+uint64_t
+BgiCommandStreamReader::ReadUInt64()
+{
+    uint64_t value = 0;
+    Read(&value, sizeof(value));
+    return value;
+}
+
+float
+BgiCommandStreamReader::ReadFloat()
+{
+    float value = 0;
+    Read(&value, sizeof(value));
+    return value;
+}
+
+std::string
+BgiCommandStreamReader::ReadString()
+{
+    size_t size = ReadUInt32();
+    const uint8_t* str = nullptr;
+    if (!_failed && size <= _byteSize - _offset) {
+        str = _data + _offset;
+        _offset += size;
+    } else {
+        _failed = true;
+        size = 0;
+    }
+    return std::string(reinterpret_cast<const char*>(str), size);
+}
+
+std::vector<uint32_t>
+BgiCommandStreamReader::ReadUInt32Vector()
+{
+    uint32_t const count = ReadUInt32();
+    if (_failed || count > (_byteSize - _offset) / sizeof(uint32_t)) {
+        _failed = true;
+        return std::vector<uint32_t>();
+    }
+    std::vector<uint32_t> values(count);
+    Read(values.data(), count * sizeof(uint32_t));
+    return values;
+}
+
+const uint8_t*
+BgiCommandStreamReader::ReadBytes(size_t* byteSize)
+{
+    uint64_t const size = ReadUInt64();
+    if (_failed || size > _byteSize - _offset) {
+        _failed = true;
+        *byteSize = 0;
+        return nullptr;
+    }
+    const uint8_t* bytes = _data + _offset;
+    _offset += size;
+    *byteSize = size;
+    return size ? bytes : nullptr;
+}
+
+BgiAttachmentDesc
+BgiCommandStreamReader::ReadAttachmentDesc()
+{
+    BgiAttachmentDesc desc;
+    desc.format = BgiFormat(ReadUInt32());
+    desc.usage = ReadUInt32();
+    desc.loadOp = BgiAttachmentLoadOp(ReadUInt32());
+    desc.storeOp = BgiAttachmentStoreOp(ReadUInt32());
+    for (int i = 0; i < 4; i++) {
+        desc.clearValue[i] = ReadFloat();
+    }
+    desc.colorMask = ReadUInt32();
+    desc.blendEnabled = ReadUInt32() != 0;
+    desc.srcColorBlendFactor = BgiBlendFactor(ReadUInt32());
+    desc.dstColorBlendFactor = BgiBlendFactor(ReadUInt32());
+    desc.colorBlendOp = BgiBlendOp(ReadUInt32());
+    desc.srcAlphaBlendFactor = BgiBlendFactor(ReadUInt32());
+    desc.dstAlphaBlendFactor = BgiBlendFactor(ReadUInt32());
+    desc.alphaBlendOp = BgiBlendOp(ReadUInt32());
+    for (int i = 0; i < 4; i++) {
+        desc.blendConstantColor[i] = ReadFloat();
+    }
+    return desc;
+}
+
+bool
+BgiCommandStreamReader::IsAtEnd() const
+{
+    return _offset == _byteSize;
+}
+
+bool
+BgiCommandStreamReader::HasFailed() const
+{
+    return _failed;
+}
+
+//
+// Replay
+//
+
+static Vector3i
+_ReadVector3i(BgiCommandStreamReader* reader)
+{
+    Vector3i v;
+    for (int i = 0; i < 3; i++) {
+        v[i] = (int) reader->ReadUInt32();
+    }
+    return v;
+}
+
+static Vector4i
+_ReadVector4i(BgiCommandStreamReader* reader)
+{
+    Vector4i v;
+    for (int i = 0; i < 4; i++) {
+        v[i] = (int) reader->ReadUInt32();
+    }
+    return v;
+}
+
+// Replays the operations all cmds types share. Returns false if 'op' is not
+// one of them.
+template <class CmdsT>
+static bool
+_ReplayCommonOp(
+    CmdsT* cmds,
+    BgiCommandStreamOp op,
+    BgiCommandStreamReader* reader)
+{
+    switch (op) {
+    case BgiCommandStreamOpPushDebugGroup: {
+        std::string const label = reader->ReadString();
+        cmds->PushDebugGroup(label.c_str());
+        return true;
+    }
+    case BgiCommandStreamOpPopDebugGroup:
+        cmds->PopDebugGroup();
+        return true;
+    case BgiCommandStreamOpInsertMemoryBarrier:
+        cmds->InsertMemoryBarrier(reader->ReadUInt32());
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Replays the query operations of graphics and compute cmds. Returns false
+// if 'op' is not one of them.
+template <class CmdsT>
+static bool
+_ReplayQueryOp(
+    CmdsT* cmds,
+    BgiCommandStreamOp op,
+    BgiCommandStreamReader* reader,
+    BgiCommandStreamResources const& resources)
+{
+    switch (op) {
+    case BgiCommandStreamOpResetQueries:
+    case BgiCommandStreamOpBeginQuery:
+    case BgiCommandStreamOpEndQuery:
+    case BgiCommandStreamOpWriteTimestamp:
+    case BgiCommandStreamOpResolveQueries:
+        break;
+    default:
+        return false;
+    }
+
+    BgiQueryPoolHandle pool;
+    bool ok = _Resolve(resources.queryPools, reader->ReadUInt64(), &pool);
+    ok &= bool(pool);
+
+    switch (op) {
+    case BgiCommandStreamOpResetQueries: {
+        uint32_t const firstQuery = reader->ReadUInt32();
+        uint32_t const queryCount = reader->ReadUInt32();
+        if (ok) {
+            cmds->ResetQueries(pool, firstQuery, queryCount);
+        }
+        break;
+    }
+    case BgiCommandStreamOpBeginQuery: {
+        uint32_t const query = reader->ReadUInt32();
+        if (ok) {
+            cmds->BeginQuery(pool, query);
+        }
+        break;
+    }
+    case BgiCommandStreamOpEndQuery: {
+        uint32_t const query = reader->ReadUInt32();
+        if (ok) {
+            cmds->EndQuery(pool, query);
+        }
+        break;
+    }
+    case BgiCommandStreamOpWriteTimestamp: {
+        uint32_t const query = reader->ReadUInt32();
+        if (ok) {
+            cmds->WriteTimestamp(pool, query);
+        }
+        break;
+    }
+    default: {
+        uint32_t const firstQuery = reader->ReadUInt32();
+        uint32_t const queryCount = reader->ReadUInt32();
+        BgiBufferHandle buffer;
+        ok &= _Resolve(resources.buffers, reader->ReadUInt64(), &buffer);
+        uint32_t const byteOffset = reader->ReadUInt32();
+        if (ok && buffer) {
+            cmds->ResolveQueries(
+                pool, firstQuery, queryCount, buffer, byteOffset);
+        }
+        break;
+    }
+    }
+    return true;
+}
+
+template <class CmdsT>
+static void
+_ReplayBindResources(
+    CmdsT* cmds,
+    BgiCommandStreamReader* reader,
+    BgiCommandStreamResources const& resources)
+{
+    BgiResourceBindingsHandle bindings;
+    bool const ok = _Resolve(
+        resources.resourceBindings, reader->ReadUInt64(), &bindings);
+    std::vector<uint32_t> const dynamicOffsets = reader->ReadUInt32Vector();
+    if (ok && bindings) {
+        cmds->BindResources(bindings, dynamicOffsets);
+    }
+}
+
+static BgiCmdsUniquePtr
+_ReplayGraphicsCmds(
+    Bgi* bgi,
+    BgiCommandStreamResources const& resources,
+    BgiCommandStreamReader* reader)
+{
+    bool ok = true;
+
+    BgiGraphicsCmdsDesc desc;
+    uint32_t const colorCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < colorCount && !reader->HasFailed(); i++) {
+        desc.colorAttachmentDescs.push_back(reader->ReadAttachmentDesc());
+    }
+    desc.depthAttachmentDesc = reader->ReadAttachmentDesc();
+
+    uint32_t const textureCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < textureCount && !reader->HasFailed(); i++) {
+        BgiTextureHandle texture;
+        ok &= _Resolve(resources.textures, reader->ReadUInt64(), &texture);
+        desc.colorTextures.push_back(texture);
+    }
+    uint32_t const resolveCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < resolveCount && !reader->HasFailed(); i++) {
+        BgiTextureHandle texture;
+        ok &= _Resolve(resources.textures, reader->ReadUInt64(), &texture);
+        desc.colorResolveTextures.push_back(texture);
+    }
+    ok &= _Resolve(
+        resources.textures, reader->ReadUInt64(), &desc.depthTexture);
+    ok &= _Resolve(
+        resources.textures, reader->ReadUInt64(), &desc.depthResolveTexture);
+
+    // Without its attachments none of the draws can be replayed.
+    if (!ok || reader->HasFailed()) {
+        return nullptr;
+    }
+
+    BgiGraphicsCmdsUniquePtr cmds = bgi->CreateGraphicsCmds(desc);
+
+    while (!reader->IsAtEnd() && !reader->HasFailed()) {
+        BgiCommandStreamOp const op = reader->ReadOp();
+        if (_ReplayCommonOp(cmds.get(), op, reader) ||
+            _ReplayQueryOp(cmds.get(), op, reader, resources)) {
+            continue;
+        }
+
+        switch (op) {
+        case BgiCommandStreamOpBindResources:
+            _ReplayBindResources(cmds.get(), reader, resources);
+            break;
+        case BgiCommandStreamOpSetViewport:
+            cmds->SetViewport(_ReadVector4i(reader));
+            break;
+        case BgiCommandStreamOpSetScissor:
+            cmds->SetScissor(_ReadVector4i(reader));
+            break;
+        case BgiCommandStreamOpBindGraphicsPipeline: {
+            BgiGraphicsPipelineHandle pipeline;
+            if (_Resolve(resources.graphicsPipelines, reader->ReadUInt64(),
+                    &pipeline) && pipeline) {
+                cmds->BindPipeline(pipeline);
+            }
+            break;
+        }
+        case BgiCommandStreamOpSetGraphicsConstantValues: {
+            BgiGraphicsPipelineHandle pipeline;
+            ok = _Resolve(resources.graphicsPipelines, reader->ReadUInt64(),
+                &pipeline);
+            BgiShaderStage const stages = reader->ReadUInt32();
+            uint32_t const bindIndex = reader->ReadUInt32();
+            uint32_t const byteOffset = reader->ReadUInt32();
+            size_t byteSize = 0;
+            const uint8_t* data = reader->ReadBytes(&byteSize);
+            if (ok && data) {
+                cmds->SetConstantValues(pipeline, stages, bindIndex,
+                    byteOffset, (uint32_t) byteSize, data);
+            }
+            break;
+        }
+        case BgiCommandStreamOpBindVertexBuffers: {
+            ok = true;
+            BgiVertexBufferBindingVector bindings;
+            uint32_t const count = reader->ReadUInt32();
+            for (uint32_t i = 0; i < count && !reader->HasFailed(); i++) {
+                BgiBufferHandle buffer;
+                ok &= _Resolve(resources.buffers, reader->ReadUInt64(),
+                    &buffer);
+                uint32_t const byteOffset = reader->ReadUInt32();
+                uint32_t const index = reader->ReadUInt32();
+                bindings.emplace_back(buffer, byteOffset, index);
+            }
+            if (ok) {
+                cmds->BindVertexBuffers(bindings);
+            }
+            break;
+        }
+        case BgiCommandStreamOpDraw: {
+            uint32_t const vertexCount = reader->ReadUInt32();
+            uint32_t const baseVertex = reader->ReadUInt32();
+            uint32_t const instanceCount = reader->ReadUInt32();
+            uint32_t const baseInstance = reader->ReadUInt32();
+            cmds->Draw(vertexCount, baseVertex, instanceCount, baseInstance);
+            break;
+        }
+        case BgiCommandStreamOpDrawIndirect: {
+            BgiBufferHandle drawBuffer;
+            ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &drawBuffer);
+            uint32_t const byteOffset = reader->ReadUInt32();
+            uint32_t const drawCount = reader->ReadUInt32();
+            uint32_t const stride = reader->ReadUInt32();
+            if (ok && drawBuffer) {
+                cmds->DrawIndirect(drawBuffer, byteOffset, drawCount, stride);
+            }
+            break;
+        }
+        case BgiCommandStreamOpDrawIndexed: {
+            BgiBufferHandle indexBuffer;
+            ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &indexBuffer);
+            uint32_t const indexCount = reader->ReadUInt32();
+            uint32_t const byteOffset = reader->ReadUInt32();
+            uint32_t const baseVertex = reader->ReadUInt32();
+            uint32_t const instanceCount = reader->ReadUInt32();
+            uint32_t const baseInstance = reader->ReadUInt32();
+            if (ok && indexBuffer) {
+                cmds->DrawIndexed(indexBuffer, indexCount, byteOffset,
+                    baseVertex, instanceCount, baseInstance);
+            }
+            break;
+        }
+        case BgiCommandStreamOpDrawIndexedIndirect: {
+            BgiBufferHandle indexBuffer;
+            BgiBufferHandle drawBuffer;
+            ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &indexBuffer);
+            ok &= _Resolve(resources.buffers, reader->ReadUInt64(),
+                &drawBuffer);
+            uint32_t const byteOffset = reader->ReadUInt32();
+            uint32_t const drawCount = reader->ReadUInt32();
+            uint32_t const stride = reader->ReadUInt32();
+            std::vector<uint32_t> const drawParameters =
+                reader->ReadUInt32Vector();
+            uint32_t const patchBaseVertexByteOffset = reader->ReadUInt32();
+            if (ok && indexBuffer && drawBuffer) {
+                cmds->DrawIndexedIndirect(indexBuffer, drawBuffer, byteOffset,
+                    drawCount, stride, drawParameters,
+                    patchBaseVertexByteOffset);
+            }
+            break;
+        }
+        case BgiCommandStreamOpDrawIndirectCount: {
+            BgiBufferHandle drawBuffer;
+            BgiBufferHandle countBuffer;
+            ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &drawBuffer);
+            uint32_t const byteOffset = reader->ReadUInt32();
+            ok &= _Resolve(resources.buffers, reader->ReadUInt64(),
+                &countBuffer);
+            uint32_t const countByteOffset = reader->ReadUInt32();
+            uint32_t const maxDrawCount = reader->ReadUInt32();
+            uint32_t const stride = reader->ReadUInt32();
+            if (ok && drawBuffer && countBuffer) {
+                cmds->DrawIndirectCount(drawBuffer, byteOffset, countBuffer,
+                    countByteOffset, maxDrawCount, stride);
+            }
+            break;
+        }
+        case BgiCommandStreamOpDrawIndexedIndirectCount: {
+            BgiBufferHandle indexBuffer;
+            BgiBufferHandle drawBuffer;
+            BgiBufferHandle countBuffer;
+            ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &indexBuffer);
+            ok &= _Resolve(resources.buffers, reader->ReadUInt64(),
+                &drawBuffer);
+            uint32_t const byteOffset = reader->ReadUInt32();
+            ok &= _Resolve(resources.buffers, reader->ReadUInt64(),
+                &countBuffer);
+            uint32_t const countByteOffset = reader->ReadUInt32();
+            uint32_t const maxDrawCount = reader->ReadUInt32();
+            uint32_t const stride = reader->ReadUInt32();
+            if (ok && indexBuffer && drawBuffer && countBuffer) {
+                cmds->DrawIndexedIndirectCount(indexBuffer, drawBuffer,
+                    byteOffset, countBuffer, countByteOffset, maxDrawCount,
+                    stride);
+            }
+            break;
+        }
+        case BgiCommandStreamOpBeginConditionalRendering: {
+            BgiBufferHandle buffer;
+            ok = _Resolve(resources.buffers, reader->ReadUInt64(), &buffer);
+            uint32_t const byteOffset = reader->ReadUInt32();
+            bool const inverted = reader->ReadUInt32() != 0;
+            // Without the predicate the block can neither be skipped nor
+            // ended, so the cmds can not be replayed.
+            if (!ok || !buffer) {
+                return nullptr;
+            }
+            cmds->BeginConditionalRendering(buffer, byteOffset, inverted);
+            break;
+        }
+        case BgiCommandStreamOpEndConditionalRendering:
+            cmds->EndConditionalRendering();
+            break;
+        default:
+            UTILS_CODING_ERROR("Unexpected graphics command stream op %u",
+                (unsigned) op);
+            return nullptr;
+        }
+    }
+
+    return cmds;
+}
+
+static BgiCmdsUniquePtr
+_ReplayComputeCmds(
+    Bgi* bgi,
+    BgiCommandStreamResources const& resources,
+    BgiCommandStreamReader* reader)
+{
+    BgiComputeCmdsDesc desc;
+    desc.dispatchMethod = BgiComputeDispatch(reader->ReadUInt32());
+    if (reader->HasFailed()) {
+        return nullptr;
+    }
+
+    BgiComputeCmdsUniquePtr cmds = bgi->CreateComputeCmds(desc);
+
+    while (!reader->IsAtEnd() && !reader->HasFailed()) {
+        BgiCommandStreamOp const op = reader->ReadOp();
+        if (_ReplayCommonOp(cmds.get(), op, reader) ||
+            _ReplayQueryOp(cmds.get(), op, reader, resources)) {
+            continue;
+        }
+
+        switch (op) {
+        case BgiCommandStreamOpBindResources:
+            _ReplayBindResources(cmds.get(), reader, resources);
+            break;
+        case BgiCommandStreamOpBindComputePipeline: {
+            BgiComputePipelineHandle pipeline;
+            if (_Resolve(resources.computePipelines, reader->ReadUInt64(),
+                    &pipeline) && pipeline) {
+                cmds->BindPipeline(pipeline);
+            }
+            break;
+        }
+        case BgiCommandStreamOpSetComputeConstantValues: {
+            BgiComputePipelineHandle pipeline;
+            bool const ok = _Resolve(resources.computePipelines,
+                reader->ReadUInt64(), &pipeline);
+            uint32_t const bindIndex = reader->ReadUInt32();
+            uint32_t const byteOffset = reader->ReadUInt32();
+            size_t byteSize = 0;
+            const uint8_t* data = reader->ReadBytes(&byteSize);
+            if (ok && data) {
+                cmds->SetConstantValues(pipeline, bindIndex, byteOffset,
+                    (uint32_t) byteSize, data);
+            }
+            break;
+        }
+        case BgiCommandStreamOpDispatch: {
+            int const dimX = (int) reader->ReadUInt32();
+            int const dimY = (int) reader->ReadUInt32();
+            int const dimZ = (int) reader->ReadUInt32();
+            cmds->Dispatch(dimX, dimY, dimZ);
+            break;
+        }
+        case BgiCommandStreamOpDispatchIndirect: {
+            BgiBufferHandle buffer;
+            bool const ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &buffer);
+            uint32_t const byteOffset = reader->ReadUInt32();
+            if (ok && buffer) {
+                cmds->DispatchIndirect(buffer, byteOffset);
+            }
+            break;
+        }
+        default:
+            UTILS_CODING_ERROR("Unexpected compute command stream op %u",
+                (unsigned) op);
+            return nullptr;
+        }
+    }
+
+    return cmds;
+}
+
+static BgiCmdsUniquePtr
+_ReplayBlitCmds(
+    Bgi* bgi,
+    BgiCommandStreamResources const& resources,
+    BgiCommandStreamReader* reader,
+    std::vector<uint8_t>* readbacks)
+{
+    BgiBlitCmdsUniquePtr cmds = bgi->CreateBlitCmds();
+
+    // GPU to CPU copies are read back into consecutive ranges of
+    // 'readbacks', in the order they were recorded.
+    size_t readbackOffset = 0;
+
+    while (!reader->IsAtEnd() && !reader->HasFailed()) {
+        BgiCommandStreamOp const op = reader->ReadOp();
+        if (_ReplayCommonOp(cmds.get(), op, reader)) {
+            continue;
+        }
+
+        switch (op) {
+        case BgiCommandStreamOpCopyTextureGpuToCpu: {
+            BgiTextureGpuToCpuOp copyOp;
+            bool const ok = _Resolve(resources.textures, reader->ReadUInt64(),
+                &copyOp.gpuSourceTexture);
+            copyOp.sourceTexelOffset = _ReadVector3i(reader);
+            copyOp.mipLevel = reader->ReadUInt32();
+            copyOp.destinationByteOffset = reader->ReadUInt64();
+            copyOp.destinationBufferByteSize = reader->ReadUInt64();
+            if (copyOp.destinationBufferByteSize >
+                    readbacks->size() - readbackOffset) {
+                UTILS_CODING_ERROR("Command stream readback out of range");
+                return nullptr;
+            }
+            copyOp.cpuDestinationBuffer = readbacks->data() + readbackOffset;
+            readbackOffset += copyOp.destinationBufferByteSize;
+            if (ok && copyOp.gpuSourceTexture) {
+                cmds->CopyTextureGpuToCpu(copyOp);
+            }
+            break;
+        }
+        case BgiCommandStreamOpCopyTextureCpuToGpu: {
+            BgiTextureCpuToGpuOp copyOp;
+            copyOp.cpuSourceBuffer = reader->ReadBytes(&copyOp.bufferByteSize);
+            copyOp.destinationTexelOffset = _ReadVector3i(reader);
+            copyOp.mipLevel = reader->ReadUInt32();
+            bool const ok = _Resolve(resources.textures, reader->ReadUInt64(),
+                &copyOp.gpuDestinationTexture);
+            if (ok && copyOp.gpuDestinationTexture) {
+                cmds->CopyTextureCpuToGpu(copyOp);
+            }
+            break;
+        }
+        case BgiCommandStreamOpCopyBufferGpuToGpu: {
+            BgiBufferGpuToGpuOp copyOp;
+            bool ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &copyOp.gpuSourceBuffer);
+            copyOp.sourceByteOffset = reader->ReadUInt64();
+            copyOp.byteSize = reader->ReadUInt64();
+            ok &= _Resolve(resources.buffers, reader->ReadUInt64(),
+                &copyOp.gpuDestinationBuffer);
+            copyOp.destinationByteOffset = reader->ReadUInt64();
+            if (ok && copyOp.gpuSourceBuffer && copyOp.gpuDestinationBuffer) {
+                cmds->CopyBufferGpuToGpu(copyOp);
+            }
+            break;
+        }
+        case BgiCommandStreamOpCopyBufferCpuToGpu: {
+            BgiBufferCpuToGpuOp copyOp;
+            copyOp.cpuSourceBuffer = reader->ReadBytes(&copyOp.byteSize);
+            bool const ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &copyOp.gpuDestinationBuffer);
+            copyOp.destinationByteOffset = reader->ReadUInt64();
+            if (ok && copyOp.gpuDestinationBuffer) {
+                cmds->CopyBufferCpuToGpu(copyOp);
+            }
+            break;
+        }
+        case BgiCommandStreamOpCopyBufferGpuToCpu: {
+            BgiBufferGpuToCpuOp copyOp;
+            bool const ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &copyOp.gpuSourceBuffer);
+            copyOp.sourceByteOffset = reader->ReadUInt64();
+            copyOp.byteSize = reader->ReadUInt64();
+            if (copyOp.byteSize > readbacks->size() - readbackOffset) {
+                UTILS_CODING_ERROR("Command stream readback out of range");
+                return nullptr;
+            }
+            copyOp.cpuDestinationBuffer = readbacks->data() + readbackOffset;
+            readbackOffset += copyOp.byteSize;
+            if (ok && copyOp.gpuSourceBuffer) {
+                cmds->CopyBufferGpuToCpu(copyOp);
+            }
+            break;
+        }
+        case BgiCommandStreamOpCopyTextureToBuffer: {
+            BgiTextureToBufferOp copyOp;
+            bool ok = _Resolve(resources.textures, reader->ReadUInt64(),
+                &copyOp.gpuSourceTexture);
+            copyOp.sourceTexelOffset = _ReadVector3i(reader);
+            copyOp.mipLevel = reader->ReadUInt32();
+            ok &= _Resolve(resources.buffers, reader->ReadUInt64(),
+                &copyOp.gpuDestinationBuffer);
+            copyOp.destinationByteOffset = reader->ReadUInt64();
+            copyOp.byteSize = reader->ReadUInt64();
+            if (ok && copyOp.gpuSourceTexture && copyOp.gpuDestinationBuffer) {
+                cmds->CopyTextureToBuffer(copyOp);
+            }
+            break;
+        }
+        case BgiCommandStreamOpCopyBufferToTexture: {
+            BgiBufferToTextureOp copyOp;
+            bool ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &copyOp.gpuSourceBuffer);
+            copyOp.sourceByteOffset = reader->ReadUInt64();
+            ok &= _Resolve(resources.textures, reader->ReadUInt64(),
+                &copyOp.gpuDestinationTexture);
+            copyOp.destinationTexelOffset = _ReadVector3i(reader);
+            copyOp.mipLevel = reader->ReadUInt32();
+            copyOp.byteSize = reader->ReadUInt64();
+            if (ok && copyOp.gpuSourceBuffer && copyOp.gpuDestinationTexture) {
+                cmds->CopyBufferToTexture(copyOp);
+            }
+            break;
+        }
+        case BgiCommandStreamOpGenerateMipMaps: {
+            BgiTextureHandle texture;
+            if (_Resolve(resources.textures, reader->ReadUInt64(), &texture) &&
+                    texture) {
+                cmds->GenerateMipMaps(texture);
+            }
+            break;
+        }
+        case BgiCommandStreamOpFillBuffer: {
+            BgiBufferHandle buffer;
+            bool const ok = _Resolve(resources.buffers, reader->ReadUInt64(),
+                &buffer);
+            uint8_t const value = (uint8_t) reader->ReadUInt32();
+            if (ok && buffer) {
+                cmds->FillBuffer(buffer, value);
+            }
+            break;
+        }
+        default:
+            UTILS_CODING_ERROR("Unexpected blit command stream op %u",
+                (unsigned) op);
+            return nullptr;
+        }
+    }
+
+    return cmds;
+}
+
+//
+// Stream
+//
+
+BgiCommandStream::BgiCommandStream() = default;
+
+BgiCommandStream::~BgiCommandStream() = default;
+
+BgiGraphicsCmdsUniquePtr
+BgiCommandStream::CreateGraphicsCmds(BgiGraphicsCmdsDesc const& desc)
+{
+    return BgiGraphicsCmdsUniquePtr(new BgiCommandStreamGraphicsCmds(desc));
+}
+
+BgiComputeCmdsUniquePtr
+BgiCommandStream::CreateComputeCmds(BgiComputeCmdsDesc const& desc)
+{
+    return BgiComputeCmdsUniquePtr(new BgiCommandStreamComputeCmds(desc));
+}
+
+BgiBlitCmdsUniquePtr
+BgiCommandStream::CreateBlitCmds()
+{
+    return BgiBlitCmdsUniquePtr(new BgiCommandStreamBlitCmds());
+}
+
+void
+BgiCommandStream::SubmitCmds(BgiCmds* cmds, BgiSubmitWaitType wait)
+{
+    BgiCommandStreamCmds* streamCmds =
+        dynamic_cast<BgiCommandStreamCmds*>(cmds);
+    if (!streamCmds) {
+        UTILS_CODING_ERROR("Cmds were not created by a command stream");
+        return;
+    }
+    if (cmds->IsSubmitted()) {
+        UTILS_CODING_ERROR("Cmds were already submitted");
+        return;
+    }
+
+    std::vector<uint8_t> const& data = streamCmds->GetData();
+    _AppendBlock(
+        streamCmds->GetCmdsType(),
+        wait,
+        data.data(),
+        data.size(),
+        streamCmds->GetReadbackByteSize());
+    _resources.Merge(streamCmds->GetResources());
+
+    streamCmds->_SetStreamSubmitted();
+}
+
+size_t
+BgiCommandStream::GetCmdsCount() const
+{
+    return _blocks.size();
+}
+
+BgiCommandStreamResources const&
+BgiCommandStream::GetResources() const
+{
+    return _resources;
+}
+
+BgiCmdsUniquePtr
+BgiCommandStream::ReplayCmds(
+    Bgi* bgi,
+    BgiCommandStreamResources const& resources,
+    size_t index) const
+{
+    if (!UTILS_VERIFY(bgi && index < _blocks.size())) {
+        return nullptr;
+    }
+
+    _CmdsBlock const& block = _blocks[index];
+    BgiCommandStreamReader reader(_data.data() + block.offset, block.byteSize);
+
+    BgiCmdsUniquePtr cmds;
+    switch (block.type) {
+    case BgiCommandStreamCmdsTypeGraphics:
+        cmds = _ReplayGraphicsCmds(bgi, resources, &reader);
+        break;
+    case BgiCommandStreamCmdsTypeCompute:
+        cmds = _ReplayComputeCmds(bgi, resources, &reader);
+        break;
+    case BgiCommandStreamCmdsTypeBlit:
+        cmds = _ReplayBlitCmds(bgi, resources, &reader, &_readbacks[index]);
+        break;
+    default:
+        break;
+    }
+
+    if (!cmds || reader.HasFailed()) {
+        UTILS_CODING_ERROR("Malformed command stream cmds %zu", index);
+        return nullptr;
+    }
+
+    return cmds;
+}
+
+bool
+BgiCommandStream::Replay(
+    Bgi* bgi,
+    BgiCommandStreamResources const& resources) const
+{
+    for (size_t i = 0; i < _blocks.size(); i++) {
+        BgiCmdsUniquePtr cmds = ReplayCmds(bgi, resources, i);
+        if (!cmds) {
+            return false;
+        }
+        bgi->SubmitCmds(cmds.get(), _blocks[i].wait);
+    }
+    return true;
+}
+
+bool
+BgiCommandStream::Replay(Bgi* bgi) const
+{
+    return Replay(bgi, _resources);
+}
+
+bool
+BgiCommandStream::Save(std::string const& path, Bgi* bgi) const
+{
+    BgiCommandStreamWriter manifest;
+    if (bgi) {
+        BgiCommandStreamWriteManifest(bgi, _resources, &manifest);
+    } else {
+        manifest.Write(_manifest.data(), _manifest.size());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    _StreamFileHeader header = {};
+    header.magic = _streamMagic;
+    header.version = Version;
+    header.cmdsCount = _blocks.size();
+    header.manifestByteSize = manifest.GetData().size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (_CmdsBlock const& block : _blocks) {
+        _StreamFileCmdsHeader cmdsHeader = {};
+        cmdsHeader.type = block.type;
+        cmdsHeader.wait = block.wait;
+        cmdsHeader.byteSize = block.byteSize;
+        cmdsHeader.readbackByteSize = block.readbackByteSize;
+        file.write(
+            reinterpret_cast<const char*>(&cmdsHeader), sizeof(cmdsHeader));
+        file.write(
+            reinterpret_cast<const char*>(_data.data() + block.offset),
+            block.byteSize);
+    }
+
+    file.write(
+        reinterpret_cast<const char*>(manifest.GetData().data()),
+        manifest.GetData().size());
+
+    return bool(file);
+}
+
+bool
+BgiCommandStream::Load(std::string const& path)
+{
+    Clear();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    _StreamFileHeader header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != _streamMagic ||
+        header.version != Version) {
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    for (uint64_t i = 0; i < header.cmdsCount; i++) {
+        _StreamFileCmdsHeader cmdsHeader = {};
+        if (!file.read(
+                reinterpret_cast<char*>(&cmdsHeader), sizeof(cmdsHeader)) ||
+            cmdsHeader.type >= BgiCommandStreamCmdsTypeCount) {
+            Clear();
+            return false;
+        }
+
+        data.resize(cmdsHeader.byteSize);
+        if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+            Clear();
+            return false;
+        }
+
+        _AppendBlock(
+            BgiCommandStreamCmdsType(cmdsHeader.type),
+            BgiSubmitWaitType(cmdsHeader.wait),
+            data.data(),
+            data.size(),
+            cmdsHeader.readbackByteSize);
+    }
+
+    _manifest.resize(header.manifestByteSize);
+    if (!file.read(reinterpret_cast<char*>(_manifest.data()),
+            _manifest.size())) {
+        Clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool
+BgiCommandStream::HasManifest() const
+{
+    return !_manifest.empty();
+}
+
+bool
+BgiCommandStream::CreateResources(
+    Bgi* bgi,
+    BgiCommandStreamResources* resources) const
+{
+    if (!UTILS_VERIFY(bgi && resources) || _manifest.empty()) {
+        return false;
+    }
+
+    BgiCommandStreamReader reader(_manifest.data(), _manifest.size());
+    if (!BgiCommandStreamReadManifest(bgi, &reader, resources)) {
+        UTILS_WARN("Malformed command stream resource manifest");
+        DestroyResources(bgi, resources);
+        return false;
+    }
+    return true;
+}
+
+template <class T>
+static void
+_DestroyHandles(
+    Bgi* bgi,
+    void (Bgi::*destroy)(T*),
+    std::unordered_map<uint64_t, T>* handles)
+{
+    for (auto& it : *handles) {
+        if (it.second) {
+            (bgi->*destroy)(&it.second);
+        }
+    }
+    handles->clear();
+}
+
+void
+BgiCommandStream::DestroyResources(
+    Bgi* bgi,
+    BgiCommandStreamResources* resources)
+{
+    // Destroy the resources before the ones they refer to.
+    _DestroyHandles(bgi, &Bgi::DestroyGraphicsPipeline,
+        &resources->graphicsPipelines);
+    _DestroyHandles(bgi, &Bgi::DestroyComputePipeline,
+        &resources->computePipelines);
+    _DestroyHandles(bgi, &Bgi::DestroyResourceBindings,
+        &resources->resourceBindings);
+    _DestroyHandles(bgi, &Bgi::DestroyQueryPool, &resources->queryPools);
+    _DestroyHandles(bgi, &Bgi::DestroyTexture, &resources->textures);
+    _DestroyHandles(bgi, &Bgi::DestroyBuffer, &resources->buffers);
+    _DestroyHandles(bgi, &Bgi::DestroySampler, &resources->samplers);
+    _DestroyHandles(bgi, &Bgi::DestroyShaderProgram,
+        &resources->shaderPrograms);
+    _DestroyHandles(bgi, &Bgi::DestroyShaderFunction,
+        &resources->shaderFunctions);
+}
+
+void
+BgiCommandStream::Clear()
+{
+    _data.clear();
+    _blocks.clear();
+    _readbacks.clear();
+    _resources.Clear();
+    _manifest.clear();
+}
+
+void
+BgiCommandStream::_AppendBlock(
+    BgiCommandStreamCmdsType type,
+    BgiSubmitWaitType wait,
+    const uint8_t* data,
+    size_t byteSize,
+    size_t readbackByteSize)
+{
+    _blocks.push_back({type, wait, _data.size(), byteSize, readbackByteSize});
+    _data.insert(_data.end(), data, data + byteSize);
+    _readbacks.emplace_back(readbackByteSize);
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,423 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/api.h"
+#include "driver/bgiBase/attachmentDesc.h"
+#include "driver/bgiBase/blitCmds.h"
+#include "driver/bgiBase/computeCmds.h"
+#include "driver/bgiBase/computeCmdsDesc.h"
+#include "driver/bgiBase/enums.h"
+#include "driver/bgiBase/graphicsCmds.h"
+#include "driver/bgiBase/graphicsCmdsDesc.h"
+#include "driver/bgiBase/sampler.h"
+#include "driver/bgiBase/shaderFunction.h"
+#include "driver/bgiBase/shaderProgram.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class Bgi;
+
+/// \enum BgiCommandStreamCmdsType
+///
+/// The type of cmds object a block of a command stream was recorded from.
+///
+enum BgiCommandStreamCmdsType : uint32_t
+{
+    BgiCommandStreamCmdsTypeGraphics = 0,
+    BgiCommandStreamCmdsTypeCompute,
+    BgiCommandStreamCmdsTypeBlit,
+
+    BgiCommandStreamCmdsTypeCount
+};
+
+/// \enum BgiCommandStreamOp
+///
+/// The operations of a command stream. Each operation is encoded as its op
+/// followed by its arguments. The values are part of the stream format, so
+/// new operations must be added at the end.
+///
+enum BgiCommandStreamOp : uint16_t
+{
+    BgiCommandStreamOpPushDebugGroup = 0,
+    BgiCommandStreamOpPopDebugGroup,
+    BgiCommandStreamOpInsertMemoryBarrier,
+    BgiCommandStreamOpBindResources,
+
+    // Graphics
+    BgiCommandStreamOpSetViewport,
+    BgiCommandStreamOpSetScissor,
+    BgiCommandStreamOpBindGraphicsPipeline,
+    BgiCommandStreamOpSetGraphicsConstantValues,
+    BgiCommandStreamOpBindVertexBuffers,
+    BgiCommandStreamOpDraw,
+    BgiCommandStreamOpDrawIndirect,
+    BgiCommandStreamOpDrawIndexed,
+    BgiCommandStreamOpDrawIndexedIndirect,
+    BgiCommandStreamOpDrawIndirectCount,
+    BgiCommandStreamOpDrawIndexedIndirectCount,
+
+    // Compute
+    BgiCommandStreamOpBindComputePipeline,
+    BgiCommandStreamOpSetComputeConstantValues,
+    BgiCommandStreamOpDispatch,
+    BgiCommandStreamOpDispatchIndirect,
+
+    // Blit
+    BgiCommandStreamOpCopyTextureGpuToCpu,
+    BgiCommandStreamOpCopyTextureCpuToGpu,
+    BgiCommandStreamOpCopyBufferGpuToGpu,
+    BgiCommandStreamOpCopyBufferCpuToGpu,
+    BgiCommandStreamOpCopyBufferGpuToCpu,
+    BgiCommandStreamOpCopyTextureToBuffer,
+    BgiCommandStreamOpCopyBufferToTexture,
+    BgiCommandStreamOpGenerateMipMaps,
+    BgiCommandStreamOpFillBuffer,
+
+    // Queries
+    BgiCommandStreamOpResetQueries,
+    BgiCommandStreamOpBeginQuery,
+    BgiCommandStreamOpEndQuery,
+    BgiCommandStreamOpWriteTimestamp,
+    BgiCommandStreamOpResolveQueries,
+
+    // Conditional rendering
+    BgiCommandStreamOpBeginConditionalRendering,
+    BgiCommandStreamOpEndConditionalRendering,
+
+    BgiCommandStreamOpCount
+};
+
+/// \struct BgiCommandStreamResources
+///
+/// The resources a command stream refers to, by the id of their handle.
+/// Recording gathers the resources of the stream. To replay a stream that
+/// was loaded from disk, the resources must be recreated and added under the
+/// ids they had when the stream was recorded, which
+/// BgiCommandStream::CreateResources does.
+///
+/// Samplers, shader functions and shader programs are only referred to
+/// through other resources. They are held so that recreated resources can
+/// be destroyed.
+///
+struct BgiCommandStreamResources
+{
+    BGI_API
+    void Add(BgiBufferHandle const& buffer);
+
+    BGI_API
+    void Add(BgiTextureHandle const& texture);
+
+    BGI_API
+    void Add(BgiGraphicsPipelineHandle const& pipeline);
+
+    BGI_API
+    void Add(BgiComputePipelineHandle const& pipeline);
+
+    BGI_API
+    void Add(BgiResourceBindingsHandle const& resourceBindings);
+
+    BGI_API
+    void Add(BgiQueryPoolHandle const& queryPool);
+
+    BGI_API
+    void Add(BgiSamplerHandle const& sampler);
+
+    BGI_API
+    void Add(BgiShaderFunctionHandle const& shaderFunction);
+
+    BGI_API
+    void Add(BgiShaderProgramHandle const& shaderProgram);
+
+    /// Adds all resources of 'other'.
+    BGI_API
+    void Merge(BgiCommandStreamResources const& other);
+
+    BGI_API
+    void Clear();
+
+    std::unordered_map<uint64_t, BgiBufferHandle> buffers;
+    std::unordered_map<uint64_t, BgiTextureHandle> textures;
+    std::unordered_map<uint64_t, BgiGraphicsPipelineHandle> graphicsPipelines;
+    std::unordered_map<uint64_t, BgiComputePipelineHandle> computePipelines;
+    std::unordered_map<uint64_t, BgiResourceBindingsHandle> resourceBindings;
+    std::unordered_map<uint64_t, BgiQueryPoolHandle> queryPools;
+    std::unordered_map<uint64_t, BgiSamplerHandle> samplers;
+    std::unordered_map<uint64_t, BgiShaderFunctionHandle> shaderFunctions;
+    std::unordered_map<uint64_t, BgiShaderProgramHandle> shaderPrograms;
+};
+
+/// \class BgiCommandStreamWriter
+///
+/// Appends values to the bytes of a command stream, in native byte order.
+///
+class BgiCommandStreamWriter
+{
+public:
+    BGI_API
+    BgiCommandStreamWriter();
+
+    BGI_API
+    void Write(const void* data, size_t byteSize);
+
+    BGI_API
+    void WriteOp(BgiCommandStreamOp op);
+
+    BGI_API
+    void WriteUInt32(uint32_t value);
+
+    BGI_API
+    void WriteUInt64(uint64_t value);
+
+    BGI_API
+    void WriteFloat(float value);
+
+    /// Writes the size of the string followed by its characters.
+    BGI_API
+    void WriteString(const char* str);
+
+    /// Writes the size of 'values' followed by the values.
+    BGI_API
+    void WriteUInt32Vector(std::vector<uint32_t> const& values);
+
+    /// Writes 'byteSize' followed by the bytes of 'data'.
+    BGI_API
+    void WriteBytes(const void* data, size_t byteSize);
+
+    BGI_API
+    void WriteAttachmentDesc(BgiAttachmentDesc const& desc);
+
+    BGI_API
+    std::vector<uint8_t> const& GetData() const;
+
+    BGI_API
+    void Clear();
+
+private:
+    std::vector<uint8_t> _data;
+};
+
+/// \class BgiCommandStreamReader
+///
+/// Reads the values written by BgiCommandStreamWriter. Reading past the end
+/// of the bytes fails the reader and returns zeros from then on.
+///
+class BgiCommandStreamReader
+{
+public:
+    BGI_API
+    BgiCommandStreamReader(const uint8_t* data, size_t byteSize);
+
+    BGI_API
+    bool Read(void* data, size_t byteSize);
+
+    BGI_API
+    BgiCommandStreamOp ReadOp();
+
+    BGI_API
+    uint32_t ReadUInt32();
+
+    BGI_API
+    uint64_t ReadUInt64();
+
+    BGI_API
+    float ReadFloat();
+
+    BGI_API
+    std::string ReadString();
+
+    BGI_API
+    std::vector<uint32_t> ReadUInt32Vector();
+
+    /// Returns a pointer to the bytes written by WriteBytes and their size in
+    /// 'byteSize'. The pointer stays valid as long as the stream data.
+    BGI_API
+    const uint8_t* ReadBytes(size_t* byteSize);
+
+    BGI_API
+    BgiAttachmentDesc ReadAttachmentDesc();
+
+    /// Returns true if all bytes were read.
+    BGI_API
+    bool IsAtEnd() const;
+
+    /// Returns true if a read went past the end of the bytes.
+    BGI_API
+    bool HasFailed() const;
+
+private:
+    const uint8_t* _data;
+    size_t _byteSize;
+    size_t _offset;
+    bool _failed;
+};
+
+/// \class BgiCommandStream
+///
+/// A backend independent recording of the operations of graphics, compute
+/// and blit cmds.
+///
+/// Cmds objects created by the stream encode their operations into a
+/// compact binary form instead of translating them to a graphics API.
+/// Resources are referred to by the id of their handle. Submitting such
+/// cmds to the stream appends their operations as one block. The stream
+/// can then be replayed into any Bgi backend, or saved to disk and loaded
+/// again.
+///
+/// Recording only writes into memory of the recording cmds object, so cmds
+/// can be recorded on any thread, like the cmds of a Bgi. Each block can be
+/// translated independently by ReplayCmds, so blocks may be translated in
+/// parallel and then submitted in order.
+///
+/// CPU data of uploads is copied into the stream. GPU to CPU copies read
+/// back into memory owned by the stream, which must therefore outlive the
+/// GPU work of a replay.
+///
+/// A saved stream can carry a manifest of its resources, so that it can be
+/// replayed without the application that recorded it, as the replay tool
+/// does: the descriptors of the resources, the shader code of their shader
+/// functions and the contents of buffers and of the first mip of textures.
+/// Texture views are recreated as textures of their own, and multisampled
+/// and depth stencil textures start out undefined.
+///
+class BgiCommandStream final
+{
+public:
+    /// The version of the stream format. Streams of another version can
+    /// not be loaded.
+    static constexpr uint32_t Version = 2;
+
+    BGI_API
+    BgiCommandStream();
+
+    BGI_API
+    ~BgiCommandStream();
+
+    /// Returns a graphics cmds object that records into the stream.
+    BGI_API
+    BgiGraphicsCmdsUniquePtr CreateGraphicsCmds(
+        BgiGraphicsCmdsDesc const& desc);
+
+    /// Returns a compute cmds object that records into the stream.
+    BGI_API
+    BgiComputeCmdsUniquePtr CreateComputeCmds(BgiComputeCmdsDesc const& desc);
+
+    /// Returns a blit cmds object that records into the stream.
+    BGI_API
+    BgiBlitCmdsUniquePtr CreateBlitCmds();
+
+    /// Appends the operations recorded into 'cmds' as a new block.
+    /// 'cmds' must have been created by this stream. 'wait' is used when the
+    /// block is replayed.
+    /// Thread safety: Not thread safe, like Bgi::SubmitCmds.
+    BGI_API
+    void SubmitCmds(
+        BgiCmds* cmds,
+        BgiSubmitWaitType wait = BgiSubmitWaitTypeNoWait);
+
+    /// Returns the number of blocks of cmds in the stream.
+    BGI_API
+    size_t GetCmdsCount() const;
+
+    /// Returns the resources gathered while recording.
+    BGI_API
+    BgiCommandStreamResources const& GetResources() const;
+
+    /// Translates block 'index' into a new cmds object of 'bgi', without
+    /// submitting it. Returns nullptr if the block is malformed.
+    /// Thread safety: Different blocks may be translated concurrently.
+    BGI_API
+    BgiCmdsUniquePtr ReplayCmds(
+        Bgi* bgi,
+        BgiCommandStreamResources const& resources,
+        size_t index) const;
+
+    /// Translates and submits all blocks in order.
+    /// Returns false if a block is malformed.
+    BGI_API
+    bool Replay(Bgi* bgi, BgiCommandStreamResources const& resources) const;
+
+    /// Replays the stream with the resources gathered while recording.
+    BGI_API
+    bool Replay(Bgi* bgi) const;
+
+    /// Writes the stream to the file at 'path'.
+    ///
+    /// If 'bgi' is given, the manifest of the resources gathered while
+    /// recording is written too. The contents of buffers and textures are
+    /// read back with 'bgi', which waits for the GPU, so save the stream
+    /// before replaying it to capture the contents it starts from. Without
+    /// 'bgi', the manifest of a loaded stream is written again.
+    BGI_API
+    bool Save(std::string const& path, Bgi* bgi = nullptr) const;
+
+    /// Replaces the stream with the one in the file at 'path'. The
+    /// resources are cleared, CreateResources recreates them from the
+    /// manifest of the file.
+    BGI_API
+    bool Load(std::string const& path);
+
+    /// Returns true if the stream was loaded with a resource manifest.
+    BGI_API
+    bool HasManifest() const;
+
+    /// Creates the resources of the manifest in 'bgi' and adds them to
+    /// 'resources' under the ids they had when the stream was recorded.
+    /// Returns false, after destroying the resources created so far, if the
+    /// stream has no manifest or it is malformed.
+    BGI_API
+    bool CreateResources(
+        Bgi* bgi,
+        BgiCommandStreamResources* resources) const;
+
+    /// Destroys the resources created by CreateResources and clears
+    /// 'resources'.
+    BGI_API
+    static void DestroyResources(
+        Bgi* bgi,
+        BgiCommandStreamResources* resources);
+
+    /// Removes all blocks, resources and the manifest.
+    BGI_API
+    void Clear();
+
+private:
+    BgiCommandStream & operator=(const BgiCommandStream&) = delete;
+    BgiCommandStream(const BgiCommandStream&) = delete;
+
+    struct _CmdsBlock
+    {
+        BgiCommandStreamCmdsType type;
+        BgiSubmitWaitType wait;
+        size_t offset;
+        size_t byteSize;
+        size_t readbackByteSize;
+    };
+
+    void _AppendBlock(
+        BgiCommandStreamCmdsType type,
+        BgiSubmitWaitType wait,
+        const uint8_t* data,
+        size_t byteSize,
+        size_t readbackByteSize);
+
+    std::vector<uint8_t> _data;
+    std::vector<_CmdsBlock> _blocks;
+    BgiCommandStreamResources _resources;
+    std::vector<uint8_t> _manifest;
+
+    // Destination of the GPU to CPU copies of each block. Sized when the
+    // block is appended, so replaying different blocks never reallocates.
+    mutable std::vector<std::vector<uint8_t>> _readbacks;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,764 @@
+#include "driver/bgiBase/commandStreamCmds.h"
+#include "driver/bgiBase/blitCmdsOps.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+BgiCommandStreamCmds::BgiCommandStreamCmds(BgiCommandStreamCmdsType type)
+    : _readbackByteSize(0)
+    , _type(type)
+{
+}
+
+BgiCommandStreamCmds::~BgiCommandStreamCmds() = default;
+
+BgiCommandStreamCmdsType
+BgiCommandStreamCmds::GetCmdsType() const
+{
+    return _type;
+}
+
+std::vector<uint8_t> const&
+BgiCommandStreamCmds::GetData() const
+{
+    return _writer.GetData();
+}
+
+BgiCommandStreamResources const&
+BgiCommandStreamCmds::GetResources() const
+{
+    return _resources;
+}
+
+size_t
+BgiCommandStreamCmds::GetReadbackByteSize() const
+{
+    return _readbackByteSize;
+}
+
+void
+BgiCommandStreamCmds::_WriteHandle(BgiBufferHandle const& buffer)
+{
+    _resources.Add(buffer);
+    _writer.WriteUInt64(buffer.GetId());
+}
+
+void
+BgiCommandStreamCmds::_WriteHandle(BgiTextureHandle const& texture)
+{
+    _resources.Add(texture);
+    _writer.WriteUInt64(texture.GetId());
+}
+
+void
+BgiCommandStreamCmds::_WriteHandle(BgiGraphicsPipelineHandle const& pipeline)
+{
+    _resources.Add(pipeline);
+    _writer.WriteUInt64(pipeline.GetId());
+}
+
+void
+BgiCommandStreamCmds::_WriteHandle(BgiComputePipelineHandle const& pipeline)
+{
+    _resources.Add(pipeline);
+    _writer.WriteUInt64(pipeline.GetId());
+}
+
+void
+BgiCommandStreamCmds::_WriteHandle(
+    BgiResourceBindingsHandle const& resourceBindings)
+{
+    _resources.Add(resourceBindings);
+    _writer.WriteUInt64(resourceBindings.GetId());
+}
+
+void
+BgiCommandStreamCmds::_WriteHandle(BgiQueryPoolHandle const& queryPool)
+{
+    _resources.Add(queryPool);
+    _writer.WriteUInt64(queryPool.GetId());
+}
+
+void
+BgiCommandStreamCmds::_WritePushDebugGroup(const char* label)
+{
+    _writer.WriteOp(BgiCommandStreamOpPushDebugGroup);
+    _writer.WriteString(label);
+}
+
+void
+BgiCommandStreamCmds::_WritePopDebugGroup()
+{
+    _writer.WriteOp(BgiCommandStreamOpPopDebugGroup);
+}
+
+void
+BgiCommandStreamCmds::_WriteInsertMemoryBarrier(BgiMemoryBarrier barrier)
+{
+    _writer.WriteOp(BgiCommandStreamOpInsertMemoryBarrier);
+    _writer.WriteUInt32(barrier);
+}
+
+void
+BgiCommandStreamCmds::_WriteBindResources(
+    BgiResourceBindingsHandle const& resources,
+    std::vector<uint32_t> const& dynamicOffsets)
+{
+    _writer.WriteOp(BgiCommandStreamOpBindResources);
+    _WriteHandle(resources);
+    _writer.WriteUInt32Vector(dynamicOffsets);
+}
+
+void
+BgiCommandStreamCmds::_WriteResetQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount)
+{
+    _writer.WriteOp(BgiCommandStreamOpResetQueries);
+    _WriteHandle(queryPool);
+    _writer.WriteUInt32(firstQuery);
+    _writer.WriteUInt32(queryCount);
+}
+
+void
+BgiCommandStreamCmds::_WriteQuery(
+    BgiCommandStreamOp op,
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _writer.WriteOp(op);
+    _WriteHandle(queryPool);
+    _writer.WriteUInt32(query);
+}
+
+void
+BgiCommandStreamCmds::_WriteResolveQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount,
+    BgiBufferHandle const& buffer,
+    uint32_t byteOffset)
+{
+    _writer.WriteOp(BgiCommandStreamOpResolveQueries);
+    _WriteHandle(queryPool);
+    _writer.WriteUInt32(firstQuery);
+    _writer.WriteUInt32(queryCount);
+    _WriteHandle(buffer);
+    _writer.WriteUInt32(byteOffset);
+}
+
+//
+// Graphics
+//
+
+BgiCommandStreamGraphicsCmds::BgiCommandStreamGraphicsCmds(
+    BgiGraphicsCmdsDesc const& desc)
+    : BgiGraphicsCmds()
+    , BgiCommandStreamCmds(BgiCommandStreamCmdsTypeGraphics)
+{
+    // The descriptor leads the operations of the block.
+    _writer.WriteUInt32((uint32_t) desc.colorAttachmentDescs.size());
+    for (BgiAttachmentDesc const& attachment : desc.colorAttachmentDescs) {
+        _writer.WriteAttachmentDesc(attachment);
+    }
+    _writer.WriteAttachmentDesc(desc.depthAttachmentDesc);
+
+    _writer.WriteUInt32((uint32_t) desc.colorTextures.size());
+    for (BgiTextureHandle const& texture : desc.colorTextures) {
+        _WriteHandle(texture);
+    }
+    _writer.WriteUInt32((uint32_t) desc.colorResolveTextures.size());
+    for (BgiTextureHandle const& texture : desc.colorResolveTextures) {
+        _WriteHandle(texture);
+    }
+    _WriteHandle(desc.depthTexture);
+    _WriteHandle(desc.depthResolveTexture);
+}
+
+BgiCommandStreamGraphicsCmds::~BgiCommandStreamGraphicsCmds() = default;
+
+void
+BgiCommandStreamGraphicsCmds::PushDebugGroup(const char* label)
+{
+    _WritePushDebugGroup(label);
+}
+
+void
+BgiCommandStreamGraphicsCmds::PopDebugGroup()
+{
+    _WritePopDebugGroup();
+}
+
+void
+BgiCommandStreamGraphicsCmds::SetViewport(Vector4i const& vp)
+{
+    _writer.WriteOp(BgiCommandStreamOpSetViewport);
+    for (int i = 0; i < 4; i++) {
+        _writer.WriteUInt32((uint32_t) vp[i]);
+    }
+}
+
+void
+BgiCommandStreamGraphicsCmds::SetScissor(Vector4i const& sc)
+{
+    _writer.WriteOp(BgiCommandStreamOpSetScissor);
+    for (int i = 0; i < 4; i++) {
+        _writer.WriteUInt32((uint32_t) sc[i]);
+    }
+}
+
+void
+BgiCommandStreamGraphicsCmds::BindPipeline(BgiGraphicsPipelineHandle pipeline)
+{
+    _writer.WriteOp(BgiCommandStreamOpBindGraphicsPipeline);
+    _WriteHandle(pipeline);
+}
+
+void
+BgiCommandStreamGraphicsCmds::BindResources(BgiResourceBindingsHandle res)
+{
+    _WriteBindResources(res, std::vector<uint32_t>());
+}
+
+void
+BgiCommandStreamGraphicsCmds::BindResources(
+    BgiResourceBindingsHandle res,
+    std::vector<uint32_t> const& dynamicOffsets)
+{
+    _WriteBindResources(res, dynamicOffsets);
+}
+
+void
+BgiCommandStreamGraphicsCmds::SetConstantValues(
+    BgiGraphicsPipelineHandle pipeline,
+    BgiShaderStage stages,
+    uint32_t bindIndex,
+    uint32_t byteSize,
+    const void* data)
+{
+    SetConstantValues(pipeline, stages, bindIndex, 0, byteSize, data);
+}
+
+void
+BgiCommandStreamGraphicsCmds::SetConstantValues(
+    BgiGraphicsPipelineHandle pipeline,
+    BgiShaderStage stages,
+    uint32_t bindIndex,
+    uint32_t byteOffset,
+    uint32_t byteSize,
+    const void* data)
+{
+    _writer.WriteOp(BgiCommandStreamOpSetGraphicsConstantValues);
+    _WriteHandle(pipeline);
+    _writer.WriteUInt32(stages);
+    _writer.WriteUInt32(bindIndex);
+    _writer.WriteUInt32(byteOffset);
+    _writer.WriteBytes(data, byteSize);
+}
+
+void
+BgiCommandStreamGraphicsCmds::BindVertexBuffers(
+    BgiVertexBufferBindingVector const &bindings)
+{
+    _writer.WriteOp(BgiCommandStreamOpBindVertexBuffers);
+    _writer.WriteUInt32((uint32_t) bindings.size());
+    for (BgiVertexBufferBinding const& binding : bindings) {
+        _WriteHandle(binding.buffer);
+        _writer.WriteUInt32(binding.byteOffset);
+        _writer.WriteUInt32(binding.index);
+    }
+}
+
+void
+BgiCommandStreamGraphicsCmds::Draw(
+    uint32_t vertexCount,
+    uint32_t baseVertex,
+    uint32_t instanceCount,
+    uint32_t baseInstance)
+{
+    _writer.WriteOp(BgiCommandStreamOpDraw);
+    _writer.WriteUInt32(vertexCount);
+    _writer.WriteUInt32(baseVertex);
+    _writer.WriteUInt32(instanceCount);
+    _writer.WriteUInt32(baseInstance);
+}
+
+void
+BgiCommandStreamGraphicsCmds::DrawIndirect(
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    uint32_t drawCount,
+    uint32_t stride)
+{
+    _writer.WriteOp(BgiCommandStreamOpDrawIndirect);
+    _WriteHandle(drawParameterBuffer);
+    _writer.WriteUInt32(drawBufferByteOffset);
+    _writer.WriteUInt32(drawCount);
+    _writer.WriteUInt32(stride);
+}
+
+void
+BgiCommandStreamGraphicsCmds::DrawIndexed(
+    BgiBufferHandle const& indexBuffer,
+    uint32_t indexCount,
+    uint32_t indexBufferByteOffset,
+    uint32_t baseVertex,
+    uint32_t instanceCount,
+    uint32_t baseInstance)
+{
+    _writer.WriteOp(BgiCommandStreamOpDrawIndexed);
+    _WriteHandle(indexBuffer);
+    _writer.WriteUInt32(indexCount);
+    _writer.WriteUInt32(indexBufferByteOffset);
+    _writer.WriteUInt32(baseVertex);
+    _writer.WriteUInt32(instanceCount);
+    _writer.WriteUInt32(baseInstance);
+}
+
+void
+BgiCommandStreamGraphicsCmds::DrawIndexedIndirect(
+    BgiBufferHandle const& indexBuffer,
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    uint32_t drawCount,
+    uint32_t stride,
+    std::vector<uint32_t> const& drawParameterBufferUInt32,
+    uint32_t patchBaseVertexByteOffset)
+{
+    _writer.WriteOp(BgiCommandStreamOpDrawIndexedIndirect);
+    _WriteHandle(indexBuffer);
+    _WriteHandle(drawParameterBuffer);
+    _writer.WriteUInt32(drawBufferByteOffset);
+    _writer.WriteUInt32(drawCount);
+    _writer.WriteUInt32(stride);
+    _writer.WriteUInt32Vector(drawParameterBufferUInt32);
+    _writer.WriteUInt32(patchBaseVertexByteOffset);
+}
+
+void
+BgiCommandStreamGraphicsCmds::DrawIndirectCount(
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    BgiBufferHandle const& countBuffer,
+    uint32_t countBufferByteOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride)
+{
+    _writer.WriteOp(BgiCommandStreamOpDrawIndirectCount);
+    _WriteHandle(drawParameterBuffer);
+    _writer.WriteUInt32(drawBufferByteOffset);
+    _WriteHandle(countBuffer);
+    _writer.WriteUInt32(countBufferByteOffset);
+    _writer.WriteUInt32(maxDrawCount);
+    _writer.WriteUInt32(stride);
+}
+
+void
+BgiCommandStreamGraphicsCmds::DrawIndexedIndirectCount(
+    BgiBufferHandle const& indexBuffer,
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    BgiBufferHandle const& countBuffer,
+    uint32_t countBufferByteOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride)
+{
+    _writer.WriteOp(BgiCommandStreamOpDrawIndexedIndirectCount);
+    _WriteHandle(indexBuffer);
+    _WriteHandle(drawParameterBuffer);
+    _writer.WriteUInt32(drawBufferByteOffset);
+    _WriteHandle(countBuffer);
+    _writer.WriteUInt32(countBufferByteOffset);
+    _writer.WriteUInt32(maxDrawCount);
+    _writer.WriteUInt32(stride);
+}
+
+void
+BgiCommandStreamGraphicsCmds::ResetQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount)
+{
+    _WriteResetQueries(queryPool, firstQuery, queryCount);
+}
+
+void
+BgiCommandStreamGraphicsCmds::BeginQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _WriteQuery(BgiCommandStreamOpBeginQuery, queryPool, query);
+}
+
+void
+BgiCommandStreamGraphicsCmds::EndQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _WriteQuery(BgiCommandStreamOpEndQuery, queryPool, query);
+}
+
+void
+BgiCommandStreamGraphicsCmds::WriteTimestamp(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _WriteQuery(BgiCommandStreamOpWriteTimestamp, queryPool, query);
+}
+
+void
+BgiCommandStreamGraphicsCmds::ResolveQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount,
+    BgiBufferHandle const& buffer,
+    uint32_t byteOffset)
+{
+    _WriteResolveQueries(
+        queryPool, firstQuery, queryCount, buffer, byteOffset);
+}
+
+void
+BgiCommandStreamGraphicsCmds::BeginConditionalRendering(
+    BgiBufferHandle const& buffer,
+    uint32_t byteOffset,
+    bool inverted)
+{
+    _writer.WriteOp(BgiCommandStreamOpBeginConditionalRendering);
+    _WriteHandle(buffer);
+    _writer.WriteUInt32(byteOffset);
+    _writer.WriteUInt32(inverted);
+}
+
+void
+BgiCommandStreamGraphicsCmds::EndConditionalRendering()
+{
+    _writer.WriteOp(BgiCommandStreamOpEndConditionalRendering);
+}
+
+void
+BgiCommandStreamGraphicsCmds::InsertMemoryBarrier(BgiMemoryBarrier barrier)
+{
+    _WriteInsertMemoryBarrier(barrier);
+}
+
+void
+BgiCommandStreamGraphicsCmds::_SetStreamSubmitted()
+{
+    _SetSubmitted();
+}
+
+//
+// Compute
+//
+
+BgiCommandStreamComputeCmds::BgiCommandStreamComputeCmds(
+    BgiComputeCmdsDesc const& desc)
+    : BgiComputeCmds()
+    , BgiCommandStreamCmds(BgiCommandStreamCmdsTypeCompute)
+    , _dispatchMethod(desc.dispatchMethod)
+{
+    _writer.WriteUInt32(desc.dispatchMethod);
+}
+
+BgiCommandStreamComputeCmds::~BgiCommandStreamComputeCmds() = default;
+
+void
+BgiCommandStreamComputeCmds::PushDebugGroup(const char* label)
+{
+    _WritePushDebugGroup(label);
+}
+
+void
+BgiCommandStreamComputeCmds::PopDebugGroup()
+{
+    _WritePopDebugGroup();
+}
+
+void
+BgiCommandStreamComputeCmds::BindPipeline(BgiComputePipelineHandle pipeline)
+{
+    _writer.WriteOp(BgiCommandStreamOpBindComputePipeline);
+    _WriteHandle(pipeline);
+}
+
+void
+BgiCommandStreamComputeCmds::BindResources(BgiResourceBindingsHandle res)
+{
+    _WriteBindResources(res, std::vector<uint32_t>());
+}
+
+void
+BgiCommandStreamComputeCmds::BindResources(
+    BgiResourceBindingsHandle res,
+    std::vector<uint32_t> const& dynamicOffsets)
+{
+    _WriteBindResources(res, dynamicOffsets);
+}
+
+void
+BgiCommandStreamComputeCmds::SetConstantValues(
+    BgiComputePipelineHandle pipeline,
+    uint32_t bindIndex,
+    uint32_t byteSize,
+    const void* data)
+{
+    SetConstantValues(pipeline, bindIndex, 0, byteSize, data);
+}
+
+void
+BgiCommandStreamComputeCmds::SetConstantValues(
+    BgiComputePipelineHandle pipeline,
+    uint32_t bindIndex,
+    uint32_t byteOffset,
+    uint32_t byteSize,
+    const void* data)
+{
+    _writer.WriteOp(BgiCommandStreamOpSetComputeConstantValues);
+    _WriteHandle(pipeline);
+    _writer.WriteUInt32(bindIndex);
+    _writer.WriteUInt32(byteOffset);
+    _writer.WriteBytes(data, byteSize);
+}
+
+void
+BgiCommandStreamComputeCmds::Dispatch(int dimX, int dimY, int dimZ)
+{
+    _writer.WriteOp(BgiCommandStreamOpDispatch);
+    _writer.WriteUInt32((uint32_t) dimX);
+    _writer.WriteUInt32((uint32_t) dimY);
+    _writer.WriteUInt32((uint32_t) dimZ);
+}
+
+void
+BgiCommandStreamComputeCmds::DispatchIndirect(
+    BgiBufferHandle const& dispatchParameterBuffer,
+    uint32_t byteOffset)
+{
+    _writer.WriteOp(BgiCommandStreamOpDispatchIndirect);
+    _WriteHandle(dispatchParameterBuffer);
+    _writer.WriteUInt32(byteOffset);
+}
+
+void
+BgiCommandStreamComputeCmds::ResetQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount)
+{
+    _WriteResetQueries(queryPool, firstQuery, queryCount);
+}
+
+void
+BgiCommandStreamComputeCmds::BeginQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _WriteQuery(BgiCommandStreamOpBeginQuery, queryPool, query);
+}
+
+void
+BgiCommandStreamComputeCmds::EndQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _WriteQuery(BgiCommandStreamOpEndQuery, queryPool, query);
+}
+
+void
+BgiCommandStreamComputeCmds::WriteTimestamp(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _WriteQuery(BgiCommandStreamOpWriteTimestamp, queryPool, query);
+}
+
+void
+BgiCommandStreamComputeCmds::ResolveQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount,
+    BgiBufferHandle const& buffer,
+    uint32_t byteOffset)
+{
+    _WriteResolveQueries(
+        queryPool, firstQuery, queryCount, buffer, byteOffset);
+}
+
+void
+BgiCommandStreamComputeCmds::InsertMemoryBarrier(BgiMemoryBarrier barrier)
+{
+    _WriteInsertMemoryBarrier(barrier);
+}
+
+BgiComputeDispatch
+BgiCommandStreamComputeCmds::GetDispatchMethod() const
+{
+    return _dispatchMethod;
+}
+
+void
+BgiCommandStreamComputeCmds::_SetStreamSubmitted()
+{
+    _SetSubmitted();
+}
+
+//
+// Blit
+//
+
+BgiCommandStreamBlitCmds::BgiCommandStreamBlitCmds()
+    : BgiBlitCmds()
+    , BgiCommandStreamCmds(BgiCommandStreamCmdsTypeBlit)
+{
+}
+
+BgiCommandStreamBlitCmds::~BgiCommandStreamBlitCmds() = default;
+
+void
+BgiCommandStreamBlitCmds::PushDebugGroup(const char* label)
+{
+    _WritePushDebugGroup(label);
+}
+
+void
+BgiCommandStreamBlitCmds::PopDebugGroup()
+{
+    _WritePopDebugGroup();
+}
+
+void
+BgiCommandStreamBlitCmds::CopyTextureGpuToCpu(
+    BgiTextureGpuToCpuOp const& copyOp)
+{
+    // The CPU memory can not be recorded. On replay the texels are read
+    // back into memory of the stream instead.
+    _writer.WriteOp(BgiCommandStreamOpCopyTextureGpuToCpu);
+    _WriteHandle(copyOp.gpuSourceTexture);
+    for (int i = 0; i < 3; i++) {
+        _writer.WriteUInt32((uint32_t) copyOp.sourceTexelOffset[i]);
+    }
+    _writer.WriteUInt32(copyOp.mipLevel);
+    _writer.WriteUInt64(copyOp.destinationByteOffset);
+    _writer.WriteUInt64(copyOp.destinationBufferByteSize);
+    _readbackByteSize += copyOp.destinationBufferByteSize;
+}
+
+void
+BgiCommandStreamBlitCmds::CopyTextureCpuToGpu(
+    BgiTextureCpuToGpuOp const& copyOp)
+{
+    _writer.WriteOp(BgiCommandStreamOpCopyTextureCpuToGpu);
+    _writer.WriteBytes(copyOp.cpuSourceBuffer, copyOp.bufferByteSize);
+    for (int i = 0; i < 3; i++) {
+        _writer.WriteUInt32((uint32_t) copyOp.destinationTexelOffset[i]);
+    }
+    _writer.WriteUInt32(copyOp.mipLevel);
+    _WriteHandle(copyOp.gpuDestinationTexture);
+}
+
+void
+BgiCommandStreamBlitCmds::CopyBufferGpuToGpu(
+    BgiBufferGpuToGpuOp const& copyOp)
+{
+    _writer.WriteOp(BgiCommandStreamOpCopyBufferGpuToGpu);
+    _WriteHandle(copyOp.gpuSourceBuffer);
+    _writer.WriteUInt64(copyOp.sourceByteOffset);
+    _writer.WriteUInt64(copyOp.byteSize);
+    _WriteHandle(copyOp.gpuDestinationBuffer);
+    _writer.WriteUInt64(copyOp.destinationByteOffset);
+}
+
+void
+BgiCommandStreamBlitCmds::CopyBufferCpuToGpu(
+    BgiBufferCpuToGpuOp const& copyOp)
+{
+    // Only the bytes that are copied are recorded.
+    const uint8_t* src =
+        static_cast<const uint8_t*>(copyOp.cpuSourceBuffer);
+
+    _writer.WriteOp(BgiCommandStreamOpCopyBufferCpuToGpu);
+    _writer.WriteBytes(
+        src ? src + copyOp.sourceByteOffset : nullptr,
+        src ? copyOp.byteSize : 0);
+    _WriteHandle(copyOp.gpuDestinationBuffer);
+    _writer.WriteUInt64(copyOp.destinationByteOffset);
+}
+
+void
+BgiCommandStreamBlitCmds::CopyBufferGpuToCpu(
+    BgiBufferGpuToCpuOp const& copyOp)
+{
+    // The CPU memory can not be recorded. On replay the bytes are read back
+    // into memory of the stream instead.
+    _writer.WriteOp(BgiCommandStreamOpCopyBufferGpuToCpu);
+    _WriteHandle(copyOp.gpuSourceBuffer);
+    _writer.WriteUInt64(copyOp.sourceByteOffset);
+    _writer.WriteUInt64(copyOp.byteSize);
+    _readbackByteSize += copyOp.byteSize;
+}
+
+void
+BgiCommandStreamBlitCmds::CopyTextureToBuffer(
+    BgiTextureToBufferOp const& copyOp)
+{
+    _writer.WriteOp(BgiCommandStreamOpCopyTextureToBuffer);
+    _WriteHandle(copyOp.gpuSourceTexture);
+    for (int i = 0; i < 3; i++) {
+        _writer.WriteUInt32((uint32_t) copyOp.sourceTexelOffset[i]);
+    }
+    _writer.WriteUInt32(copyOp.mipLevel);
+    _WriteHandle(copyOp.gpuDestinationBuffer);
+    _writer.WriteUInt64(copyOp.destinationByteOffset);
+    _writer.WriteUInt64(copyOp.byteSize);
+}
+
+void
+BgiCommandStreamBlitCmds::CopyBufferToTexture(
+    BgiBufferToTextureOp const& copyOp)
+{
+    _writer.WriteOp(BgiCommandStreamOpCopyBufferToTexture);
+    _WriteHandle(copyOp.gpuSourceBuffer);
+    _writer.WriteUInt64(copyOp.sourceByteOffset);
+    _WriteHandle(copyOp.gpuDestinationTexture);
+    for (int i = 0; i < 3; i++) {
+        _writer.WriteUInt32((uint32_t) copyOp.destinationTexelOffset[i]);
+    }
+    _writer.WriteUInt32(copyOp.mipLevel);
+    _writer.WriteUInt64(copyOp.byteSize);
+}
+
+void
+BgiCommandStreamBlitCmds::GenerateMipMaps(BgiTextureHandle const& texture)
+{
+    _writer.WriteOp(BgiCommandStreamOpGenerateMipMaps);
+    _WriteHandle(texture);
+}
+
+void
+BgiCommandStreamBlitCmds::FillBuffer(
+    BgiBufferHandle const& buffer,
+    uint8_t value)
+{
+    _writer.WriteOp(BgiCommandStreamOpFillBuffer);
+    _WriteHandle(buffer);
+    _writer.WriteUInt32(value);
+}
+
+void
+BgiCommandStreamBlitCmds::InsertMemoryBarrier(BgiMemoryBarrier barrier)
+{
+    _WriteInsertMemoryBarrier(barrier);
+}
+
+void
+BgiCommandStreamBlitCmds::_SetStreamSubmitted()
+{
+    _SetSubmitted();
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
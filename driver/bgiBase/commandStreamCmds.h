@@ -0,0 +1,428 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/api.h"
+#include "driver/bgiBase/blitCmds.h"
+#include "driver/bgiBase/commandStream.h"
+#include "driver/bgiBase/computeCmds.h"
+#include "driver/bgiBase/computeCmdsDesc.h"
+#include "driver/bgiBase/graphicsCmds.h"
+#include "driver/bgiBase/graphicsCmdsDesc.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+/// \class BgiCommandStreamCmds
+///
+/// The part shared by the cmds objects that record into a
+/// BgiCommandStream. It holds the encoded operations and the resources they
+/// refer to until the cmds are submitted to the stream.
+///
+class BgiCommandStreamCmds
+{
+public:
+    BGI_API
+    virtual ~BgiCommandStreamCmds();
+
+    /// Returns the type of cmds that were recorded.
+    BGI_API
+    BgiCommandStreamCmdsType GetCmdsType() const;
+
+    /// Returns the encoded operations.
+    BGI_API
+    std::vector<uint8_t> const& GetData() const;
+
+    /// Returns the resources the operations refer to.
+    BGI_API
+    BgiCommandStreamResources const& GetResources() const;
+
+    /// Returns the number of bytes the GPU to CPU copies read back.
+    BGI_API
+    size_t GetReadbackByteSize() const;
+
+protected:
+    friend class BgiCommandStream;
+
+    BGI_API
+    BgiCommandStreamCmds(BgiCommandStreamCmdsType type);
+
+    // Flags the cmds object as submitted to the stream.
+    virtual void _SetStreamSubmitted() = 0;
+
+    void _WriteHandle(BgiBufferHandle const& buffer);
+    void _WriteHandle(BgiTextureHandle const& texture);
+    void _WriteHandle(BgiGraphicsPipelineHandle const& pipeline);
+    void _WriteHandle(BgiComputePipelineHandle const& pipeline);
+    void _WriteHandle(BgiResourceBindingsHandle const& resourceBindings);
+    void _WriteHandle(BgiQueryPoolHandle const& queryPool);
+
+    void _WritePushDebugGroup(const char* label);
+    void _WritePopDebugGroup();
+    void _WriteInsertMemoryBarrier(BgiMemoryBarrier barrier);
+    void _WriteBindResources(
+        BgiResourceBindingsHandle const& resources,
+        std::vector<uint32_t> const& dynamicOffsets);
+    void _WriteResetQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount);
+    void _WriteQuery(
+        BgiCommandStreamOp op,
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query);
+    void _WriteResolveQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset);
+
+    BgiCommandStreamWriter _writer;
+    BgiCommandStreamResources _resources;
+    size_t _readbackByteSize;
+
+private:
+    BgiCommandStreamCmds() = delete;
+    BgiCommandStreamCmds & operator=(const BgiCommandStreamCmds&) = delete;
+    BgiCommandStreamCmds(const BgiCommandStreamCmds&) = delete;
+
+    BgiCommandStreamCmdsType _type;
+};
+
+/// \class BgiCommandStreamGraphicsCmds
+///
+/// Graphics cmds that record into a BgiCommandStream.
+///
+class BgiCommandStreamGraphicsCmds final
+    : public BgiGraphicsCmds
+    , public BgiCommandStreamCmds
+{
+public:
+    BGI_API
+    ~BgiCommandStreamGraphicsCmds() override;
+
+    BGI_API
+    void PushDebugGroup(const char* label) override;
+
+    BGI_API
+    void PopDebugGroup() override;
+
+    BGI_API
+    void SetViewport(Vector4i const& vp) override;
+
+    BGI_API
+    void SetScissor(Vector4i const& sc) override;
+
+    BGI_API
+    void BindPipeline(BgiGraphicsPipelineHandle pipeline) override;
+
+    BGI_API
+    void BindResources(BgiResourceBindingsHandle resources) override;
+
+    BGI_API
+    void BindResources(
+        BgiResourceBindingsHandle resources,
+        std::vector<uint32_t> const& dynamicOffsets) override;
+
+    BGI_API
+    void SetConstantValues(
+        BgiGraphicsPipelineHandle pipeline,
+        BgiShaderStage stages,
+        uint32_t bindIndex,
+        uint32_t byteSize,
+        const void* data) override;
+
+    BGI_API
+    void SetConstantValues(
+        BgiGraphicsPipelineHandle pipeline,
+        BgiShaderStage stages,
+        uint32_t bindIndex,
+        uint32_t byteOffset,
+        uint32_t byteSize,
+        const void* data) override;
+
+    BGI_API
+    void BindVertexBuffers(
+        BgiVertexBufferBindingVector const &bindings) override;
+
+    BGI_API
+    void Draw(
+        uint32_t vertexCount,
+        uint32_t baseVertex,
+        uint32_t instanceCount,
+        uint32_t baseInstance) override;
+
+    BGI_API
+    void DrawIndirect(
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        uint32_t drawCount,
+        uint32_t stride) override;
+
+    BGI_API
+    void DrawIndexed(
+        BgiBufferHandle const& indexBuffer,
+        uint32_t indexCount,
+        uint32_t indexBufferByteOffset,
+        uint32_t baseVertex,
+        uint32_t instanceCount,
+        uint32_t baseInstance) override;
+
+    BGI_API
+    void DrawIndexedIndirect(
+        BgiBufferHandle const& indexBuffer,
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        uint32_t drawCount,
+        uint32_t stride,
+        std::vector<uint32_t> const& drawParameterBufferUInt32,
+        uint32_t patchBaseVertexByteOffset) override;
+
+    BGI_API
+    void DrawIndirectCount(
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        BgiBufferHandle const& countBuffer,
+        uint32_t countBufferByteOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride) override;
+
+    BGI_API
+    void DrawIndexedIndirectCount(
+        BgiBufferHandle const& indexBuffer,
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        BgiBufferHandle const& countBuffer,
+        uint32_t countBufferByteOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride) override;
+
+    BGI_API
+    void ResetQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount) override;
+
+    BGI_API
+    void BeginQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGI_API
+    void EndQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGI_API
+    void WriteTimestamp(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGI_API
+    void ResolveQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset) override;
+
+    BGI_API
+    void BeginConditionalRendering(
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset,
+        bool inverted) override;
+
+    BGI_API
+    void EndConditionalRendering() override;
+
+    BGI_API
+    void InsertMemoryBarrier(BgiMemoryBarrier barrier) override;
+
+protected:
+    friend class BgiCommandStream;
+
+    BGI_API
+    BgiCommandStreamGraphicsCmds(BgiGraphicsCmdsDesc const& desc);
+
+    void _SetStreamSubmitted() override;
+
+private:
+    BgiCommandStreamGraphicsCmds() = delete;
+    BgiCommandStreamGraphicsCmds & operator=(
+        const BgiCommandStreamGraphicsCmds&) = delete;
+    BgiCommandStreamGraphicsCmds(
+        const BgiCommandStreamGraphicsCmds&) = delete;
+};
+
+/// \class BgiCommandStreamComputeCmds
+///
+/// Compute cmds that record into a BgiCommandStream.
+///
+class BgiCommandStreamComputeCmds final
+    : public BgiComputeCmds
+    , public BgiCommandStreamCmds
+{
+public:
+    BGI_API
+    ~BgiCommandStreamComputeCmds() override;
+
+    BGI_API
+    void PushDebugGroup(const char* label) override;
+
+    BGI_API
+    void PopDebugGroup() override;
+
+    BGI_API
+    void BindPipeline(BgiComputePipelineHandle pipeline) override;
+
+    BGI_API
+    void BindResources(BgiResourceBindingsHandle resources) override;
+
+    BGI_API
+    void BindResources(
+        BgiResourceBindingsHandle resources,
+        std::vector<uint32_t> const& dynamicOffsets) override;
+
+    BGI_API
+    void SetConstantValues(
+        BgiComputePipelineHandle pipeline,
+        uint32_t bindIndex,
+        uint32_t byteSize,
+        const void* data) override;
+
+    BGI_API
+    void SetConstantValues(
+        BgiComputePipelineHandle pipeline,
+        uint32_t bindIndex,
+        uint32_t byteOffset,
+        uint32_t byteSize,
+        const void* data) override;
+
+    BGI_API
+    void Dispatch(int dimX, int dimY, int dimZ) override;
+
+    BGI_API
+    void DispatchIndirect(
+        BgiBufferHandle const& dispatchParameterBuffer,
+        uint32_t byteOffset) override;
+
+    BGI_API
+    void ResetQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount) override;
+
+    BGI_API
+    void BeginQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGI_API
+    void EndQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGI_API
+    void WriteTimestamp(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGI_API
+    void ResolveQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset) override;
+
+    BGI_API
+    void InsertMemoryBarrier(BgiMemoryBarrier barrier) override;
+
+    BGI_API
+    BgiComputeDispatch GetDispatchMethod() const override;
+
+protected:
+    friend class BgiCommandStream;
+
+    BGI_API
+    BgiCommandStreamComputeCmds(BgiComputeCmdsDesc const& desc);
+
+    void _SetStreamSubmitted() override;
+
+private:
+    BgiCommandStreamComputeCmds() = delete;
+    BgiCommandStreamComputeCmds & operator=(
+        const BgiCommandStreamComputeCmds&) = delete;
+    BgiCommandStreamComputeCmds(
+        const BgiCommandStreamComputeCmds&) = delete;
+
+    BgiComputeDispatch _dispatchMethod;
+};
+
+/// \class BgiCommandStreamBlitCmds
+///
+/// Blit cmds that record into a BgiCommandStream.
+///
+class BgiCommandStreamBlitCmds final
+    : public BgiBlitCmds
+    , public BgiCommandStreamCmds
+{
+public:
+    BGI_API
+    ~BgiCommandStreamBlitCmds() override;
+
+    BGI_API
+    void PushDebugGroup(const char* label) override;
+
+    BGI_API
+    void PopDebugGroup() override;
+
+    BGI_API
+    void CopyTextureGpuToCpu(BgiTextureGpuToCpuOp const& copyOp) override;
+
+    BGI_API
+    void CopyTextureCpuToGpu(BgiTextureCpuToGpuOp const& copyOp) override;
+
+    BGI_API
+    void CopyBufferGpuToGpu(BgiBufferGpuToGpuOp const& copyOp) override;
+
+    BGI_API
+    void CopyBufferCpuToGpu(BgiBufferCpuToGpuOp const& copyOp) override;
+
+    BGI_API
+    void CopyBufferGpuToCpu(BgiBufferGpuToCpuOp const& copyOp) override;
+
+    BGI_API
+    void CopyTextureToBuffer(BgiTextureToBufferOp const& copyOp) override;
+
+    BGI_API
+    void CopyBufferToTexture(BgiBufferToTextureOp const& copyOp) override;
+
+    BGI_API
+    void GenerateMipMaps(BgiTextureHandle const& texture) override;
+
+    BGI_API
+    void FillBuffer(BgiBufferHandle const& buffer, uint8_t value) override;
+
+    BGI_API
+    void InsertMemoryBarrier(BgiMemoryBarrier barrier) override;
+
+protected:
+    friend class BgiCommandStream;
+
+    BGI_API
+    BgiCommandStreamBlitCmds();
+
+    void _SetStreamSubmitted() override;
+
+private:
+    BgiCommandStreamBlitCmds & operator=(
+        const BgiCommandStreamBlitCmds&) = delete;
+    BgiCommandStreamBlitCmds(const BgiCommandStreamBlitCmds&) = delete;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
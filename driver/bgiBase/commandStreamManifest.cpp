@@ -0,0 +1,1147 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiBase/commandStreamManifest.h"
+#include "driver/bgiBase/bgi.h"
+#include "driver/bgiBase/blitCmdsOps.h"
+#include "driver/bgiBase/types.h"
+
+#include <algorithm>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+// The manifest is a list of sections, each a count followed by that many
+// resources. A resource is the id it was recorded with followed by its
+// descriptor. Sections come in this order, so the resources a descriptor
+// refers to are always created before it.
+//
+//   shader functions, shader programs, samplers, buffers, textures,
+//   query pools, resource bindings, graphics pipelines, compute pipelines
+
+//
+// Helpers
+//
+
+// Returns the ids of 'handles' in ascending order, so that saving the same
+// stream twice writes the same bytes.
+template <class T>
+static std::vector<uint64_t>
+_GetSortedIds(std::unordered_map<uint64_t, T> const& handles)
+{
+    std::vector<uint64_t> ids;
+    ids.reserve(handles.size());
+    for (auto const& it : handles) {
+        ids.push_back(it.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Returns the recreated resource of 'id'. A resource that was not recreated
+// fails the manifest. Id zero is an empty handle.
+template <class T>
+static T
+_Lookup(std::unordered_map<uint64_t, T> const& handles, uint64_t id, bool* ok)
+{
+    if (id == 0) {
+        return T();
+    }
+    auto const it = handles.find(id);
+    if (it == handles.end()) {
+        *ok = false;
+        return T();
+    }
+    return it->second;
+}
+
+template <class T>
+static void
+_WriteIds(BgiCommandStreamWriter* writer, std::vector<T> const& handles)
+{
+    writer->WriteUInt32((uint32_t) handles.size());
+    for (T const& handle : handles) {
+        writer->WriteUInt64(handle ? handle.GetId() : 0);
+    }
+}
+
+template <class T>
+static std::vector<T>
+_ReadIds(
+    BgiCommandStreamReader* reader,
+    std::unordered_map<uint64_t, T> const& handles,
+    bool* ok)
+{
+    std::vector<T> result;
+    uint32_t const count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && !reader->HasFailed(); i++) {
+        result.push_back(_Lookup(handles, reader->ReadUInt64(), ok));
+    }
+    return result;
+}
+
+static void
+_WriteVector3i(BgiCommandStreamWriter* writer, Vector3i const& v)
+{
+    for (int i = 0; i < 3; i++) {
+        writer->WriteUInt32((uint32_t) v[i]);
+    }
+}
+
+static Vector3i
+_ReadVector3i(BgiCommandStreamReader* reader)
+{
+    Vector3i v;
+    for (int i = 0; i < 3; i++) {
+        v[i] = (int) reader->ReadUInt32();
+    }
+    return v;
+}
+
+//
+// Gathering
+//
+
+// Adds the resources the descriptors of 'resources' refer to, which are not
+// referred to by the operations of the stream.
+static void
+_GatherReferencedResources(BgiCommandStreamResources* resources)
+{
+    for (auto const& it : resources->graphicsPipelines) {
+        resources->Add(it.second->GetDescriptor().shaderProgram);
+    }
+    for (auto const& it : resources->computePipelines) {
+        resources->Add(it.second->GetDescriptor().shaderProgram);
+    }
+    for (auto const& it : resources->shaderPrograms) {
+        for (BgiShaderFunctionHandle const& function :
+                it.second->GetShaderFunctions()) {
+            resources->Add(function);
+        }
+    }
+    for (auto const& it : resources->resourceBindings) {
+        BgiResourceBindingsDesc const& desc = it.second->GetDescriptor();
+        for (BgiBufferBindingDesc const& binding : desc.buffers) {
+            for (BgiBufferHandle const& buffer : binding.buffers) {
+                resources->Add(buffer);
+            }
+        }
+        for (BgiTextureBindingDesc const& binding : desc.textures) {
+            for (BgiTextureHandle const& texture : binding.textures) {
+                resources->Add(texture);
+            }
+            for (BgiSamplerHandle const& sampler : binding.samplers) {
+                resources->Add(sampler);
+            }
+        }
+    }
+}
+
+// Returns true if the first mip of 'desc' can be read back. Copies to the
+// CPU only read the color aspect of single sampled images.
+static bool
+_CanReadBackTexture(BgiTextureDesc const& desc)
+{
+    return desc.sampleCount == BgiSampleCount1 &&
+        !(desc.usage & (BgiTextureUsageBitsDepthTarget |
+                        BgiTextureUsageBitsStencilTarget));
+}
+
+static size_t
+_GetTextureLayerByteSize(BgiTextureDesc const& desc)
+{
+    return BgiGetDataSize(desc.format, desc.dimensions);
+}
+
+// Reads back the contents of the buffers and of the first mip of the
+// textures of 'resources', in the order of their sorted ids.
+static void
+_ReadBackContents(
+    Bgi* bgi,
+    BgiCommandStreamResources const& resources,
+    std::vector<std::vector<uint8_t>>* bufferContents,
+    std::vector<std::vector<uint8_t>>* textureContents)
+{
+    std::vector<uint64_t> const bufferIds = _GetSortedIds(resources.buffers);
+    std::vector<uint64_t> const textureIds =
+        _GetSortedIds(resources.textures);
+    bufferContents->resize(bufferIds.size());
+    textureContents->resize(textureIds.size());
+
+    BgiBlitCmdsUniquePtr blitCmds = bgi->CreateBlitCmds();
+    for (size_t i = 0; i < bufferIds.size(); i++) {
+        BgiBufferHandle const& buffer = resources.buffers.at(bufferIds[i]);
+        size_t const byteSize = buffer->GetDescriptor().byteSize;
+        if (byteSize == 0) {
+            continue;
+        }
+        (*bufferContents)[i].resize(byteSize);
+
+        BgiBufferGpuToCpuOp copyOp;
+        copyOp.gpuSourceBuffer = buffer;
+        copyOp.byteSize = byteSize;
+        copyOp.cpuDestinationBuffer = (*bufferContents)[i].data();
+        blitCmds->CopyBufferGpuToCpu(copyOp);
+    }
+    bgi->SubmitCmds(blitCmds.get(), BgiSubmitWaitTypeWaitUntilCompleted);
+
+    // Textures read back through their staging buffer, so each layer of a
+    // texture is copied by its own cmds.
+    uint16_t layerCount = 0;
+    for (size_t i = 0; i < textureIds.size(); i++) {
+        BgiTextureDesc const& desc =
+            resources.textures.at(textureIds[i])->GetDescriptor();
+        if (_CanReadBackTexture(desc)) {
+            (*textureContents)[i].resize(
+                _GetTextureLayerByteSize(desc) * desc.layerCount);
+            layerCount = std::max(layerCount, desc.layerCount);
+        }
+    }
+
+    for (uint16_t layer = 0; layer < layerCount; layer++) {
+        blitCmds = bgi->CreateBlitCmds();
+        for (size_t i = 0; i < textureIds.size(); i++) {
+            BgiTextureHandle const& texture =
+                resources.textures.at(textureIds[i]);
+            BgiTextureDesc const& desc = texture->GetDescriptor();
+            if ((*textureContents)[i].empty() || layer >= desc.layerCount) {
+                continue;
+            }
+
+            size_t const layerByteSize = _GetTextureLayerByteSize(desc);
+            BgiTextureGpuToCpuOp copyOp;
+            copyOp.gpuSourceTexture = texture;
+            copyOp.sourceTexelOffset = Vector3i(0, 0, layer);
+            copyOp.cpuDestinationBuffer = (*textureContents)[i].data();
+            copyOp.destinationByteOffset = layerByteSize * layer;
+            copyOp.destinationBufferByteSize = layerByteSize;
+            blitCmds->CopyTextureGpuToCpu(copyOp);
+        }
+        bgi->SubmitCmds(blitCmds.get(), BgiSubmitWaitTypeWaitUntilCompleted);
+    }
+}
+
+//
+// Shader functions
+//
+
+// Writes a string that may be null.
+static void
+_WriteOptionalString(BgiCommandStreamWriter* writer, const char* str)
+{
+    writer->WriteUInt32(str != nullptr);
+    writer->WriteString(str);
+}
+
+static void
+_WriteParamDescs(
+    BgiCommandStreamWriter* writer,
+    std::vector<BgiShaderFunctionParamDesc> const& params)
+{
+    writer->WriteUInt32((uint32_t) params.size());
+    for (BgiShaderFunctionParamDesc const& param : params) {
+        writer->WriteString(param.nameInShader.c_str());
+        writer->WriteString(param.type.c_str());
+        writer->WriteUInt32((uint32_t) param.location);
+        writer->WriteUInt32((uint32_t) param.interstageSlot);
+        writer->WriteUInt32(param.interpolation);
+        writer->WriteUInt32(param.sampling);
+        writer->WriteUInt32(param.storage);
+        writer->WriteUInt32(param.role);
+        writer->WriteString(param.arraySize.c_str());
+    }
+}
+
+static std::vector<BgiShaderFunctionParamDesc>
+_ReadParamDescs(BgiCommandStreamReader* reader)
+{
+    std::vector<BgiShaderFunctionParamDesc> params;
+    uint32_t const count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && !reader->HasFailed(); i++) {
+        BgiShaderFunctionParamDesc param;
+        param.nameInShader = reader->ReadString();
+        param.type = reader->ReadString();
+        param.location = (int32_t) reader->ReadUInt32();
+        param.interstageSlot = (int32_t) reader->ReadUInt32();
+        param.interpolation = BgiInterpolationType(reader->ReadUInt32());
+        param.sampling = BgiSamplingType(reader->ReadUInt32());
+        param.storage = BgiStorageType(reader->ReadUInt32());
+        param.role = tokens::SHADER_KEYWORD(reader->ReadUInt32());
+        param.arraySize = reader->ReadString();
+        params.push_back(std::move(param));
+    }
+    return params;
+}
+
+static void
+_WriteParamBlockDescs(
+    BgiCommandStreamWriter* writer,
+    std::vector<BgiShaderFunctionParamBlockDesc> const& blocks)
+{
+    writer->WriteUInt32((uint32_t) blocks.size());
+    for (BgiShaderFunctionParamBlockDesc const& block : blocks) {
+        writer->WriteString(block.blockName.c_str());
+        writer->WriteString(block.instanceName.c_str());
+        writer->WriteUInt32((uint32_t) block.members.size());
+        for (auto const& member : block.members) {
+            writer->WriteString(member.name.c_str());
+            writer->WriteString(member.type.c_str());
+        }
+        writer->WriteString(block.arraySize.c_str());
+        writer->WriteUInt32((uint32_t) block.interstageSlot);
+    }
+}
+
+static std::vector<BgiShaderFunctionParamBlockDesc>
+_ReadParamBlockDescs(BgiCommandStreamReader* reader)
+{
+    std::vector<BgiShaderFunctionParamBlockDesc> blocks;
+    uint32_t const count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && !reader->HasFailed(); i++) {
+        BgiShaderFunctionParamBlockDesc block;
+        block.blockName = reader->ReadString();
+        block.instanceName = reader->ReadString();
+        uint32_t const memberCount = reader->ReadUInt32();
+        for (uint32_t m = 0; m < memberCount && !reader->HasFailed(); m++) {
+            BgiShaderFunctionParamBlockDesc::Member member;
+            member.name = reader->ReadString();
+            member.type = reader->ReadString();
+            block.members.push_back(std::move(member));
+        }
+        block.arraySize = reader->ReadString();
+        block.interstageSlot = (int32_t) reader->ReadUInt32();
+        blocks.push_back(std::move(block));
+    }
+    return blocks;
+}
+
+// Must match _ReadShaderFunctionDesc.
+static void
+_WriteShaderFunctionDesc(
+    BgiCommandStreamWriter* writer,
+    BgiShaderFunctionDesc const& desc)
+{
+    writer->WriteString(desc.debugName.c_str());
+    writer->WriteUInt32(desc.shaderStage);
+    _WriteOptionalString(writer, desc.shaderCodeDeclarations);
+    _WriteOptionalString(writer, desc.shaderCode);
+
+    writer->WriteUInt32((uint32_t) desc.textures.size());
+    for (BgiShaderFunctionTextureDesc const& texture : desc.textures) {
+        writer->WriteString(texture.nameInShader.c_str());
+        writer->WriteUInt32(texture.dimensions);
+        writer->WriteUInt32(texture.format);
+        writer->WriteUInt32(texture.textureType);
+        writer->WriteUInt32(texture.bindIndex);
+        writer->WriteUInt64(texture.arraySize);
+        writer->WriteUInt32(texture.writable);
+        writer->WriteUInt32(texture.bindless);
+    }
+
+    writer->WriteUInt32((uint32_t) desc.buffers.size());
+    for (BgiShaderFunctionBufferDesc const& buffer : desc.buffers) {
+        writer->WriteString(buffer.nameInShader.c_str());
+        writer->WriteString(buffer.type.c_str());
+        writer->WriteUInt32(buffer.bindIndex);
+        writer->WriteUInt32(buffer.arraySize);
+        writer->WriteUInt32(buffer.binding);
+        writer->WriteUInt32(buffer.writable);
+        writer->WriteUInt32(buffer.bindless);
+        writer->WriteUInt32(buffer.dynamicOffset);
+        writer->WriteUInt32(buffer.deviceAddress);
+    }
+
+    _WriteParamDescs(writer, desc.constantParams);
+    _WriteParamDescs(writer, desc.stageGlobalMembers);
+    _WriteParamDescs(writer, desc.stageInputs);
+    _WriteParamDescs(writer, desc.stageOutputs);
+    _WriteParamBlockDescs(writer, desc.stageInputBlocks);
+    _WriteParamBlockDescs(writer, desc.stageOutputBlocks);
+
+    _WriteVector3i(writer, desc.computeDescriptor.localSize);
+
+    BgiShaderFunctionTessellationDesc const& tess =
+        desc.tessellationDescriptor;
+    writer->WriteUInt32((uint32_t) tess.patchType);
+    writer->WriteUInt32((uint32_t) tess.spacing);
+    writer->WriteUInt32((uint32_t) tess.ordering);
+    writer->WriteString(tess.numVertsPerPatchIn.c_str());
+    writer->WriteString(tess.numVertsPerPatchOut.c_str());
+
+    BgiShaderFunctionGeometryDesc const& geometry = desc.geometryDescriptor;
+    writer->WriteUInt32((uint32_t) geometry.inPrimitiveType);
+    writer->WriteUInt32((uint32_t) geometry.outPrimitiveType);
+    writer->WriteString(geometry.outMaxVertices.c_str());
+
+    writer->WriteUInt32(desc.fragmentDescriptor.earlyFragmentTests);
+
+    writer->WriteString(desc.slangModule.c_str());
+    writer->WriteString(desc.slangEntryPoint.c_str());
+}
+
+// The shader code is returned in 'declarations' and 'code', which 'desc'
+// points to.
+static BgiShaderFunctionDesc
+_ReadShaderFunctionDesc(
+    BgiCommandStreamReader* reader,
+    std::string* declarations,
+    std::string* code)
+{
+    BgiShaderFunctionDesc desc;
+    desc.debugName = reader->ReadString();
+    desc.shaderStage = reader->ReadUInt32();
+    bool const hasDeclarations = reader->ReadUInt32() != 0;
+    *declarations = reader->ReadString();
+    desc.shaderCodeDeclarations =
+        hasDeclarations ? declarations->c_str() : nullptr;
+    bool const hasCode = reader->ReadUInt32() != 0;
+    *code = reader->ReadString();
+    desc.shaderCode = hasCode ? code->c_str() : nullptr;
+
+    uint32_t const textureCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < textureCount && !reader->HasFailed(); i++) {
+        BgiShaderFunctionTextureDesc texture;
+        texture.nameInShader = reader->ReadString();
+        texture.dimensions = reader->ReadUInt32();
+        texture.format = BgiFormat(reader->ReadUInt32());
+        texture.textureType = BgiShaderTextureType(reader->ReadUInt32());
+        texture.bindIndex = reader->ReadUInt32();
+        texture.arraySize = (size_t) reader->ReadUInt64();
+        texture.writable = reader->ReadUInt32() != 0;
+        texture.bindless = reader->ReadUInt32() != 0;
+        desc.textures.push_back(std::move(texture));
+    }
+
+    uint32_t const bufferCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < bufferCount && !reader->HasFailed(); i++) {
+        BgiShaderFunctionBufferDesc buffer;
+        buffer.nameInShader = reader->ReadString();
+        buffer.type = reader->ReadString();
+        buffer.bindIndex = reader->ReadUInt32();
+        buffer.arraySize = reader->ReadUInt32();
+        buffer.binding = BgiBindingType(reader->ReadUInt32());
+        buffer.writable = reader->ReadUInt32() != 0;
+        buffer.bindless = reader->ReadUInt32() != 0;
+        buffer.dynamicOffset = reader->ReadUInt32() != 0;
+        buffer.deviceAddress = reader->ReadUInt32() != 0;
+        desc.buffers.push_back(std::move(buffer));
+    }
+
+    desc.constantParams = _ReadParamDescs(reader);
+    desc.stageGlobalMembers = _ReadParamDescs(reader);
+    desc.stageInputs = _ReadParamDescs(reader);
+    desc.stageOutputs = _ReadParamDescs(reader);
+    desc.stageInputBlocks = _ReadParamBlockDescs(reader);
+    desc.stageOutputBlocks = _ReadParamBlockDescs(reader);
+
+    desc.computeDescriptor.localSize = _ReadVector3i(reader);
+
+    using TessDesc = BgiShaderFunctionTessellationDesc;
+    TessDesc& tess = desc.tessellationDescriptor;
+    tess.patchType = TessDesc::PatchType(reader->ReadUInt32());
+    tess.spacing = TessDesc::Spacing(reader->ReadUInt32());
+    tess.ordering = TessDesc::Ordering(reader->ReadUInt32());
+    tess.numVertsPerPatchIn = reader->ReadString();
+    tess.numVertsPerPatchOut = reader->ReadString();
+
+    using GeometryDesc = BgiShaderFunctionGeometryDesc;
+    GeometryDesc& geometry = desc.geometryDescriptor;
+    geometry.inPrimitiveType =
+        GeometryDesc::InPrimitiveType(reader->ReadUInt32());
+    geometry.outPrimitiveType =
+        GeometryDesc::OutPrimitiveType(reader->ReadUInt32());
+    geometry.outMaxVertices = reader->ReadString();
+
+    desc.fragmentDescriptor.earlyFragmentTests = reader->ReadUInt32() != 0;
+
+    desc.slangModule = reader->ReadString();
+    desc.slangEntryPoint = reader->ReadString();
+    return desc;
+}
+
+//
+// Samplers, buffers, textures and query pools
+//
+
+// Must match _ReadSamplerDesc.
+static void
+_WriteSamplerDesc(
+    BgiCommandStreamWriter* writer,
+    BgiSamplerDesc const& desc)
+{
+    writer->WriteString(desc.debugName.c_str());
+    writer->WriteUInt32(desc.magFilter);
+    writer->WriteUInt32(desc.minFilter);
+    writer->WriteUInt32(desc.mipFilter);
+    writer->WriteUInt32(desc.addressModeU);
+    writer->WriteUInt32(desc.addressModeV);
+    writer->WriteUInt32(desc.addressModeW);
+    writer->WriteUInt32(desc.borderColor);
+    writer->WriteUInt32(desc.enableCompare);
+    writer->WriteUInt32(desc.compareFunction);
+}
+
+static BgiSamplerDesc
+_ReadSamplerDesc(BgiCommandStreamReader* reader)
+{
+    BgiSamplerDesc desc;
+    desc.debugName = reader->ReadString();
+    desc.magFilter = BgiSamplerFilter(reader->ReadUInt32());
+    desc.minFilter = BgiSamplerFilter(reader->ReadUInt32());
+    desc.mipFilter = BgiMipFilter(reader->ReadUInt32());
+    desc.addressModeU = BgiSamplerAddressMode(reader->ReadUInt32());
+    desc.addressModeV = BgiSamplerAddressMode(reader->ReadUInt32());
+    desc.addressModeW = BgiSamplerAddressMode(reader->ReadUInt32());
+    desc.borderColor = BgiBorderColor(reader->ReadUInt32());
+    desc.enableCompare = reader->ReadUInt32() != 0;
+    desc.compareFunction = BgiCompareFunction(reader->ReadUInt32());
+    return desc;
+}
+
+// Must match _ReadBufferDesc.
+static void
+_WriteBufferDesc(
+    BgiCommandStreamWriter* writer,
+    BgiBufferDesc const& desc,
+    std::vector<uint8_t> const& contents)
+{
+    writer->WriteString(desc.debugName.c_str());
+    writer->WriteUInt32(desc.usage);
+    writer->WriteUInt64(desc.byteSize);
+    writer->WriteUInt32(desc.vertexStride);
+    writer->WriteBytes(contents.data(), contents.size());
+}
+
+// 'initialData' of the returned descriptor points into the manifest.
+static BgiBufferDesc
+_ReadBufferDesc(BgiCommandStreamReader* reader)
+{
+    BgiBufferDesc desc;
+    desc.debugName = reader->ReadString();
+    desc.usage = reader->ReadUInt32();
+    desc.byteSize = (size_t) reader->ReadUInt64();
+    desc.vertexStride = reader->ReadUInt32();
+
+    size_t contentsByteSize = 0;
+    const uint8_t* contents = reader->ReadBytes(&contentsByteSize);
+    if (contentsByteSize == desc.byteSize) {
+        desc.initialData = contents;
+    }
+    return desc;
+}
+
+// Must match _ReadTextureDesc.
+static void
+_WriteTextureDesc(
+    BgiCommandStreamWriter* writer,
+    BgiTextureDesc const& desc,
+    std::vector<uint8_t> const& contents)
+{
+    writer->WriteString(desc.debugName.c_str());
+    writer->WriteUInt32(desc.usage);
+    writer->WriteUInt32(desc.format);
+    writer->WriteUInt32(desc.componentMapping.r);
+    writer->WriteUInt32(desc.componentMapping.g);
+    writer->WriteUInt32(desc.componentMapping.b);
+    writer->WriteUInt32(desc.componentMapping.a);
+    writer->WriteUInt32(desc.type);
+    _WriteVector3i(writer, desc.dimensions);
+    writer->WriteUInt32(desc.layerCount);
+    writer->WriteUInt32(desc.mipLevels);
+    writer->WriteUInt32(desc.sampleCount);
+    writer->WriteBytes(contents.data(), contents.size());
+}
+
+// 'initialData' of the returned descriptor points into the manifest. It
+// only holds the first mip.
+static BgiTextureDesc
+_ReadTextureDesc(BgiCommandStreamReader* reader)
+{
+    BgiTextureDesc desc;
+    desc.debugName = reader->ReadString();
+    desc.usage = reader->ReadUInt32();
+    desc.format = BgiFormat(reader->ReadUInt32());
+    desc.componentMapping.r = BgiComponentSwizzle(reader->ReadUInt32());
+    desc.componentMapping.g = BgiComponentSwizzle(reader->ReadUInt32());
+    desc.componentMapping.b = BgiComponentSwizzle(reader->ReadUInt32());
+    desc.componentMapping.a = BgiComponentSwizzle(reader->ReadUInt32());
+    desc.type = BgiTextureType(reader->ReadUInt32());
+    desc.dimensions = _ReadVector3i(reader);
+    desc.layerCount = (uint16_t) reader->ReadUInt32();
+    desc.mipLevels = (uint16_t) reader->ReadUInt32();
+    desc.sampleCount = BgiSampleCount(reader->ReadUInt32());
+
+    size_t contentsByteSize = 0;
+    const uint8_t* contents = reader->ReadBytes(&contentsByteSize);
+    if (contentsByteSize > 0) {
+        desc.initialData = contents;
+        desc.pixelsByteSize = contentsByteSize;
+    }
+    return desc;
+}
+
+// Must match _ReadQueryPoolDesc.
+static void
+_WriteQueryPoolDesc(
+    BgiCommandStreamWriter* writer,
+    BgiQueryPoolDesc const& desc)
+{
+    writer->WriteString(desc.debugName.c_str());
+    writer->WriteUInt32(desc.type);
+    writer->WriteUInt32(desc.queryCount);
+    writer->WriteUInt32(desc.pipelineStatistics);
+}
+
+static BgiQueryPoolDesc
+_ReadQueryPoolDesc(BgiCommandStreamReader* reader)
+{
+    BgiQueryPoolDesc desc;
+    desc.debugName = reader->ReadString();
+    desc.type = BgiQueryType(reader->ReadUInt32());
+    desc.queryCount = reader->ReadUInt32();
+    desc.pipelineStatistics = reader->ReadUInt32();
+    return desc;
+}
+
+//
+// Resource bindings
+//
+
+// Must match _ReadResourceBindingsDesc.
+static void
+_WriteResourceBindingsDesc(
+    BgiCommandStreamWriter* writer,
+    BgiResourceBindingsDesc const& desc)
+{
+    writer->WriteString(desc.debugName.c_str());
+
+    writer->WriteUInt32((uint32_t) desc.buffers.size());
+    for (BgiBufferBindingDesc const& binding : desc.buffers) {
+        _WriteIds(writer, binding.buffers);
+        writer->WriteUInt32Vector(binding.offsets);
+        writer->WriteUInt32Vector(binding.sizes);
+        writer->WriteUInt32(binding.resourceType);
+        writer->WriteUInt32(binding.bindingIndex);
+        writer->WriteUInt32(binding.stageUsage);
+        writer->WriteUInt32(binding.writable);
+        writer->WriteUInt32(binding.dynamicOffset);
+    }
+
+    writer->WriteUInt32((uint32_t) desc.textures.size());
+    for (BgiTextureBindingDesc const& binding : desc.textures) {
+        _WriteIds(writer, binding.textures);
+        _WriteIds(writer, binding.samplers);
+        writer->WriteUInt32(binding.resourceType);
+        writer->WriteUInt32(binding.bindingIndex);
+        writer->WriteUInt32(binding.stageUsage);
+        writer->WriteUInt32(binding.writable);
+    }
+}
+
+// Transient bindings only live for the frame they were created in, while
+// recreated bindings are used by every replay, so they are never transient.
+static BgiResourceBindingsDesc
+_ReadResourceBindingsDesc(
+    BgiCommandStreamReader* reader,
+    BgiCommandStreamResources const& resources,
+    bool* ok)
+{
+    BgiResourceBindingsDesc desc;
+    desc.debugName = reader->ReadString();
+
+    uint32_t const bufferCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < bufferCount && !reader->HasFailed(); i++) {
+        BgiBufferBindingDesc binding;
+        binding.buffers = _ReadIds(reader, resources.buffers, ok);
+        binding.offsets = reader->ReadUInt32Vector();
+        binding.sizes = reader->ReadUInt32Vector();
+        binding.resourceType = BgiBindResourceType(reader->ReadUInt32());
+        binding.bindingIndex = reader->ReadUInt32();
+        binding.stageUsage = reader->ReadUInt32();
+        binding.writable = reader->ReadUInt32() != 0;
+        binding.dynamicOffset = reader->ReadUInt32() != 0;
+        desc.buffers.push_back(std::move(binding));
+    }
+
+    uint32_t const textureCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < textureCount && !reader->HasFailed(); i++) {
+        BgiTextureBindingDesc binding;
+        binding.textures = _ReadIds(reader, resources.textures, ok);
+        binding.samplers = _ReadIds(reader, resources.samplers, ok);
+        binding.resourceType = BgiBindResourceType(reader->ReadUInt32());
+        binding.bindingIndex = reader->ReadUInt32();
+        binding.stageUsage = reader->ReadUInt32();
+        binding.writable = reader->ReadUInt32() != 0;
+        desc.textures.push_back(std::move(binding));
+    }
+    return desc;
+}
+
+//
+// Pipelines
+//
+
+static void
+_WriteStencilState(
+    BgiCommandStreamWriter* writer,
+    BgiStencilState const& state)
+{
+    writer->WriteUInt32(state.compareFn);
+    writer->WriteUInt32(state.referenceValue);
+    writer->WriteUInt32(state.stencilFailOp);
+    writer->WriteUInt32(state.depthFailOp);
+    writer->WriteUInt32(state.depthStencilPassOp);
+    writer->WriteUInt32(state.readMask);
+    writer->WriteUInt32(state.writeMask);
+}
+
+static BgiStencilState
+_ReadStencilState(BgiCommandStreamReader* reader)
+{
+    BgiStencilState state;
+    state.compareFn = BgiCompareFunction(reader->ReadUInt32());
+    state.referenceValue = reader->ReadUInt32();
+    state.stencilFailOp = BgiStencilOp(reader->ReadUInt32());
+    state.depthFailOp = BgiStencilOp(reader->ReadUInt32());
+    state.depthStencilPassOp = BgiStencilOp(reader->ReadUInt32());
+    state.readMask = reader->ReadUInt32();
+    state.writeMask = reader->ReadUInt32();
+    return state;
+}
+
+static void
+_WriteAttachmentDescs(
+    BgiCommandStreamWriter* writer,
+    BgiAttachmentDescVector const& descs)
+{
+    writer->WriteUInt32((uint32_t) descs.size());
+    for (BgiAttachmentDesc const& desc : descs) {
+        writer->WriteAttachmentDesc(desc);
+    }
+}
+
+static BgiAttachmentDescVector
+_ReadAttachmentDescs(BgiCommandStreamReader* reader)
+{
+    BgiAttachmentDescVector descs;
+    uint32_t const count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && !reader->HasFailed(); i++) {
+        descs.push_back(reader->ReadAttachmentDesc());
+    }
+    return descs;
+}
+
+// Must match _ReadGraphicsPipelineDesc.
+static void
+_WriteGraphicsPipelineDesc(
+    BgiCommandStreamWriter* writer,
+    BgiGraphicsPipelineDesc const& desc)
+{
+    writer->WriteString(desc.debugName.c_str());
+    writer->WriteUInt32(desc.primitiveType);
+    writer->WriteUInt64(desc.shaderProgram ? desc.shaderProgram.GetId() : 0);
+
+    BgiDepthStencilState const& depth = desc.depthState;
+    writer->WriteUInt32(depth.depthTestEnabled);
+    writer->WriteUInt32(depth.depthWriteEnabled);
+    writer->WriteUInt32(depth.depthCompareFn);
+    writer->WriteUInt32(depth.depthBiasEnabled);
+    writer->WriteFloat(depth.depthBiasConstantFactor);
+    writer->WriteFloat(depth.depthBiasSlopeFactor);
+    writer->WriteUInt32(depth.stencilTestEnabled);
+    _WriteStencilState(writer, depth.stencilFront);
+    _WriteStencilState(writer, depth.stencilBack);
+
+    BgiMultiSampleState const& multiSample = desc.multiSampleState;
+    writer->WriteUInt32(multiSample.multiSampleEnable);
+    writer->WriteUInt32(multiSample.alphaToCoverageEnable);
+    writer->WriteUInt32(multiSample.alphaToOneEnable);
+    writer->WriteUInt32(multiSample.sampleCount);
+
+    BgiRasterizationState const& raster = desc.rasterizationState;
+    writer->WriteUInt32(raster.polygonMode);
+    writer->WriteFloat(raster.lineWidth);
+    writer->WriteUInt32(raster.cullMode);
+    writer->WriteUInt32(raster.winding);
+    writer->WriteUInt32(raster.rasterizerEnabled);
+    writer->WriteUInt32(raster.depthClampEnabled);
+    writer->WriteFloat(raster.depthRange[0]);
+    writer->WriteFloat(raster.depthRange[1]);
+    writer->WriteUInt32(raster.conservativeRaster);
+    writer->WriteUInt64(raster.numClipDistances);
+
+    writer->WriteUInt32((uint32_t) desc.vertexBuffers.size());
+    for (BgiVertexBufferDesc const& vbo : desc.vertexBuffers) {
+        writer->WriteUInt32(vbo.bindingIndex);
+        writer->WriteUInt32((uint32_t) vbo.vertexAttributes.size());
+        for (BgiVertexAttributeDesc const& attr : vbo.vertexAttributes) {
+            writer->WriteUInt32(attr.format);
+            writer->WriteUInt32(attr.offset);
+            writer->WriteUInt32(attr.shaderBindLocation);
+        }
+        writer->WriteUInt32(vbo.vertexStepFunction);
+        writer->WriteUInt32(vbo.vertexStride);
+    }
+
+    _WriteAttachmentDescs(writer, desc.colorAttachmentDescs);
+    _WriteAttachmentDescs(writer, desc.colorResolveAttachmentDescs);
+    writer->WriteAttachmentDesc(desc.depthAttachmentDesc);
+    writer->WriteAttachmentDesc(desc.depthResolveAttachmentDesc);
+
+    BgiGraphicsShaderConstantsDesc const& constants =
+        desc.shaderConstantsDesc;
+    writer->WriteUInt32(constants.byteSize);
+    writer->WriteUInt32(constants.stageUsage);
+    writer->WriteUInt32((uint32_t) constants.ranges.size());
+    for (BgiGraphicsShaderConstantsRange const& range : constants.ranges) {
+        writer->WriteUInt32(range.byteOffset);
+        writer->WriteUInt32(range.byteSize);
+        writer->WriteUInt32(range.stageUsage);
+    }
+
+    BgiTessellationState const& tess = desc.tessellationState;
+    writer->WriteUInt32(tess.patchType);
+    writer->WriteUInt32((uint32_t) tess.primitiveIndexSize);
+    writer->WriteUInt32(tess.tessFactorMode);
+    for (int i = 0; i < 2; i++) {
+        writer->WriteFloat(tess.tessellationLevel.innerTessLevel[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        writer->WriteFloat(tess.tessellationLevel.outerTessLevel[i]);
+    }
+}
+
+static BgiGraphicsPipelineDesc
+_ReadGraphicsPipelineDesc(
+    BgiCommandStreamReader* reader,
+    BgiCommandStreamResources const& resources,
+    bool* ok)
+{
+    BgiGraphicsPipelineDesc desc;
+    desc.debugName = reader->ReadString();
+    desc.primitiveType = BgiPrimitiveType(reader->ReadUInt32());
+    desc.shaderProgram =
+        _Lookup(resources.shaderPrograms, reader->ReadUInt64(), ok);
+
+    BgiDepthStencilState& depth = desc.depthState;
+    depth.depthTestEnabled = reader->ReadUInt32() != 0;
+    depth.depthWriteEnabled = reader->ReadUInt32() != 0;
+    depth.depthCompareFn = BgiCompareFunction(reader->ReadUInt32());
+    depth.depthBiasEnabled = reader->ReadUInt32() != 0;
+    depth.depthBiasConstantFactor = reader->ReadFloat();
+    depth.depthBiasSlopeFactor = reader->ReadFloat();
+    depth.stencilTestEnabled = reader->ReadUInt32() != 0;
+    depth.stencilFront = _ReadStencilState(reader);
+    depth.stencilBack = _ReadStencilState(reader);
+
+    BgiMultiSampleState& multiSample = desc.multiSampleState;
+    multiSample.multiSampleEnable = reader->ReadUInt32() != 0;
+    multiSample.alphaToCoverageEnable = reader->ReadUInt32() != 0;
+    multiSample.alphaToOneEnable = reader->ReadUInt32() != 0;
+    multiSample.sampleCount = BgiSampleCount(reader->ReadUInt32());
+
+    BgiRasterizationState& raster = desc.rasterizationState;
+    raster.polygonMode = BgiPolygonMode(reader->ReadUInt32());
+    raster.lineWidth = reader->ReadFloat();
+    raster.cullMode = BgiCullMode(reader->ReadUInt32());
+    raster.winding = BgiWinding(reader->ReadUInt32());
+    raster.rasterizerEnabled = reader->ReadUInt32() != 0;
+    raster.depthClampEnabled = reader->ReadUInt32() != 0;
+    raster.depthRange[0] = reader->ReadFloat();
+    raster.depthRange[1] = reader->ReadFloat();
+    raster.conservativeRaster = reader->ReadUInt32() != 0;
+    raster.numClipDistances = (size_t) reader->ReadUInt64();
+
+    uint32_t const vboCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < vboCount && !reader->HasFailed(); i++) {
+        BgiVertexBufferDesc vbo;
+        vbo.bindingIndex = reader->ReadUInt32();
+        uint32_t const attrCount = reader->ReadUInt32();
+        for (uint32_t a = 0; a < attrCount && !reader->HasFailed(); a++) {
+            BgiVertexAttributeDesc attr;
+            attr.format = BgiFormat(reader->ReadUInt32());
+            attr.offset = reader->ReadUInt32();
+            attr.shaderBindLocation = reader->ReadUInt32();
+            vbo.vertexAttributes.push_back(attr);
+        }
+        vbo.vertexStepFunction =
+            BgiVertexBufferStepFunction(reader->ReadUInt32());
+        vbo.vertexStride = reader->ReadUInt32();
+        desc.vertexBuffers.push_back(std::move(vbo));
+    }
+
+    desc.colorAttachmentDescs = _ReadAttachmentDescs(reader);
+    desc.colorResolveAttachmentDescs = _ReadAttachmentDescs(reader);
+    desc.depthAttachmentDesc = reader->ReadAttachmentDesc();
+    desc.depthResolveAttachmentDesc = reader->ReadAttachmentDesc();
+
+    BgiGraphicsShaderConstantsDesc& constants = desc.shaderConstantsDesc;
+    constants.byteSize = reader->ReadUInt32();
+    constants.stageUsage = reader->ReadUInt32();
+    uint32_t const rangeCount = reader->ReadUInt32();
+    for (uint32_t i = 0; i < rangeCount && !reader->HasFailed(); i++) {
+        BgiGraphicsShaderConstantsRange range;
+        range.byteOffset = reader->ReadUInt32();
+        range.byteSize = reader->ReadUInt32();
+        range.stageUsage = reader->ReadUInt32();
+        constants.ranges.push_back(range);
+    }
+
+    BgiTessellationState& tess = desc.tessellationState;
+    tess.patchType = BgiTessellationState::PatchType(reader->ReadUInt32());
+    tess.primitiveIndexSize = (int) reader->ReadUInt32();
+    tess.tessFactorMode =
+        BgiTessellationState::TessFactorMode(reader->ReadUInt32());
+    for (int i = 0; i < 2; i++) {
+        tess.tessellationLevel.innerTessLevel[i] = reader->ReadFloat();
+    }
+    for (int i = 0; i < 4; i++) {
+        tess.tessellationLevel.outerTessLevel[i] = reader->ReadFloat();
+    }
+    return desc;
+}
+
+// Must match _ReadComputePipelineDesc.
+static void
+_WriteComputePipelineDesc(
+    BgiCommandStreamWriter* writer,
+    BgiComputePipelineDesc const& desc)
+{
+    writer->WriteString(desc.debugName.c_str());
+    writer->WriteUInt64(desc.shaderProgram ? desc.shaderProgram.GetId() : 0);
+    writer->WriteUInt32(desc.shaderConstantsDesc.byteSize);
+}
+
+static BgiComputePipelineDesc
+_ReadComputePipelineDesc(
+    BgiCommandStreamReader* reader,
+    BgiCommandStreamResources const& resources,
+    bool* ok)
+{
+    BgiComputePipelineDesc desc;
+    desc.debugName = reader->ReadString();
+    desc.shaderProgram =
+        _Lookup(resources.shaderPrograms, reader->ReadUInt64(), ok);
+    desc.shaderConstantsDesc.byteSize = reader->ReadUInt32();
+    return desc;
+}
+
+//
+// Manifest
+//
+
+void
+BgiCommandStreamWriteManifest(
+    Bgi* bgi,
+    BgiCommandStreamResources const& streamResources,
+    BgiCommandStreamWriter* writer)
+{
+    BgiCommandStreamResources resources = streamResources;
+    _GatherReferencedResources(&resources);
+
+    std::vector<std::vector<uint8_t>> bufferContents;
+    std::vector<std::vector<uint8_t>> textureContents;
+    _ReadBackContents(bgi, resources, &bufferContents, &textureContents);
+
+    std::vector<uint64_t> ids = _GetSortedIds(resources.shaderFunctions);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (uint64_t id : ids) {
+        writer->WriteUInt64(id);
+        _WriteShaderFunctionDesc(
+            writer, resources.shaderFunctions.at(id)->GetDescriptor());
+    }
+
+    ids = _GetSortedIds(resources.shaderPrograms);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (uint64_t id : ids) {
+        BgiShaderProgramHandle const& program = resources.shaderPrograms.at(id);
+        writer->WriteUInt64(id);
+        writer->WriteString(program->GetDescriptor().debugName.c_str());
+        _WriteIds(writer, program->GetShaderFunctions());
+    }
+
+    ids = _GetSortedIds(resources.samplers);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (uint64_t id : ids) {
+        writer->WriteUInt64(id);
+        _WriteSamplerDesc(writer, resources.samplers.at(id)->GetDescripter());
+    }
+
+    ids = _GetSortedIds(resources.buffers);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        writer->WriteUInt64(ids[i]);
+        _WriteBufferDesc(
+            writer,
+            resources.buffers.at(ids[i])->GetDescriptor(),
+            bufferContents[i]);
+    }
+
+    ids = _GetSortedIds(resources.textures);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        writer->WriteUInt64(ids[i]);
+        _WriteTextureDesc(
+            writer,
+            resources.textures.at(ids[i])->GetDescriptor(),
+            textureContents[i]);
+    }
+
+    ids = _GetSortedIds(resources.queryPools);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (uint64_t id : ids) {
+        writer->WriteUInt64(id);
+        _WriteQueryPoolDesc(
+            writer, resources.queryPools.at(id)->GetDescriptor());
+    }
+
+    ids = _GetSortedIds(resources.resourceBindings);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (uint64_t id : ids) {
+        writer->WriteUInt64(id);
+        _WriteResourceBindingsDesc(
+            writer, resources.resourceBindings.at(id)->GetDescriptor());
+    }
+
+    ids = _GetSortedIds(resources.graphicsPipelines);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (uint64_t id : ids) {
+        writer->WriteUInt64(id);
+        _WriteGraphicsPipelineDesc(
+            writer, resources.graphicsPipelines.at(id)->GetDescriptor());
+    }
+
+    ids = _GetSortedIds(resources.computePipelines);
+    writer->WriteUInt32((uint32_t) ids.size());
+    for (uint64_t id : ids) {
+        writer->WriteUInt64(id);
+        _WriteComputePipelineDesc(
+            writer, resources.computePipelines.at(id)->GetDescriptor());
+    }
+}
+
+bool
+BgiCommandStreamReadManifest(
+    Bgi* bgi,
+    BgiCommandStreamReader* reader,
+    BgiCommandStreamResources* resources)
+{
+    bool ok = true;
+
+    uint32_t count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        std::string declarations;
+        std::string code;
+        BgiShaderFunctionDesc const desc =
+            _ReadShaderFunctionDesc(reader, &declarations, &code);
+        if (reader->HasFailed()) {
+            break;
+        }
+
+        BgiShaderFunctionHandle function = bgi->CreateShaderFunction(desc);
+        resources->shaderFunctions[id] = function;
+        if (!function->IsValid()) {
+            UTILS_WARN("Failed to compile shader function %s: %s",
+                desc.debugName.c_str(),
+                function->GetCompileErrors().c_str());
+            ok = false;
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiShaderProgramDesc desc;
+        desc.debugName = reader->ReadString();
+        desc.shaderFunctions =
+            _ReadIds(reader, resources->shaderFunctions, &ok);
+        if (!ok || reader->HasFailed()) {
+            break;
+        }
+
+        BgiShaderProgramHandle program = bgi->CreateShaderProgram(desc);
+        resources->shaderPrograms[id] = program;
+        if (!program->IsValid()) {
+            UTILS_WARN("Failed to link shader program %s: %s",
+                desc.debugName.c_str(),
+                program->GetCompileErrors().c_str());
+            ok = false;
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiSamplerDesc const desc = _ReadSamplerDesc(reader);
+        if (!reader->HasFailed()) {
+            resources->samplers[id] = bgi->CreateSampler(desc);
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiBufferDesc const desc = _ReadBufferDesc(reader);
+        if (!reader->HasFailed()) {
+            resources->buffers[id] = bgi->CreateBuffer(desc);
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiTextureDesc const desc = _ReadTextureDesc(reader);
+        if (!reader->HasFailed()) {
+            resources->textures[id] = bgi->CreateTexture(desc);
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiQueryPoolDesc const desc = _ReadQueryPoolDesc(reader);
+        if (!reader->HasFailed()) {
+            resources->queryPools[id] = bgi->CreateQueryPool(desc);
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiResourceBindingsDesc const desc =
+            _ReadResourceBindingsDesc(reader, *resources, &ok);
+        if (ok && !reader->HasFailed()) {
+            resources->resourceBindings[id] =
+                bgi->CreateResourceBindings(desc);
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiGraphicsPipelineDesc const desc =
+            _ReadGraphicsPipelineDesc(reader, *resources, &ok);
+        if (ok && !reader->HasFailed()) {
+            resources->graphicsPipelines[id] =
+                bgi->CreateGraphicsPipeline(desc);
+        }
+    }
+
+    count = reader->ReadUInt32();
+    for (uint32_t i = 0; i < count && ok && !reader->HasFailed(); i++) {
+        uint64_t const id = reader->ReadUInt64();
+        BgiComputePipelineDesc const desc =
+            _ReadComputePipelineDesc(reader, *resources, &ok);
+        if (ok && !reader->HasFailed()) {
+            resources->computePipelines[id] =
+                bgi->CreateComputePipeline(desc);
+        }
+    }
+
+    return ok && !reader->HasFailed() && reader->IsAtEnd();
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/api.h"
+#include "driver/bgiBase/commandStream.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class Bgi;
+
+/// Writes the manifest of 'resources' and of the resources they refer to:
+/// their descriptors, the shader code of shader functions and the contents
+/// of buffers and textures, which are read back with 'bgi'.
+BGI_API
+void BgiCommandStreamWriteManifest(
+    Bgi* bgi,
+    BgiCommandStreamResources const& resources,
+    BgiCommandStreamWriter* writer);
+
+/// Creates the resources of the manifest read by 'reader' in 'bgi' and adds
+/// them to 'resources' under the ids they were written with. Returns false
+/// if the manifest is malformed or a resource could not be created; the
+/// resources created so far are left in 'resources'.
+BGI_API
+bool BgiCommandStreamReadManifest(
+    Bgi* bgi,
+    BgiCommandStreamReader* reader,
+    BgiCommandStreamResources* resources);
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
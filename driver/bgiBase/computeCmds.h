@@ -6,6 +6,7 @@
 #include "driver/bgiBase/cmds.h"
 #include "driver/bgiBase/resourceBindings.h"
 #include "driver/bgiBase/computePipeline.h"
+#include "driver/bgiBase/queryPool.h"
 
 #include <memory.h>
 
@@ -48,6 +49,15 @@ public:
     BGI_API
     virtual void BindResources(BgiResourceBindingsHandle resources) = 0;
 
+    /// Bind resources that have buffers with dynamic offsets (see
+    /// BgiBufferBindingDesc::dynamicOffset). 'dynamicOffsets' holds one
+    /// offset for each buffer of those bindings, ordered by binding index
+    /// and then by array element.
+    BGI_API
+    virtual void BindResources(
+        BgiResourceBindingsHandle resources,
+        std::vector<uint32_t> const& dynamicOffsets) = 0;
+
     /// Set Push / Function constants.
     /// `pipeline` is the compute pipeline that you are binding before the
     /// draw call. It contains the program used for the uniform buffer
@@ -63,11 +73,79 @@ public:
         uint32_t byteSize,
         const void* data) = 0;
 
+    /// Update part of the Push / Function constants.
+    /// Same as above, but only writes `byteSize` bytes at `byteOffset` in the
+    /// constants block and leaves the other bytes as they were set before.
+    /// `byteOffset` and `byteSize` must be multiples of 4.
+    BGI_API
+    virtual void SetConstantValues(
+        BgiComputePipelineHandle pipeline,
+        uint32_t bindIndex,
+        uint32_t byteOffset,
+        uint32_t byteSize,
+        const void* data) = 0;
+
     /// Execute a compute shader with provided thread group count in each
     /// dimension.
     BGI_API
     virtual void Dispatch(int dimX, int dimY, int dimZ) = 0;
 
+    /// Execute a compute shader with the thread group count read on the GPU
+    /// from `dispatchParameterBuffer`, so earlier passes can size the
+    /// dispatch without a readback.
+    /// `dispatchParameterBuffer`: holds a structure:
+    //     struct DispatchIndirectCommand {
+    //         uint32_t groupCountX;
+    //         uint32_t groupCountY;
+    //         uint32_t groupCountZ;
+    //     }
+    /// Unlike Dispatch, the counts are work groups and not threads.
+    /// `byteOffset`: Byte offset of the structure, a multiple of 4.
+    BGI_API
+    virtual void DispatchIndirect(
+        BgiBufferHandle const& dispatchParameterBuffer,
+        uint32_t byteOffset) = 0;
+
+    /// Resets `queryCount` queries of `queryPool` starting at `firstQuery`.
+    /// Queries must be reset before they are begun or written again.
+    BGI_API
+    virtual void ResetQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount) = 0;
+
+    /// Begins pipeline statistics query `query`, which counts the dispatches
+    /// recorded until EndQuery.
+    BGI_API
+    virtual void BeginQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) = 0;
+
+    /// Ends query `query` begun by BeginQuery.
+    BGI_API
+    virtual void EndQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) = 0;
+
+    /// Writes the GPU time at which all previous commands completed into
+    /// timestamp query `query`.
+    BGI_API
+    virtual void WriteTimestamp(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) = 0;
+
+    /// Copies the results of `queryCount` queries starting at `firstQuery`
+    /// into `buffer` at `byteOffset`, tightly packed with
+    /// BgiQueryPool::GetResultByteSize bytes per query. The copy waits on the
+    /// GPU for the results, but not on the CPU.
+    BGI_API
+    virtual void ResolveQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset) = 0;
+
     /// Inserts a barrier so that data written to memory by commands before
     /// the barrier is available to commands after the barrier.
     BGI_API
@@ -54,6 +54,20 @@ using BgiBits = uint32_t;
 ///   The device requires workaround for primitive id</li>
 /// <li>BgiDeviceCapabilitiesBitsIndirectCommandBuffers:
 ///   Indirect command buffers are supported</li>
+/// <li>BgiDeviceCapabilitiesBitsBufferDeviceAddress:
+///   Shaders can access buffers through their GPU address</li>
+/// <li>BgiDeviceCapabilitiesBitsDrawIndirectCount:
+///   Indirect draws can read the number of draws from a GPU buffer</li>
+/// <li>BgiDeviceCapabilitiesBitsIndexTypeUint8:
+///   Index buffers can hold 8 bit indices</li>
+/// <li>BgiDeviceCapabilitiesBitsOcclusionQueryPrecise:
+///   Occlusion queries can count the exact number of samples</li>
+/// <li>BgiDeviceCapabilitiesBitsPipelineStatisticsQuery:
+///   Pipeline statistics queries are supported</li>
+/// <li>BgiDeviceCapabilitiesBitsTimestampQuery:
+///   Timestamp queries are supported</li>
+/// <li>BgiDeviceCapabilitiesBitsConditionalRendering:
+///   Draws can be skipped by the GPU based on a value in a buffer</li>
 /// </ul>
 ///
 enum BgiDeviceCapabilitiesBits : BgiBits
@@ -76,6 +90,13 @@ enum BgiDeviceCapabilitiesBits : BgiBits
     BgiDeviceCapabilitiesBitsBasePrimitiveOffset     = 1 << 15,
     BgiDeviceCapabilitiesBitsPrimitiveIdEmulation    = 1 << 16,
     BgiDeviceCapabilitiesBitsIndirectCommandBuffers  = 1 << 17,
+    BgiDeviceCapabilitiesBitsBufferDeviceAddress     = 1 << 18,
+    BgiDeviceCapabilitiesBitsDrawIndirectCount       = 1 << 19,
+    BgiDeviceCapabilitiesBitsIndexTypeUint8          = 1 << 20,
+    BgiDeviceCapabilitiesBitsOcclusionQueryPrecise   = 1 << 21,
+    BgiDeviceCapabilitiesBitsPipelineStatisticsQuery = 1 << 22,
+    BgiDeviceCapabilitiesBitsTimestampQuery          = 1 << 23,
+    BgiDeviceCapabilitiesBitsConditionalRendering    = 1 << 24,
 };
 
 using BgiDeviceCapabilities = BgiBits;
@@ -289,6 +310,21 @@ enum BgiAttachmentStoreOp
 ///   Vertex attributes.</li>
 /// <li>BgiBufferUsageStorage:
 ///   Shader storage buffer / Argument buffer.</li>
+/// <li>BgiBufferUsageDeviceAddress:
+///   Shaders access the buffer through its GPU address, see
+///   BgiBuffer::GetDeviceAddress. Requires
+///   BgiDeviceCapabilitiesBitsBufferDeviceAddress.</li>
+/// <li>BgiBufferUsageIndex16:
+///   Topology 16 bit indices.</li>
+/// <li>BgiBufferUsageIndex8:
+///   Topology 8 bit indices. Requires
+///   BgiDeviceCapabilitiesBitsIndexTypeUint8.</li>
+/// <li>BgiBufferUsagePredicate:
+///   Holds the values of BgiGraphicsCmds::BeginConditionalRendering.
+///   Requires BgiDeviceCapabilitiesBitsConditionalRendering.</li>
+/// <li>BgiBufferUsageIndirect:
+///   Holds the parameters of indirect draws or dispatches only. Unlike
+///   BgiBufferUsageStorage the buffer can not be bound to shaders.</li>
 ///
 /// <li>BgiBufferUsageCustomBitsBegin:
 ///   This bit (and any bit after) can be used to attached custom, backend
@@ -301,8 +337,13 @@ enum BgiBufferUsageBits : BgiBits
     BgiBufferUsageIndex32 = 1 << 1,
     BgiBufferUsageVertex  = 1 << 2,
     BgiBufferUsageStorage = 1 << 3,
+    BgiBufferUsageDeviceAddress = 1 << 4,
+    BgiBufferUsageIndex16 = 1 << 5,
+    BgiBufferUsageIndex8  = 1 << 6,
+    BgiBufferUsagePredicate = 1 << 7,
+    BgiBufferUsageIndirect = 1 << 8,
 
-    BgiBufferUsageCustomBitsBegin = 1 << 4,
+    BgiBufferUsageCustomBitsBegin = 1 << 9,
 };
 using BgiBufferUsage = BgiBits;
 
@@ -807,6 +848,101 @@ enum BgiComputeDispatch
     BgiComputeDispatchConcurrent
 };
 
+/// \enum BgiQueryType
+///
+/// Describes what the queries of a query pool measure.
+///
+/// <ul>
+/// <li>BgiQueryTypeOcclusion:
+///   Non-zero if any samples passed the depth and stencil tests.</li>
+/// <li>BgiQueryTypeOcclusionPrecise:
+///   The number of samples that passed the depth and stencil tests.
+///   Requires BgiDeviceCapabilitiesBitsOcclusionQueryPrecise.</li>
+/// <li>BgiQueryTypePipelineStatistics:
+///   Counters of the pipeline statistics of the pool.
+///   Requires BgiDeviceCapabilitiesBitsPipelineStatisticsQuery.</li>
+/// <li>BgiQueryTypeTimestamp:
+///   The GPU time, in ticks of BgiQueryPool::GetTimestampPeriod.
+///   Requires BgiDeviceCapabilitiesBitsTimestampQuery.</li>
+/// </ul>
+///
+enum BgiQueryType
+{
+    BgiQueryTypeOcclusion = 0,
+    BgiQueryTypeOcclusionPrecise,
+    BgiQueryTypePipelineStatistics,
+    BgiQueryTypeTimestamp,
+
+    BgiQueryTypeCount
+};
+
+/// \enum BgiPipelineStatisticsBits
+///
+/// The counters a pipeline statistics query pool collects. Results hold one
+/// value per enabled counter, in the order of the bits.
+///
+/// <ul>
+/// <li>BgiPipelineStatisticsBitsInputAssemblyVertices:
+///   Vertices read by the input assembler.</li>
+/// <li>BgiPipelineStatisticsBitsInputAssemblyPrimitives:
+///   Primitives assembled by the input assembler.</li>
+/// <li>BgiPipelineStatisticsBitsVertexShaderInvocations:
+///   Vertex shader invocations.</li>
+/// <li>BgiPipelineStatisticsBitsClippingInvocations:
+///   Primitives that reached the clipping stage.</li>
+/// <li>BgiPipelineStatisticsBitsClippingPrimitives:
+///   Primitives that were output by the clipping stage.</li>
+/// <li>BgiPipelineStatisticsBitsFragmentShaderInvocations:
+///   Fragment shader invocations.</li>
+/// <li>BgiPipelineStatisticsBitsComputeShaderInvocations:
+///   Compute shader invocations.</li>
+/// </ul>
+///
+enum BgiPipelineStatisticsBits : BgiBits
+{
+    BgiPipelineStatisticsBitsInputAssemblyVertices     = 1 << 0,
+    BgiPipelineStatisticsBitsInputAssemblyPrimitives   = 1 << 1,
+    BgiPipelineStatisticsBitsVertexShaderInvocations   = 1 << 2,
+    BgiPipelineStatisticsBitsClippingInvocations       = 1 << 3,
+    BgiPipelineStatisticsBitsClippingPrimitives        = 1 << 4,
+    BgiPipelineStatisticsBitsFragmentShaderInvocations = 1 << 5,
+    BgiPipelineStatisticsBitsComputeShaderInvocations  = 1 << 6,
+};
+
+using BgiPipelineStatistics = BgiBits;
+
+/// \enum BgiMemoryResourceKind
+///
+/// The kinds of resources whose memory is accounted separately.
+///
+/// <ul>
+/// <li>BgiMemoryResourceKindBuffer:
+///   Buffers created with Bgi::CreateBuffer.</li>
+/// <li>BgiMemoryResourceKindTexture:
+///   Textures created with Bgi::CreateTexture. Views share the memory of
+///   their source texture and are not counted.</li>
+/// <li>BgiMemoryResourceKindStaging:
+///   Host visible buffers used to upload the initial data of buffers and
+///   textures.</li>
+/// <li>BgiMemoryResourceKindPipeline:
+///   Graphics and compute pipelines. Their memory is owned by the driver,
+///   so only their count is known.</li>
+/// <li>BgiMemoryResourceKindDescriptorPool:
+///   Descriptor pools and descriptor buffers. The memory of descriptor pools
+///   is owned by the driver, so only the descriptor buffers add bytes.</li>
+/// </ul>
+///
+enum BgiMemoryResourceKind
+{
+    BgiMemoryResourceKindBuffer = 0,
+    BgiMemoryResourceKindTexture,
+    BgiMemoryResourceKindStaging,
+    BgiMemoryResourceKindPipeline,
+    BgiMemoryResourceKindDescriptorPool,
+
+    BgiMemoryResourceKindCount
+};
+
 }
 
 GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/api.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+/// \struct BgiGpuTimingScope
+///
+/// The GPU time measured between a PushDebugGroup and its PopDebugGroup.
+///
+/// <ul>
+/// <li>label:
+///   The label passed to PushDebugGroup.</li>
+/// <li>startMs:
+///   Milliseconds from the start of the frame to the start of the scope.</li>
+/// <li>durationMs:
+///   Milliseconds the GPU spent in the scope.</li>
+/// <li>children:
+///   The scopes of the debug groups pushed inside this one, in the order
+///   they were pushed.</li>
+/// </ul>
+///
+struct BgiGpuTimingScope
+{
+    std::string label;
+    double startMs = 0.0;
+    double durationMs = 0.0;
+    std::vector<BgiGpuTimingScope> children;
+};
+
+using BgiGpuTimingScopeVector = std::vector<BgiGpuTimingScope>;
+
+/// \struct BgiGpuFrameTimings
+///
+/// The GPU timings of the debug groups of one frame.
+///
+/// <ul>
+/// <li>frameNumber:
+///   The number of the frame, counting the outermost StartFrame calls.</li>
+/// <li>durationMs:
+///   Milliseconds from the start of the first scope to the end of the last
+///   scope of the frame.</li>
+/// <li>scopes:
+///   The outermost scopes of the frame, in the order they were pushed.</li>
+/// </ul>
+///
+struct BgiGpuFrameTimings
+{
+    uint64_t frameNumber = 0;
+    double durationMs = 0.0;
+    BgiGpuTimingScopeVector scopes;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -7,6 +7,7 @@
 #include "driver/bgiBase/cmds.h"
 #include "driver/bgiBase/graphicsCmdsDesc.h"
 #include "driver/bgiBase/graphicsPipeline.h"
+#include "driver/bgiBase/queryPool.h"
 #include "driver/bgiBase/resourceBindings.h"
 
 #include <memory>
@@ -61,6 +62,15 @@ public:
     BGI_API
     virtual void BindResources(BgiResourceBindingsHandle resources) = 0;
 
+    /// Bind resources that have buffers with dynamic offsets (see
+    /// BgiBufferBindingDesc::dynamicOffset). 'dynamicOffsets' holds one
+    /// offset for each buffer of those bindings, ordered by binding index
+    /// and then by array element.
+    BGI_API
+    virtual void BindResources(
+        BgiResourceBindingsHandle resources,
+        std::vector<uint32_t> const& dynamicOffsets) = 0;
+
     /// Set Push / Function constants.
     /// `pipeline` is the pipeline that you are binding before the draw call. It
     /// contains the program used for the uniform buffer
@@ -79,6 +89,19 @@ public:
         uint32_t byteSize,
         const void* data) = 0;
 
+    /// Update part of the Push / Function constants.
+    /// Same as above, but only writes `byteSize` bytes at `byteOffset` in the
+    /// constants block and leaves the other bytes as they were set before.
+    /// `byteOffset` and `byteSize` must be multiples of 4.
+    BGI_API
+    virtual void SetConstantValues(
+        BgiGraphicsPipelineHandle pipeline,
+        BgiShaderStage stages,
+        uint32_t bindIndex,
+        uint32_t byteOffset,
+        uint32_t byteSize,
+        const void* data) = 0;
+
     /// Binds the vertex buffer(s) that describe the vertex attributes.
     BGI_API
     virtual void BindVertexBuffers(
@@ -124,9 +147,12 @@ public:
     /// using an indexBuffer starting from the base vertex.
     /// The 'primitive type' (eg. Lines, Triangles, etc) can be acquired from
     /// the bound HgiPipeline.
+    /// The size of the indices follows the index usage of the buffer
+    /// (BgiBufferUsageIndex32, BgiBufferUsageIndex16 or BgiBufferUsageIndex8).
     /// `indexCount`: The number of indices in the index buffer (num vertices).
     /// `indexBufferByteOffset`: Byte offset within index buffer to start
-    ///                          reading the indices from.
+    ///                          reading the indices from. Must be a multiple
+    ///                          of the index size.
     /// `baseVertex`: The value added to the vertex index before indexing
     ///                 into the vertex buffer (baseVertex).
     /// `instanceCount`: Number of instances to draw.
@@ -179,6 +205,97 @@ public:
         std::vector<uint32_t> const& drawParameterBufferUInt32,
         uint32_t patchBaseVertexByteOffset) = 0;
 
+    /// Records a multi-draw command like DrawIndirect, but the number of
+    /// draws is read on the GPU, e.g. after a culling pass compacted the
+    /// draw parameters.
+    /// `countBuffer`: buffer holding the number of draws as a uint32_t.
+    /// `countBufferByteOffset`: Byte offset of the count in countBuffer.
+    /// `maxDrawCount`: The most draws that are executed, whatever the count.
+    /// Requires BgiDeviceCapabilitiesBitsDrawIndirectCount.
+    BGI_API
+    virtual void DrawIndirectCount(
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        BgiBufferHandle const& countBuffer,
+        uint32_t countBufferByteOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride) = 0;
+
+    /// Records an indexed multi-draw command like DrawIndexedIndirect, but
+    /// the number of draws is read on the GPU from `countBuffer` at
+    /// `countBufferByteOffset` and clamped to `maxDrawCount`.
+    /// Requires BgiDeviceCapabilitiesBitsDrawIndirectCount.
+    BGI_API
+    virtual void DrawIndexedIndirectCount(
+        BgiBufferHandle const& indexBuffer,
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        BgiBufferHandle const& countBuffer,
+        uint32_t countBufferByteOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride) = 0;
+
+    /// Resets `queryCount` queries of `queryPool` starting at `firstQuery`.
+    /// Queries must be reset before they are begun or written again.
+    /// Must be recorded before the first draw of the cmds.
+    BGI_API
+    virtual void ResetQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount) = 0;
+
+    /// Begins occlusion or pipeline statistics query `query`, which counts
+    /// the draws recorded until EndQuery. A query covers the draws of one
+    /// render pass, see the backend for what ends a render pass.
+    BGI_API
+    virtual void BeginQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) = 0;
+
+    /// Ends query `query` begun by BeginQuery.
+    BGI_API
+    virtual void EndQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) = 0;
+
+    /// Writes the GPU time at which all previous commands completed into
+    /// timestamp query `query`.
+    BGI_API
+    virtual void WriteTimestamp(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) = 0;
+
+    /// Copies the results of `queryCount` queries starting at `firstQuery`
+    /// into `buffer` at `byteOffset`, tightly packed with
+    /// BgiQueryPool::GetResultByteSize bytes per query. The copy waits on the
+    /// GPU for the results, but not on the CPU, and is recorded after the
+    /// draws of the cmds.
+    BGI_API
+    virtual void ResolveQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset) = 0;
+
+    /// Begins a block of draws that the GPU skips when the 32 bit value at
+    /// `byteOffset` in `buffer` is zero, or non-zero if `inverted` is true.
+    /// The value is read when the block begins, so it can be written by
+    /// earlier GPU work, e.g. by resolving the occlusion queries of bounding
+    /// boxes from a previous pass, without a CPU readback.
+    /// `buffer` must have BgiBufferUsagePredicate and `byteOffset` must be a
+    /// multiple of 4. Blocks can not be nested.
+    /// Requires BgiDeviceCapabilitiesBitsConditionalRendering.
+    BGI_API
+    virtual void BeginConditionalRendering(
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset,
+        bool inverted) = 0;
+
+    /// Ends the block begun by BeginConditionalRendering.
+    BGI_API
+    virtual void EndConditionalRendering() = 0;
+
     /// Inserts a barrier so that data written to memory by commands before
     /// the barrier is available to commands after the barrier.
     BGI_API
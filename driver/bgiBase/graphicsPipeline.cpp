@@ -177,6 +177,29 @@ bool operator!=(
     return !(lhs == rhs);
 }
 
+BgiGraphicsShaderConstantsRange::BgiGraphicsShaderConstantsRange()
+    : byteOffset(0)
+    , byteSize(0)
+    , stageUsage(BgiShaderStageFragment)
+{
+}
+
+bool operator==(
+    const BgiGraphicsShaderConstantsRange& lhs,
+    const BgiGraphicsShaderConstantsRange& rhs)
+{
+    return lhs.byteOffset == rhs.byteOffset &&
+           lhs.byteSize == rhs.byteSize &&
+           lhs.stageUsage == rhs.stageUsage;
+}
+
+bool operator!=(
+    const BgiGraphicsShaderConstantsRange& lhs,
+    const BgiGraphicsShaderConstantsRange& rhs)
+{
+    return !(lhs == rhs);
+}
+
 BgiGraphicsShaderConstantsDesc::BgiGraphicsShaderConstantsDesc()
     : byteSize(0)
     , stageUsage(BgiShaderStageFragment)
@@ -188,7 +211,8 @@ bool operator==(
     const BgiGraphicsShaderConstantsDesc& rhs)
 {
     return lhs.byteSize == rhs.byteSize &&
-           lhs.stageUsage == rhs.stageUsage;
+           lhs.stageUsage == rhs.stageUsage &&
+           lhs.ranges == rhs.ranges;
 }
 
 bool operator!=(
@@ -288,6 +288,40 @@ bool operator!=(
     const BgiDepthStencilState& lhs,
     const BgiDepthStencilState& rhs);
 
+/// \struct BgiGraphicsShaderConstantsRange
+///
+/// A part of the shader constants that is used by some shader stages.
+///
+/// <ul>
+/// <li>byteOffset:
+///    Offset of the range in the constants in bytes. (multiple of 4)</li>
+/// <li>byteSize:
+///    Size of the range in bytes. (multiple of 4)</li>
+/// <li>stageUsage:
+///    What shader stage(s) read this range.</li>
+/// </ul>
+///
+struct BgiGraphicsShaderConstantsRange {
+    BGI_API
+    BgiGraphicsShaderConstantsRange();
+
+    uint32_t byteOffset;
+    uint32_t byteSize;
+    BgiShaderStage stageUsage;
+};
+using BgiGraphicsShaderConstantsRangeVector =
+    std::vector<BgiGraphicsShaderConstantsRange>;
+
+BGI_API
+bool operator==(
+    const BgiGraphicsShaderConstantsRange& lhs,
+    const BgiGraphicsShaderConstantsRange& rhs);
+
+BGI_API
+bool operator!=(
+    const BgiGraphicsShaderConstantsRange& lhs,
+    const BgiGraphicsShaderConstantsRange& rhs);
+
 /// \struct HgiGraphicsShaderConstantsDesc
 ///
 /// A small, but fast buffer of uniform data for shaders.
@@ -297,6 +331,11 @@ bool operator!=(
 ///    Size of the constants in bytes. (max 256 bytes)</li>
 /// <li>stageUsage:
 ///    What shader stage(s) the constants will be used in.</li>
+/// <li>ranges:
+///    Optional. Splits the constants in ranges that are each used by their
+///    own shader stages, e.g. a vertex range followed by a fragment range.
+///    When not empty the ranges replace stageUsage and byteSize must cover
+///    the end of every range.</li>
 /// </ul>
 ///
 struct BgiGraphicsShaderConstantsDesc {
@@ -305,6 +344,7 @@ struct BgiGraphicsShaderConstantsDesc {
 
     uint32_t byteSize;
     BgiShaderStage stageUsage;
+    BgiGraphicsShaderConstantsRangeVector ranges;
 };
 
 BGI_API
@@ -379,7 +419,9 @@ struct BgiTessellationState
 ///   Various settings to control rasterization.</li>
 /// <li>vertexBuffers:
 ///   Description of the vertex buffers (per-vertex attributes).
-///   The actual VBOs are bound via GraphicsCmds.</li>
+///   The actual VBOs are bound via GraphicsCmds. Leave empty for shaders
+///   that pull their vertices from buffers themselves, e.g. by device
+///   address.</li>
 /// <li>colorAttachmentDescs:
 ///   Describes each of the color attachments.</li>
 /// <li>colorResolveAttachmentDescs:
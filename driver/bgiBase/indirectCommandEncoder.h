@@ -47,7 +47,7 @@ using BgiIndirectCommandsUniquePtr = std::unique_ptr<BgiIndirectCommands>;
 /// in the HgiIndirectCommands structure.  This is sub-classed based on the
 /// platform implementation to maintain all the custom state.
 /// Execute draw takes the HgiIndirectCommands structure and replays it on the
-/// device.  Currently this is only implemented on the Metal HGI device.
+/// device.  BgiVulkan implements it with indirect draws from a GPU buffer.
 ///
 class BgiIndirectCommandEncoder : public BgiCmds
 {
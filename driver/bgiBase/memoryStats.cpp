@@ -0,0 +1,63 @@
+#include "driver/bgiBase/memoryStats.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+static const char*
+_GetResourceKindName(BgiMemoryResourceKind kind)
+{
+    switch (kind) {
+    case BgiMemoryResourceKindBuffer:         return "buffer";
+    case BgiMemoryResourceKindTexture:        return "texture";
+    case BgiMemoryResourceKindStaging:        return "staging";
+    case BgiMemoryResourceKindPipeline:       return "pipeline";
+    case BgiMemoryResourceKindDescriptorPool: return "descriptorPool";
+    case BgiMemoryResourceKindCount:          break;
+    }
+    return "unknown";
+}
+
+void
+BgiWriteMemoryStatsJson(BgiMemoryStats const& stats, std::ostream& out)
+{
+    out << "{\n"
+        << "  \"frameNumber\": " << stats.frameNumber << ",\n"
+        << "  \"budgetQueried\": "
+        << (stats.budgetQueried ? "true" : "false") << ",\n"
+        << "  \"heaps\": [";
+
+    for (size_t i = 0; i < stats.heaps.size(); i++) {
+        BgiMemoryHeapStats const& heap = stats.heaps[i];
+        out << (i ? "," : "") << "\n    {"
+            << "\"index\": " << i
+            << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+            << ", \"size\": " << heap.size
+            << ", \"budget\": " << heap.budget
+            << ", \"usage\": " << heap.usage
+            << ", \"blockBytes\": " << heap.blockBytes
+            << ", \"allocationBytes\": " << heap.allocationBytes
+            << ", \"peakUsage\": " << heap.peakUsage << "}";
+    }
+
+    out << "\n  ],\n  \"resources\": {";
+
+    for (int i = 0; i < BgiMemoryResourceKindCount; i++) {
+        BgiMemoryResourceStats const& resource = stats.resources[i];
+        out << (i ? "," : "") << "\n    \""
+            << _GetResourceKindName(BgiMemoryResourceKind(i)) << "\": {"
+            << "\"count\": " << resource.count
+            << ", \"byteSize\": " << resource.byteSize
+            << ", \"frameHighWaterCount\": " << resource.frameHighWaterCount
+            << ", \"frameHighWaterByteSize\": "
+            << resource.frameHighWaterByteSize
+            << ", \"peakCount\": " << resource.peakCount
+            << ", \"peakByteSize\": " << resource.peakByteSize << "}";
+    }
+
+    out << "\n  }\n}\n";
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/api.h"
+#include "driver/bgiBase/enums.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+/// \struct BgiMemoryHeapStats
+///
+/// The memory usage of one device memory heap.
+///
+/// <ul>
+/// <li>deviceLocal:
+///   True if the heap is device local memory.</li>
+/// <li>size:
+///   The size of the heap in bytes.</li>
+/// <li>budget:
+///   The bytes the process can use from the heap before allocations are
+///   likely to fail or to degrade performance.</li>
+/// <li>usage:
+///   The bytes of the heap the process currently uses.</li>
+/// <li>blockBytes:
+///   The bytes of the memory blocks allocated from the heap.</li>
+/// <li>allocationBytes:
+///   The bytes of the resources placed in those blocks. The difference to
+///   blockBytes is free space or fragmentation.</li>
+/// <li>peakUsage:
+///   The highest usage seen at the end of a frame or when the stats were
+///   queried.</li>
+/// </ul>
+///
+struct BgiMemoryHeapStats
+{
+    bool deviceLocal = false;
+    uint64_t size = 0;
+    uint64_t budget = 0;
+    uint64_t usage = 0;
+    uint64_t blockBytes = 0;
+    uint64_t allocationBytes = 0;
+    uint64_t peakUsage = 0;
+};
+
+/// \struct BgiMemoryResourceStats
+///
+/// The live resources of one BgiMemoryResourceKind.
+///
+/// <ul>
+/// <li>count, byteSize:
+///   The number of live resources and the bytes of memory allocated for
+///   them.</li>
+/// <li>frameHighWaterCount, frameHighWaterByteSize:
+///   The highest count and bytes reached during the last completed frame.
+///   </li>
+/// <li>peakCount, peakByteSize:
+///   The highest count and bytes reached since the device was created.</li>
+/// </ul>
+///
+struct BgiMemoryResourceStats
+{
+    uint64_t count = 0;
+    uint64_t byteSize = 0;
+    uint64_t frameHighWaterCount = 0;
+    uint64_t frameHighWaterByteSize = 0;
+    uint64_t peakCount = 0;
+    uint64_t peakByteSize = 0;
+};
+
+/// \struct BgiMemoryStats
+///
+/// A snapshot of the memory used by a Bgi device.
+///
+/// <ul>
+/// <li>frameNumber:
+///   The number of frames completed, counting the outermost EndFrame calls.
+///   </li>
+/// <li>budgetQueried:
+///   True if the heap budgets were queried from the driver. Otherwise they
+///   are estimated from the heap sizes.</li>
+/// <li>heaps:
+///   The device memory heaps, in the order the device reports them.</li>
+/// <li>resources:
+///   The live resources, indexed by BgiMemoryResourceKind.</li>
+/// </ul>
+///
+struct BgiMemoryStats
+{
+    uint64_t frameNumber = 0;
+    bool budgetQueried = false;
+    std::vector<BgiMemoryHeapStats> heaps;
+    BgiMemoryResourceStats resources[BgiMemoryResourceKindCount];
+};
+
+/// Writes 'stats' to 'out' as JSON.
+BGI_API
+void BgiWriteMemoryStatsJson(BgiMemoryStats const& stats, std::ostream& out);
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
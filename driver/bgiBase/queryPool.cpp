@@ -0,0 +1,51 @@
+#include "driver/bgiBase/queryPool.h"
+
+#include <bitset>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+BgiQueryPool::BgiQueryPool(BgiQueryPoolDesc const& desc)
+    : _descriptor(desc)
+{
+}
+
+BgiQueryPool::~BgiQueryPool() = default;
+
+BgiQueryPoolDesc const&
+BgiQueryPool::GetDescriptor() const
+{
+    return _descriptor;
+}
+
+uint32_t
+BgiQueryPool::GetResultByteSize() const
+{
+    if (_descriptor.type == BgiQueryTypePipelineStatistics) {
+        std::bitset<32> const counters(_descriptor.pipelineStatistics);
+        return uint32_t(counters.count() * sizeof(uint64_t));
+    }
+    return sizeof(uint64_t);
+}
+
+bool operator==(
+    const BgiQueryPoolDesc& lhs,
+    const BgiQueryPoolDesc& rhs)
+{
+    return lhs.debugName == rhs.debugName &&
+           lhs.type == rhs.type &&
+           lhs.queryCount == rhs.queryCount &&
+           lhs.pipelineStatistics == rhs.pipelineStatistics;
+}
+
+bool operator!=(
+    const BgiQueryPoolDesc& lhs,
+    const BgiQueryPoolDesc& rhs)
+{
+    return !(lhs == rhs);
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/api.h"
+#include "driver/bgiBase/enums.h"
+#include "driver/bgiBase/handle.h"
+#include "driver/bgiBase/types.h"
+
+#include <string>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+/// \struct BgiQueryPoolDesc
+///
+/// Describes the properties needed to create a GPU query pool.
+///
+/// <ul>
+/// <li>debugName:
+///   This label can be applied as debug label for GPU debugging.</li>
+/// <li>type:
+///   What the queries of the pool measure.</li>
+/// <li>queryCount:
+///   The number of queries in the pool.</li>
+/// <li>pipelineStatistics:
+///   The counters collected by a BgiQueryTypePipelineStatistics pool.
+///   Ignored by other types.</li>
+/// </ul>
+///
+struct BgiQueryPoolDesc
+{
+    BgiQueryPoolDesc()
+    : type(BgiQueryTypeOcclusion)
+    , queryCount(0)
+    , pipelineStatistics(0)
+    {}
+
+    std::string debugName;
+    BgiQueryType type;
+    uint32_t queryCount;
+    BgiPipelineStatistics pipelineStatistics;
+};
+
+BGI_API
+bool operator==(
+    const BgiQueryPoolDesc& lhs,
+    const BgiQueryPoolDesc& rhs);
+
+BGI_API
+bool operator!=(
+    const BgiQueryPoolDesc& lhs,
+    const BgiQueryPoolDesc& rhs);
+
+///
+/// \class BgiQueryPool
+///
+/// Represents a graphics platform independent pool of GPU queries.
+/// Query pools should be created via Bgi::CreateQueryPool.
+///
+/// Queries are reset, begun, ended or written by graphics and compute cmds,
+/// which also copy their results into a buffer with ResolveQueries. The
+/// results can then be read back like any other buffer, without stalling on
+/// the queries.
+///
+class BgiQueryPool
+{
+public:
+    BGI_API
+    virtual ~BgiQueryPool();
+
+    /// The descriptor describes the object.
+    BGI_API
+    BgiQueryPoolDesc const& GetDescriptor() const;
+
+    /// Returns the number of bytes ResolveQueries writes per query: one
+    /// uint64_t per query, or per enabled counter of a pipeline statistics
+    /// pool.
+    BGI_API
+    uint32_t GetResultByteSize() const;
+
+    /// Returns the number of nanoseconds per tick of a timestamp query.
+    BGI_API
+    virtual double GetTimestampPeriod() const = 0;
+
+    /// This function returns the handle to the Bgi backend's gpu resource,
+    /// cast to a uint64_t. In Vulkan this returns the VkQueryPool.
+    BGI_API
+    virtual uint64_t GetRawResource() const = 0;
+
+protected:
+    BGI_API
+    BgiQueryPool(BgiQueryPoolDesc const& desc);
+
+    BgiQueryPoolDesc _descriptor;
+
+private:
+    BgiQueryPool() = delete;
+    BgiQueryPool & operator=(const BgiQueryPool&) = delete;
+    BgiQueryPool(const BgiQueryPool&) = delete;
+};
+
+using BgiQueryPoolHandle = BgiHandle<BgiQueryPool>;
+using BgiQueryPoolHandleVector = std::vector<BgiQueryPoolHandle>;
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
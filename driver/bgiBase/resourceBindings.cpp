@@ -21,6 +21,7 @@ BgiBufferBindingDesc::BgiBufferBindingDesc()
     : bindingIndex(0)
     , stageUsage(BgiShaderStageVertex | BgiShaderStagePostTessellationVertex)
     , writable(false)
+    , dynamicOffset(false)
 {
 }
 
@@ -34,7 +35,8 @@ bool operator==(
         lhs.sizes == rhs.sizes &&
         lhs.bindingIndex == rhs.bindingIndex &&
         lhs.stageUsage == rhs.stageUsage &&
-        lhs.writable == rhs.writable;
+        lhs.writable == rhs.writable &&
+        lhs.dynamicOffset == rhs.dynamicOffset;
 }
 
 bool operator!=(
@@ -71,7 +73,10 @@ bool operator!=(
     return !(lhs == rhs);
 }
 
-BgiResourceBindingsDesc::BgiResourceBindingsDesc() = default;
+BgiResourceBindingsDesc::BgiResourceBindingsDesc()
+    : transient(false)
+{
+}
 
 bool operator==(
     const BgiResourceBindingsDesc& lhs,
@@ -79,7 +84,8 @@ bool operator==(
 {
     return lhs.debugName == rhs.debugName &&
         lhs.buffers == rhs.buffers &&
-        lhs.textures == rhs.textures;
+        lhs.textures == rhs.textures &&
+        lhs.transient == rhs.transient;
 }
 
 bool operator!=(
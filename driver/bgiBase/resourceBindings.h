@@ -48,6 +48,13 @@ namespace driver {
 ///    What shader stage(s) the buffer will be used in.</li>
 /// <li>writable:
 ///    Whether the buffer binding should be non-const.</li>
+/// <li>dynamicOffset:
+///    Whether an offset is provided for each buffer when the resources are
+///    bound (see BgiGraphicsCmds::BindResources). The offset is added to
+///    the one in 'offsets', so one set of bindings can address many ranges
+///    of a large buffer. Only for uniform and storage buffers. A non-zero
+///    size must be specified for each buffer. The shader must declare the
+///    buffer with BgiShaderFunctionBufferDesc::dynamicOffset.</li>
 /// </ul>
 ///
 struct BgiBufferBindingDesc
@@ -62,6 +69,7 @@ struct BgiBufferBindingDesc
     uint32_t bindingIndex;
     BgiShaderStage stageUsage;
     bool writable;
+    bool dynamicOffset;
 };
 using BgiBufferBindingDescVector = std::vector<BgiBufferBindingDesc>;
 
@@ -134,6 +142,11 @@ bool operator!=(
 ///   The buffers to be bound (E.g. uniform or shader storage).</li>
 /// <li>textures:
 ///   The textures to be bound.</li>
+/// <li>transient:
+///   When true the resource bindings are only used during the frame they are
+///   created in. Backends may allocate them from cheap frame memory that is
+///   recycled when the frame retires, making it practical to create
+///   bindings per draw.</li>
 /// </ul>
 ///
 struct BgiResourceBindingsDesc
@@ -144,6 +157,7 @@ struct BgiResourceBindingsDesc
     std::string debugName;
     BgiBufferBindingDescVector buffers;
     BgiTextureBindingDescVector textures;
+    bool transient;
 };
 
 BGI_API
@@ -172,6 +186,26 @@ public:
     BGI_API
     BgiResourceBindingsDesc const& GetDescriptor() const;
 
+    /// Replaces the buffers of the existing binding at
+    /// 'bufferDesc.bindingIndex'. The binding must keep its resource type and
+    /// number of buffers. Only the descriptors of this binding are rewritten.
+    /// Draws and dispatches recorded before the update keep using the
+    /// previous buffers.
+    /// Thread safety: No. The bindings must not be bound by another thread
+    /// during the update.
+    BGI_API
+    virtual void UpdateBuffers(BgiBufferBindingDesc const& bufferDesc) = 0;
+
+    /// Replaces the textures (and samplers) of the existing binding at
+    /// 'textureDesc.bindingIndex'. The binding must keep its resource type
+    /// and number of textures. Only the descriptors of this binding are
+    /// rewritten. Draws and dispatches recorded before the update keep using
+    /// the previous textures.
+    /// Thread safety: No. The bindings must not be bound by another thread
+    /// during the update.
+    BGI_API
+    virtual void UpdateTextures(BgiTextureBindingDesc const& textureDesc) = 0;
+
 protected:
 BGI_API
     BgiResourceBindings(BgiResourceBindingsDesc const& desc);
@@ -17,6 +17,12 @@ BgiSampler::GetDescripter() const
     return _descriptor;
 }
 
+uint32_t
+BgiSampler::GetBindlessIndex() const
+{
+    return BgiBindlessIndexInvalid;
+}
+
 bool operator==(const BgiSamplerDesc& lhs,
     const BgiSamplerDesc& rhs)
 {
@@ -106,6 +106,14 @@ public:
     BGI_API
     virtual uint64_t GetRawResource() const = 0;
 
+    /// Returns the stable index of the resource in the backend's bindless
+    /// descriptor heap, or BgiBindlessIndexInvalid if the backend does not
+    /// support bindless resources or the resource's usage does not allow it.
+    /// Shader functions that declare the resource as bindless access it
+    /// through this index.
+    BGI_API
+    virtual uint32_t GetBindlessIndex() const;
+
 protected:
     BGI_API
     BgiSampler(BgiSamplerDesc const& desc);
@@ -13,6 +13,17 @@ BgiShaderFunction::GetDescriptor() const
 BgiShaderFunction::BgiShaderFunction(BgiShaderFunctionDesc const& desc)
     : _descriptor(desc)
 {
+    // The code of 'desc' may not outlive the constructor, keep a copy so
+    // the function can be recreated from its descriptor.
+    if (desc.shaderCodeDeclarations) {
+        _shaderCodeDeclarations = desc.shaderCodeDeclarations;
+        _descriptor.shaderCodeDeclarations = _shaderCodeDeclarations.c_str();
+    }
+    if (desc.shaderCode) {
+        _shaderCode = desc.shaderCode;
+        _descriptor.shaderCode = _shaderCode.c_str();
+    }
+    _descriptor.generatedShaderCodeOut = nullptr;
 }
 
 BgiShaderFunction::~BgiShaderFunction() = default;
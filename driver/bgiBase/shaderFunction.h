@@ -8,6 +8,7 @@
 #include "driver/bgiBase/types.h"
 #include "driver/bgiBase/shaderFunctionDesc.h"
 
+#include <future>
 #include <vector>
 #include <string>
 
@@ -32,7 +33,9 @@ public:
     BGI_API
     virtual ~BgiShaderFunction();
 
-    /// The descriptor describes the object.
+    /// The descriptor describes the object. It points to a copy of the
+    /// shader code the function was created from, and
+    /// generatedShaderCodeOut is cleared.
     BGI_API
     BgiShaderFunctionDesc const& GetDescriptor() const;
 
@@ -73,11 +76,19 @@ private:
     BgiShaderFunction() = delete;
     BgiShaderFunction & operator=(const BgiShaderFunction&) = delete;
     BgiShaderFunction(const BgiShaderFunction&) = delete;
+
+    std::string _shaderCodeDeclarations;
+    std::string _shaderCode;
 };
 
 using BgiShaderFunctionHandle = BgiHandle<class BgiShaderFunction>;
 using BgiShaderFunctionHandleVector = std::vector<BgiShaderFunctionHandle>;
 
+/// A shader function that may still be compiling. The handle becomes
+/// available once the future is ready (see Bgi::CreateShaderFunctions).
+using BgiShaderFunctionFuture = std::shared_future<BgiShaderFunctionHandle>;
+using BgiShaderFunctionFutureVector = std::vector<BgiShaderFunctionFuture>;
+
 }
 
 GUNGNIR_NAMESPACE_CLOSE_SCOPE
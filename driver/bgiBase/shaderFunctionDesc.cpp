@@ -11,6 +11,7 @@ BgiShaderFunctionTextureDesc::BgiShaderFunctionTextureDesc()
   , bindIndex(0)
   , arraySize(0)
   , writable(false)
+  , bindless(false)
 {
 }
 
@@ -19,6 +20,9 @@ BgiShaderFunctionBufferDesc::BgiShaderFunctionBufferDesc()
   , arraySize(0)
   , binding(BgiBindingTypeValue)
   , writable(false)
+  , bindless(false)
+  , dynamicOffset(false)
+  , deviceAddress(false)
 {
 }
 
@@ -63,6 +67,8 @@ BgiShaderFunctionDesc::BgiShaderFunctionDesc()
   , tessellationDescriptor()
   , geometryDescriptor()
   , fragmentDescriptor()
+  , slangModule()
+  , slangEntryPoint()
 {
 }
 
@@ -75,7 +81,8 @@ bool operator==(
            lhs.format == rhs.format &&
            lhs.textureType == rhs.textureType &&
            lhs.arraySize == rhs.arraySize &&
-           lhs.writable == rhs.writable;
+           lhs.writable == rhs.writable &&
+           lhs.bindless == rhs.bindless;
 }
 
 bool operator!=(
@@ -137,7 +144,10 @@ bool operator==(
            lhs.bindIndex == rhs.bindIndex &&
            lhs.arraySize == rhs.arraySize &&
            lhs.binding == rhs.binding &&
-           lhs.writable == rhs.writable;
+           lhs.writable == rhs.writable &&
+           lhs.bindless == rhs.bindless &&
+           lhs.dynamicOffset == rhs.dynamicOffset &&
+           lhs.deviceAddress == rhs.deviceAddress;
 }
 
 bool operator!=(
@@ -251,7 +261,9 @@ bool operator==(
            lhs.computeDescriptor == rhs.computeDescriptor &&
            lhs.tessellationDescriptor == rhs.tessellationDescriptor &&
            lhs.geometryDescriptor == rhs.geometryDescriptor &&
-           lhs.fragmentDescriptor == rhs.fragmentDescriptor;
+           lhs.fragmentDescriptor == rhs.fragmentDescriptor &&
+           lhs.slangModule == rhs.slangModule &&
+           lhs.slangEntryPoint == rhs.slangEntryPoint;
 }
 
 bool operator!=(
@@ -38,6 +38,11 @@ namespace driver {
 ///   supported as well).</li>
 /// <li>writable
 ///   Whether the texture is writable.</li>
+/// <li>bindless
+///   Access the texture through the backend's bindless descriptor heap instead
+///   of a fixed binding. The generated accessors take the texture's
+///   GetBindlessIndex (and for sampled textures the sampler's) as additional
+///   arguments. bindIndex and arraySize are ignored.</li>
 /// </ul>
 ///
 struct BgiShaderFunctionTextureDesc
@@ -52,6 +57,7 @@ struct BgiShaderFunctionTextureDesc
     uint32_t bindIndex;
     size_t arraySize;
     bool writable;
+    bool bindless;
 };
 
 using BgiShaderFunctionTextureDescVector =
@@ -84,6 +90,19 @@ bool operator!=(
 ///   The binding model to use to expose the buffer to the shader.</li>
 /// <li>writeable:
 ///   Whether the resource is writable.</li>
+/// <li>bindless:
+///   Access the storage buffer through the backend's bindless descriptor heap
+///   instead of a fixed binding, using the buffer's GetBindlessIndex.
+///   bindIndex is ignored.</li>
+/// <li>dynamicOffset:
+///   The buffer is bound with an offset provided at bind time, see
+///   BgiBufferBindingDesc::dynamicOffset.</li>
+/// <li>deviceAddress:
+///   Access the buffer through its GPU address (BgiBuffer::GetDeviceAddress)
+///   instead of a binding. Only a buffer reference type is declared; shaders
+///   get the buffer with BgiGetDeviceAddress_<nameInShader>(address), where
+///   the address is typically passed in constants or another buffer.
+///   bindIndex is ignored.</li>
 /// </ul>
 ///
 struct BgiShaderFunctionBufferDesc
@@ -97,6 +116,9 @@ struct BgiShaderFunctionBufferDesc
     uint32_t arraySize;
     BgiBindingType binding;
     bool writable;
+    bool bindless;
+    bool dynamicOffset;
+    bool deviceAddress;
 };
 
 using BgiShaderFunctionBufferDescVector =
@@ -410,6 +432,12 @@ bool operator!=(
 ///   Description of geometry shader function.</li>
 /// <li>fragmentDescriptor:
 ///   Description of fragment shader function.</li>
+/// <li>slangModule:
+///   Optional name of a Slang module. When set, the function is compiled
+///   from the module's slangEntryPoint instead of from shaderCode, and no
+///   resource declarations are generated.</li>
+/// <li>slangEntryPoint:
+///   Name of the entry point in slangModule.</li>
 /// </ul>
 ///
 struct BgiShaderFunctionDesc
@@ -433,6 +461,8 @@ struct BgiShaderFunctionDesc
     BgiShaderFunctionTessellationDesc tessellationDescriptor;
     BgiShaderFunctionGeometryDesc geometryDescriptor;
     BgiShaderFunctionFragmentDesc fragmentDescriptor;
+    std::string slangModule;
+    std::string slangEntryPoint;
 };
 
 using BgiShaderFunctionDescVector =
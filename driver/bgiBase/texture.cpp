@@ -17,6 +17,12 @@ BgiTexture::GetDescriptor() const
     return _descriptor;
 }
 
+uint32_t
+BgiTexture::GetBindlessIndex() const
+{
+    return BgiBindlessIndexInvalid;
+}
+
 size_t
 BgiTexture::_GetByteSizeOfResource(const BgiTextureDesc &descriptor)
 {
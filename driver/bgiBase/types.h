@@ -185,6 +185,11 @@ BgiGetMipInfos(
     const size_t layerCount,
     const size_t dataByteSize = std::numeric_limits<size_t>::max());
 
+/// Returned by GetBindlessIndex of resources that are not accessible through
+/// the bindless descriptor heap.
+static const uint32_t BgiBindlessIndexInvalid =
+    std::numeric_limits<uint32_t>::max();
+
 }
 
 GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -1,4 +1,5 @@
 #include "common/utils/diagnostic.h"
+#include "common/utils/trace.h"
 
 #include "driver/bgiVulkan/bgi.h"
 #include "driver/bgiVulkan/blitCmds.h"
@@ -7,12 +8,18 @@
 #include "driver/bgiVulkan/commandQueue.h"
 #include "driver/bgiVulkan/computeCmds.h"
 #include "driver/bgiVulkan/computePipeline.h"
+#include "driver/bgiVulkan/descriptorAllocator.h"
+#include "driver/bgiVulkan/descriptorBuffer.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
 #include "driver/bgiVulkan/garbageCollector.h"
+#include "driver/bgiVulkan/gpuProfiler.h"
 #include "driver/bgiVulkan/graphicsCmds.h"
 #include "driver/bgiVulkan/graphicsPipeline.h"
+#include "driver/bgiVulkan/indirectCommandEncoder.h"
 #include "driver/bgiVulkan/instance.h"
+#include "driver/bgiVulkan/memoryTracker.h"
+#include "driver/bgiVulkan/queryPool.h"
 #include "driver/bgiVulkan/resourceBindings.h"
 #include "driver/bgiVulkan/sampler.h"
 #include "driver/bgiVulkan/shaderFunction.h"
@@ -27,6 +34,7 @@ BgiVulkan::BgiVulkan()
     : _instance(new BgiVulkanInstance())
     , _device(new BgiVulkanDevice(_instance))
     , _garbageCollector(new BgiVulkanGarbageCollector(this))
+    , _indirectCommandEncoder(new BgiVulkanIndirectCommandEncoder(this))
     , _threadId(std::this_thread::get_id())
     , _frameDepth(0)
 {
@@ -34,6 +42,9 @@ BgiVulkan::BgiVulkan()
 
 BgiVulkan::~BgiVulkan()
 {
+    // Let in-flight shader compiles finish before the device goes away.
+    _shaderCompilePool.reset();
+
     BgiVulkanCommandQueue* queue = _device->GetCommandQueue();
 
     // Wait for command buffers to complete, then reset command buffers for 
@@ -87,6 +98,8 @@ BgiVulkan::CreateComputeCmds(
 BgiTextureHandle
 BgiVulkan::CreateTexture(BgiTextureDesc const & desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiTextureHandle(
         new BgiVulkanTexture(this, GetPrimaryDevice(), desc),
         GetUniqueId());
@@ -103,6 +116,8 @@ BgiVulkan::DestroyTexture(BgiTextureHandle* texHandle)
 BgiTextureViewHandle
 BgiVulkan::CreateTextureView(BgiTextureViewDesc const & desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     if (!desc.sourceTexture) {
         UTILS_CODING_ERROR("Source texture is null");
     }
@@ -129,6 +144,8 @@ BgiVulkan::DestroyTextureView(BgiTextureViewHandle* viewHandle)
 BgiSamplerHandle
 BgiVulkan::CreateSampler(BgiSamplerDesc const & desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiSamplerHandle(
         new BgiVulkanSampler(GetPrimaryDevice(), desc),
         GetUniqueId());
@@ -145,6 +162,8 @@ BgiVulkan::DestroySampler(BgiSamplerHandle* smpHandle)
 BgiBufferHandle
 BgiVulkan::CreateBuffer(BgiBufferDesc const & desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiBufferHandle(
         new BgiVulkanBuffer(this, GetPrimaryDevice(), desc),
         GetUniqueId());
@@ -161,11 +180,39 @@ BgiVulkan::DestroyBuffer(BgiBufferHandle* bufHandle)
 BgiShaderFunctionHandle
 BgiVulkan::CreateShaderFunction(BgiShaderFunctionDesc const& desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiShaderFunctionHandle(
         new BgiVulkanShaderFunction(GetPrimaryDevice(), this, desc,
         GetCapabilities()->GetShaderVersion()), GetUniqueId());
 }
 
+/* Multi threaded */
+BgiShaderFunctionFutureVector
+BgiVulkan::CreateShaderFunctions(BgiShaderFunctionDescVector const& descs)
+{
+    utils::WorkStealingPool* pool = _GetShaderCompilePool();
+    const int shaderVersion = GetCapabilities()->GetShaderVersion();
+
+    BgiShaderFunctionFutureVector futures;
+    futures.reserve(descs.size());
+
+    // Each task generates, compiles and reflects one function and creates its
+    // shader module. All of these steps are safe to run concurrently.
+    // The handle id is reserved up front so ids follow the order of descs.
+    for (BgiShaderFunctionDesc const& desc : descs) {
+        const uint64_t id = GetUniqueId();
+        futures.push_back(pool->Submit(
+            [this, desc, shaderVersion, id]() {
+                return BgiShaderFunctionHandle(
+                    new BgiVulkanShaderFunction(
+                        GetPrimaryDevice(), this, desc, shaderVersion), id);
+            }).share());
+    }
+
+    return futures;
+}
+
 /* Multi threaded */
 void
 BgiVulkan::DestroyShaderFunction(BgiShaderFunctionHandle* shaderFnHandle)
@@ -177,6 +224,8 @@ BgiVulkan::DestroyShaderFunction(BgiShaderFunctionHandle* shaderFnHandle)
 BgiShaderProgramHandle
 BgiVulkan::CreateShaderProgram(BgiShaderProgramDesc const& desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiShaderProgramHandle(
         new BgiVulkanShaderProgram(GetPrimaryDevice(), desc),
         GetUniqueId());
@@ -193,6 +242,8 @@ BgiVulkan::DestroyShaderProgram(BgiShaderProgramHandle* shaderPrgHandle)
 BgiResourceBindingsHandle
 BgiVulkan::CreateResourceBindings(BgiResourceBindingsDesc const& desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiResourceBindingsHandle(
         new BgiVulkanResourceBindings(GetPrimaryDevice(), desc),
         GetUniqueId());
@@ -208,6 +259,8 @@ BgiVulkan::DestroyResourceBindings(BgiResourceBindingsHandle* resHandle)
 BgiGraphicsPipelineHandle
 BgiVulkan::CreateGraphicsPipeline(BgiGraphicsPipelineDesc const& desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiGraphicsPipelineHandle(
         new BgiVulkanGraphicsPipeline(GetPrimaryDevice(), desc),
         GetUniqueId());
@@ -222,6 +275,8 @@ BgiVulkan::DestroyGraphicsPipeline(BgiGraphicsPipelineHandle* pipeHandle)
 BgiComputePipelineHandle
 BgiVulkan::CreateComputePipeline(BgiComputePipelineDesc const& desc)
 {
+    UTILS_TRACE_FUNCTION();
+
     return BgiComputePipelineHandle(
         new BgiVulkanComputePipeline(GetPrimaryDevice(), desc),
         GetUniqueId());
@@ -233,6 +288,22 @@ BgiVulkan::DestroyComputePipeline(BgiComputePipelineHandle* pipeHandle)
     TrashObject(pipeHandle, GetGarbageCollector()->GetComputePipelineList());
 }
 
+BgiQueryPoolHandle
+BgiVulkan::CreateQueryPool(BgiQueryPoolDesc const& desc)
+{
+    UTILS_TRACE_FUNCTION();
+
+    return BgiQueryPoolHandle(
+        new BgiVulkanQueryPool(GetPrimaryDevice(), desc),
+        GetUniqueId());
+}
+
+void
+BgiVulkan::DestroyQueryPool(BgiQueryPoolHandle* queryPoolHandle)
+{
+    TrashObject(queryPoolHandle, GetGarbageCollector()->GetQueryPoolList());
+}
+
 /* Multi threaded */
 tokens::DRIVER const&
 BgiVulkan::GetAPIName() const {
@@ -250,7 +321,7 @@ BgiVulkan::GetCapabilities() const
 BgiIndirectCommandEncoder*
 BgiVulkan::GetIndirectCommandEncoder() const
 {
-    return nullptr;
+    return _indirectCommandEncoder.get();
 }
 
 /* Single threaded */
@@ -261,6 +332,11 @@ BgiVulkan::StartFrame()
 
     if (_frameDepth++ == 0) {
         BgiVulkanBeginQueueLabel(GetPrimaryDevice(), "Full Hydra Frame");
+
+        if (BgiVulkanGpuProfiler* profiler =
+                GetPrimaryDevice()->GetGpuProfiler()) {
+            profiler->BeginFrame();
+        }
     }
 }
 
@@ -268,14 +344,61 @@ BgiVulkan::StartFrame()
 void
 BgiVulkan::EndFrame()
 {
+    UTILS_TRACE_FUNCTION();
+
     // Please read important usage limitations for Hgi::EndFrame
 
     if (--_frameDepth == 0) {
         _EndFrameSync();
-        BgiVulkanEndQueueLabel(GetPrimaryDevice());
+
+        // Resolve after the consumed command buffers were reset, so the
+        // in-flight bits reflect what the GPU has completed.
+        BgiVulkanDevice* device = GetPrimaryDevice();
+        if (BgiVulkanGpuProfiler* profiler = device->GetGpuProfiler()) {
+            profiler->EndFrame(
+                device->GetCommandQueue()->GetInflightCommandBuffersBits());
+        }
+
+        device->GetMemoryTracker()->EndFrame();
+
+        BgiVulkanEndQueueLabel(device);
     }
 }
 
+/* Single threaded */
+void
+BgiVulkan::SetGpuProfilingEnabled(bool enabled)
+{
+    if (BgiVulkanGpuProfiler* profiler =
+            GetPrimaryDevice()->GetGpuProfiler()) {
+        profiler->SetEnabled(enabled);
+    }
+}
+
+/* Multi threaded */
+bool
+BgiVulkan::IsGpuProfilingEnabled() const
+{
+    BgiVulkanGpuProfiler* profiler = GetPrimaryDevice()->GetGpuProfiler();
+    return profiler && profiler->IsEnabled();
+}
+
+/* Single threaded */
+bool
+BgiVulkan::GetGpuFrameTimings(BgiGpuFrameTimings* timings) const
+{
+    BgiVulkanGpuProfiler* profiler = GetPrimaryDevice()->GetGpuProfiler();
+    return profiler && profiler->GetFrameTimings(timings);
+}
+
+/* Multi threaded */
+bool
+BgiVulkan::GetMemoryStats(BgiMemoryStats* stats) const
+{
+    GetPrimaryDevice()->GetMemoryTracker()->GetStats(stats);
+    return true;
+}
+
 /* Multi threaded */
 BgiVulkanInstance*
 BgiVulkan::GetVulkanInstance() const
@@ -301,6 +424,8 @@ BgiVulkan::GetGarbageCollector() const
 bool
 BgiVulkan::_SubmitCmds(BgiCmds* cmds, BgiSubmitWaitType wait)
 {
+    UTILS_TRACE_FUNCTION();
+
     // XXX The device queue is externally synchronized so we would at minimum
     // need a mutex here to ensure only one thread submits cmds at a time.
     // However, since we currently call garbage collection here and because
@@ -327,6 +452,16 @@ BgiVulkan::_SubmitCmds(BgiCmds* cmds, BgiSubmitWaitType wait)
     return result;
 }
 
+/* Multi threaded */
+utils::WorkStealingPool*
+BgiVulkan::_GetShaderCompilePool()
+{
+    std::call_once(_shaderCompilePoolOnce, [this]() {
+        _shaderCompilePool = std::make_unique<utils::WorkStealingPool>();
+    });
+    return _shaderCompilePool.get();
+}
+
 /* Single threaded */
 void
 BgiVulkan::_EndFrameSync()
@@ -344,6 +479,15 @@ BgiVulkan::_EndFrameSync()
     // Reset command buffers for each device's queue.
     queue->ResetConsumedCommandBuffers();
 
+    // Retire this frame's transient descriptor sets and recycle the pages of
+    // frames the GPU has finished with.
+    device->GetDescriptorAllocator()->EndFrame(
+        queue->GetInflightCommandBuffersBits());
+    if (BgiVulkanDescriptorBuffer* descriptorBuffer =
+            device->GetDescriptorBuffer()) {
+        descriptorBuffer->EndFrame(queue->GetInflightCommandBuffersBits());
+    }
+
     // Perform garbage collection for each device.
     _garbageCollector->PerformGarbageCollection(device);
 }
@@ -2,6 +2,7 @@
 
 #include "common/base.h"
 #include "common/utils/tokens.h"
+#include "common/utils/workStealingPool.h"
 
 #include "driver/bgiBase/bgi.h"
 #include "driver/bgiVulkan/capabilities.h"
@@ -9,6 +10,8 @@
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/vulkanBridge.h"
 
+#include <mutex>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <string>
@@ -18,6 +21,7 @@ GUNGNIR_NAMESPACE_OPEN_SCOPE
 namespace driver {
 
 class BgiVulkanGarbageCollector;
+class BgiVulkanIndirectCommandEncoder;
 class BgiVulkanInstance;
 
 /// \class HgiVulkan
@@ -76,6 +80,10 @@ public:
     BgiShaderFunctionHandle CreateShaderFunction(
         BgiShaderFunctionDesc const& desc) override;
 
+    BGIVULKAN_API
+    BgiShaderFunctionFutureVector CreateShaderFunctions(
+        BgiShaderFunctionDescVector const& descs) override;
+
     BGIVULKAN_API
     void DestroyShaderFunction(
         BgiShaderFunctionHandle* shaderFunctionHandle) override;
@@ -110,6 +118,13 @@ public:
     BGIVULKAN_API
     void DestroyComputePipeline(BgiComputePipelineHandle* pipeHandle) override;
 
+    BGIVULKAN_API
+    BgiQueryPoolHandle CreateQueryPool(
+        BgiQueryPoolDesc const& desc) override;
+
+    BGIVULKAN_API
+    void DestroyQueryPool(BgiQueryPoolHandle* queryPoolHandle) override;
+
     BGIVULKAN_API
     tokens::DRIVER const& GetAPIName() const override;
 
@@ -125,6 +140,18 @@ public:
     BGIVULKAN_API
     void EndFrame() override;
 
+    BGIVULKAN_API
+    void SetGpuProfilingEnabled(bool enabled) override;
+
+    BGIVULKAN_API
+    bool IsGpuProfilingEnabled() const override;
+
+    BGIVULKAN_API
+    bool GetGpuFrameTimings(BgiGpuFrameTimings* timings) const override;
+
+    BGIVULKAN_API
+    bool GetMemoryStats(BgiMemoryStats* stats) const override;
+
     //
     // HgiVulkan specific
     //
@@ -169,6 +196,11 @@ private:
     BgiVulkan & operator=(const BgiVulkan&) = delete;
     BgiVulkan(const BgiVulkan&) = delete;
 
+    // Returns the pool used to compile shader functions concurrently.
+    // The worker threads are only spawned on first use.
+    // Thread safety: Yes.
+    utils::WorkStealingPool* _GetShaderCompilePool();
+
     // Perform low frequency actions, such as garbage collection.
     // Thread safety: No. Must be called from main thread.
     void _EndFrameSync();
@@ -176,6 +208,9 @@ private:
     BgiVulkanInstance* _instance;
     BgiVulkanDevice* _device;
     BgiVulkanGarbageCollector* _garbageCollector;
+    std::unique_ptr<BgiVulkanIndirectCommandEncoder> _indirectCommandEncoder;
+    std::unique_ptr<utils::WorkStealingPool> _shaderCompilePool;
+    std::once_flag _shaderCompilePoolOnce;
     std::thread::id _threadId;
     int _frameDepth;
 };
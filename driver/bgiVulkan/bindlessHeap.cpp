@@ -0,0 +1,407 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiBase/types.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/device.h"
+#include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/layoutCache.h"
+#include "driver/bgiVulkan/memoryTracker.h"
+
+#include <algorithm>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+namespace {
+    // Upper bounds for the size of the heap's arrays. The device's
+    // (update-after-bind) descriptor limits may lower these further.
+    static const uint32_t _maxTextures = 16384;
+    static const uint32_t _maxSamplers = 1024;
+    static const uint32_t _maxBuffers = 16384;
+}
+
+BgiVulkanBindlessHeap::BgiVulkanBindlessHeap(BgiVulkanDevice* device)
+    : _device(device)
+    , _vkDescriptorSetLayout(nullptr)
+    , _vkDescriptorPool(nullptr)
+    , _vkDescriptorSet(nullptr)
+    , _descriptorBuffer(device->GetDescriptorBuffer())
+    , _bindingOffsets{}
+{
+    BgiVulkanCapabilities const& caps = device->GetDeviceCapabilities();
+
+    if (_descriptorBuffer) {
+        // Descriptor buffer layouts are not update-after-bind, so the
+        // regular per-stage limits apply.
+        VkPhysicalDeviceLimits const& limits =
+            caps.vkDeviceProperties.limits;
+        _textures.capacity = std::min({_maxTextures,
+            limits.maxPerStageDescriptorSampledImages,
+            limits.maxPerStageDescriptorStorageImages});
+        _samplers.capacity = std::min(_maxSamplers,
+            limits.maxPerStageDescriptorSamplers);
+        _buffers.capacity = std::min(_maxBuffers,
+            limits.maxPerStageDescriptorStorageBuffers);
+    } else {
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT const& props =
+            caps.vkIndexingProperties;
+        _textures.capacity = std::min({_maxTextures,
+            props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            props.maxPerStageDescriptorUpdateAfterBindStorageImages});
+        _samplers.capacity = std::min(_maxSamplers,
+            props.maxPerStageDescriptorUpdateAfterBindSamplers);
+        _buffers.capacity = std::min(_maxBuffers,
+            props.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+    }
+
+    //
+    // Descriptor set layout
+    //
+    _vkDescriptorSetLayout = AcquireDescriptorSetLayout();
+
+    //
+    // Descriptor buffer range
+    //
+    if (_descriptorBuffer) {
+        _descriptorBufferAllocation = _descriptorBuffer->Allocate(
+            _descriptorBuffer->GetLayoutSize(_vkDescriptorSetLayout),
+            /*transient*/ false);
+
+        const uint32_t bindings[] = {SampledImageBinding, SamplerBinding,
+            StorageImageBinding, StorageBufferBinding};
+        for (uint32_t binding : bindings) {
+            _bindingOffsets[binding] = _descriptorBuffer->GetBindingOffset(
+                _vkDescriptorSetLayout, binding);
+        }
+        return;
+    }
+
+    //
+    // Descriptor pool
+    //
+    VkDescriptorPoolSize poolSizes[] = {
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, _textures.capacity},
+        {VK_DESCRIPTOR_TYPE_SAMPLER, _samplers.capacity},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _textures.capacity},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _buffers.capacity}};
+
+    VkDescriptorPoolCreateInfo poolInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = (uint32_t) std::size(poolSizes);
+    poolInfo.pPoolSizes = poolSizes;
+
+    UTILS_VERIFY(
+        vkCreateDescriptorPool(
+            device->GetVulkanDevice(),
+            &poolInfo,
+            BgiVulkanAllocator(),
+            &_vkDescriptorPool) == VK_SUCCESS
+    );
+
+    device->GetMemoryTracker()->AddResource(
+        BgiMemoryResourceKindDescriptorPool, 0);
+
+    BgiVulkanSetDebugName(
+        device,
+        (uint64_t)_vkDescriptorPool,
+        VK_OBJECT_TYPE_DESCRIPTOR_POOL,
+        "Descriptor Pool Bindless Heap");
+
+    //
+    // Descriptor set
+    //
+    VkDescriptorSetAllocateInfo allocateInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocateInfo.descriptorPool = _vkDescriptorPool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &_vkDescriptorSetLayout;
+
+    UTILS_VERIFY(
+        vkAllocateDescriptorSets(
+            device->GetVulkanDevice(),
+            &allocateInfo,
+            &_vkDescriptorSet) == VK_SUCCESS
+    );
+
+    BgiVulkanSetDebugName(
+        device,
+        (uint64_t)_vkDescriptorSet,
+        VK_OBJECT_TYPE_DESCRIPTOR_SET,
+        "Descriptor Set Bindless Heap");
+}
+
+BgiVulkanBindlessHeap::~BgiVulkanBindlessHeap()
+{
+    if (_descriptorBuffer) {
+        _descriptorBuffer->Free(_descriptorBufferAllocation);
+    } else {
+        _device->GetMemoryTracker()->RemoveResource(
+            BgiMemoryResourceKindDescriptorPool, 0);
+        vkDestroyDescriptorPool(
+            _device->GetVulkanDevice(),
+            _vkDescriptorPool,
+            BgiVulkanAllocator());
+    }
+
+    _device->GetLayoutCache()->ReleaseDescriptorSetLayout(
+        _vkDescriptorSetLayout);
+}
+
+VkDescriptorSetLayout
+BgiVulkanBindlessHeap::GetVulkanDescriptorSetLayout() const
+{
+    return _vkDescriptorSetLayout;
+}
+
+VkDescriptorSet
+BgiVulkanBindlessHeap::GetVulkanDescriptorSet() const
+{
+    return _vkDescriptorSet;
+}
+
+void
+BgiVulkanBindlessHeap::BindDescriptors(
+    VkCommandBuffer cb,
+    VkPipelineBindPoint bindPoint,
+    VkPipelineLayout layout) const
+{
+    if (_descriptorBuffer) {
+        _descriptorBuffer->SetOffset(
+            cb, bindPoint, layout, SetIndex,
+            _descriptorBufferAllocation.offset);
+        return;
+    }
+
+    vkCmdBindDescriptorSets(
+        cb,
+        bindPoint,
+        layout,
+        SetIndex,
+        1,
+        &_vkDescriptorSet,
+        0,
+        nullptr);
+}
+
+VkDescriptorSetLayout
+BgiVulkanBindlessHeap::AcquireDescriptorSetLayout()
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<VkDescriptorBindingFlags> bindingFlags;
+    _GetLayoutBindings(&bindings, &bindingFlags);
+
+    return _device->GetLayoutCache()->AcquireDescriptorSetLayout(
+        bindings,
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        "Bindless Heap",
+        bindingFlags);
+}
+
+/* Multi threaded */
+uint32_t
+BgiVulkanBindlessHeap::RegisterTexture(
+    VkImageView imageView,
+    VkImageLayout imageLayout,
+    bool sampled,
+    bool storage)
+{
+    if (!sampled && !storage) {
+        return BgiBindlessIndexInvalid;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint32_t index = _AllocateIndex(&_textures);
+    if (!UTILS_VERIFY(index != BgiBindlessIndexInvalid,
+            "Bindless heap is out of texture descriptors")) {
+        return BgiBindlessIndexInvalid;
+    }
+
+    BgiVulkanDescriptorInfo info;
+    info.image.sampler = nullptr;
+    info.image.imageView = imageView;
+    info.image.imageLayout = imageLayout;
+
+    // Update-after-bind: this is allowed while the set is bound in command
+    // buffers that are recording or in-flight, as long as they do not access
+    // this (newly allocated) index.
+    if (sampled) {
+        _WriteDescriptor(
+            SampledImageBinding, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, index, info);
+    }
+
+    if (storage) {
+        _WriteDescriptor(
+            StorageImageBinding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, index, info);
+    }
+
+    return index;
+}
+
+/* Multi threaded */
+uint32_t
+BgiVulkanBindlessHeap::RegisterSampler(VkSampler sampler)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint32_t index = _AllocateIndex(&_samplers);
+    if (!UTILS_VERIFY(index != BgiBindlessIndexInvalid,
+            "Bindless heap is out of sampler descriptors")) {
+        return BgiBindlessIndexInvalid;
+    }
+
+    BgiVulkanDescriptorInfo info;
+    info.image.sampler = sampler;
+    info.image.imageView = nullptr;
+    info.image.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    _WriteDescriptor(SamplerBinding, VK_DESCRIPTOR_TYPE_SAMPLER, index, info);
+
+    return index;
+}
+
+/* Multi threaded */
+uint32_t
+BgiVulkanBindlessHeap::RegisterBuffer(VkBuffer buffer, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint32_t index = _AllocateIndex(&_buffers);
+    if (!UTILS_VERIFY(index != BgiBindlessIndexInvalid,
+            "Bindless heap is out of buffer descriptors")) {
+        return BgiBindlessIndexInvalid;
+    }
+
+    BgiVulkanDescriptorInfo info;
+    info.buffer.buffer = buffer;
+    info.buffer.offset = 0;
+    info.buffer.range = size;
+
+    _WriteDescriptor(
+        StorageBufferBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, index, info);
+
+    return index;
+}
+
+/* Multi threaded */
+void
+BgiVulkanBindlessHeap::UnregisterTexture(uint32_t index)
+{
+    // The stale descriptor stays in the (partially bound) array until the
+    // index is handed out again.
+    if (index != BgiBindlessIndexInvalid) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _textures.freeIndices.push_back(index);
+    }
+}
+
+/* Multi threaded */
+void
+BgiVulkanBindlessHeap::UnregisterSampler(uint32_t index)
+{
+    if (index != BgiBindlessIndexInvalid) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _samplers.freeIndices.push_back(index);
+    }
+}
+
+/* Multi threaded */
+void
+BgiVulkanBindlessHeap::UnregisterBuffer(uint32_t index)
+{
+    if (index != BgiBindlessIndexInvalid) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.freeIndices.push_back(index);
+    }
+}
+
+uint32_t
+BgiVulkanBindlessHeap::_AllocateIndex(_IndexAllocator* allocator)
+{
+    if (!allocator->freeIndices.empty()) {
+        const uint32_t index = allocator->freeIndices.back();
+        allocator->freeIndices.pop_back();
+        return index;
+    }
+
+    if (allocator->next < allocator->capacity) {
+        return allocator->next++;
+    }
+
+    return BgiBindlessIndexInvalid;
+}
+
+void
+BgiVulkanBindlessHeap::_WriteDescriptor(
+    uint32_t binding,
+    VkDescriptorType type,
+    uint32_t index,
+    BgiVulkanDescriptorInfo const& info)
+{
+    if (_descriptorBuffer) {
+        _descriptorBuffer->WriteDescriptor(
+            _descriptorBufferAllocation.offset + _bindingOffsets[binding] +
+                index * _descriptorBuffer->GetDescriptorSize(type),
+            type,
+            info);
+        return;
+    }
+
+    VkWriteDescriptorSet w = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    w.dstSet = _vkDescriptorSet;
+    w.dstBinding = binding;
+    w.dstArrayElement = index;
+    w.descriptorCount = 1;
+    w.descriptorType = type;
+    if (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+        w.pBufferInfo = &info.buffer;
+    } else {
+        w.pImageInfo = &info.image;
+    }
+
+    vkUpdateDescriptorSets(_device->GetVulkanDevice(), 1, &w, 0, nullptr);
+}
+
+void
+BgiVulkanBindlessHeap::_GetLayoutBindings(
+    std::vector<VkDescriptorSetLayoutBinding>* bindingsOUT,
+    std::vector<VkDescriptorBindingFlags>* flagsOUT) const
+{
+    const struct {
+        uint32_t binding;
+        VkDescriptorType type;
+        uint32_t count;
+    } arrays[] = {
+        {SampledImageBinding, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            _textures.capacity},
+        {SamplerBinding, VK_DESCRIPTOR_TYPE_SAMPLER,
+            _samplers.capacity},
+        {StorageImageBinding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            _textures.capacity},
+        {StorageBufferBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            _buffers.capacity}};
+
+    for (auto const& a : arrays) {
+        VkDescriptorSetLayoutBinding b = {};
+        b.binding = a.binding;
+        b.descriptorType = a.type;
+        b.descriptorCount = a.count;
+        b.stageFlags = VK_SHADER_STAGE_ALL;
+        b.pImmutableSamplers = nullptr;
+        bindingsOUT->push_back(b);
+
+        // Only the descriptors at indices that are in use are valid, and
+        // resources are registered while the heap is bound.
+        flagsOUT->push_back(
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
+    }
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
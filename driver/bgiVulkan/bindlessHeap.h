@@ -0,0 +1,166 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/descriptorBuffer.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+#include <mutex>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkanDevice;
+
+/// \class BgiVulkanBindlessHeap
+///
+/// Global descriptor heap for bindless resource access.
+///
+/// A single update-after-bind, partially bound descriptor set holds runtime
+/// arrays of all sampled images, samplers, storage images and storage
+/// buffers. Resources are registered when they are created and receive a
+/// stable index that shaders use to access them (see the 'bindless' flag of
+/// BgiShaderFunctionTextureDesc and BgiShaderFunctionBufferDesc).
+///
+/// Textures share one index for the sampled image and storage image arrays.
+///
+/// Pipelines whose shaders access the heap bind it at SetIndex when they are
+/// bound, so there is no per-draw descriptor binding for bindless resources.
+///
+/// On devices that use descriptor buffers the heap is a long-lived range of
+/// the device's BgiVulkanDescriptorBuffer instead of a descriptor set.
+///
+/// Indices are returned to the heap when the resource is destroyed. Since
+/// resources are destroyed by the garbage collector once the GPU no longer
+/// uses them, a reused index is never observed by in-flight work.
+///
+class BgiVulkanBindlessHeap final
+{
+public:
+    /// The descriptor set index the heap is bound at.
+    static const uint32_t SetIndex = 1;
+
+    /// The bindings of the heap's descriptor set.
+    static const uint32_t SampledImageBinding = 0;
+    static const uint32_t SamplerBinding = 1;
+    static const uint32_t StorageImageBinding = 2;
+    static const uint32_t StorageBufferBinding = 3;
+
+    BGIVULKAN_API
+    BgiVulkanBindlessHeap(BgiVulkanDevice* device);
+
+    BGIVULKAN_API
+    ~BgiVulkanBindlessHeap();
+
+    /// Returns the layout of the heap's descriptor set.
+    BGIVULKAN_API
+    VkDescriptorSetLayout GetVulkanDescriptorSetLayout() const;
+
+    /// Returns the heap's descriptor set, or nullptr when the heap lives in
+    /// the descriptor buffer.
+    BGIVULKAN_API
+    VkDescriptorSet GetVulkanDescriptorSet() const;
+
+    /// Binds the heap at SetIndex of 'layout'.
+    BGIVULKAN_API
+    void BindDescriptors(
+        VkCommandBuffer cb,
+        VkPipelineBindPoint bindPoint,
+        VkPipelineLayout layout) const;
+
+    /// Returns an additional reference to the heap's descriptor set layout
+    /// from the device's layout cache, for use in a pipeline layout.
+    /// Must be released with BgiVulkanLayoutCache::ReleaseDescriptorSetLayout.
+    BGIVULKAN_API
+    VkDescriptorSetLayout AcquireDescriptorSetLayout();
+
+    /// Writes the image view into the sampled and/or storage image arrays and
+    /// returns its index.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    uint32_t RegisterTexture(
+        VkImageView imageView,
+        VkImageLayout imageLayout,
+        bool sampled,
+        bool storage);
+
+    /// Writes the sampler into the sampler array and returns its index.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    uint32_t RegisterSampler(VkSampler sampler);
+
+    /// Writes the first 'size' bytes of the buffer into the storage buffer
+    /// array and returns its index.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    uint32_t RegisterBuffer(VkBuffer buffer, VkDeviceSize size);
+
+    /// Returns the index of a destroyed texture to the heap.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void UnregisterTexture(uint32_t index);
+
+    /// Returns the index of a destroyed sampler to the heap.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void UnregisterSampler(uint32_t index);
+
+    /// Returns the index of a destroyed buffer to the heap.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void UnregisterBuffer(uint32_t index);
+
+private:
+    BgiVulkanBindlessHeap() = delete;
+    BgiVulkanBindlessHeap & operator=(const BgiVulkanBindlessHeap&) = delete;
+    BgiVulkanBindlessHeap(const BgiVulkanBindlessHeap&) = delete;
+
+    // Hands out the indices of one of the heap's arrays.
+    struct _IndexAllocator
+    {
+        uint32_t capacity = 0;
+        uint32_t next = 0;
+        std::vector<uint32_t> freeIndices;
+    };
+
+    // Returns a free index or BgiBindlessIndexInvalid if the array is full.
+    static uint32_t _AllocateIndex(_IndexAllocator* allocator);
+
+    // Writes one descriptor into the array at 'binding'.
+    // Must be called with _mutex held.
+    void _WriteDescriptor(
+        uint32_t binding,
+        VkDescriptorType type,
+        uint32_t index,
+        BgiVulkanDescriptorInfo const& info);
+
+    // Returns the bindings and binding flags of the heap's set layout.
+    void _GetLayoutBindings(
+        std::vector<VkDescriptorSetLayoutBinding>* bindingsOUT,
+        std::vector<VkDescriptorBindingFlags>* flagsOUT) const;
+
+    BgiVulkanDevice* _device;
+    VkDescriptorSetLayout _vkDescriptorSetLayout;
+    VkDescriptorPool _vkDescriptorPool;
+    VkDescriptorSet _vkDescriptorSet;
+
+    // The heap's range of the descriptor buffer and the offsets of its
+    // bindings within it, when the device uses descriptor buffers.
+    BgiVulkanDescriptorBuffer* _descriptorBuffer;
+    BgiVulkanDescriptorBufferAllocation _descriptorBufferAllocation;
+    VkDeviceSize _bindingOffsets[4];
+
+    // Serializes index allocation and the descriptor writes. The heap's set
+    // is externally synchronized for vkUpdateDescriptorSets.
+    std::mutex _mutex;
+    _IndexAllocator _textures;
+    _IndexAllocator _samplers;
+    _IndexAllocator _buffers;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -8,6 +8,7 @@
 #include "driver/bgiVulkan/conversions.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/gpuProfiler.h"
 #include "driver/bgiVulkan/bgi.h"
 #include "driver/bgiVulkan/texture.h"
 
@@ -31,14 +32,22 @@ void
 BgiVulkanBlitCmds::PushDebugGroup(const char* label)
 {
     _CreateCommandBuffer();
-    BgiVulkanBeginLabel(_bgi->GetPrimaryDevice(), _commandBuffer, label);
+    BgiVulkanDevice* device = _bgi->GetPrimaryDevice();
+    BgiVulkanBeginLabel(device, _commandBuffer, label);
+    if (BgiVulkanGpuProfiler* profiler = device->GetGpuProfiler()) {
+        profiler->PushScope(_commandBuffer, label, &_timestampScopes);
+    }
 }
 
 void
 BgiVulkanBlitCmds::PopDebugGroup()
 {
     _CreateCommandBuffer();
-    BgiVulkanEndLabel(_bgi->GetPrimaryDevice(), _commandBuffer);
+    BgiVulkanDevice* device = _bgi->GetPrimaryDevice();
+    if (BgiVulkanGpuProfiler* profiler = device->GetGpuProfiler()) {
+        profiler->PopScope(_commandBuffer, &_timestampScopes);
+    }
+    BgiVulkanEndLabel(device, _commandBuffer);
 }
 
 void
@@ -6,6 +6,8 @@
 #include "driver/bgiVulkan/api.h"
 #include "driver/bgiVulkan/vulkanBridge.h"
 
+#include <vector>
+
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
@@ -81,6 +83,9 @@ private:
     BgiVulkan* _bgi;
     BgiVulkanCommandBuffer* _commandBuffer;
 
+    // The GPU profiler scopes of the debug groups pushed on these cmds.
+    std::vector<uint32_t> _timestampScopes;
+
     // BlitCmds is used only one frame so storing multi-frame state on BlitCmds
     // will not survive.
 };
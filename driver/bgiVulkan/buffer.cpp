@@ -1,12 +1,15 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/buffer.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
+#include "driver/bgiVulkan/capabilities.h"
 #include "driver/bgiVulkan/commandBuffer.h"
 #include "driver/bgiVulkan/commandQueue.h"
 #include "driver/bgiVulkan/conversions.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
 #include "driver/bgiVulkan/garbageCollector.h"
+#include "driver/bgiVulkan/memoryTracker.h"
 #include "driver/bgiVulkan/bgi.h"
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
@@ -24,6 +27,10 @@ BgiVulkanBuffer::BgiVulkanBuffer(
     , _inflightBits(0)
     , _stagingBuffer(nullptr)
     , _cpuStagingAddress(nullptr)
+    , _bindlessIndex(BgiBindlessIndexInvalid)
+    , _deviceAddress(0)
+    , _memoryKind(BgiMemoryResourceKindBuffer)
+    , _memoryByteSize(0)
 {
     if (desc.byteSize == 0) {
         UTILS_CODING_ERROR("The size of buffer [%p] is zero.", this);
@@ -39,6 +46,32 @@ BgiVulkanBuffer::BgiVulkanBuffer(
                 VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // gfx queue only
 
+    BgiVulkanCapabilities const& caps = device->GetDeviceCapabilities();
+    if ((desc.usage & BgiBufferUsageDeviceAddress) &&
+        !caps.supportsBufferDeviceAddress) {
+        UTILS_CODING_ERROR("Buffer %s requires a device with buffer device "
+            "address support", desc.debugName.c_str());
+        bi.usage &= ~VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+
+    if ((desc.usage & BgiBufferUsageIndex8) && !caps.supportsIndexTypeUint8) {
+        UTILS_CODING_ERROR("Buffer %s requires a device with 8 bit index "
+            "support", desc.debugName.c_str());
+    }
+
+    if ((desc.usage & BgiBufferUsagePredicate) &&
+        !caps.supportsConditionalRendering) {
+        UTILS_CODING_ERROR("Buffer %s requires a device with conditional "
+            "rendering support", desc.debugName.c_str());
+        bi.usage &= ~VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT;
+    }
+
+    // Descriptor buffers reference uniform and storage buffers by address.
+    if (device->GetDescriptorBuffer() &&
+        (desc.usage & (BgiBufferUsageUniform | BgiBufferUsageStorage))) {
+        bi.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+
     // Create buffer with memory allocated and bound.
     // Equivalent to: vkCreateBuffer, vkAllocateMemory, vkBindBufferMemory
     // XXX On VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU it may be beneficial to
@@ -51,6 +84,10 @@ BgiVulkanBuffer::BgiVulkanBuffer(
         vmaCreateBuffer(vma,&bi,&ai,&_vkBuffer,&_vmaAllocation,0) == VK_SUCCESS
     );
 
+    BgiVulkanMemoryTracker* tracker = device->GetMemoryTracker();
+    _memoryByteSize = tracker->GetAllocationByteSize(_vmaAllocation);
+    tracker->AddResource(_memoryKind, _memoryByteSize);
+
     // Debug label
     if (!_descriptor.debugName.empty()) {
         std::string debugLabel = "Buffer " + _descriptor.debugName;
@@ -61,6 +98,20 @@ BgiVulkanBuffer::BgiVulkanBuffer(
             debugLabel.c_str());
     }
 
+    if (bi.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        VkBufferDeviceAddressInfo addressInfo =
+            {VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+        addressInfo.buffer = _vkBuffer;
+        _deviceAddress =
+            vkGetBufferDeviceAddress(device->GetVulkanDevice(), &addressInfo);
+    }
+
+    // Storage buffers are accessible through the bindless heap.
+    BgiVulkanBindlessHeap* heap = device->GetBindlessHeap();
+    if (heap && (desc.usage & BgiBufferUsageStorage)) {
+        _bindlessIndex = heap->RegisterBuffer(_vkBuffer, desc.byteSize);
+    }
+
     if (desc.initialData) {
         // Use a 'staging buffer' to schedule uploading the 'initialData' to
         // the device-local GPU buffer.
@@ -102,11 +153,22 @@ BgiVulkanBuffer::BgiVulkanBuffer(
     , _inflightBits(0)
     , _stagingBuffer(nullptr)
     , _cpuStagingAddress(nullptr)
+    , _bindlessIndex(BgiBindlessIndexInvalid)
+    , _deviceAddress(0)
+    , _memoryKind(BgiMemoryResourceKindStaging)
+    , _memoryByteSize(0)
 {
+    BgiVulkanMemoryTracker* tracker = device->GetMemoryTracker();
+    _memoryByteSize = tracker->GetAllocationByteSize(_vmaAllocation);
+    tracker->AddResource(_memoryKind, _memoryByteSize);
 }
 
 BgiVulkanBuffer::~BgiVulkanBuffer()
 {
+    if (_bindlessIndex != BgiBindlessIndexInvalid) {
+        _device->GetBindlessHeap()->UnregisterBuffer(_bindlessIndex);
+    }
+
     if (_cpuStagingAddress && _stagingBuffer) {
         vmaUnmapMemory(
             _device->GetVulkanMemoryAllocator(),
@@ -117,6 +179,11 @@ BgiVulkanBuffer::~BgiVulkanBuffer()
     delete _stagingBuffer;
     _stagingBuffer = nullptr;
 
+    if (_vmaAllocation) {
+        _device->GetMemoryTracker()->RemoveResource(
+            _memoryKind, _memoryByteSize);
+    }
+
     vmaDestroyBuffer(
         _device->GetVulkanMemoryAllocator(),
         _vkBuffer,
@@ -135,6 +202,21 @@ BgiVulkanBuffer::GetRawResource() const
     return (uint64_t) _vkBuffer;
 }
 
+uint32_t
+BgiVulkanBuffer::GetBindlessIndex() const
+{
+    return _bindlessIndex;
+}
+
+uint64_t
+BgiVulkanBuffer::GetDeviceAddress() const
+{
+    // Only buffers created with BgiBufferUsageDeviceAddress expose their
+    // address. Buffers that got the usage for the descriptor buffer do not.
+    return (_descriptor.usage & BgiBufferUsageDeviceAddress) ?
+        (uint64_t) _deviceAddress : 0;
+}
+
 void*
 BgiVulkanBuffer::GetCPUStagingAddress()
 {
@@ -207,6 +289,8 @@ BgiVulkanBuffer::CreateStagingBuffer(
     bi.usage = BgiVulkanConversions::GetBufferUsage(desc.usage);
     bi.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | 
                 VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    // Shaders never read staging buffers by address.
+    bi.usage &= ~VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
     bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // gfx queue only
 
     VmaAllocationCreateInfo ai = {};
@@ -34,6 +34,12 @@ public:
     BGIVULKAN_API
     void* GetCPUStagingAddress() override;
 
+    BGIVULKAN_API
+    uint32_t GetBindlessIndex() const override;
+
+    BGIVULKAN_API
+    uint64_t GetDeviceAddress() const override;
+
     /// Returns true if the provided ptr matches the address of staging buffer.
     BGIVULKAN_API
     bool IsCPUStagingAddress(const void* address) const;
@@ -94,6 +100,10 @@ private:
     uint64_t _inflightBits;
     BgiVulkanBuffer* _stagingBuffer;
     void* _cpuStagingAddress;
+    uint32_t _bindlessIndex;
+    VkDeviceAddress _deviceAddress;
+    BgiMemoryResourceKind _memoryKind;
+    uint64_t _memoryByteSize;
 };
 
 }
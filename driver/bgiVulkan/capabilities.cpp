@@ -10,9 +10,26 @@ namespace driver {
 
 BgiVulkanCapabilities::BgiVulkanCapabilities(BgiVulkanDevice* device)
     : supportsTimeStamps(false)
+    , supportsBindlessHeap(false)
+    , supportsPushDescriptors(false)
+    , supportsBufferDeviceAddress(false)
+    , supportsDescriptorBuffer(false)
+    , supportsDrawIndirectCount(false)
+    , supportsIndexTypeUint8(false)
+    , supportsConditionalRendering(false)
 {
     VkPhysicalDevice physicalDevice = device->GetVulkanPhysicalDevice();
 
+    // The feature structs of optional extensions are only chained into the
+    // query when the extension is available. The chain is rebuilt for device
+    // creation once we know which of them are supported.
+    const bool descriptorBufferExtension =
+        device->IsSupportedExtension(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+    const bool indexTypeUint8Extension =
+        device->IsSupportedExtension(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+    const bool conditionalRenderingExtension = device->IsSupportedExtension(
+        VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+
     uint32_t queueCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, 0);
     std::vector<VkQueueFamilyProperties> queues(queueCount);
@@ -38,7 +55,25 @@ BgiVulkanCapabilities::BgiVulkanCapabilities(BgiVulkanDevice* device)
     // Vertex attribute divisor properties ext
     vkVertexAttributeDivisorProperties.sType =
       VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_ATTRIBUTE_DIVISOR_PROPERTIES_EXT;
-    vkVertexAttributeDivisorProperties.pNext = nullptr;
+    vkVertexAttributeDivisorProperties.pNext = &vkIndexingProperties;
+
+    // Descriptor indexing properties (update-after-bind limits)
+    vkIndexingProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+    vkIndexingProperties.pNext = &vkPushDescriptorProperties;
+
+    // Push descriptor properties (max descriptors per push)
+    vkPushDescriptorProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+    vkPushDescriptorProperties.pNext = descriptorBufferExtension ?
+        &vkDescriptorBufferProperties : nullptr;
+    vkPushDescriptorProperties.maxPushDescriptors = 0;
+
+    // Descriptor buffer properties (descriptor sizes and alignment)
+    vkDescriptorBufferProperties = {};
+    vkDescriptorBufferProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+    vkDescriptorBufferProperties.pNext = nullptr;
         
     vkDeviceProperties2.sType =
         VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
@@ -49,7 +84,35 @@ BgiVulkanCapabilities::BgiVulkanCapabilities(BgiVulkanDevice* device)
     // Vertex attribute divisor features ext
     vkVertexAttributeDivisorFeatures.sType =
         VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_ATTRIBUTE_DIVISOR_FEATURES_EXT;
-    vkVertexAttributeDivisorFeatures.pNext = nullptr;
+    vkVertexAttributeDivisorFeatures.pNext = descriptorBufferExtension ?
+        &vkDescriptorBufferFeatures : nullptr;
+
+    // Descriptor buffer features ext
+    vkDescriptorBufferFeatures = {};
+    vkDescriptorBufferFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+    vkDescriptorBufferFeatures.pNext = nullptr;
+
+    // 8 bit index features ext, chained in front of the descriptor buffer
+    // features when the extension is available.
+    vkIndexTypeUint8Features = {};
+    vkIndexTypeUint8Features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT;
+    vkIndexTypeUint8Features.pNext = vkVertexAttributeDivisorFeatures.pNext;
+    if (indexTypeUint8Extension) {
+        vkVertexAttributeDivisorFeatures.pNext = &vkIndexTypeUint8Features;
+    }
+
+    // Conditional rendering features ext, chained the same way.
+    vkConditionalRenderingFeatures = {};
+    vkConditionalRenderingFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT;
+    vkConditionalRenderingFeatures.pNext =
+        vkVertexAttributeDivisorFeatures.pNext;
+    if (conditionalRenderingExtension) {
+        vkVertexAttributeDivisorFeatures.pNext =
+            &vkConditionalRenderingFeatures;
+    }
 
     // Indexing features ext for resource bindings
     vkIndexingFeatures.sType =
@@ -92,6 +155,77 @@ BgiVulkanCapabilities::BgiVulkanCapabilities(BgiVulkanDevice* device)
     UTILS_VERIFY(
         vkVertexAttributeDivisorFeatures.vertexAttributeInstanceRateDivisor);
 
+    // The bindless descriptor heap needs a partially bound, update-after-bind
+    // runtime array of each resource type it holds. These features are
+    // enabled on the device via the vkIndexingFeatures chain.
+    supportsBindlessHeap =
+        vkIndexingFeatures.runtimeDescriptorArray &&
+        vkIndexingFeatures.descriptorBindingPartiallyBound &&
+        vkIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+        vkIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind &&
+        vkIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+        vkIndexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+        vkIndexingFeatures.shaderStorageImageArrayNonUniformIndexing &&
+        vkIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing;
+
+    supportsBufferDeviceAddress = vkVulkan12Features.bufferDeviceAddress;
+
+    // With descriptor buffers, descriptors are written straight into buffer
+    // memory (see BgiVulkanDescriptorBuffer). Capture replay is only useful
+    // to tools and may cost performance, so it is not enabled.
+    vkDescriptorBufferFeatures.descriptorBufferCaptureReplay = VK_FALSE;
+    supportsDescriptorBuffer = descriptorBufferExtension &&
+        vkDescriptorBufferFeatures.descriptorBuffer &&
+        supportsBufferDeviceAddress;
+
+    // Small per-draw resource sets are pushed into the command buffer
+    // instead of being allocated (see BgiVulkanResourceBindings).
+    supportsPushDescriptors =
+        device->IsSupportedExtension(
+            VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) &&
+        vkPushDescriptorProperties.maxPushDescriptors > 0;
+
+    // The device enables the feature through VK_KHR_draw_indirect_count,
+    // since the 1.2 feature struct cannot be chained next to the indexing
+    // and buffer device address structs.
+    supportsDrawIndirectCount =
+        vkVulkan12Features.drawIndirectCount &&
+        device->IsSupportedExtension(
+            VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+    // Meshes with few vertices can use 8 bit indices.
+    supportsIndexTypeUint8 = indexTypeUint8Extension &&
+        vkIndexTypeUint8Features.indexTypeUint8;
+
+    // Draws can be skipped on the GPU, e.g. based on occlusion results.
+    // Conditional rendering is not inherited by secondary command buffers,
+    // so that feature is not enabled.
+    vkConditionalRenderingFeatures.inheritedConditionalRendering = VK_FALSE;
+    supportsConditionalRendering = conditionalRenderingExtension &&
+        vkConditionalRenderingFeatures.conditionalRendering;
+
+    // The device reuses the feature chain from vkVulkan11Features on, but
+    // only enables the extensions of supported features. Keep only the
+    // structs of those extensions in the chain, since structs of extensions
+    // that are not enabled must not be passed to vkCreateDevice.
+    vkDescriptorBufferFeatures.pNext = nullptr;
+    vkIndexTypeUint8Features.pNext = nullptr;
+    vkConditionalRenderingFeatures.pNext = nullptr;
+
+    void** chainEnd = &vkVertexAttributeDivisorFeatures.pNext;
+    *chainEnd = nullptr;
+    if (supportsConditionalRendering) {
+        *chainEnd = &vkConditionalRenderingFeatures;
+        chainEnd = &vkConditionalRenderingFeatures.pNext;
+    }
+    if (supportsIndexTypeUint8) {
+        *chainEnd = &vkIndexTypeUint8Features;
+        chainEnd = &vkIndexTypeUint8Features.pNext;
+    }
+    if (supportsDescriptorBuffer) {
+        *chainEnd = &vkDescriptorBufferFeatures;
+    }
+
     if (BgiVulkanIsDebugEnabled()) {
         UTILS_WARN("Selected GPU %s", vkDeviceProperties.deviceName);
     }
@@ -120,6 +254,21 @@ BgiVulkanCapabilities::BgiVulkanCapabilities(BgiVulkanDevice* device)
         hasBuiltinBarycentrics);
     _SetFlag(BgiDeviceCapabilitiesBitsShaderDrawParameters, 
         shaderDrawParametersEnabled);
+    _SetFlag(BgiDeviceCapabilitiesBitsBindlessBuffers, supportsBindlessHeap);
+    _SetFlag(BgiDeviceCapabilitiesBitsBindlessTextures, supportsBindlessHeap);
+    _SetFlag(BgiDeviceCapabilitiesBitsBufferDeviceAddress,
+        supportsBufferDeviceAddress);
+    _SetFlag(BgiDeviceCapabilitiesBitsDrawIndirectCount,
+        supportsDrawIndirectCount);
+    _SetFlag(BgiDeviceCapabilitiesBitsIndexTypeUint8,
+        supportsIndexTypeUint8);
+    _SetFlag(BgiDeviceCapabilitiesBitsOcclusionQueryPrecise,
+        vkDeviceFeatures.occlusionQueryPrecise);
+    _SetFlag(BgiDeviceCapabilitiesBitsPipelineStatisticsQuery,
+        vkDeviceFeatures.pipelineStatisticsQuery);
+    _SetFlag(BgiDeviceCapabilitiesBitsTimestampQuery, supportsTimeStamps);
+    _SetFlag(BgiDeviceCapabilitiesBitsConditionalRendering,
+        supportsConditionalRendering);
 }
 
 BgiVulkanCapabilities::~BgiVulkanCapabilities() = default;
@@ -32,12 +32,23 @@ public:
     int GetShaderVersion() const override;
 
     bool supportsTimeStamps;
+    bool supportsBindlessHeap;
+    bool supportsPushDescriptors;
+    bool supportsBufferDeviceAddress;
+    bool supportsDescriptorBuffer;
+    bool supportsDrawIndirectCount;
+    bool supportsIndexTypeUint8;
+    bool supportsConditionalRendering;
     
     VkPhysicalDeviceProperties vkDeviceProperties;
     VkPhysicalDeviceProperties2 vkDeviceProperties2;
     VkPhysicalDeviceFeatures vkDeviceFeatures;
     VkPhysicalDeviceFeatures2 vkDeviceFeatures2;
     VkPhysicalDeviceVertexAttributeDivisorPropertiesEXT vkVertexAttributeDivisorProperties;
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT vkIndexingProperties;
+    VkPhysicalDevicePushDescriptorPropertiesKHR vkPushDescriptorProperties;
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT
+        vkDescriptorBufferProperties;
 
     // vulkan features in different versions
     VkPhysicalDeviceVulkan11Features vkVulkan11Features;
@@ -47,6 +58,10 @@ public:
     VkPhysicalDeviceDescriptorIndexingFeaturesEXT vkIndexingFeatures;
     VkPhysicalDeviceVertexAttributeDivisorFeaturesEXT
         vkVertexAttributeDivisorFeatures;
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT vkDescriptorBufferFeatures;
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT vkIndexTypeUint8Features;
+    VkPhysicalDeviceConditionalRenderingFeaturesEXT
+        vkConditionalRenderingFeatures;
     VkPhysicalDeviceMemoryProperties vkMemoryProperties;
 };
 
@@ -1,8 +1,12 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/commandBuffer.h"
+#include "driver/bgiVulkan/buffer.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/descriptorBuffer.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/queryPool.h"
 
 #include <string>
 
@@ -102,6 +106,13 @@ BgiVulkanCommandBuffer::BeginCommandBuffer(uint8_t inflightId)
             vkBeginCommandBuffer(_vkCommandBuffer, &beginInfo) == VK_SUCCESS
         );
 
+        // Descriptor sets are bound as offsets into the descriptor buffer,
+        // which stays bound for the whole command buffer.
+        if (BgiVulkanDescriptorBuffer* descriptorBuffer =
+                _device->GetDescriptorBuffer()) {
+            descriptorBuffer->BindBuffer(_vkCommandBuffer);
+        }
+
         _inflightId = inflightId;
         _isInFlight = true;
     }
@@ -251,6 +262,62 @@ BgiVulkanCommandBuffer::InsertMemoryBarrier(BgiMemoryBarrier barrier)
         0, nullptr);                        // image barriers
 }
 
+void
+BgiVulkanCommandBuffer::ResolveQueries(
+    BgiVulkanQueryPool* pool,
+    uint32_t firstQuery,
+    uint32_t queryCount,
+    BgiVulkanBuffer* buffer,
+    uint32_t byteOffset)
+{
+    if (!_vkCommandBuffer || !pool || !buffer || queryCount == 0) {
+        return;
+    }
+
+    BgiQueryPoolDesc const& desc = pool->GetDescriptor();
+    if (firstQuery + queryCount > desc.queryCount) {
+        UTILS_CODING_ERROR("Resolving queries past the end of query pool %s",
+            desc.debugName.c_str());
+        return;
+    }
+
+    uint32_t const stride = pool->GetResultByteSize();
+    if (byteOffset + size_t(stride) * queryCount >
+            buffer->GetDescriptor().byteSize) {
+        UTILS_CODING_ERROR("Buffer %s is too small for the query results",
+            buffer->GetDescriptor().debugName.c_str());
+        return;
+    }
+
+    vkCmdCopyQueryPoolResults(
+        _vkCommandBuffer,
+        pool->GetVulkanQueryPool(),
+        firstQuery,
+        queryCount,
+        buffer->GetVulkanBuffer(),
+        byteOffset,
+        stride,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+    // The results may be consumed by shaders (e.g. occlusion culling),
+    // indirect draws, conditional rendering, copies or read back by the CPU.
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT |
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+        VK_ACCESS_TRANSFER_READ_BIT |
+        VK_ACCESS_HOST_READ_BIT;
+    if (_device->GetDeviceCapabilities().supportsConditionalRendering) {
+        barrier.dstAccessMask |= VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
+    }
+    vkCmdPipelineBarrier(
+        _vkCommandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
 void
 BgiVulkanCommandBuffer::AddCompletedHandler(BgiVulkanCompletedHandler const& fn)
 {
@@ -13,7 +13,9 @@ GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
 
+class BgiVulkanBuffer;
 class BgiVulkanDevice;
+class BgiVulkanQueryPool;
 
 using BgiVulkanCompletedHandler = std::function<void(void)>;
 using BgiVulkanCompletedHandlerVector = std::vector<BgiVulkanCompletedHandler>;
@@ -83,6 +85,18 @@ public:
     BGIVULKAN_API
     void InsertMemoryBarrier(BgiMemoryBarrier barrier);
 
+    /// Copies the 64 bit results of 'queryCount' queries of 'pool' into
+    /// 'buffer', waiting for the queries to complete on the GPU. The results
+    /// are made visible to the commands recorded after this call and to the
+    /// host. Must be recorded outside of a render pass.
+    BGIVULKAN_API
+    void ResolveQueries(
+        BgiVulkanQueryPool* pool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiVulkanBuffer* buffer,
+        uint32_t byteOffset);
+
     /// Returns the id that uniquely identifies this command buffer amongst
     /// all in-flight command buffers.
     BGIVULKAN_API
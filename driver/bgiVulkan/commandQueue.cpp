@@ -1,4 +1,5 @@
 #include "common/utils/diagnostic.h"
+#include "common/utils/trace.h"
 
 #include "driver/bgiVulkan/commandQueue.h"
 #include "driver/bgiVulkan/commandBuffer.h"
@@ -88,6 +89,8 @@ BgiVulkanCommandQueue::SubmitToQueue(
     BgiVulkanCommandBuffer* cb,
     BgiSubmitWaitType wait)
 {
+    UTILS_TRACE_FUNCTION();
+
     VkSemaphore semaphore = nullptr;
 
     // If we have resource commands submit those before work commands.
@@ -219,6 +222,8 @@ BgiVulkanCommandQueue::GetVulkanGraphicsQueue() const
 void
 BgiVulkanCommandQueue::ResetConsumedCommandBuffers(BgiSubmitWaitType wait)
 {
+    UTILS_TRACE_FUNCTION();
+
     // Lock the command pool map from concurrent access since we may insert.
     std::lock_guard<std::mutex> guard(_commandPoolsMutex);
 
@@ -1,13 +1,16 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/computeCmds.h"
+#include "driver/bgiVulkan/buffer.h"
 #include "driver/bgiVulkan/commandBuffer.h"
 #include "driver/bgiVulkan/commandQueue.h"
 #include "driver/bgiVulkan/computePipeline.h"
 #include "driver/bgiVulkan/conversions.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/gpuProfiler.h"
 #include "driver/bgiVulkan/bgi.h"
+#include "driver/bgiVulkan/queryPool.h"
 #include "driver/bgiVulkan/resourceBindings.h"
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
@@ -23,30 +26,37 @@ BgiVulkanComputeCmds::BgiVulkanComputeCmds(
     , _bgi(bgi)
     , _commandBuffer(nullptr)
     , _pipelineLayout(nullptr)
-    , _pushConstantsDirty(false)
-    , _pushConstants(nullptr)
-    , _pushConstantsByteSize(0)
+    , _pushConstantRanges(nullptr)
     , _localWorkGroupSize(Vector3i(1, 1, 1))
+    , _boundResourceUpdateCount(0)
+    , _boundResourceLayout(nullptr)
 {
 }
 
 BgiVulkanComputeCmds::~BgiVulkanComputeCmds()
 {
-    delete[] _pushConstants;
 }
 
 void
 BgiVulkanComputeCmds::PushDebugGroup(const char* label)
 {
     _CreateCommandBuffer();
-    BgiVulkanBeginLabel(_bgi->GetPrimaryDevice(), _commandBuffer, label);
+    BgiVulkanDevice* device = _bgi->GetPrimaryDevice();
+    BgiVulkanBeginLabel(device, _commandBuffer, label);
+    if (BgiVulkanGpuProfiler* profiler = device->GetGpuProfiler()) {
+        profiler->PushScope(_commandBuffer, label, &_timestampScopes);
+    }
 }
 
 void
 BgiVulkanComputeCmds::PopDebugGroup()
 {
     _CreateCommandBuffer();
-    BgiVulkanEndLabel(_bgi->GetPrimaryDevice(), _commandBuffer);
+    BgiVulkanDevice* device = _bgi->GetPrimaryDevice();
+    if (BgiVulkanGpuProfiler* profiler = device->GetGpuProfiler()) {
+        profiler->PopScope(_commandBuffer, &_timestampScopes);
+    }
+    BgiVulkanEndLabel(device, _commandBuffer);
 }
 
 void
@@ -54,11 +64,23 @@ BgiVulkanComputeCmds::BindPipeline(BgiComputePipelineHandle pipeline)
 {
     _CreateCommandBuffer();
 
+    // Binding the same pipeline again changes nothing.
+    if (pipeline && pipeline == _pipeline) {
+        return;
+    }
+    _pipeline = pipeline;
+
     BgiVulkanComputePipeline* pso = 
         static_cast<BgiVulkanComputePipeline*>(pipeline.Get());
 
     if (UTILS_VERIFY(pso)) {
+        // Pipeline layouts are shared through the layout cache, so the
+        // constants only need to be pushed again if the layout changes.
+        if (_pipelineLayout != pso->GetVulkanPipelineLayout()) {
+            _pushConstants.Invalidate();
+        }
         _pipelineLayout = pso->GetVulkanPipelineLayout();
+        _pushConstantRanges = &pso->GetPushConstantRanges();
         pso->BindPipeline(_commandBuffer->GetVulkanCommandBuffer());
     }
 
@@ -81,28 +103,54 @@ BgiVulkanComputeCmds::BindPipeline(BgiComputePipelineHandle pipeline)
 
 void
 BgiVulkanComputeCmds::BindResources(BgiResourceBindingsHandle res)
+{
+    BindResources(res, std::vector<uint32_t>());
+}
+
+void
+BgiVulkanComputeCmds::BindResources(
+    BgiResourceBindingsHandle res,
+    std::vector<uint32_t> const& dynamicOffsets)
 {
     _CreateCommandBuffer();
     // Delay bindings until we know for sure what the pipeline will be.
     _resourceBindings = res;
+    _dynamicOffsets = dynamicOffsets;
+}
+
+void
+BgiVulkanComputeCmds::SetConstantValues(
+    BgiComputePipelineHandle pipeline,
+    uint32_t bindIndex,
+    uint32_t byteSize,
+    const void* data)
+{
+    SetConstantValues(pipeline, bindIndex, 0, byteSize, data);
 }
 
 void
 BgiVulkanComputeCmds::SetConstantValues(
     BgiComputePipelineHandle pipeline,
     uint32_t bindIndex,
+    uint32_t byteOffset,
     uint32_t byteSize,
     const void* data)
 {
+    // Compute pipelines have a single push constant range read by the
+    // compute stage, so the values only need to fit in it.
+    BgiVulkanComputePipeline const* pso =
+        static_cast<BgiVulkanComputePipeline const*>(pipeline.Get());
+    if (pso) {
+        uint32_t const constantsByteSize =
+            pso->GetDescriptor().shaderConstantsDesc.byteSize;
+        UTILS_VERIFY(byteOffset + byteSize <= constantsByteSize,
+            "Push constants [%u, %u) exceed the pipeline's %u bytes",
+            byteOffset, byteOffset + byteSize, constantsByteSize);
+    }
+
     _CreateCommandBuffer();
     // Delay pushing until we know for sure what the pipeline will be.
-    if (!_pushConstants || _pushConstantsByteSize != byteSize) {
-        delete[] _pushConstants;
-        _pushConstants = new uint8_t[byteSize];
-        _pushConstantsByteSize = byteSize;
-    }
-    memcpy(_pushConstants, data, byteSize);
-    _pushConstantsDirty = true;
+    _pushConstants.SetValues(byteOffset, byteSize, data);
 }
 
 void
@@ -149,6 +197,28 @@ BgiVulkanComputeCmds::Dispatch(int dimX, int dimY, int dimZ)
         (uint32_t) numWorkGroupsZ);
 }
 
+void
+BgiVulkanComputeCmds::DispatchIndirect(
+    BgiBufferHandle const& dispatchParameterBuffer,
+    uint32_t byteOffset)
+{
+    _CreateCommandBuffer();
+    _BindResources();
+
+    BgiVulkanBuffer* dispatchBuf =
+        static_cast<BgiVulkanBuffer*>(dispatchParameterBuffer.Get());
+    if (!UTILS_VERIFY(dispatchBuf)) {
+        return;
+    }
+
+    // The group counts are only known on the GPU, so unlike Dispatch they
+    // cannot be clamped to the device limits here.
+    vkCmdDispatchIndirect(
+        _commandBuffer->GetVulkanCommandBuffer(),
+        dispatchBuf->GetVulkanBuffer(),
+        byteOffset);
+}
+
 bool
 BgiVulkanComputeCmds::_Submit(Bgi* bgi, BgiSubmitWaitType wait)
 {
@@ -176,31 +246,123 @@ BgiVulkanComputeCmds::_BindResources()
         BgiVulkanResourceBindings * rb =
             static_cast<BgiVulkanResourceBindings*>(_resourceBindings.Get());
 
-        if (rb){
+        // Skip the bind if the same version of the resources is bound with
+        // the same layout and offsets.
+        if (rb && !(
+                _resourceBindings == _boundResourceBindings &&
+                rb->GetUpdateCount() == _boundResourceUpdateCount &&
+                _pipelineLayout == _boundResourceLayout &&
+                _dynamicOffsets == _boundDynamicOffsets)) {
             rb->BindResources(
-                _commandBuffer->GetVulkanCommandBuffer(),
+                _commandBuffer,
                 VK_PIPELINE_BIND_POINT_COMPUTE,
-                _pipelineLayout);
+                _pipelineLayout,
+                _dynamicOffsets);
+            _boundResourceBindings = _resourceBindings;
+            _boundResourceUpdateCount = rb->GetUpdateCount();
+            _boundResourceLayout = _pipelineLayout;
+            _boundDynamicOffsets = _dynamicOffsets;
         }
 
         // Make sure we bind only once
         _resourceBindings = BgiResourceBindingsHandle();
     }
 
-    if (_pushConstantsDirty && _pushConstants && _pushConstantsByteSize > 0) {
-        vkCmdPushConstants(
+    _pushConstants.Flush(
+        _commandBuffer->GetVulkanCommandBuffer(),
+        _pipelineLayout,
+        *_pushConstantRanges);
+}
+
+void
+BgiVulkanComputeCmds::ResetQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        vkCmdResetQueryPool(
+            _commandBuffer->GetVulkanCommandBuffer(),
+            pool->GetVulkanQueryPool(),
+            firstQuery,
+            queryCount);
+    }
+}
+
+void
+BgiVulkanComputeCmds::BeginQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        vkCmdBeginQuery(
+            _commandBuffer->GetVulkanCommandBuffer(),
+            pool->GetVulkanQueryPool(),
+            query,
+            pool->GetVulkanQueryControlFlags());
+    }
+}
+
+void
+BgiVulkanComputeCmds::EndQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        vkCmdEndQuery(
             _commandBuffer->GetVulkanCommandBuffer(),
-            _pipelineLayout,
-            VK_SHADER_STAGE_COMPUTE_BIT,
-            0, // offset
-            _pushConstantsByteSize,
-            _pushConstants);
+            pool->GetVulkanQueryPool(),
+            query);
+    }
+}
 
-        // Make sure we copy only once
-        _pushConstantsDirty = false;
+void
+BgiVulkanComputeCmds::WriteTimestamp(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        vkCmdWriteTimestamp(
+            _commandBuffer->GetVulkanCommandBuffer(),
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            pool->GetVulkanQueryPool(),
+            query);
     }
 }
 
+void
+BgiVulkanComputeCmds::ResolveQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount,
+    BgiBufferHandle const& buffer,
+    uint32_t byteOffset)
+{
+    _CreateCommandBuffer();
+    _commandBuffer->ResolveQueries(
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get()),
+        firstQuery,
+        queryCount,
+        static_cast<BgiVulkanBuffer*>(buffer.Get()),
+        byteOffset);
+}
+
 void
 BgiVulkanComputeCmds::InsertMemoryBarrier(BgiMemoryBarrier barrier)
 {
@@ -214,6 +376,13 @@ BgiVulkanComputeCmds::GetDispatchMethod() const
     return BgiComputeDispatchSerial;
 }
 
+BgiVulkanCommandBuffer*
+BgiVulkanComputeCmds::GetCommandBuffer()
+{
+    _CreateCommandBuffer();
+    return _commandBuffer;
+}
+
 void
 BgiVulkanComputeCmds::_CreateCommandBuffer()
 {
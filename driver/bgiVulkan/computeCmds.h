@@ -6,8 +6,11 @@
 #include "driver/bgiBase/computeCmds.h"
 #include "driver/bgiBase/computePipeline.h"
 #include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/pushConstants.h"
 #include "driver/bgiVulkan/vulkanBridge.h"
 
+#include <vector>
+
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 using namespace math;
@@ -40,22 +43,74 @@ public:
     BGIVULKAN_API
     void BindResources(BgiResourceBindingsHandle resources) override;
 
+    BGIVULKAN_API
+    void BindResources(
+        BgiResourceBindingsHandle resources,
+        std::vector<uint32_t> const& dynamicOffsets) override;
+
     BGIVULKAN_API
     void SetConstantValues(
         BgiComputePipelineHandle pipeline,
         uint32_t bindIndex,
         uint32_t byteSize,
         const void* data) override;
+
+    BGIVULKAN_API
+    void SetConstantValues(
+        BgiComputePipelineHandle pipeline,
+        uint32_t bindIndex,
+        uint32_t byteOffset,
+        uint32_t byteSize,
+        const void* data) override;
     
     BGIVULKAN_API
     void Dispatch(int dimX, int dimY, int dimZ) override;
 
+    BGIVULKAN_API
+    void DispatchIndirect(
+        BgiBufferHandle const& dispatchParameterBuffer,
+        uint32_t byteOffset) override;
+
+    BGIVULKAN_API
+    void ResetQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount) override;
+
+    BGIVULKAN_API
+    void BeginQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGIVULKAN_API
+    void EndQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGIVULKAN_API
+    void WriteTimestamp(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGIVULKAN_API
+    void ResolveQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset) override;
+
     BGIVULKAN_API
     void InsertMemoryBarrier(BgiMemoryBarrier barrier) override;
 
     BGIVULKAN_API
     BgiComputeDispatch GetDispatchMethod() const override;
 
+    /// Returns the command buffer used inside this cmds, acquiring it for
+    /// the calling thread if needed.
+    BGIVULKAN_API
+    BgiVulkanCommandBuffer* GetCommandBuffer();
+
 protected:
     friend class BgiVulkan;
 
@@ -75,13 +130,24 @@ private:
 
     BgiVulkan* _bgi;
     BgiVulkanCommandBuffer* _commandBuffer;
+    BgiComputePipelineHandle _pipeline;
     VkPipelineLayout _pipelineLayout;
+    VkPushConstantRangeVector const* _pushConstantRanges;
     BgiResourceBindingsHandle _resourceBindings;
-    bool _pushConstantsDirty;
-    uint8_t* _pushConstants;
-    uint32_t _pushConstantsByteSize;
+    std::vector<uint32_t> _dynamicOffsets;
+    BgiVulkanPushConstants _pushConstants;
     Vector3i _localWorkGroupSize;
 
+    // The GPU profiler scopes of the debug groups pushed on these cmds.
+    std::vector<uint32_t> _timestampScopes;
+
+    // The resources last bound into the command buffer. Binding them again
+    // is skipped when nothing changed.
+    BgiResourceBindingsHandle _boundResourceBindings;
+    uint64_t _boundResourceUpdateCount;
+    VkPipelineLayout _boundResourceLayout;
+    std::vector<uint32_t> _boundDynamicOffsets;
+
     // Cmds is used only one frame so storing multi-frame state on will not
     // survive.
 };
@@ -1,8 +1,11 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/computePipeline.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/layoutCache.h"
+#include "driver/bgiVulkan/memoryTracker.h"
 #include "driver/bgiVulkan/pipelineCache.h"
 #include "driver/bgiVulkan/shaderFunction.h"
 #include "driver/bgiVulkan/shaderProgram.h"
@@ -19,6 +22,7 @@ BgiVulkanComputePipeline::BgiVulkanComputePipeline(
     , _inflightBits(0)
     , _vkPipeline(nullptr)
     , _vkPipelineLayout(nullptr)
+    , _usesBindlessHeap(false)
 {
     VkComputePipelineCreateInfo pipeCreateInfo =
         {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
@@ -48,46 +52,35 @@ BgiVulkanComputePipeline::BgiVulkanComputePipeline(
     //
     // Generate Pipeline layout
     //
-    bool usePushConstants = desc.shaderConstantsDesc.byteSize > 0;
-    VkPushConstantRange pcRanges;
-    if (usePushConstants) {
+    // The only stage of a compute pipeline is the compute stage, so a single
+    // range covering all constants is always the one range of that stage.
+    if (desc.shaderConstantsDesc.byteSize > 0) {
         UTILS_VERIFY(desc.shaderConstantsDesc.byteSize % 4 == 0,
             "Push constants not multipes of 4");
-        pcRanges.offset = 0;
-        pcRanges.size = desc.shaderConstantsDesc.byteSize;
-        pcRanges.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        VkPushConstantRange pcRange;
+        pcRange.offset = 0;
+        pcRange.size = desc.shaderConstantsDesc.byteSize;
+        pcRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        _pushConstantRanges.push_back(pcRange);
     }
 
-    VkPipelineLayoutCreateInfo pipeLayCreateInfo =
-        {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-    pipeLayCreateInfo.pushConstantRangeCount = usePushConstants ? 1 : 0;
-    pipeLayCreateInfo.pPushConstantRanges = &pcRanges;
-
     _vkDescriptorSetLayouts = BgiVulkanMakeDescriptorSetLayouts(
         device, {setInfo}, desc.debugName);
-    pipeLayCreateInfo.setLayoutCount = (uint32_t)_vkDescriptorSetLayouts.size();
-    pipeLayCreateInfo.pSetLayouts = _vkDescriptorSetLayouts.data();
+    _vkPipelineLayout = device->GetLayoutCache()->AcquirePipelineLayout(
+        _vkDescriptorSetLayouts, _pushConstantRanges, desc.debugName);
 
-    UTILS_VERIFY(
-        vkCreatePipelineLayout(
-            _device->GetVulkanDevice(),
-            &pipeLayCreateInfo,
-            BgiVulkanAllocator(),
-            &_vkPipelineLayout) == VK_SUCCESS
-    );
-
-    // Debug label
-    if (!desc.debugName.empty()) {
-        std::string debugLabel = "PipelineLayout " + desc.debugName;
-        BgiVulkanSetDebugName(
-            device,
-            (uint64_t)_vkPipelineLayout,
-            VK_OBJECT_TYPE_PIPELINE_LAYOUT,
-            debugLabel.c_str());
-    }
+    BgiVulkanBindlessHeap* heap = device->GetBindlessHeap();
+    _usesBindlessHeap = heap &&
+        _vkDescriptorSetLayouts.size() > BgiVulkanBindlessHeap::SetIndex;
 
     pipeCreateInfo.layout = _vkPipelineLayout;
 
+    // Pipelines read their descriptors from the descriptor buffer when the
+    // device uses one.
+    if (device->GetDescriptorBuffer()) {
+        pipeCreateInfo.flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+    }
+
     //
     // Create pipeline
     //
@@ -103,6 +96,11 @@ BgiVulkanComputePipeline::BgiVulkanComputePipeline(
             &_vkPipeline) == VK_SUCCESS
     );
 
+    if (_vkPipeline) {
+        device->GetMemoryTracker()->AddResource(
+            BgiMemoryResourceKindPipeline, 0);
+    }
+
     // Debug label
     if (!desc.debugName.empty()) {
         std::string debugLabel = "Pipeline " + desc.debugName;
@@ -116,21 +114,20 @@ BgiVulkanComputePipeline::BgiVulkanComputePipeline(
 
 BgiVulkanComputePipeline::~BgiVulkanComputePipeline()
 {
-    vkDestroyPipelineLayout(
-        _device->GetVulkanDevice(),
-        _vkPipelineLayout,
-        BgiVulkanAllocator());
+    if (_vkPipeline) {
+        _device->GetMemoryTracker()->RemoveResource(
+            BgiMemoryResourceKindPipeline, 0);
+    }
 
     vkDestroyPipeline(
         _device->GetVulkanDevice(),
         _vkPipeline,
         BgiVulkanAllocator());
 
+    BgiVulkanLayoutCache* layoutCache = _device->GetLayoutCache();
+    layoutCache->ReleasePipelineLayout(_vkPipelineLayout);
     for (VkDescriptorSetLayout layout : _vkDescriptorSetLayouts) {
-        vkDestroyDescriptorSetLayout(
-            _device->GetVulkanDevice(),
-            layout,
-            BgiVulkanAllocator());
+        layoutCache->ReleaseDescriptorSetLayout(layout);
     }
 }
 
@@ -138,6 +135,13 @@ void
 BgiVulkanComputePipeline::BindPipeline(VkCommandBuffer cb)
 {
     vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, _vkPipeline);
+
+    // The bindless heap is update-after-bind, so it is bound once with the
+    // pipeline instead of per draw.
+    if (_usesBindlessHeap) {
+        _device->GetBindlessHeap()->BindDescriptors(
+            cb, VK_PIPELINE_BIND_POINT_COMPUTE, _vkPipelineLayout);
+    }
 }
 
 VkPipelineLayout
@@ -146,6 +150,12 @@ BgiVulkanComputePipeline::GetVulkanPipelineLayout() const
     return _vkPipelineLayout;
 }
 
+VkPushConstantRangeVector const&
+BgiVulkanComputePipeline::GetPushConstantRanges() const
+{
+    return _pushConstantRanges;
+}
+
 BgiVulkanDevice*
 BgiVulkanComputePipeline::GetDevice() const
 {
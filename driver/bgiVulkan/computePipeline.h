@@ -15,6 +15,7 @@ namespace driver {
 class BgiVulkanDevice;
 
 using VkDescriptorSetLayoutVector = std::vector<VkDescriptorSetLayout>;
+using VkPushConstantRangeVector = std::vector<VkPushConstantRange>;
 
 /// \class HgiVulkanComputePipeline
 ///
@@ -34,6 +35,10 @@ public:
     BGIVULKAN_API
     VkPipelineLayout GetVulkanPipelineLayout() const;
 
+    /// Returns the push constant ranges of the pipeline layout.
+    BGIVULKAN_API
+    VkPushConstantRangeVector const& GetPushConstantRanges() const;
+
     /// Returns the device used to create this object.
     BGIVULKAN_API
     BgiVulkanDevice* GetDevice() const;
@@ -59,7 +64,9 @@ private:
     uint64_t _inflightBits;
     VkPipeline _vkPipeline;
     VkPipelineLayout _vkPipelineLayout;
+    VkPushConstantRangeVector _pushConstantRanges;
     VkDescriptorSetLayoutVector _vkDescriptorSetLayouts;
+    bool _usesBindlessHeap;
 };
 
 }
@@ -133,9 +133,17 @@ _BufferUsageTable[][2] =
     {BgiBufferUsageUniform, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT},
     {BgiBufferUsageIndex32, VK_BUFFER_USAGE_INDEX_BUFFER_BIT},
     {BgiBufferUsageVertex,  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT},
-    {BgiBufferUsageStorage, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT},
+    {BgiBufferUsageStorage, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT},
+    {BgiBufferUsageDeviceAddress,
+        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT},
+    {BgiBufferUsageIndex16, VK_BUFFER_USAGE_INDEX_BUFFER_BIT},
+    {BgiBufferUsageIndex8,  VK_BUFFER_USAGE_INDEX_BUFFER_BIT},
+    {BgiBufferUsagePredicate,
+        VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT},
+    {BgiBufferUsageIndirect, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT},
 };
-static_assert(BgiBufferUsageCustomBitsBegin == 1 << 4, "");
+static_assert(BgiBufferUsageCustomBitsBegin == 1 << 9, "");
 
 static const uint32_t
 _CullModeTable[BgiCullModeCount][2] =
@@ -311,6 +319,35 @@ _primitiveTypeTable[BgiPrimitiveTypeCount][2] =
 };
 static_assert(BgiPrimitiveTypeCount==6, "");
 
+static const uint32_t
+_queryTypeTable[BgiQueryTypeCount][2] =
+{
+    {BgiQueryTypeOcclusion,          VK_QUERY_TYPE_OCCLUSION},
+    {BgiQueryTypeOcclusionPrecise,   VK_QUERY_TYPE_OCCLUSION},
+    {BgiQueryTypePipelineStatistics, VK_QUERY_TYPE_PIPELINE_STATISTICS},
+    {BgiQueryTypeTimestamp,          VK_QUERY_TYPE_TIMESTAMP}
+};
+static_assert(BgiQueryTypeCount==4, "");
+
+static const uint32_t
+_pipelineStatisticsTable[][2] =
+{
+    {BgiPipelineStatisticsBitsInputAssemblyVertices,
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT},
+    {BgiPipelineStatisticsBitsInputAssemblyPrimitives,
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT},
+    {BgiPipelineStatisticsBitsVertexShaderInvocations,
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT},
+    {BgiPipelineStatisticsBitsClippingInvocations,
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT},
+    {BgiPipelineStatisticsBitsClippingPrimitives,
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT},
+    {BgiPipelineStatisticsBitsFragmentShaderInvocations,
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT},
+    {BgiPipelineStatisticsBitsComputeShaderInvocations,
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT}
+};
+
 static const std::string
 _imageLayoutFormatTable[BgiFormatCount][2] =
 { 
@@ -486,6 +523,18 @@ BgiVulkanConversions::GetBufferUsage(BgiBufferUsage bu)
     return vkFlags;
 }
 
+VkIndexType
+BgiVulkanConversions::GetIndexType(BgiBufferUsage bu)
+{
+    if (bu & BgiBufferUsageIndex8) {
+        return VK_INDEX_TYPE_UINT8_EXT;
+    }
+    if (bu & BgiBufferUsageIndex16) {
+        return VK_INDEX_TYPE_UINT16;
+    }
+    return VK_INDEX_TYPE_UINT32;
+}
+
 VkCullModeFlags
 BgiVulkanConversions::GetCullMode(BgiCullMode cm)
 {
@@ -588,6 +637,22 @@ BgiVulkanConversions::GetImageLayoutFormatQualifier(BgiFormat inFormat)
     return layoutQualifier;
 }
 
+VkQueryType
+BgiVulkanConversions::GetQueryType(BgiQueryType qt)
+{
+    return VkQueryType(_queryTypeTable[qt][1]);
+}
+
+VkQueryPipelineStatisticFlags
+BgiVulkanConversions::GetPipelineStatistics(BgiPipelineStatistics ps)
+{
+    VkQueryPipelineStatisticFlags vkFlags = 0;
+    for (const auto& f : _pipelineStatisticsTable) {
+        if (ps & f[0]) vkFlags |= f[1];
+    }
+    return vkFlags;
+}
+
 }
 
 GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -49,6 +49,11 @@ public:
     BGIVULKAN_API
     static VkBufferUsageFlags GetBufferUsage(BgiBufferUsage bu);
 
+    /// Returns the index type of an index buffer with usage 'bu'. Buffers
+    /// without a smaller index usage hold 32 bit indices.
+    BGIVULKAN_API
+    static VkIndexType GetIndexType(BgiBufferUsage bu);
+
     BGIVULKAN_API
     static VkCullModeFlags GetCullMode(BgiCullMode cm);
 
@@ -96,6 +101,13 @@ public:
 
     BGIVULKAN_API
     static std::string GetImageLayoutFormatQualifier(BgiFormat inFormat);
+
+    BGIVULKAN_API
+    static VkQueryType GetQueryType(BgiQueryType qt);
+
+    BGIVULKAN_API
+    static VkQueryPipelineStatisticFlags GetPipelineStatistics(
+        BgiPipelineStatistics ps);
 };
 
 }
@@ -0,0 +1,376 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/descriptorAllocator.h"
+#include "driver/bgiVulkan/conversions.h"
+#include "driver/bgiVulkan/device.h"
+#include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/memoryTracker.h"
+
+#include <algorithm>
+#include <atomic>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+namespace {
+    // Number of descriptor sets a page holds.
+    static const uint32_t _pageMaxSets = 256;
+
+    // Average number of descriptors of each resource type we reserve per set
+    // in a page. Sets that need more than a page holds get a dedicated pool.
+    static const uint32_t _pageDescriptorsPerSet[BgiBindResourceTypeCount] = {
+        1, // BgiBindResourceTypeSampler
+        2, // BgiBindResourceTypeSampledImage
+        4, // BgiBindResourceTypeCombinedSamplerImage
+        1, // BgiBindResourceTypeStorageImage
+        4, // BgiBindResourceTypeUniformBuffer
+        4, // BgiBindResourceTypeStorageBuffer
+        1, // BgiBindResourceTypeTessFactors
+    };
+    static_assert(BgiBindResourceTypeCount==7, "");
+
+    // Buffers bound with dynamic offsets use their own descriptor types.
+    static const uint32_t _pageDynamicUniformBuffersPerSet = 2;
+    static const uint32_t _pageDynamicStorageBuffersPerSet = 1;
+
+    // Ids are never reused, so a thread local state cache can not match an
+    // allocator that was destroyed or pruned its thread states.
+    static std::atomic<uint64_t> _nextId(1);
+}
+
+static uint32_t
+_GetDescriptorCount(
+    VkDescriptorPoolSizeVector const& poolSizes,
+    VkDescriptorType type)
+{
+    uint32_t count = 0;
+    for (VkDescriptorPoolSize const& p : poolSizes) {
+        if (p.type == type) {
+            count += p.descriptorCount;
+        }
+    }
+    return count;
+}
+
+BgiVulkanDescriptorAllocator::BgiVulkanDescriptorAllocator(
+    BgiVulkanDevice* device)
+    : _device(device)
+{
+    // Identifies this allocator in the thread local state cache.
+    _id = _nextId++;
+
+    for (size_t i=0; i<BgiBindResourceTypeCount; i++) {
+        VkDescriptorPoolSize p;
+        p.type = BgiVulkanConversions::GetDescriptorType(
+            BgiBindResourceType(i));
+        p.descriptorCount = _pageMaxSets * _pageDescriptorsPerSet[i];
+        _pagePoolSizes.push_back(p);
+    }
+
+    _pagePoolSizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        _pageMaxSets * _pageDynamicUniformBuffersPerSet});
+    _pagePoolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+        _pageMaxSets * _pageDynamicStorageBuffersPerSet});
+}
+
+BgiVulkanDescriptorAllocator::~BgiVulkanDescriptorAllocator()
+{
+    for (auto const& pair : _threadStates) {
+        for (VkDescriptorPool pool : pair.second->pools) {
+            _DestroyPool(pool);
+        }
+    }
+
+    for (_RetiredFrame const& frame : _retiredFrames) {
+        for (VkDescriptorPool pool : frame.pools) {
+            _DestroyPool(pool);
+        }
+    }
+
+    for (VkDescriptorPool pool : _freeTransientPools) {
+        _DestroyPool(pool);
+    }
+
+    for (VkDescriptorPool pool : _persistentPools) {
+        _DestroyPool(pool);
+    }
+}
+
+/* Multi threaded */
+BgiVulkanDescriptorAllocation
+BgiVulkanDescriptorAllocator::Allocate(
+    VkDescriptorSetLayout layout,
+    VkDescriptorPoolSizeVector const& poolSizes,
+    bool transient)
+{
+    BgiVulkanDescriptorAllocation result;
+
+    // Large sets get their own pool, sized exactly to what they need.
+    if (!_FitsInPage(poolSizes)) {
+        VkDescriptorPoolSizeVector sizes;
+        for (VkDescriptorPoolSize const& p : poolSizes) {
+            // Vulkan validation will complain if any descriptorCount is 0.
+            if (p.descriptorCount > 0) {
+                sizes.push_back(p);
+            }
+        }
+
+        result.pool = _CreatePool(sizes, 1, 0, "Descriptor Pool Dedicated");
+        result.set = _AllocateSet(result.pool, layout);
+        result.dedicated = true;
+        UTILS_VERIFY(result.set, "Failed to allocate descriptor set");
+        return result;
+    }
+
+    if (transient) {
+        // The thread state is only used by this thread (and by EndFrame when
+        // no threads are recording) so we do not need to lock it.
+        _ThreadState* state = _GetThreadState();
+
+        if (!state->pools.empty()) {
+            result.set = _AllocateSet(state->pools.back(), layout);
+            result.pool = state->pools.back();
+        }
+
+        // Current page is full (or there is none). Grab a recycled page or
+        // create a new one.
+        if (!result.set) {
+            VkDescriptorPool pool = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(_transientMutex);
+                if (!_freeTransientPools.empty()) {
+                    pool = _freeTransientPools.back();
+                    _freeTransientPools.pop_back();
+                }
+            }
+            if (!pool) {
+                pool = _CreatePool(_pagePoolSizes, _pageMaxSets, 0,
+                    "Descriptor Pool Transient Page");
+            }
+            state->pools.push_back(pool);
+
+            result.set = _AllocateSet(pool, layout);
+            result.pool = pool;
+        }
+
+        result.transient = true;
+        UTILS_VERIFY(result.set, "Failed to allocate descriptor set");
+        return result;
+    }
+
+    // Long-lived pages are shared between threads. Vulkan requires external
+    // synchronization of the pool for allocate and free.
+    std::lock_guard<std::mutex> lock(_persistentMutex);
+
+    // Most recently created pages are most likely to have room.
+    for (size_t i=_persistentPools.size(); i-- > 0;) {
+        result.set = _AllocateSet(_persistentPools[i], layout);
+        if (result.set) {
+            result.pool = _persistentPools[i];
+            return result;
+        }
+    }
+
+    VkDescriptorPool pool = _CreatePool(
+        _pagePoolSizes,
+        _pageMaxSets,
+        VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+        "Descriptor Pool Page");
+    _persistentPools.push_back(pool);
+
+    result.set = _AllocateSet(pool, layout);
+    result.pool = pool;
+    UTILS_VERIFY(result.set, "Failed to allocate descriptor set");
+    return result;
+}
+
+/* Multi threaded */
+void
+BgiVulkanDescriptorAllocator::Free(
+    BgiVulkanDescriptorAllocation const& allocation)
+{
+    if (allocation.transient || !allocation.pool) {
+        return;
+    }
+
+    if (allocation.dedicated) {
+        _DestroyPool(allocation.pool);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_persistentMutex);
+
+    UTILS_VERIFY(
+        vkFreeDescriptorSets(
+            _device->GetVulkanDevice(),
+            allocation.pool,
+            1,
+            &allocation.set) == VK_SUCCESS
+    );
+}
+
+/* Single threaded */
+void
+BgiVulkanDescriptorAllocator::EndFrame(uint64_t queueInflightBits)
+{
+    std::lock_guard<std::mutex> lock(_transientMutex);
+
+    // Recycle the pages of frames whose command buffers have all been
+    // consumed by the GPU. See BgiVulkanGarbageCollector for how the
+    // in-flight bits are compared.
+    for (size_t i=_retiredFrames.size(); i-- > 0;) {
+        _RetiredFrame& frame = _retiredFrames[i];
+        if ((queueInflightBits & frame.inflightBits) != 0) {
+            continue;
+        }
+
+        for (VkDescriptorPool pool : frame.pools) {
+            UTILS_VERIFY(
+                vkResetDescriptorPool(
+                    _device->GetVulkanDevice(),
+                    pool,
+                    0) == VK_SUCCESS
+            );
+            _freeTransientPools.push_back(pool);
+        }
+
+        std::iter_swap(_retiredFrames.begin() + i, _retiredFrames.end() - 1);
+        _retiredFrames.pop_back();
+    }
+
+    // Retire the pages used during this frame. Any command buffer that is
+    // in-flight now may reference their sets.
+    _RetiredFrame retired;
+    retired.inflightBits = queueInflightBits;
+    for (auto const& pair : _threadStates) {
+        std::vector<VkDescriptorPool>& pools = pair.second->pools;
+        retired.pools.insert(retired.pools.end(), pools.begin(), pools.end());
+        pools.clear();
+    }
+
+    if (!retired.pools.empty()) {
+        _retiredFrames.push_back(std::move(retired));
+    }
+
+    // Drop the now empty thread states, so threads that stopped recording
+    // (e.g. short lived worker threads) do not accumulate. Taking a new id
+    // invalidates the thread local caches; threads that allocate again
+    // register once more.
+    if (!_threadStates.empty()) {
+        _threadStates.clear();
+        _id = _nextId++;
+    }
+}
+
+BgiVulkanDescriptorAllocator::_ThreadState*
+BgiVulkanDescriptorAllocator::_GetThreadState()
+{
+    // Only lock the first time a thread allocates from this allocator.
+    thread_local uint64_t tlsId = 0;
+    thread_local _ThreadState* tlsState = nullptr;
+
+    if (tlsId != _id) {
+        std::lock_guard<std::mutex> lock(_transientMutex);
+        std::unique_ptr<_ThreadState>& state =
+            _threadStates[std::this_thread::get_id()];
+        if (!state) {
+            state = std::make_unique<_ThreadState>();
+        }
+        tlsId = _id;
+        tlsState = state.get();
+    }
+
+    return tlsState;
+}
+
+bool
+BgiVulkanDescriptorAllocator::_FitsInPage(
+    VkDescriptorPoolSizeVector const& poolSizes) const
+{
+    for (VkDescriptorPoolSize const& p : poolSizes) {
+        if (p.descriptorCount == 0) {
+            continue;
+        }
+        if (_GetDescriptorCount(poolSizes, p.type) >
+                _GetDescriptorCount(_pagePoolSizes, p.type)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+VkDescriptorPool
+BgiVulkanDescriptorAllocator::_CreatePool(
+    VkDescriptorPoolSizeVector const& poolSizes,
+    uint32_t maxSets,
+    VkDescriptorPoolCreateFlags flags,
+    const char* debugName)
+{
+    VkDescriptorPoolCreateInfo poolInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.flags = flags;
+    poolInfo.maxSets = maxSets;
+    poolInfo.poolSizeCount = (uint32_t) poolSizes.size();
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool = nullptr;
+    UTILS_VERIFY(
+        vkCreateDescriptorPool(
+            _device->GetVulkanDevice(),
+            &poolInfo,
+            BgiVulkanAllocator(),
+            &pool) == VK_SUCCESS
+    );
+
+    // Debug label
+    BgiVulkanSetDebugName(
+        _device,
+        (uint64_t)pool,
+        VK_OBJECT_TYPE_DESCRIPTOR_POOL,
+        debugName);
+
+    _device->GetMemoryTracker()->AddResource(
+        BgiMemoryResourceKindDescriptorPool, 0);
+
+    return pool;
+}
+
+void
+BgiVulkanDescriptorAllocator::_DestroyPool(VkDescriptorPool pool)
+{
+    _device->GetMemoryTracker()->RemoveResource(
+        BgiMemoryResourceKindDescriptorPool, 0);
+
+    vkDestroyDescriptorPool(
+        _device->GetVulkanDevice(),
+        pool,
+        BgiVulkanAllocator());
+}
+
+VkDescriptorSet
+BgiVulkanDescriptorAllocator::_AllocateSet(
+    VkDescriptorPool pool,
+    VkDescriptorSetLayout layout)
+{
+    VkDescriptorSetAllocateInfo allocateInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocateInfo.descriptorPool = pool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &layout;
+
+    // A full (or fragmented) pool reports VK_ERROR_OUT_OF_POOL_MEMORY or
+    // VK_ERROR_FRAGMENTED_POOL. The caller moves on to another page.
+    VkDescriptorSet set = nullptr;
+    if (vkAllocateDescriptorSets(
+            _device->GetVulkanDevice(),
+            &allocateInfo,
+            &set) != VK_SUCCESS) {
+        return nullptr;
+    }
+    return set;
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
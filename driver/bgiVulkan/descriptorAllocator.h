@@ -0,0 +1,152 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkanDevice;
+
+using VkDescriptorPoolSizeVector = std::vector<VkDescriptorPoolSize>;
+
+/// \struct BgiVulkanDescriptorAllocation
+///
+/// A descriptor set handed out by BgiVulkanDescriptorAllocator and the pool
+/// it was allocated from.
+///
+struct BgiVulkanDescriptorAllocation
+{
+    VkDescriptorSet set = nullptr;
+    VkDescriptorPool pool = nullptr;
+
+    /// The set lives in a frame page and is reclaimed when the frame retires.
+    bool transient = false;
+
+    /// The set did not fit in a page and owns its own pool.
+    bool dedicated = false;
+};
+
+/// \class BgiVulkanDescriptorAllocator
+///
+/// Allocates descriptor sets from pages of shared descriptor pools.
+///
+/// Transient sets come from per-thread pages that are never freed
+/// individually. At the end of each frame the pages used during that frame
+/// are retired together with the in-flight bits of the command queue. Once
+/// none of those command buffers are in-flight any more, the pages are reset
+/// wholesale with vkResetDescriptorPool and recycled. Allocating a transient
+/// set is a single vkAllocateDescriptorSets call on a pool owned by the
+/// calling thread.
+///
+/// Long-lived sets come from shared pages created with
+/// VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT and are returned to
+/// their page with Free.
+///
+/// Sets that need more descriptors of a type than a page holds get a
+/// dedicated pool.
+///
+class BgiVulkanDescriptorAllocator final
+{
+public:
+    BGIVULKAN_API
+    BgiVulkanDescriptorAllocator(BgiVulkanDevice* device);
+
+    BGIVULKAN_API
+    ~BgiVulkanDescriptorAllocator();
+
+    /// Allocates a descriptor set for 'layout'. 'poolSizes' is the number of
+    /// descriptors of each type the layout needs.
+    /// Transient sets are only valid until the end of the current frame.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    BgiVulkanDescriptorAllocation Allocate(
+        VkDescriptorSetLayout layout,
+        VkDescriptorPoolSizeVector const& poolSizes,
+        bool transient);
+
+    /// Returns a long-lived or dedicated set to the allocator.
+    /// Transient sets are reclaimed by EndFrame and ignored here.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void Free(BgiVulkanDescriptorAllocation const& allocation);
+
+    /// Retires the transient pages used during the frame and recycles the
+    /// pages of previous frames that are no longer used by the GPU.
+    /// 'queueInflightBits' are the in-flight bits of the command queue.
+    /// Thread safety: No. Must be called when no threads are recording.
+    BGIVULKAN_API
+    void EndFrame(uint64_t queueInflightBits);
+
+private:
+    BgiVulkanDescriptorAllocator() = delete;
+    BgiVulkanDescriptorAllocator & operator=(
+        const BgiVulkanDescriptorAllocator&) = delete;
+    BgiVulkanDescriptorAllocator(
+        const BgiVulkanDescriptorAllocator&) = delete;
+
+    // The transient pages a thread allocated from during the current frame.
+    // The last page is the one currently allocated from. Thread states are
+    // dropped at the end of each frame.
+    struct _ThreadState
+    {
+        std::vector<VkDescriptorPool> pools;
+    };
+
+    // The transient pages of a retired frame and the in-flight bits of the
+    // command queue when the frame was retired.
+    struct _RetiredFrame
+    {
+        uint64_t inflightBits;
+        std::vector<VkDescriptorPool> pools;
+    };
+
+    // Returns the transient state of the calling thread.
+    _ThreadState* _GetThreadState();
+
+    // Returns true if 'poolSizes' fits in an empty page.
+    bool _FitsInPage(VkDescriptorPoolSizeVector const& poolSizes) const;
+
+    // Creates a descriptor pool.
+    VkDescriptorPool _CreatePool(
+        VkDescriptorPoolSizeVector const& poolSizes,
+        uint32_t maxSets,
+        VkDescriptorPoolCreateFlags flags,
+        const char* debugName);
+
+    // Destroys a descriptor pool created by _CreatePool.
+    void _DestroyPool(VkDescriptorPool pool);
+
+    // Allocates a set from pool. Returns nullptr if the pool is full.
+    VkDescriptorSet _AllocateSet(
+        VkDescriptorPool pool,
+        VkDescriptorSetLayout layout);
+
+    BgiVulkanDevice* _device;
+    uint64_t _id;
+    VkDescriptorPoolSizeVector _pagePoolSizes;
+
+    // Transient pages
+    std::mutex _transientMutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<_ThreadState>>
+        _threadStates;
+    std::vector<_RetiredFrame> _retiredFrames;
+    std::vector<VkDescriptorPool> _freeTransientPools;
+
+    // Long-lived pages
+    std::mutex _persistentMutex;
+    std::vector<VkDescriptorPool> _persistentPools;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,402 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/descriptorBuffer.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/device.h"
+#include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/memoryTracker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+namespace {
+    // Size of the descriptor buffer and the part of it used as the ring for
+    // transient sets. The device's descriptor buffer limits may lower these.
+    static const VkDeviceSize _bufferSize = 32 * 1024 * 1024;
+    static const VkDeviceSize _ringSize = 8 * 1024 * 1024;
+
+    VkDeviceSize
+    _AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+BgiVulkanDescriptorBuffer::BgiVulkanDescriptorBuffer(BgiVulkanDevice* device)
+    : _device(device)
+    , _vkBuffer(nullptr)
+    , _vmaAllocation(nullptr)
+    , _mappedAddress(nullptr)
+    , _deviceAddress(0)
+    , _alignment(1)
+    , _ringBegin(0)
+    , _ringEnd(0)
+    , _ringHead(0)
+    , _ringUsedBytes(0)
+    , _frameUsedBytes(0)
+{
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT const& props =
+        device->GetDeviceCapabilities().vkDescriptorBufferProperties;
+
+    _alignment = std::max<VkDeviceSize>(
+        props.descriptorBufferOffsetAlignment, 1);
+
+    // Samplers and resources share the buffer, so it must stay addressable
+    // through both kinds of bindings.
+    const VkDeviceSize size = std::min({
+        _bufferSize,
+        props.maxResourceDescriptorBufferRange,
+        props.maxSamplerDescriptorBufferRange,
+        props.resourceDescriptorBufferAddressSpaceSize,
+        props.samplerDescriptorBufferAddressSpaceSize}) /
+        _alignment * _alignment;
+
+    VkBufferCreateInfo bi = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bi.size = size;
+    bi.usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+               VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+               VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // gfx queue only
+
+    // Descriptors are written by the CPU and read by the GPU every draw.
+    // Prefer memory that is both (e.g. resizable BAR).
+    VmaAllocationCreateInfo ai = {};
+    ai.requiredFlags =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | // CPU access (mem map)
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT; // Dont have to manually flush
+    ai.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    VmaAllocator vma = device->GetVulkanMemoryAllocator();
+    UTILS_VERIFY(
+        vmaCreateBuffer(vma, &bi, &ai, &_vkBuffer, &_vmaAllocation, 0) ==
+            VK_SUCCESS
+    );
+
+    BgiVulkanMemoryTracker* tracker = device->GetMemoryTracker();
+    tracker->AddResource(
+        BgiMemoryResourceKindDescriptorPool,
+        tracker->GetAllocationByteSize(_vmaAllocation));
+
+    BgiVulkanSetDebugName(
+        device,
+        (uint64_t)_vkBuffer,
+        VK_OBJECT_TYPE_BUFFER,
+        "Buffer Descriptors");
+
+    void* mapped = nullptr;
+    UTILS_VERIFY(vmaMapMemory(vma, _vmaAllocation, &mapped) == VK_SUCCESS);
+    _mappedAddress = static_cast<uint8_t*>(mapped);
+
+    VkBufferDeviceAddressInfo addressInfo =
+        {VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+    addressInfo.buffer = _vkBuffer;
+    _deviceAddress =
+        vkGetBufferDeviceAddress(device->GetVulkanDevice(), &addressInfo);
+
+    // The ring sits at the start of the buffer, the long-lived ranges after.
+    _ringBegin = 0;
+    _ringEnd = _AlignUp(std::min(_ringSize, size / 4), _alignment);
+    _ringHead = _ringBegin;
+    _freeRanges.emplace(_ringEnd, size - _ringEnd);
+}
+
+BgiVulkanDescriptorBuffer::~BgiVulkanDescriptorBuffer()
+{
+    VmaAllocator vma = _device->GetVulkanMemoryAllocator();
+
+    if (_mappedAddress) {
+        vmaUnmapMemory(vma, _vmaAllocation);
+        _mappedAddress = nullptr;
+    }
+
+    if (_vkBuffer) {
+        BgiVulkanMemoryTracker* tracker = _device->GetMemoryTracker();
+        tracker->RemoveResource(
+            BgiMemoryResourceKindDescriptorPool,
+            tracker->GetAllocationByteSize(_vmaAllocation));
+        vmaDestroyBuffer(vma, _vkBuffer, _vmaAllocation);
+    }
+}
+
+VkDeviceSize
+BgiVulkanDescriptorBuffer::GetLayoutSize(VkDescriptorSetLayout layout) const
+{
+    VkDeviceSize size = 0;
+    _device->vkGetDescriptorSetLayoutSizeEXT(
+        _device->GetVulkanDevice(), layout, &size);
+    return size;
+}
+
+VkDeviceSize
+BgiVulkanDescriptorBuffer::GetBindingOffset(
+    VkDescriptorSetLayout layout,
+    uint32_t binding) const
+{
+    VkDeviceSize offset = 0;
+    _device->vkGetDescriptorSetLayoutBindingOffsetEXT(
+        _device->GetVulkanDevice(), layout, binding, &offset);
+    return offset;
+}
+
+size_t
+BgiVulkanDescriptorBuffer::GetDescriptorSize(VkDescriptorType type) const
+{
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT const& props =
+        _device->GetDeviceCapabilities().vkDescriptorBufferProperties;
+
+    switch (type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+        return props.samplerDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        return props.combinedImageSamplerDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        return props.sampledImageDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        return props.storageImageDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        return props.uniformBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        return props.storageBufferDescriptorSize;
+    default:
+        UTILS_CODING_ERROR("Unsupported descriptor buffer type %d", type);
+        return 0;
+    }
+}
+
+/* Multi threaded */
+BgiVulkanDescriptorBufferAllocation
+BgiVulkanDescriptorBuffer::Allocate(VkDeviceSize size, bool transient)
+{
+    BgiVulkanDescriptorBufferAllocation allocation;
+    size = _AlignUp(std::max<VkDeviceSize>(size, 1), _alignment);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (transient) {
+        // Wrap around when the range does not fit before the end of the
+        // ring. The skipped bytes count towards this frame.
+        VkDeviceSize head = _ringHead;
+        VkDeviceSize needed = size;
+        if (head + size > _ringEnd) {
+            needed += _ringEnd - head;
+            head = _ringBegin;
+        }
+
+        if (_ringUsedBytes + needed <= _ringEnd - _ringBegin) {
+            _ringHead = head + size;
+            _ringUsedBytes += needed;
+            _frameUsedBytes += needed;
+
+            allocation.offset = head;
+            allocation.size = size;
+            allocation.transient = true;
+            return allocation;
+        }
+
+        // The ring is full, fall back to a long-lived range.
+    }
+
+    if (!UTILS_VERIFY(_AllocatePersistent(size, &allocation),
+            "Descriptor buffer is out of memory")) {
+        return BgiVulkanDescriptorBufferAllocation();
+    }
+
+    return allocation;
+}
+
+/* Multi threaded */
+void
+BgiVulkanDescriptorBuffer::Free(
+    BgiVulkanDescriptorBufferAllocation const& allocation)
+{
+    if (allocation.transient || allocation.size == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    VkDeviceSize offset = allocation.offset;
+    VkDeviceSize size = allocation.size;
+
+    // Merge with the free ranges on either side.
+    auto next = _freeRanges.lower_bound(offset);
+    if (next != _freeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        next = _freeRanges.erase(next);
+    }
+    if (next != _freeRanges.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+
+    _freeRanges.emplace(offset, size);
+}
+
+bool
+BgiVulkanDescriptorBuffer::_AllocatePersistent(
+    VkDeviceSize size,
+    BgiVulkanDescriptorBufferAllocation* allocation)
+{
+    for (auto it = _freeRanges.begin(); it != _freeRanges.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+
+        allocation->offset = it->first;
+        allocation->size = size;
+        allocation->transient = false;
+
+        const VkDeviceSize remaining = it->second - size;
+        const VkDeviceSize remainingOffset = it->first + size;
+        _freeRanges.erase(it);
+        if (remaining > 0) {
+            _freeRanges.emplace(remainingOffset, remaining);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/* Multi threaded */
+void
+BgiVulkanDescriptorBuffer::WriteDescriptor(
+    VkDeviceSize offset,
+    VkDescriptorType type,
+    BgiVulkanDescriptorInfo const& info)
+{
+    VkDescriptorGetInfoEXT getInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT};
+    getInfo.type = type;
+
+    VkDescriptorAddressInfoEXT addressInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT};
+
+    // Empty descriptors (invalid resources) have nothing to get a descriptor
+    // for. Ring slots are reused across frames and the sets are not
+    // partially bound, so the slot is zeroed instead of keeping the bytes of
+    // whatever descriptor was written there before. Shaders must still not
+    // access empty descriptors.
+    bool empty = false;
+
+    switch (type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+        empty = !info.image.sampler;
+        getInfo.data.pSampler = &info.image.sampler;
+        break;
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        empty = !info.image.imageView || !info.image.sampler;
+        getInfo.data.pCombinedImageSampler = &info.image;
+        break;
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        empty = !info.image.imageView;
+        getInfo.data.pSampledImage = &info.image;
+        break;
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        empty = !info.image.imageView;
+        getInfo.data.pStorageImage = &info.image;
+        break;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+        empty = !info.buffer.buffer;
+        if (empty) {
+            break;
+        }
+        VkBufferDeviceAddressInfo bufferAddressInfo =
+            {VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+        bufferAddressInfo.buffer = info.buffer.buffer;
+        addressInfo.address = vkGetBufferDeviceAddress(
+            _device->GetVulkanDevice(), &bufferAddressInfo) +
+            info.buffer.offset;
+        addressInfo.range = info.buffer.range;
+        addressInfo.format = VK_FORMAT_UNDEFINED;
+        if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+            getInfo.data.pUniformBuffer = &addressInfo;
+        } else {
+            getInfo.data.pStorageBuffer = &addressInfo;
+        }
+        break;
+    }
+    default:
+        UTILS_CODING_ERROR("Unsupported descriptor buffer type %d", type);
+        return;
+    }
+
+    if (empty) {
+        memset(_mappedAddress + offset, 0, GetDescriptorSize(type));
+        return;
+    }
+
+    _device->vkGetDescriptorEXT(
+        _device->GetVulkanDevice(),
+        &getInfo,
+        GetDescriptorSize(type),
+        _mappedAddress + offset);
+}
+
+/* Multi threaded */
+void
+BgiVulkanDescriptorBuffer::CopyDescriptors(
+    VkDeviceSize dstOffset,
+    VkDeviceSize srcOffset,
+    VkDeviceSize size)
+{
+    memcpy(_mappedAddress + dstOffset, _mappedAddress + srcOffset, size);
+}
+
+void
+BgiVulkanDescriptorBuffer::BindBuffer(VkCommandBuffer cb) const
+{
+    VkDescriptorBufferBindingInfoEXT bindingInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT};
+    bindingInfo.address = _deviceAddress;
+    bindingInfo.usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+                        VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+
+    _device->vkCmdBindDescriptorBuffersEXT(cb, 1, &bindingInfo);
+}
+
+void
+BgiVulkanDescriptorBuffer::SetOffset(
+    VkCommandBuffer cb,
+    VkPipelineBindPoint bindPoint,
+    VkPipelineLayout layout,
+    uint32_t set,
+    VkDeviceSize offset) const
+{
+    const uint32_t bufferIndex = 0;
+    _device->vkCmdSetDescriptorBufferOffsetsEXT(
+        cb, bindPoint, layout, set, 1, &bufferIndex, &offset);
+}
+
+/* Single threaded */
+void
+BgiVulkanDescriptorBuffer::EndFrame(uint64_t queueInflightBits)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Frames retire in order, so the ring's tail advances past each frame
+    // whose command buffers all completed.
+    while (!_retiredFrames.empty() &&
+           (_retiredFrames.front().inflightBits & queueInflightBits) == 0) {
+        _ringUsedBytes -= _retiredFrames.front().usedBytes;
+        _retiredFrames.pop_front();
+    }
+
+    if (_frameUsedBytes > 0) {
+        _retiredFrames.push_back({queueInflightBits, _frameUsedBytes});
+        _frameUsedBytes = 0;
+    }
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/layoutCache.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+#include <deque>
+#include <map>
+#include <mutex>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkanDevice;
+
+/// \struct BgiVulkanDescriptorBufferAllocation
+///
+/// A range of the descriptor buffer handed out by BgiVulkanDescriptorBuffer.
+///
+struct BgiVulkanDescriptorBufferAllocation
+{
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+
+    /// The range lives in the frame ring and is reclaimed when the frame
+    /// retires.
+    bool transient = false;
+};
+
+/// \class BgiVulkanDescriptorBuffer
+///
+/// Descriptor memory for devices that support VK_EXT_descriptor_buffer.
+///
+/// A single persistently mapped buffer holds the descriptors of all resource
+/// bindings and of the bindless heap. Descriptors are written with
+/// vkGetDescriptorEXT straight into the mapped memory and descriptor sets are
+/// bound by setting their offset in the buffer, so there are no pools or
+/// descriptor set objects to manage.
+///
+/// The buffer is split in two parts:
+/// <ul>
+/// <li>A ring for transient sets. At the end of each frame the bytes used
+///   during that frame are retired together with the in-flight bits of the
+///   command queue and reclaimed once those command buffers completed.</li>
+/// <li>A first-fit free list for long-lived sets, which are returned with
+///   Free when their owner is destroyed by the garbage collector.</li>
+/// </ul>
+///
+/// The buffer is bound to every command buffer when recording begins.
+///
+class BgiVulkanDescriptorBuffer final
+{
+public:
+    BGIVULKAN_API
+    BgiVulkanDescriptorBuffer(BgiVulkanDevice* device);
+
+    BGIVULKAN_API
+    ~BgiVulkanDescriptorBuffer();
+
+    /// Returns the number of bytes a set with 'layout' needs in the buffer.
+    BGIVULKAN_API
+    VkDeviceSize GetLayoutSize(VkDescriptorSetLayout layout) const;
+
+    /// Returns the offset of 'binding' within a set with 'layout'.
+    BGIVULKAN_API
+    VkDeviceSize GetBindingOffset(
+        VkDescriptorSetLayout layout,
+        uint32_t binding) const;
+
+    /// Returns the size of one descriptor of 'type'. Elements of a
+    /// descriptor array are this many bytes apart.
+    BGIVULKAN_API
+    size_t GetDescriptorSize(VkDescriptorType type) const;
+
+    /// Allocates 'size' bytes for a descriptor set.
+    /// Transient ranges are only valid until the end of the current frame.
+    /// When the ring is full a long-lived range is returned instead, which
+    /// Free then returns to the free list.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    BgiVulkanDescriptorBufferAllocation Allocate(
+        VkDeviceSize size,
+        bool transient);
+
+    /// Returns a long-lived range to the buffer.
+    /// Transient ranges are reclaimed by EndFrame and ignored here.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void Free(BgiVulkanDescriptorBufferAllocation const& allocation);
+
+    /// Writes one descriptor at 'offset' in the buffer. 'info' holds an
+    /// image info for image and sampler types and a buffer info with an
+    /// explicit range for buffer types. The descriptor of an empty resource
+    /// is zeroed.
+    /// Thread safety: Yes, as long as threads write to different ranges.
+    BGIVULKAN_API
+    void WriteDescriptor(
+        VkDeviceSize offset,
+        VkDescriptorType type,
+        BgiVulkanDescriptorInfo const& info);
+
+    /// Copies 'size' bytes of descriptors from 'srcOffset' to 'dstOffset'.
+    /// Thread safety: Yes, as long as threads write to different ranges.
+    BGIVULKAN_API
+    void CopyDescriptors(
+        VkDeviceSize dstOffset,
+        VkDeviceSize srcOffset,
+        VkDeviceSize size);
+
+    /// Binds the buffer to 'cb'. Called when recording begins.
+    BGIVULKAN_API
+    void BindBuffer(VkCommandBuffer cb) const;
+
+    /// Binds the set at 'offset' in the buffer to 'set' of 'layout'.
+    BGIVULKAN_API
+    void SetOffset(
+        VkCommandBuffer cb,
+        VkPipelineBindPoint bindPoint,
+        VkPipelineLayout layout,
+        uint32_t set,
+        VkDeviceSize offset) const;
+
+    /// Retires the transient ranges used during the frame and reclaims the
+    /// ranges of previous frames that are no longer used by the GPU.
+    /// 'queueInflightBits' are the in-flight bits of the command queue.
+    /// Thread safety: No. Must be called when no threads are recording.
+    BGIVULKAN_API
+    void EndFrame(uint64_t queueInflightBits);
+
+private:
+    BgiVulkanDescriptorBuffer() = delete;
+    BgiVulkanDescriptorBuffer & operator=(
+        const BgiVulkanDescriptorBuffer&) = delete;
+    BgiVulkanDescriptorBuffer(const BgiVulkanDescriptorBuffer&) = delete;
+
+    // The ring bytes used during a retired frame and the in-flight bits of
+    // the command queue when the frame was retired.
+    struct _RetiredFrame
+    {
+        uint64_t inflightBits;
+        VkDeviceSize usedBytes;
+    };
+
+    // Allocates from the free list. Must be called with _mutex held.
+    bool _AllocatePersistent(
+        VkDeviceSize size,
+        BgiVulkanDescriptorBufferAllocation* allocation);
+
+    BgiVulkanDevice* _device;
+    VkBuffer _vkBuffer;
+    VmaAllocation _vmaAllocation;
+    uint8_t* _mappedAddress;
+    VkDeviceAddress _deviceAddress;
+    VkDeviceSize _alignment;
+
+    std::mutex _mutex;
+
+    // Long-lived ranges: offset to size of each free range.
+    std::map<VkDeviceSize, VkDeviceSize> _freeRanges;
+
+    // Transient ring
+    VkDeviceSize _ringBegin;
+    VkDeviceSize _ringEnd;
+    VkDeviceSize _ringHead;
+    VkDeviceSize _ringUsedBytes;
+    VkDeviceSize _frameUsedBytes;
+    std::deque<_RetiredFrame> _retiredFrames;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -1,16 +1,26 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/device.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
 #include "driver/bgiVulkan/capabilities.h"
 #include "driver/bgiVulkan/commandQueue.h"
+#include "driver/bgiVulkan/descriptorAllocator.h"
+#include "driver/bgiVulkan/descriptorBuffer.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/gpuProfiler.h"
 #include "driver/bgiVulkan/bgi.h"
 #include "driver/bgiVulkan/instance.h"
+#include "driver/bgiVulkan/layoutCache.h"
+#include "driver/bgiVulkan/memoryTracker.h"
 #include "driver/bgiVulkan/pipelineCache.h"
+#include "driver/bgiVulkan/shaderCache.h"
+#include "driver/slangDriver/slangDriver.h"
 
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
 
+#include <cstdlib>
+
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
@@ -65,6 +75,14 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
     , _vmaAllocator(nullptr)
     , _commandQueue(nullptr)
     , _capabilities(nullptr)
+    , _pipelineCache(nullptr)
+    , _layoutCache(nullptr)
+    , _descriptorAllocator(nullptr)
+    , _descriptorBuffer(nullptr)
+    , _bindlessHeap(nullptr)
+    , _shaderCache(nullptr)
+    , _gpuProfiler(nullptr)
+    , _memoryTracker(nullptr)
 {
     //
     // Determine physical device
@@ -89,8 +107,10 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
 
         if (familyIndex == VK_QUEUE_FAMILY_IGNORED) continue;
 
-        // Assume we always want a presentation capable device for now.
-        if (!_SupportsPresentation(physicalDevices[i], familyIndex)) {
+        // Assume we always want a presentation capable device for now,
+        // unless nothing will be presented.
+        if (!instance->IsHeadless() &&
+            !_SupportsPresentation(physicalDevices[i], familyIndex)) {
             continue;
         }
 
@@ -149,9 +169,10 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
     queueInfo.queueCount = 1;
     queueInfo.pQueuePriorities = queuePriorities;
 
-    std::vector<const char*> extensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    std::vector<const char*> extensions;
+    if (!instance->IsHeadless()) {
+        extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
     // Allow certain buffers/images to have dedicated memory allocations to
     // improve performance on some GPUs.
@@ -216,6 +237,32 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
         extensions.push_back(VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_EXTENSION_NAME);
     }
 
+    // Push descriptors for small per-draw resource sets.
+    if (IsSupportedExtension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+        extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    }
+
+    // Indirect draws with a GPU provided draw count (e.g. after culling).
+    if (_capabilities->supportsDrawIndirectCount) {
+        extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    // 8 bit index buffers.
+    if (_capabilities->supportsIndexTypeUint8) {
+        extensions.push_back(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+    }
+
+    // Draws predicated on a value in a buffer.
+    if (_capabilities->supportsConditionalRendering) {
+        extensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+    }
+
+    // Descriptor buffers replace descriptor pools and sets for all
+    // resource bindings when available.
+    if (_capabilities->supportsDescriptorBuffer) {
+        extensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+    }
+
     // This extension is needed to allow the viewport to be flipped in Y so that
     // shaders and vertex data can remain the same between opengl and vulkan.
     extensions.push_back(VK_KHR_MAINTENANCE1_EXTENSION_NAME);
@@ -228,6 +275,16 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
     vulkan11Features.shaderDrawParameters =
         _capabilities->vkVulkan11Features.shaderDrawParameters;
 
+    // Buffer device addresses are needed by descriptor buffers and to pass
+    // buffer pointers to shaders.
+    VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures =
+        {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES};
+    if (_capabilities->supportsBufferDeviceAddress) {
+        bufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;
+        bufferDeviceAddressFeatures.pNext = vulkan11Features.pNext;
+        vulkan11Features.pNext = &bufferDeviceAddressFeatures;
+    }
+
     /*VkPhysicalDeviceVulkan12Features vulkan12Features =
         {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
     vulkan12Features.pNext = _capabilities->vkVulkan12Features.pNext;
@@ -265,6 +322,11 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
     // Needed to write to storage buffers from fragment shader (eg. OIT).
     features2.features.fragmentStoresAndAtomics =
         _capabilities->vkDeviceFeatures.fragmentStoresAndAtomics;
+    // Needed for BgiQueryPool.
+    features2.features.occlusionQueryPrecise =
+        _capabilities->vkDeviceFeatures.occlusionQueryPrecise;
+    features2.features.pipelineStatisticsQuery =
+        _capabilities->vkDeviceFeatures.pipelineStatisticsQuery;
 
     #if !defined(VK_USE_PLATFORM_MACOS_MVK)
         // Needed for buffer address feature
@@ -299,6 +361,38 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
     vkCreateRenderPass2KHR = (PFN_vkCreateRenderPass2KHR)
     vkGetDeviceProcAddr(_vkDevice, "vkCreateRenderPass2KHR");
 
+    if (_capabilities->supportsPushDescriptors) {
+        vkCmdPushDescriptorSetWithTemplateKHR =
+            (PFN_vkCmdPushDescriptorSetWithTemplateKHR)
+        vkGetDeviceProcAddr(_vkDevice, "vkCmdPushDescriptorSetWithTemplateKHR");
+    }
+
+    if (_capabilities->supportsDescriptorBuffer) {
+        vkGetDescriptorSetLayoutSizeEXT =
+            (PFN_vkGetDescriptorSetLayoutSizeEXT)
+        vkGetDeviceProcAddr(_vkDevice, "vkGetDescriptorSetLayoutSizeEXT");
+        vkGetDescriptorSetLayoutBindingOffsetEXT =
+            (PFN_vkGetDescriptorSetLayoutBindingOffsetEXT)
+        vkGetDeviceProcAddr(_vkDevice,
+            "vkGetDescriptorSetLayoutBindingOffsetEXT");
+        vkGetDescriptorEXT = (PFN_vkGetDescriptorEXT)
+        vkGetDeviceProcAddr(_vkDevice, "vkGetDescriptorEXT");
+        vkCmdBindDescriptorBuffersEXT = (PFN_vkCmdBindDescriptorBuffersEXT)
+        vkGetDeviceProcAddr(_vkDevice, "vkCmdBindDescriptorBuffersEXT");
+        vkCmdSetDescriptorBufferOffsetsEXT =
+            (PFN_vkCmdSetDescriptorBufferOffsetsEXT)
+        vkGetDeviceProcAddr(_vkDevice, "vkCmdSetDescriptorBufferOffsetsEXT");
+    }
+
+    if (_capabilities->supportsConditionalRendering) {
+        vkCmdBeginConditionalRenderingEXT =
+            (PFN_vkCmdBeginConditionalRenderingEXT)
+        vkGetDeviceProcAddr(_vkDevice, "vkCmdBeginConditionalRenderingEXT");
+        vkCmdEndConditionalRenderingEXT =
+            (PFN_vkCmdEndConditionalRenderingEXT)
+        vkGetDeviceProcAddr(_vkDevice, "vkCmdEndConditionalRenderingEXT");
+    }
+
     //
     // Memory allocator
     //
@@ -315,10 +409,20 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
         allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
     }
 
+    if (_capabilities->supportsBufferDeviceAddress) {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+    }
+
     UTILS_VERIFY(
         vmaCreateAllocator(&allocatorInfo, &_vmaAllocator) == VK_SUCCESS
     );
 
+    //
+    // Memory tracker
+    //
+
+    _memoryTracker = new BgiVulkanMemoryTracker(this, supportsMemExtension);
+
     //
     // Command Queue
     //
@@ -330,6 +434,48 @@ BgiVulkanDevice::BgiVulkanDevice(BgiVulkanInstance* instance)
     //
 
     _pipelineCache = new BgiVulkanPipelineCache(this);
+
+    //
+    // Descriptor set and pipeline layout cache
+    //
+
+    _layoutCache = new BgiVulkanLayoutCache(this);
+
+    //
+    // Descriptor set allocator
+    //
+
+    _descriptorAllocator = new BgiVulkanDescriptorAllocator(this);
+
+    //
+    // Descriptor buffer
+    //
+
+    if (_capabilities->supportsDescriptorBuffer) {
+        _descriptorBuffer = new BgiVulkanDescriptorBuffer(this);
+    }
+
+    //
+    // Bindless descriptor heap
+    //
+
+    if (_capabilities->supportsBindlessHeap) {
+        _bindlessHeap = new BgiVulkanBindlessHeap(this);
+    }
+
+    //
+    // Shader cache
+    //
+
+    _shaderCache = new BgiVulkanShaderCache();
+
+    //
+    // GPU timestamp profiler
+    //
+
+    if (_capabilities->supportsTimeStamps) {
+        _gpuProfiler = new BgiVulkanGpuProfiler(this);
+    }
 }
 
 BgiVulkanDevice::~BgiVulkanDevice()
@@ -337,9 +483,17 @@ BgiVulkanDevice::~BgiVulkanDevice()
     // Make sure device is idle before destroying objects.
     UTILS_VERIFY(vkDeviceWaitIdle(_vkDevice) == VK_SUCCESS);
 
+    _slangDriver.reset();
+    delete _gpuProfiler;
+    delete _shaderCache;
+    delete _bindlessHeap;
+    delete _descriptorBuffer;
+    delete _descriptorAllocator;
+    delete _layoutCache;
     delete _pipelineCache;
     delete _commandQueue;
     delete _capabilities;
+    delete _memoryTracker;
     vmaDestroyAllocator(_vmaAllocator);
     vkDestroyDevice(_vkDevice, BgiVulkanAllocator());
 }
@@ -386,6 +540,82 @@ BgiVulkanDevice::GetPipelineCache() const
     return _pipelineCache;
 }
 
+BgiVulkanDescriptorAllocator*
+BgiVulkanDevice::GetDescriptorAllocator() const
+{
+    return _descriptorAllocator;
+}
+
+BgiVulkanDescriptorBuffer*
+BgiVulkanDevice::GetDescriptorBuffer() const
+{
+    return _descriptorBuffer;
+}
+
+BgiVulkanBindlessHeap*
+BgiVulkanDevice::GetBindlessHeap() const
+{
+    return _bindlessHeap;
+}
+
+BgiVulkanLayoutCache*
+BgiVulkanDevice::GetLayoutCache() const
+{
+    return _layoutCache;
+}
+
+BgiVulkanShaderCache*
+BgiVulkanDevice::GetShaderCache() const
+{
+    return _shaderCache;
+}
+
+BgiVulkanGpuProfiler*
+BgiVulkanDevice::GetGpuProfiler() const
+{
+    return _gpuProfiler;
+}
+
+BgiVulkanMemoryTracker*
+BgiVulkanDevice::GetMemoryTracker() const
+{
+    return _memoryTracker;
+}
+
+SlangDriver*
+BgiVulkanDevice::GetSlangDriver()
+{
+    std::call_once(_slangDriverOnce, [this]() {
+        #if defined(ARCH_OS_WINDOWS)
+            const char separator = ';';
+        #else
+            const char separator = ':';
+        #endif
+
+        std::vector<std::string> searchPaths;
+        if (const char* paths = std::getenv("GUNGNIR_SLANG_SEARCH_PATH")) {
+            std::string path;
+            for (const char* c = paths; ; c++) {
+                if (*c == separator || *c == '\0') {
+                    if (!path.empty()) {
+                        searchPaths.push_back(path);
+                    }
+                    path.clear();
+                    if (*c == '\0') {
+                        break;
+                    }
+                } else {
+                    path += *c;
+                }
+            }
+        }
+
+        _slangDriver = std::make_unique<SlangDriver>(searchPaths);
+    });
+
+    return _slangDriver.get();
+}
+
 void
 BgiVulkanDevice::WaitForIdle()
 {
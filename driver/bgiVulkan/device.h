@@ -5,16 +5,26 @@
 #include "driver/bgiVulkan/api.h"
 #include "driver/bgiVulkan/vulkanBridge.h"
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
 
+class BgiVulkanBindlessHeap;
 class BgiVulkanCapabilities;
 class BgiVulkanCommandQueue;
+class BgiVulkanDescriptorAllocator;
+class BgiVulkanDescriptorBuffer;
+class BgiVulkanGpuProfiler;
 class BgiVulkanInstance;
+class BgiVulkanLayoutCache;
+class BgiVulkanMemoryTracker;
 class BgiVulkanPipelineCache;
+class BgiVulkanShaderCache;
+class SlangDriver;
 
 /// \class HgiVulkanDevice
 ///
@@ -57,6 +67,44 @@ public:
     BGIVULKAN_API
     BgiVulkanPipelineCache* GetPipelineCache() const;
 
+    /// Returns the allocator resource bindings get their descriptor sets from.
+    BGIVULKAN_API
+    BgiVulkanDescriptorAllocator* GetDescriptorAllocator() const;
+
+    /// Returns the descriptor buffer, or nullptr if the device does not
+    /// support VK_EXT_descriptor_buffer and descriptor sets are used instead.
+    BGIVULKAN_API
+    BgiVulkanDescriptorBuffer* GetDescriptorBuffer() const;
+
+    /// Returns the global bindless descriptor heap, or nullptr if the device
+    /// does not support the required descriptor indexing features.
+    BGIVULKAN_API
+    BgiVulkanBindlessHeap* GetBindlessHeap() const;
+
+    /// Returns the cache of descriptor set layouts and pipeline layouts.
+    BGIVULKAN_API
+    BgiVulkanLayoutCache* GetLayoutCache() const;
+
+    /// Returns the on-disk spirv cache.
+    BGIVULKAN_API
+    BgiVulkanShaderCache* GetShaderCache() const;
+
+    /// Returns the GPU timestamp profiler, or nullptr if the graphics queue
+    /// does not support timestamps.
+    BGIVULKAN_API
+    BgiVulkanGpuProfiler* GetGpuProfiler() const;
+
+    /// Returns the tracker that accounts the memory of the device.
+    BGIVULKAN_API
+    BgiVulkanMemoryTracker* GetMemoryTracker() const;
+
+    /// Returns the slang driver used to compile slang shader functions.
+    /// The slang session is created on first use. Modules are looked up in
+    /// the paths listed in the GUNGNIR_SLANG_SEARCH_PATH environment variable.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    SlangDriver* GetSlangDriver();
+
     /// Wait for all queued up commands to have been processed on device.
     /// This should ideally never be used as it creates very big stalls, but
     /// is useful for unit testing.
@@ -69,6 +117,18 @@ public:
 
     /// Device extension function pointers
     PFN_vkCreateRenderPass2KHR vkCreateRenderPass2KHR = 0;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR
+        vkCmdPushDescriptorSetWithTemplateKHR = 0;
+    PFN_vkGetDescriptorSetLayoutSizeEXT vkGetDescriptorSetLayoutSizeEXT = 0;
+    PFN_vkGetDescriptorSetLayoutBindingOffsetEXT
+        vkGetDescriptorSetLayoutBindingOffsetEXT = 0;
+    PFN_vkGetDescriptorEXT vkGetDescriptorEXT = 0;
+    PFN_vkCmdBindDescriptorBuffersEXT vkCmdBindDescriptorBuffersEXT = 0;
+    PFN_vkCmdSetDescriptorBufferOffsetsEXT
+        vkCmdSetDescriptorBufferOffsetsEXT = 0;
+    PFN_vkCmdBeginConditionalRenderingEXT
+        vkCmdBeginConditionalRenderingEXT = 0;
+    PFN_vkCmdEndConditionalRenderingEXT vkCmdEndConditionalRenderingEXT = 0;
     PFN_vkCmdBeginDebugUtilsLabelEXT vkCmdBeginDebugUtilsLabelEXT = 0;
     PFN_vkCmdEndDebugUtilsLabelEXT vkCmdEndDebugUtilsLabelEXT = 0;
     PFN_vkCmdInsertDebugUtilsLabelEXT vkCmdInsertDebugUtilsLabelEXT = 0;
@@ -90,6 +150,15 @@ private:
     BgiVulkanCommandQueue* _commandQueue;
     BgiVulkanCapabilities* _capabilities;
     BgiVulkanPipelineCache* _pipelineCache;
+    BgiVulkanLayoutCache* _layoutCache;
+    BgiVulkanDescriptorAllocator* _descriptorAllocator;
+    BgiVulkanDescriptorBuffer* _descriptorBuffer;
+    BgiVulkanBindlessHeap* _bindlessHeap;
+    BgiVulkanShaderCache* _shaderCache;
+    BgiVulkanGpuProfiler* _gpuProfiler;
+    BgiVulkanMemoryTracker* _memoryTracker;
+    std::unique_ptr<SlangDriver> _slangDriver;
+    std::once_flag _slangDriverOnce;
 };
 
 }
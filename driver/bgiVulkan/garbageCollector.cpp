@@ -1,5 +1,6 @@
 #include "common/arch/hints.h"
 #include "common/utils/diagnostic.h"
+#include "common/utils/trace.h"
 
 #include "driver/bgiVulkan/garbageCollector.h"
 #include "driver/bgiVulkan/buffer.h"
@@ -8,6 +9,7 @@
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/graphicsPipeline.h"
 #include "driver/bgiVulkan/bgi.h"
+#include "driver/bgiVulkan/queryPool.h"
 #include "driver/bgiVulkan/resourceBindings.h"
 #include "driver/bgiVulkan/sampler.h"
 #include "driver/bgiVulkan/shaderFunction.h"
@@ -34,6 +36,8 @@ std::vector<BgiVulkanGraphicsPipelineVector*>
     BgiVulkanGarbageCollector::_graphicsPipelineList;
 std::vector<BgiVulkanComputePipelineVector*> 
     BgiVulkanGarbageCollector::_computePipelineList;
+std::vector<BgiVulkanQueryPoolVector*> 
+    BgiVulkanGarbageCollector::_queryPoolList;
 
 template<class T>
 static void _EmptyTrash(
@@ -127,10 +131,19 @@ BgiVulkanGarbageCollector::GetComputePipelineList()
     return _GetThreadLocalStorageList(&_computePipelineList);
 }
 
+/* Multi threaded */
+BgiVulkanQueryPoolVector*
+BgiVulkanGarbageCollector::GetQueryPoolList()
+{
+    return _GetThreadLocalStorageList(&_queryPoolList);
+}
+
 /* Single threaded */
 void
 BgiVulkanGarbageCollector::PerformGarbageCollection(BgiVulkanDevice* device)
 {
+    UTILS_TRACE_FUNCTION();
+
     // Garbage Collection notes:
     //
     // When the client requests objects to be destroyed (Eg. Hgi::DestroyBuffer)
@@ -171,6 +184,7 @@ BgiVulkanGarbageCollector::PerformGarbageCollection(BgiVulkanDevice* device)
     _EmptyTrash(&_resourceBindingsList, vkDevice, queueBits);
     _EmptyTrash(&_graphicsPipelineList, vkDevice, queueBits);
     _EmptyTrash(&_computePipelineList, vkDevice, queueBits);
+    _EmptyTrash(&_queryPoolList, vkDevice, queueBits);
 
     _isDestroying = false;
 }
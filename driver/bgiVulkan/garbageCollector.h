@@ -31,6 +31,8 @@ using BgiVulkanGraphicsPipelineVector =
     std::vector<class BgiVulkanGraphicsPipeline*>;
 using BgiVulkanComputePipelineVector =
     std::vector<class BgiVulkanComputePipeline*>;
+using BgiVulkanQueryPoolVector =
+    std::vector<class BgiVulkanQueryPool*>;
 
 
 /// \class HgiVulkanGarbageCollector
@@ -64,6 +66,7 @@ public:
     BgiVulkanResourceBindingsVector* GetResourceBindingsList();
     BgiVulkanGraphicsPipelineVector* GetGraphicsPipelineList();
     BgiVulkanComputePipelineVector* GetComputePipelineList();
+    BgiVulkanQueryPoolVector* GetQueryPoolList();
 
 private:
     BgiVulkanGarbageCollector & operator =
@@ -90,6 +93,7 @@ private:
     static std::vector<BgiVulkanResourceBindingsVector*> _resourceBindingsList;
     static std::vector<BgiVulkanGraphicsPipelineVector*> _graphicsPipelineList;
     static std::vector<BgiVulkanComputePipelineVector*> _computePipelineList;
+    static std::vector<BgiVulkanQueryPoolVector*> _queryPoolList;
 
     bool _isDestroying;
 };
@@ -0,0 +1,335 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/gpuProfiler.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/commandBuffer.h"
+#include "driver/bgiVulkan/commandQueue.h"
+#include "driver/bgiVulkan/device.h"
+#include "driver/bgiVulkan/diagnostic.h"
+
+#include <algorithm>
+#include <functional>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+BgiVulkanGpuProfiler::BgiVulkanGpuProfiler(BgiVulkanDevice* device)
+    : _device(device)
+    , _timestampPeriodMs(0.0)
+    , _timestampMask(~uint64_t(0))
+    , _enabled(false)
+    , _recordingFrame(-1)
+    , _frameNumber(0)
+    , _hasTimings(false)
+{
+    BgiVulkanCapabilities const& caps = device->GetDeviceCapabilities();
+    _timestampPeriodMs =
+        double(caps.vkDeviceProperties.limits.timestampPeriod) * 1e-6;
+
+    // Timestamps only have timestampValidBits significant bits and wrap
+    // around past them.
+    uint32_t queueCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        device->GetVulkanPhysicalDevice(), &queueCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queues(queueCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        device->GetVulkanPhysicalDevice(), &queueCount, queues.data());
+
+    uint32_t const gfxQueueIndex = device->GetGfxQueueFamilyIndex();
+    if (UTILS_VERIFY(gfxQueueIndex < queues.size())) {
+        uint32_t const validBits = queues[gfxQueueIndex].timestampValidBits;
+        if (validBits > 0 && validBits < 64) {
+            _timestampMask = (uint64_t(1) << validBits) - 1;
+        }
+    }
+
+    VkQueryPoolCreateInfo poolInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = _MaxScopes * 2;
+
+    for (_Frame& frame : _frames) {
+        UTILS_VERIFY(
+            vkCreateQueryPool(
+                device->GetVulkanDevice(),
+                &poolInfo,
+                BgiVulkanAllocator(),
+                &frame.vkQueryPool) == VK_SUCCESS
+        );
+        frame.scopes.reserve(_MaxScopes);
+    }
+}
+
+BgiVulkanGpuProfiler::~BgiVulkanGpuProfiler()
+{
+    for (_Frame& frame : _frames) {
+        if (frame.vkQueryPool) {
+            vkDestroyQueryPool(
+                _device->GetVulkanDevice(),
+                frame.vkQueryPool,
+                BgiVulkanAllocator());
+        }
+    }
+}
+
+void
+BgiVulkanGpuProfiler::SetEnabled(bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool
+BgiVulkanGpuProfiler::IsEnabled() const
+{
+    return _enabled;
+}
+
+void
+BgiVulkanGpuProfiler::BeginFrame()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _recordingFrame = -1;
+    uint64_t const frameNumber = _frameNumber++;
+
+    if (!_enabled) {
+        return;
+    }
+
+    int const slot = int(frameNumber % _FrameCount);
+    _Frame& frame = _frames[slot];
+
+    // The GPU is more than _FrameCount frames behind. Skip this frame rather
+    // than resetting queries that may still be written.
+    if (frame.state == _FrameStatePending) {
+        return;
+    }
+
+    if (!frame.vkQueryPool) {
+        return;
+    }
+
+    // Queries must be reset before they are written. The resource command
+    // buffer is submitted ahead of the command buffers of the frame.
+    BgiVulkanCommandBuffer* cb =
+        _device->GetCommandQueue()->AcquireResourceCommandBuffer();
+    vkCmdResetQueryPool(
+        cb->GetVulkanCommandBuffer(),
+        frame.vkQueryPool,
+        0,
+        _MaxScopes * 2);
+
+    frame.state = _FrameStateRecording;
+    frame.frameNumber = frameNumber;
+    frame.inflightBits = 0;
+    frame.scopes.clear();
+    _recordingFrame = slot;
+}
+
+void
+BgiVulkanGpuProfiler::EndFrame(uint64_t queueInflightBits)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_recordingFrame >= 0) {
+        _Frame& frame = _frames[_recordingFrame];
+        frame.state = _FrameStatePending;
+        frame.inflightBits = queueInflightBits;
+        _recordingFrame = -1;
+    }
+
+    // Resolve in frame order, so the latest timings are the newest frame.
+    for (uint32_t i = 0; i < _FrameCount; i++) {
+        _Frame& frame = _frames[(_frameNumber + i) % _FrameCount];
+        if (frame.state != _FrameStatePending) {
+            continue;
+        }
+        if ((frame.inflightBits & queueInflightBits) != 0) {
+            continue;
+        }
+        _ResolveFrame(&frame);
+    }
+}
+
+void
+BgiVulkanGpuProfiler::PushScope(
+    BgiVulkanCommandBuffer* cb,
+    const char* label,
+    std::vector<uint32_t>* scopes)
+{
+    uint32_t scope = InvalidScope;
+
+    if (_enabled && cb) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_recordingFrame >= 0) {
+            _Frame& frame = _frames[_recordingFrame];
+            if (frame.scopes.size() < _MaxScopes) {
+                uint32_t const index = uint32_t(frame.scopes.size());
+                uint32_t const frameBegin = _recordingFrame * _MaxScopes;
+
+                // Only scopes of the same frame can be parents.
+                uint32_t parent = InvalidScope;
+                if (!scopes->empty() &&
+                    scopes->back() != InvalidScope &&
+                    scopes->back() / _MaxScopes == uint32_t(_recordingFrame)) {
+                    parent = scopes->back() - frameBegin;
+                }
+
+                frame.scopes.push_back({label ? label : "", parent});
+                vkCmdWriteTimestamp(
+                    cb->GetVulkanCommandBuffer(),
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                    frame.vkQueryPool,
+                    index * 2);
+                scope = frameBegin + index;
+            }
+        }
+    }
+
+    // Invalid scopes are pushed as well to keep the stack balanced.
+    scopes->push_back(scope);
+}
+
+void
+BgiVulkanGpuProfiler::PopScope(
+    BgiVulkanCommandBuffer* cb,
+    std::vector<uint32_t>* scopes)
+{
+    if (scopes->empty()) {
+        return;
+    }
+
+    uint32_t const scope = scopes->back();
+    scopes->pop_back();
+
+    if (scope == InvalidScope || !cb) {
+        return;
+    }
+
+    // The query pools are never recreated, so no lock is needed to write
+    // the end timestamp.
+    _Frame const& frame = _frames[scope / _MaxScopes];
+    vkCmdWriteTimestamp(
+        cb->GetVulkanCommandBuffer(),
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        frame.vkQueryPool,
+        (scope % _MaxScopes) * 2 + 1);
+}
+
+bool
+BgiVulkanGpuProfiler::GetFrameTimings(BgiGpuFrameTimings* timings) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_hasTimings || !timings) {
+        return false;
+    }
+
+    *timings = _timings;
+    return true;
+}
+
+void
+BgiVulkanGpuProfiler::_ResolveFrame(_Frame* frame)
+{
+    frame->state = _FrameStateIdle;
+
+    size_t const scopeCount = frame->scopes.size();
+    if (scopeCount == 0) {
+        return;
+    }
+
+    // Each query is read as its value followed by its availability, so
+    // scopes that were never ended or submitted can be skipped.
+    std::vector<uint64_t> results(scopeCount * 4);
+    VkResult const result = vkGetQueryPoolResults(
+        _device->GetVulkanDevice(),
+        frame->vkQueryPool,
+        0,
+        uint32_t(scopeCount * 2),
+        results.size() * sizeof(uint64_t),
+        results.data(),
+        2 * sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS && result != VK_NOT_READY) {
+        return;
+    }
+
+    std::vector<bool> available(scopeCount);
+    std::vector<uint64_t> begins(scopeCount);
+    std::vector<uint64_t> ends(scopeCount);
+    bool hasFrameBegin = false;
+    uint64_t frameBegin = 0;
+    uint64_t frameEnd = 0;
+
+    for (size_t i = 0; i < scopeCount; i++) {
+        available[i] = results[i * 4 + 1] != 0 && results[i * 4 + 3] != 0;
+        begins[i] = results[i * 4] & _timestampMask;
+        ends[i] = results[i * 4 + 2] & _timestampMask;
+        if (!available[i]) {
+            continue;
+        }
+        // Cmds recorded on different threads are not pushed in the order
+        // the GPU executes them.
+        if (!hasFrameBegin) {
+            frameBegin = begins[i];
+            frameEnd = ends[i];
+            hasFrameBegin = true;
+        } else {
+            frameBegin = std::min(frameBegin, begins[i]);
+            frameEnd = std::max(frameEnd, ends[i]);
+        }
+    }
+
+    if (!hasFrameBegin) {
+        return;
+    }
+
+    auto toMs = [this](uint64_t begin, uint64_t end) {
+        return double((end - begin) & _timestampMask) * _timestampPeriodMs;
+    };
+
+    // Scopes are pushed before their children, so parents always have a
+    // lower index. Children are collected per parent in push order.
+    std::vector<std::vector<uint32_t>> children(scopeCount);
+    std::vector<uint32_t> roots;
+    for (size_t i = 0; i < scopeCount; i++) {
+        uint32_t const parent = frame->scopes[i].parent;
+        if (parent == InvalidScope) {
+            roots.push_back(uint32_t(i));
+        } else {
+            children[parent].push_back(uint32_t(i));
+        }
+    }
+
+    // Builds the subtree of each available scope. Scopes whose timestamps
+    // are missing are left out together with their children.
+    std::function<void(std::vector<uint32_t> const&, BgiGpuTimingScopeVector*)>
+        buildScopes = [&](std::vector<uint32_t> const& indices,
+                          BgiGpuTimingScopeVector* out) {
+        for (uint32_t index : indices) {
+            if (!available[index]) {
+                continue;
+            }
+            BgiGpuTimingScope scope;
+            scope.label = frame->scopes[index].label;
+            scope.startMs = toMs(frameBegin, begins[index]);
+            scope.durationMs = toMs(begins[index], ends[index]);
+            buildScopes(children[index], &scope.children);
+            out->push_back(std::move(scope));
+        }
+    };
+
+    BgiGpuFrameTimings timings;
+    timings.frameNumber = frame->frameNumber;
+    timings.durationMs = toMs(frameBegin, frameEnd);
+    buildScopes(roots, &timings.scopes);
+
+    _timings = std::move(timings);
+    _hasTimings = true;
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/gpuTimings.h"
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkanCommandBuffer;
+class BgiVulkanDevice;
+
+/// \class BgiVulkanGpuProfiler
+///
+/// Measures the GPU time of debug groups with timestamp queries.
+///
+/// When enabled, PushDebugGroup and PopDebugGroup of the cmds objects write
+/// a timestamp at the start and the end of the group. Each frame between
+/// StartFrame and EndFrame records into one of a small ring of query pools.
+/// Once the command buffers of a frame completed, its timestamps are read
+/// back without waiting and turned into a tree of scopes, so the timings
+/// lag a few frames behind.
+///
+/// Debug groups pushed outside of a frame are not measured. Cmds must be
+/// submitted before the frame they were recorded in ends.
+///
+class BgiVulkanGpuProfiler final
+{
+public:
+    /// Returned for debug groups that are not measured.
+    static const uint32_t InvalidScope = UINT32_MAX;
+
+    BGIVULKAN_API
+    BgiVulkanGpuProfiler(BgiVulkanDevice* device);
+
+    BGIVULKAN_API
+    ~BgiVulkanGpuProfiler();
+
+    /// Enables or disables writing timestamps. Takes effect at the next
+    /// pushed debug group.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void SetEnabled(bool enabled);
+
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    bool IsEnabled() const;
+
+    /// Starts recording the scopes of a new frame. The queries of the frame
+    /// are reset in the resource command buffer.
+    /// Thread safety: No. Must be called from the main thread.
+    BGIVULKAN_API
+    void BeginFrame();
+
+    /// Ends the frame and resolves the frames whose command buffers have
+    /// completed. 'queueInflightBits' are the in-flight bits of the command
+    /// queue.
+    /// Thread safety: No. Must be called from the main thread.
+    BGIVULKAN_API
+    void EndFrame(uint64_t queueInflightBits);
+
+    /// Writes the start timestamp of a scope into 'cb' and pushes the scope
+    /// onto 'scopes', the debug group stack of a cmds object. The scope on
+    /// top of the stack becomes the parent.
+    /// Thread safety: Yes, as long as each thread records into its own 'cb'.
+    BGIVULKAN_API
+    void PushScope(
+        BgiVulkanCommandBuffer* cb,
+        const char* label,
+        std::vector<uint32_t>* scopes);
+
+    /// Writes the end timestamp of the scope on top of 'scopes' into 'cb'
+    /// and pops it.
+    /// Thread safety: Yes, as long as each thread records into its own 'cb'.
+    BGIVULKAN_API
+    void PopScope(
+        BgiVulkanCommandBuffer* cb,
+        std::vector<uint32_t>* scopes);
+
+    /// Returns the timings of the most recently resolved frame, or false if
+    /// no frame has been resolved yet.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    bool GetFrameTimings(BgiGpuFrameTimings* timings) const;
+
+private:
+    BgiVulkanGpuProfiler() = delete;
+    BgiVulkanGpuProfiler & operator=(const BgiVulkanGpuProfiler&) = delete;
+    BgiVulkanGpuProfiler(const BgiVulkanGpuProfiler&) = delete;
+
+    // The number of frames that can be in flight before their slot is
+    // needed again, and the number of scopes measured per frame.
+    static const uint32_t _FrameCount = 4;
+    static const uint32_t _MaxScopes = 512;
+
+    struct _Scope
+    {
+        std::string label;
+        uint32_t parent;
+    };
+
+    enum _FrameState
+    {
+        _FrameStateIdle = 0,
+        _FrameStateRecording,
+        _FrameStatePending
+    };
+
+    // Scope i of a frame writes queries 2i and 2i+1 of the frame's pool.
+    struct _Frame
+    {
+        VkQueryPool vkQueryPool = nullptr;
+        _FrameState state = _FrameStateIdle;
+        uint64_t frameNumber = 0;
+        uint64_t inflightBits = 0;
+        std::vector<_Scope> scopes;
+    };
+
+    // Reads back the timestamps of 'frame' and builds its timings.
+    void _ResolveFrame(_Frame* frame);
+
+    BgiVulkanDevice* _device;
+    double _timestampPeriodMs;
+    uint64_t _timestampMask;
+    std::atomic<bool> _enabled;
+
+    mutable std::mutex _mutex;
+    _Frame _frames[_FrameCount];
+    int _recordingFrame;
+    uint64_t _frameNumber;
+    bool _hasTimings;
+    BgiGpuFrameTimings _timings;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -8,11 +8,15 @@
 #include "driver/bgiVulkan/conversions.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/gpuProfiler.h"
 #include "driver/bgiVulkan/bgi.h"
 #include "driver/bgiVulkan/graphicsPipeline.h"
+#include "driver/bgiVulkan/queryPool.h"
 #include "driver/bgiVulkan/resourceBindings.h"
 #include "driver/bgiVulkan/texture.h"
 
+#include <algorithm>
+
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
@@ -26,6 +30,24 @@ BgiVulkanGraphicsCmds::BgiVulkanGraphicsCmds(
     , _renderPassStarted(false)
     , _viewportSet(false)
     , _scissorSet(false)
+    , _dirtyBits(0)
+    , _viewport{}
+    , _scissor{}
+    , _vertexBuffers{}
+    , _vertexBufferOffsets{}
+    , _vertexBuffersDirtyBegin(0)
+    , _vertexBuffersDirtyEnd(0)
+    , _boundBits(0)
+    , _boundViewport{}
+    , _boundScissor{}
+    , _boundResourceUpdateCount(0)
+    , _boundResourceLayout(nullptr)
+    , _boundIndexBuffer(nullptr)
+    , _boundIndexType(VK_INDEX_TYPE_UINT32)
+    , _conditionalRendering{
+        VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT}
+    , _conditionalRenderingOpen(false)
+    , _conditionalRenderingActive(false)
 {
     // We do not acquire the command buffer here, because the Cmds object may
     // have been created on the main thread, but used on a secondary thread.
@@ -41,14 +63,22 @@ void
 BgiVulkanGraphicsCmds::PushDebugGroup(const char* label)
 {
     _CreateCommandBuffer();
-    BgiVulkanBeginLabel(_bgi->GetPrimaryDevice(), _commandBuffer, label);
+    BgiVulkanDevice* device = _bgi->GetPrimaryDevice();
+    BgiVulkanBeginLabel(device, _commandBuffer, label);
+    if (BgiVulkanGpuProfiler* profiler = device->GetGpuProfiler()) {
+        profiler->PushScope(_commandBuffer, label, &_timestampScopes);
+    }
 }
 
 void
 BgiVulkanGraphicsCmds::PopDebugGroup()
 {
     _CreateCommandBuffer();
-    BgiVulkanEndLabel(_bgi->GetPrimaryDevice(), _commandBuffer);
+    BgiVulkanDevice* device = _bgi->GetPrimaryDevice();
+    if (BgiVulkanGpuProfiler* profiler = device->GetGpuProfiler()) {
+        profiler->PopScope(_commandBuffer, &_timestampScopes);
+    }
+    BgiVulkanEndLabel(device, _commandBuffer);
 }
 
 void
@@ -56,44 +86,36 @@ BgiVulkanGraphicsCmds::SetViewport(Vector4i const& vp)
 {
     _viewportSet = true;
 
+    float offsetX = (float) vp[0];
+    float offsetY = (float) vp[1];
+    float width = (float) vp[2];
+    float height = (float) vp[3];
+
+    // Flip viewport in Y-axis, because the vertex.y position is flipped
+    // between opengl and vulkan. This also moves origin to bottom-left.
+    // Requires VK_KHR_maintenance1 extension.
+
+    // Alternatives are:
+    // 1. Multiply projection by 'inverted Y and half Z' matrix:
+    //    const GfMatrix4d clip(
+    //        1.0,  0.0, 0.0, 0.0,
+    //        0.0, -1.0, 0.0, 0.0,
+    //        0.0,  0.0, 0.5, 0.0,
+    //        0.0,  0.0, 0.5, 1.0);
+    //    projection = clip * projection;
+    //
+    // 2. Adjust vertex position:
+    //    gl_Position.z = (gl_Position.z + gl_Position.w) / 2.0;
+
+    _viewport.x = offsetX;
+    _viewport.y = offsetY + height;
+    _viewport.width = width;
+    _viewport.height = -height;
+    _viewport.minDepth = 0.0f;
+    _viewport.maxDepth = 1.0f;
+
     // Delay until the pipeline is set and the render pass has begun.
-    _pendingUpdates.push_back(
-        [this, vp] {
-            float offsetX = (float) vp[0];
-            float offsetY = (float) vp[1];
-            float width = (float) vp[2];
-            float height = (float) vp[3];
-
-            // Flip viewport in Y-axis, because the vertex.y position is flipped
-            // between opengl and vulkan. This also moves origin to bottom-left.
-            // Requires VK_KHR_maintenance1 extension.
-
-            // Alternatives are:
-            // 1. Multiply projection by 'inverted Y and half Z' matrix:
-            //    const GfMatrix4d clip(
-            //        1.0,  0.0, 0.0, 0.0,
-            //        0.0, -1.0, 0.0, 0.0,
-            //        0.0,  0.0, 0.5, 0.0,
-            //        0.0,  0.0, 0.5, 1.0);
-            //    projection = clip * projection;
-            //
-            // 2. Adjust vertex position:
-            //    gl_Position.z = (gl_Position.z + gl_Position.w) / 2.0;
-
-            VkViewport viewport;
-            viewport.x = offsetX;
-            viewport.y = offsetY + height;
-            viewport.width = width;
-            viewport.height = -height;
-            viewport.minDepth = 0.0f;
-            viewport.maxDepth = 1.0f;
-
-            vkCmdSetViewport(
-                _commandBuffer->GetVulkanCommandBuffer(),
-                0,
-                1,
-                &viewport);
-    });
+    _dirtyBits |= _DirtyViewport;
 }
 
 void
@@ -101,18 +123,12 @@ BgiVulkanGraphicsCmds::SetScissor(Vector4i const& sc)
 {
     _scissorSet = true;
 
+    uint32_t w(sc[2]);
+    uint32_t h(sc[3]);
+    _scissor = {{sc[0], sc[1]}, {w, h}};
+
     // Delay until the pipeline is set and the render pass has begun.
-    _pendingUpdates.push_back(
-        [this, sc] {
-            uint32_t w(sc[2]);
-            uint32_t h(sc[3]);
-            VkRect2D scissor = {{sc[0], sc[1]}, {w, h}};
-            vkCmdSetScissor(
-                _commandBuffer->GetVulkanCommandBuffer(),
-                0,
-                1,
-                &scissor);
-    });
+    _dirtyBits |= _DirtyScissor;
 }
 
 void
@@ -120,39 +136,54 @@ BgiVulkanGraphicsCmds::BindPipeline(BgiGraphicsPipelineHandle pipeline)
 {
     _CreateCommandBuffer();
 
+    // Binding the same pipeline again changes nothing.
+    if (pipeline && pipeline == _pipeline) {
+        return;
+    }
+
+    BgiVulkanGraphicsPipeline* prevPso =
+        static_cast<BgiVulkanGraphicsPipeline*>(_pipeline.Get());
+    BgiVulkanGraphicsPipeline* pso = 
+        static_cast<BgiVulkanGraphicsPipeline*>(pipeline.Get());
+
     // End the previous render pass in case we are using the same
-    // GfxCmds with multiple pipelines.
-    _EndRenderPass();
+    // GfxCmds with multiple pipelines, unless the new pipeline can keep
+    // drawing into it.
+    if (!pso || !pso->IsRenderPassCompatible(prevPso)) {
+        _EndRenderPass();
+    }
 
     _pipeline = pipeline;
-    BgiVulkanGraphicsPipeline* pso = 
-        static_cast<BgiVulkanGraphicsPipeline*>(_pipeline.Get());
 
     if (UTILS_VERIFY(pso)) {
+        // Push the constants again, in case the layout of the new pipeline
+        // is not compatible with the previous one. Pipeline layouts are
+        // shared through the layout cache, so equal handles are compatible.
+        if (!prevPso || prevPso->GetVulkanPipelineLayout() !=
+                pso->GetVulkanPipelineLayout()) {
+            _pushConstants.Invalidate();
+        }
+
         pso->BindPipeline(_commandBuffer->GetVulkanCommandBuffer());
     }
 }
 
 void
 BgiVulkanGraphicsCmds::BindResources(BgiResourceBindingsHandle res)
+{
+    BindResources(res, std::vector<uint32_t>());
+}
+
+void
+BgiVulkanGraphicsCmds::BindResources(
+    BgiResourceBindingsHandle res,
+    std::vector<uint32_t> const& dynamicOffsets)
 {
     // Delay until the pipeline is set and the render pass has begun.
-    _pendingUpdates.push_back(
-        [this, res] {
-            BgiVulkanGraphicsPipeline* pso = 
-                static_cast<BgiVulkanGraphicsPipeline*>(_pipeline.Get());
-
-            BgiVulkanResourceBindings * rb =
-                static_cast<BgiVulkanResourceBindings*>(res.Get());
-
-            if (pso && rb){
-                rb->BindResources(
-                    _commandBuffer->GetVulkanCommandBuffer(),
-                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    pso->GetVulkanPipelineLayout());
-            }
-        }
-    );
+    // Assigning reuses the capacity of the offsets of earlier binds.
+    _resourceBindings = res;
+    _dynamicOffsets = dynamicOffsets;
+    _dirtyBits |= _DirtyResources;
 }
 
 void
@@ -163,29 +194,41 @@ BgiVulkanGraphicsCmds::SetConstantValues(
     uint32_t byteSize,
     const void* data)
 {
-    // The data provided could be local stack memory that goes out of scope
-    // before we execute this pending fn. Make a copy to prevent that.
-    uint8_t* dataCopy = new uint8_t[byteSize];
-    memcpy(dataCopy, data, byteSize);
+    SetConstantValues(pipeline, stages, bindIndex, 0, byteSize, data);
+}
 
-    // Delay until the pipeline is set and the render pass has begun.
-    _pendingUpdates.push_back(
-        [this, byteSize, dataCopy, stages] {
-            BgiVulkanGraphicsPipeline* pso = 
-                static_cast<BgiVulkanGraphicsPipeline*>(_pipeline.Get());
-
-            if (pso) {
-                vkCmdPushConstants(
-                    _commandBuffer->GetVulkanCommandBuffer(),
-                    pso->GetVulkanPipelineLayout(),
-                    BgiVulkanConversions::GetShaderStages(stages),
-                    0, // offset
-                    byteSize,
-                    dataCopy);
+void
+BgiVulkanGraphicsCmds::SetConstantValues(
+    BgiGraphicsPipelineHandle pipeline,
+    BgiShaderStage stages,
+    uint32_t bindIndex,
+    uint32_t byteOffset,
+    uint32_t byteSize,
+    const void* data)
+{
+    // The pushes name the stages of the pipeline ranges the bytes fall in,
+    // so 'stages' is only used to catch values no requested stage can read.
+    BgiVulkanGraphicsPipeline const* pso =
+        static_cast<BgiVulkanGraphicsPipeline const*>(pipeline.Get());
+    if (pso && byteSize > 0) {
+        VkShaderStageFlags rangeStages = 0;
+        for (VkPushConstantRange const& range : pso->GetPushConstantRanges()) {
+            if (range.offset < byteOffset + byteSize &&
+                byteOffset < range.offset + range.size) {
+                rangeStages |= range.stageFlags;
             }
+        }
+        VkShaderStageFlags const requested =
+            BgiVulkanConversions::GetShaderStages(stages);
+        UTILS_VERIFY((requested & rangeStages) == requested,
+            "Push constants [%u, %u) are not in a range of all stages %u",
+            byteOffset, byteOffset + byteSize, (uint32_t) stages);
+    }
 
-        delete[] dataCopy;
-    });
+    // The data provided could be local stack memory, so copy it into the
+    // shadow values. The dirty bytes are pushed before the next draw, for
+    // the stages of the pipeline ranges they fall in.
+    _pushConstants.SetValues(byteOffset, byteSize, data);
 }
 
 void
@@ -193,28 +236,35 @@ BgiVulkanGraphicsCmds::BindVertexBuffers(
     BgiVertexBufferBindingVector const &bindings)
 {
     // Delay until the pipeline is set and the render pass has begun.
-    _pendingUpdates.push_back(
-        [this, bindings] {
-        std::vector<VkBuffer> buffers;
-        std::vector<VkDeviceSize> bufferOffsets;
-
-        for (BgiVertexBufferBinding const &binding : bindings) {
-            BgiVulkanBuffer* buf =
-                static_cast<BgiVulkanBuffer*>(binding.buffer.Get());
-            VkBuffer vkBuf = buf->GetVulkanBuffer();
-            if (vkBuf) {
-                buffers.push_back(vkBuf);
-                bufferOffsets.push_back(binding.byteOffset);
-            }
+    for (BgiVertexBufferBinding const &binding : bindings) {
+        if (!UTILS_VERIFY(binding.index < _MaxVertexBuffers,
+                "Vertex buffer index %u out of range", binding.index)) {
+            continue;
         }
 
-        vkCmdBindVertexBuffers(
-            _commandBuffer->GetVulkanCommandBuffer(),
-            bindings[0].index, // first binding
-            buffers.size(),
-            buffers.data(),
-            bufferOffsets.data());
-    });
+        BgiVulkanBuffer* buf =
+            static_cast<BgiVulkanBuffer*>(binding.buffer.Get());
+        VkBuffer vkBuf = buf ? buf->GetVulkanBuffer() : nullptr;
+
+        // Skip buffers that are already bound at the same offset.
+        if (vkBuf == _vertexBuffers[binding.index] &&
+            binding.byteOffset == _vertexBufferOffsets[binding.index]) {
+            continue;
+        }
+
+        _vertexBuffers[binding.index] = vkBuf;
+        _vertexBufferOffsets[binding.index] = binding.byteOffset;
+
+        if (_vertexBuffersDirtyBegin >= _vertexBuffersDirtyEnd) {
+            _vertexBuffersDirtyBegin = binding.index;
+            _vertexBuffersDirtyEnd = binding.index + 1;
+        } else {
+            _vertexBuffersDirtyBegin =
+                std::min(_vertexBuffersDirtyBegin, binding.index);
+            _vertexBuffersDirtyEnd =
+                std::max(_vertexBuffersDirtyEnd, binding.index + 1);
+        }
+    }
 }
 
 void
@@ -268,19 +318,15 @@ BgiVulkanGraphicsCmds::DrawIndexed(
     // Make sure the render pass has begun and resource are bound
     _ApplyPendingUpdates();
 
-    BgiVulkanBuffer* ibo = static_cast<BgiVulkanBuffer*>(indexBuffer.Get());
-
-    vkCmdBindIndexBuffer(
-        _commandBuffer->GetVulkanCommandBuffer(),
-        ibo->GetVulkanBuffer(),
-        indexBufferByteOffset,
-        VK_INDEX_TYPE_UINT32);
+    // The byte offset is applied through the first index, so draws from
+    // different ranges of the same index buffer share one binding.
+    uint32_t const indexSize = _BindIndexBuffer(indexBuffer);
 
     vkCmdDrawIndexed(
         _commandBuffer->GetVulkanCommandBuffer(),
         indexCount,
         instanceCount,
-        static_cast<uint32_t>(indexBufferByteOffset / sizeof(uint32_t)),
+        indexBufferByteOffset / indexSize,
         baseVertex,
         baseInstance);
 }
@@ -298,13 +344,7 @@ BgiVulkanGraphicsCmds::DrawIndexedIndirect(
     // Make sure the render pass has begun and resource are bound
     _ApplyPendingUpdates();
 
-    BgiVulkanBuffer* ibo = static_cast<BgiVulkanBuffer*>(indexBuffer.Get());
-
-    vkCmdBindIndexBuffer(
-        _commandBuffer->GetVulkanCommandBuffer(),
-        ibo->GetVulkanBuffer(),
-        0, // indexBufferByteOffset
-        VK_INDEX_TYPE_UINT32);
+    _BindIndexBuffer(indexBuffer);
 
     BgiVulkanBuffer* drawBuf =
         static_cast<BgiVulkanBuffer*>(drawParameterBuffer.Get());
@@ -318,6 +358,268 @@ BgiVulkanGraphicsCmds::DrawIndexedIndirect(
 
 }
 
+void
+BgiVulkanGraphicsCmds::DrawIndirectCount(
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    BgiBufferHandle const& countBuffer,
+    uint32_t countBufferByteOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride)
+{
+    if (!_bgi->GetCapabilities()->supportsDrawIndirectCount) {
+        UTILS_CODING_ERROR("DrawIndirectCount is not supported by the device");
+        return;
+    }
+
+    // Make sure the render pass has begun and resource are bound
+    _ApplyPendingUpdates();
+
+    BgiVulkanBuffer* drawBuf =
+        static_cast<BgiVulkanBuffer*>(drawParameterBuffer.Get());
+    BgiVulkanBuffer* countBuf =
+        static_cast<BgiVulkanBuffer*>(countBuffer.Get());
+
+    vkCmdDrawIndirectCount(
+        _commandBuffer->GetVulkanCommandBuffer(),
+        drawBuf->GetVulkanBuffer(),
+        drawBufferByteOffset,
+        countBuf->GetVulkanBuffer(),
+        countBufferByteOffset,
+        maxDrawCount,
+        stride);
+}
+
+void
+BgiVulkanGraphicsCmds::DrawIndexedIndirectCount(
+    BgiBufferHandle const& indexBuffer,
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    BgiBufferHandle const& countBuffer,
+    uint32_t countBufferByteOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride)
+{
+    if (!_bgi->GetCapabilities()->supportsDrawIndirectCount) {
+        UTILS_CODING_ERROR("DrawIndexedIndirectCount is not supported by the "
+            "device");
+        return;
+    }
+
+    // Make sure the render pass has begun and resource are bound
+    _ApplyPendingUpdates();
+
+    _BindIndexBuffer(indexBuffer);
+
+    BgiVulkanBuffer* drawBuf =
+        static_cast<BgiVulkanBuffer*>(drawParameterBuffer.Get());
+    BgiVulkanBuffer* countBuf =
+        static_cast<BgiVulkanBuffer*>(countBuffer.Get());
+
+    vkCmdDrawIndexedIndirectCount(
+        _commandBuffer->GetVulkanCommandBuffer(),
+        drawBuf->GetVulkanBuffer(),
+        drawBufferByteOffset,
+        countBuf->GetVulkanBuffer(),
+        countBufferByteOffset,
+        maxDrawCount,
+        stride);
+}
+
+void
+BgiVulkanGraphicsCmds::ResetQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount)
+{
+    _CreateCommandBuffer();
+
+    if (_renderPassStarted) {
+        UTILS_CODING_ERROR("Queries must be reset before the first draw");
+        return;
+    }
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        vkCmdResetQueryPool(
+            _commandBuffer->GetVulkanCommandBuffer(),
+            pool->GetVulkanQueryPool(),
+            firstQuery,
+            queryCount);
+    }
+}
+
+void
+BgiVulkanGraphicsCmds::BeginQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (!UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        return;
+    }
+
+    _Query const q = {
+        pool->GetVulkanQueryPool(),
+        query,
+        pool->GetVulkanQueryControlFlags()};
+
+    if (_renderPassStarted) {
+        _BeginQuery(q.vkQueryPool, q.query, q.flags);
+    } else {
+        _pendingQueries.push_back(q);
+    }
+}
+
+void
+BgiVulkanGraphicsCmds::EndQuery(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (!UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        return;
+    }
+
+    VkQueryPool const vkQueryPool = pool->GetVulkanQueryPool();
+    VkCommandBuffer cb = _commandBuffer->GetVulkanCommandBuffer();
+    auto matches = [vkQueryPool, query](_Query const& q) {
+        return q.vkQueryPool == vkQueryPool && q.query == query;
+    };
+
+    // Nothing was drawn since the query began. Begin and end it outside of
+    // a render pass so its result is still written.
+    auto it = std::find_if(
+        _pendingQueries.begin(), _pendingQueries.end(), matches);
+    if (it != _pendingQueries.end()) {
+        vkCmdBeginQuery(cb, vkQueryPool, query, it->flags);
+        vkCmdEndQuery(cb, vkQueryPool, query);
+        _pendingQueries.erase(it);
+        return;
+    }
+
+    it = std::find_if(_activeQueries.begin(), _activeQueries.end(), matches);
+    if (it != _activeQueries.end()) {
+        vkCmdEndQuery(cb, vkQueryPool, query);
+        _activeQueries.erase(it);
+        return;
+    }
+
+    UTILS_CODING_ERROR("Query %u of query pool %s was not begun", query,
+        pool->GetDescriptor().debugName.c_str());
+}
+
+void
+BgiVulkanGraphicsCmds::WriteTimestamp(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t query)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanQueryPool* pool =
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get());
+    if (UTILS_VERIFY(pool && pool->GetVulkanQueryPool())) {
+        vkCmdWriteTimestamp(
+            _commandBuffer->GetVulkanCommandBuffer(),
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            pool->GetVulkanQueryPool(),
+            query);
+    }
+}
+
+void
+BgiVulkanGraphicsCmds::ResolveQueries(
+    BgiQueryPoolHandle const& queryPool,
+    uint32_t firstQuery,
+    uint32_t queryCount,
+    BgiBufferHandle const& buffer,
+    uint32_t byteOffset)
+{
+    _CreateCommandBuffer();
+
+    if (_renderPassStarted) {
+        _pendingResolves.push_back(
+            {queryPool, firstQuery, queryCount, buffer, byteOffset});
+        return;
+    }
+
+    _commandBuffer->ResolveQueries(
+        static_cast<BgiVulkanQueryPool*>(queryPool.Get()),
+        firstQuery,
+        queryCount,
+        static_cast<BgiVulkanBuffer*>(buffer.Get()),
+        byteOffset);
+}
+
+void
+BgiVulkanGraphicsCmds::BeginConditionalRendering(
+    BgiBufferHandle const& buffer,
+    uint32_t byteOffset,
+    bool inverted)
+{
+    _CreateCommandBuffer();
+
+    BgiVulkanDevice* device = _bgi->GetPrimaryDevice();
+    if (!device->vkCmdBeginConditionalRenderingEXT) {
+        UTILS_CODING_ERROR("Conditional rendering is not supported");
+        return;
+    }
+
+    if (_conditionalRenderingOpen) {
+        UTILS_CODING_ERROR("Conditional rendering blocks can not be nested");
+        return;
+    }
+
+    BgiVulkanBuffer* buf = static_cast<BgiVulkanBuffer*>(buffer.Get());
+    if (!UTILS_VERIFY(buf)) {
+        return;
+    }
+
+    if (!(buf->GetDescriptor().usage & BgiBufferUsagePredicate) ||
+        (byteOffset % 4) != 0) {
+        UTILS_CODING_ERROR("Buffer %s can not be used for conditional "
+            "rendering at offset %u", buf->GetDescriptor().debugName.c_str(),
+            byteOffset);
+        return;
+    }
+
+    _conditionalRendering.buffer = buf->GetVulkanBuffer();
+    _conditionalRendering.offset = byteOffset;
+    _conditionalRendering.flags = inverted ?
+        VK_CONDITIONAL_RENDERING_INVERTED_BIT_EXT : 0;
+    _conditionalRenderingOpen = true;
+
+    if (_renderPassStarted) {
+        _BeginConditionalRendering();
+    }
+}
+
+void
+BgiVulkanGraphicsCmds::EndConditionalRendering()
+{
+    _CreateCommandBuffer();
+
+    if (!_conditionalRenderingOpen) {
+        UTILS_CODING_ERROR("No conditional rendering block to end");
+        return;
+    }
+
+    // Nothing was drawn in the block if it never became active.
+    if (_conditionalRenderingActive) {
+        _bgi->GetPrimaryDevice()->vkCmdEndConditionalRenderingEXT(
+            _commandBuffer->GetVulkanCommandBuffer());
+        _conditionalRenderingActive = false;
+    }
+    _conditionalRenderingOpen = false;
+}
+
 void
 BgiVulkanGraphicsCmds::InsertMemoryBarrier(BgiMemoryBarrier barrier)
 {
@@ -338,6 +640,11 @@ BgiVulkanGraphicsCmds::_Submit(Bgi* bgi, BgiSubmitWaitType wait)
         return false;
     }
 
+    if (_conditionalRenderingOpen) {
+        UTILS_CODING_ERROR("Conditional rendering block was not ended");
+        _conditionalRenderingOpen = false;
+    }
+
     // End render pass
     _EndRenderPass();
 
@@ -362,7 +669,7 @@ BgiVulkanGraphicsCmds::_ApplyPendingUpdates()
     _CreateCommandBuffer();
 
     // Begin render pass
-    if (!_renderPassStarted && !_pendingUpdates.empty()) {
+    if (!_renderPassStarted) {
         _renderPassStarted = true;
 
         BgiVulkanGraphicsPipeline* pso = 
@@ -387,6 +694,17 @@ BgiVulkanGraphicsCmds::_ApplyPendingUpdates()
             &beginInfo,
             contents);
 
+        // Queries begun before the first draw count the draws of the
+        // render pass.
+        for (_Query const& q : _pendingQueries) {
+            _BeginQuery(q.vkQueryPool, q.query, q.flags);
+        }
+        _pendingQueries.clear();
+
+        if (_conditionalRenderingOpen) {
+            _BeginConditionalRendering();
+        }
+
         // Make sure viewport and scissor are set since our HgiVulkanPipeline
         // hardcodes one dynamic viewport and scissor.
         if (!_viewportSet) {
@@ -397,22 +715,177 @@ BgiVulkanGraphicsCmds::_ApplyPendingUpdates()
         }
     }
 
-    // Now that the render pass has begun we can execute any cmds that
-    // require a render pass to be active.
-    for (BgiVulkanGfxFunction const& fn : _pendingUpdates) {
-        fn();
+    // Now that the render pass has begun we can apply the state that
+    // changed since the last draw.
+    VkCommandBuffer cb = _commandBuffer->GetVulkanCommandBuffer();
+    BgiVulkanGraphicsPipeline* pso =
+        static_cast<BgiVulkanGraphicsPipeline*>(_pipeline.Get());
+
+    if ((_dirtyBits & _DirtyViewport) && !(
+            (_boundBits & _DirtyViewport) &&
+            _viewport.x == _boundViewport.x &&
+            _viewport.y == _boundViewport.y &&
+            _viewport.width == _boundViewport.width &&
+            _viewport.height == _boundViewport.height &&
+            _viewport.minDepth == _boundViewport.minDepth &&
+            _viewport.maxDepth == _boundViewport.maxDepth)) {
+        vkCmdSetViewport(cb, 0, 1, &_viewport);
+        _boundViewport = _viewport;
+        _boundBits |= _DirtyViewport;
+    }
+
+    if ((_dirtyBits & _DirtyScissor) && !(
+            (_boundBits & _DirtyScissor) &&
+            _scissor.offset.x == _boundScissor.offset.x &&
+            _scissor.offset.y == _boundScissor.offset.y &&
+            _scissor.extent.width == _boundScissor.extent.width &&
+            _scissor.extent.height == _boundScissor.extent.height)) {
+        vkCmdSetScissor(cb, 0, 1, &_scissor);
+        _boundScissor = _scissor;
+        _boundBits |= _DirtyScissor;
+    }
+
+    if (_dirtyBits & _DirtyResources) {
+        BgiVulkanResourceBindings * rb =
+            static_cast<BgiVulkanResourceBindings*>(_resourceBindings.Get());
+
+        // Skip the bind if the same version of the resources is bound with
+        // the same layout and offsets.
+        if (pso && rb && !(
+                _resourceBindings == _boundResourceBindings &&
+                rb->GetUpdateCount() == _boundResourceUpdateCount &&
+                pso->GetVulkanPipelineLayout() == _boundResourceLayout &&
+                _dynamicOffsets == _boundDynamicOffsets)) {
+            rb->BindResources(
+                _commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pso->GetVulkanPipelineLayout(),
+                _dynamicOffsets);
+            _boundResourceBindings = _resourceBindings;
+            _boundResourceUpdateCount = rb->GetUpdateCount();
+            _boundResourceLayout = pso->GetVulkanPipelineLayout();
+            _boundDynamicOffsets = _dynamicOffsets;
+        }
+    }
+
+    _dirtyBits = 0;
+
+    // Bind each run of consecutive vertex buffers with one call.
+    uint32_t first = _vertexBuffersDirtyBegin;
+    while (first < _vertexBuffersDirtyEnd) {
+        if (!_vertexBuffers[first]) {
+            first++;
+            continue;
+        }
+        uint32_t end = first + 1;
+        while (end < _vertexBuffersDirtyEnd && _vertexBuffers[end]) {
+            end++;
+        }
+        vkCmdBindVertexBuffers(
+            cb,
+            first,
+            end - first,
+            _vertexBuffers + first,
+            _vertexBufferOffsets + first);
+        first = end;
     }
-    _pendingUpdates.clear();
+    _vertexBuffersDirtyBegin = 0;
+    _vertexBuffersDirtyEnd = 0;
+
+    _pushConstants.Flush(
+        cb,
+        pso->GetVulkanPipelineLayout(),
+        pso->GetPushConstantRanges());
 }
 
 void
 BgiVulkanGraphicsCmds::_EndRenderPass()
 {
     if (_renderPassStarted) {
-        vkCmdEndRenderPass(_commandBuffer->GetVulkanCommandBuffer());
+        VkCommandBuffer cb = _commandBuffer->GetVulkanCommandBuffer();
+
+        // An open conditional rendering block begins again with the next
+        // render pass.
+        if (_conditionalRenderingActive) {
+            _bgi->GetPrimaryDevice()->vkCmdEndConditionalRenderingEXT(cb);
+            _conditionalRenderingActive = false;
+        }
+
+        // Queries can not outlive the render pass they began in.
+        if (!_activeQueries.empty()) {
+            UTILS_CODING_ERROR("Queries must end before the render pass ends "
+                "(e.g. by binding an incompatible pipeline or submitting)");
+            for (_Query const& q : _activeQueries) {
+                vkCmdEndQuery(cb, q.vkQueryPool, q.query);
+            }
+            _activeQueries.clear();
+        }
+
+        vkCmdEndRenderPass(cb);
         _renderPassStarted = false;
         _viewportSet = false;
         _scissorSet = false;
+
+        for (_QueryResolve const& r : _pendingResolves) {
+            _commandBuffer->ResolveQueries(
+                static_cast<BgiVulkanQueryPool*>(r.queryPool.Get()),
+                r.firstQuery,
+                r.queryCount,
+                static_cast<BgiVulkanBuffer*>(r.buffer.Get()),
+                r.byteOffset);
+        }
+        _pendingResolves.clear();
+    }
+}
+
+void
+BgiVulkanGraphicsCmds::_BeginQuery(
+    VkQueryPool vkQueryPool,
+    uint32_t query,
+    VkQueryControlFlags flags)
+{
+    vkCmdBeginQuery(
+        _commandBuffer->GetVulkanCommandBuffer(),
+        vkQueryPool,
+        query,
+        flags);
+    _activeQueries.push_back({vkQueryPool, query, flags});
+}
+
+void
+BgiVulkanGraphicsCmds::_BeginConditionalRendering()
+{
+    _bgi->GetPrimaryDevice()->vkCmdBeginConditionalRenderingEXT(
+        _commandBuffer->GetVulkanCommandBuffer(),
+        &_conditionalRendering);
+    _conditionalRenderingActive = true;
+}
+
+uint32_t
+BgiVulkanGraphicsCmds::_BindIndexBuffer(BgiBufferHandle const& indexBuffer)
+{
+    BgiVulkanBuffer* ibo = static_cast<BgiVulkanBuffer*>(indexBuffer.Get());
+    VkBuffer vkBuf = ibo->GetVulkanBuffer();
+    VkIndexType indexType =
+        BgiVulkanConversions::GetIndexType(ibo->GetDescriptor().usage);
+
+    if (vkBuf != _boundIndexBuffer || indexType != _boundIndexType) {
+        vkCmdBindIndexBuffer(
+            _commandBuffer->GetVulkanCommandBuffer(),
+            vkBuf,
+            0, // indexBufferByteOffset
+            indexType);
+        _boundIndexBuffer = vkBuf;
+        _boundIndexType = indexType;
+    }
+
+    switch (indexType) {
+    case VK_INDEX_TYPE_UINT8_EXT:
+        return sizeof(uint8_t);
+    case VK_INDEX_TYPE_UINT16:
+        return sizeof(uint16_t);
+    default:
+        return sizeof(uint32_t);
     }
 }
 
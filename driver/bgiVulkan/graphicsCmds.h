@@ -5,10 +5,10 @@
 
 #include "driver/bgiBase/graphicsCmds.h"
 #include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/pushConstants.h"
 #include "driver/bgiVulkan/vulkanBridge.h"
 
 #include <cstdint>
-#include <functional>
 #include <vector>
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
@@ -21,9 +21,6 @@ struct BgiGraphicsCmdsDesc;
 class BgiVulkan;
 class BgiVulkanCommandBuffer;
 
-using BgiVulkanGfxFunction = std::function<void(void)>;
-using BgiVulkanGfxFunctionVector = std::vector<BgiVulkanGfxFunction>;
-
 /// \class HgiVulkanGraphicsCmds
 ///
 /// Vulkan implementation of HgiGraphicsEncoder.
@@ -52,6 +49,11 @@ public:
     BGIVULKAN_API
     void BindResources(BgiResourceBindingsHandle resources) override;
 
+    BGIVULKAN_API
+    void BindResources(
+        BgiResourceBindingsHandle resources,
+        std::vector<uint32_t> const& dynamicOffsets) override;
+
     BGIVULKAN_API
     void SetConstantValues(
         BgiGraphicsPipelineHandle pipeline,
@@ -60,6 +62,15 @@ public:
         uint32_t byteSize,
         const void* data) override;
 
+    BGIVULKAN_API
+    void SetConstantValues(
+        BgiGraphicsPipelineHandle pipeline,
+        BgiShaderStage stages,
+        uint32_t bindIndex,
+        uint32_t byteOffset,
+        uint32_t byteSize,
+        const void* data) override;
+
     BGIVULKAN_API
     void BindVertexBuffers(
         BgiVertexBufferBindingVector const &bindings) override;
@@ -97,6 +108,63 @@ public:
         std::vector<uint32_t> const& drawParameterBufferUInt32,
         uint32_t patchBaseVertexByteOffset) override;
 
+    BGIVULKAN_API
+    void DrawIndirectCount(
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        BgiBufferHandle const& countBuffer,
+        uint32_t countBufferByteOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride) override;
+
+    BGIVULKAN_API
+    void DrawIndexedIndirectCount(
+        BgiBufferHandle const& indexBuffer,
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        BgiBufferHandle const& countBuffer,
+        uint32_t countBufferByteOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride) override;
+
+    BGIVULKAN_API
+    void ResetQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount) override;
+
+    BGIVULKAN_API
+    void BeginQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGIVULKAN_API
+    void EndQuery(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGIVULKAN_API
+    void WriteTimestamp(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t query) override;
+
+    BGIVULKAN_API
+    void ResolveQueries(
+        BgiQueryPoolHandle const& queryPool,
+        uint32_t firstQuery,
+        uint32_t queryCount,
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset) override;
+
+    BGIVULKAN_API
+    void BeginConditionalRendering(
+        BgiBufferHandle const& buffer,
+        uint32_t byteOffset,
+        bool inverted) override;
+
+    BGIVULKAN_API
+    void EndConditionalRendering() override;
+
     BGIVULKAN_API
     void InsertMemoryBarrier(BgiMemoryBarrier barrier) override;
 
@@ -120,8 +188,15 @@ private:
 
     void _ApplyPendingUpdates();
     void _EndRenderPass();
+    void _BeginQuery(VkQueryPool vkQueryPool, uint32_t query,
+                     VkQueryControlFlags flags);
+    void _BeginConditionalRendering();
     void _CreateCommandBuffer();
 
+    // Binds the index buffer, unless it is bound already. Returns the byte
+    // size of its indices.
+    uint32_t _BindIndexBuffer(BgiBufferHandle const& indexBuffer);
+
     BgiVulkan* _bgi;
     BgiGraphicsCmdsDesc _descriptor;
     BgiVulkanCommandBuffer* _commandBuffer;
@@ -129,7 +204,79 @@ private:
     bool _renderPassStarted;
     bool _viewportSet;
     bool _scissorSet;
-    BgiVulkanGfxFunctionVector _pendingUpdates;
+
+    // The GPU profiler scopes of the debug groups pushed on these cmds.
+    std::vector<uint32_t> _timestampScopes;
+
+    // Queries begun before the render pass are begun once it starts, so
+    // that they count the draws of the render pass. Active queries must end
+    // before the render pass does.
+    struct _Query
+    {
+        VkQueryPool vkQueryPool;
+        uint32_t query;
+        VkQueryControlFlags flags;
+    };
+
+    // Query results can not be copied inside a render pass. They are
+    // resolved once the render pass has ended.
+    struct _QueryResolve
+    {
+        BgiQueryPoolHandle queryPool;
+        uint32_t firstQuery;
+        uint32_t queryCount;
+        BgiBufferHandle buffer;
+        uint32_t byteOffset;
+    };
+
+    std::vector<_Query> _pendingQueries;
+    std::vector<_Query> _activeQueries;
+    std::vector<_QueryResolve> _pendingResolves;
+
+    // An open conditional rendering block is only active inside the render
+    // pass. It is begun again when the render pass is restarted (e.g. after
+    // binding an incompatible pipeline), since a block begun inside a
+    // render pass must end inside it.
+    VkConditionalRenderingBeginInfoEXT _conditionalRendering;
+    bool _conditionalRenderingOpen;
+    bool _conditionalRenderingActive;
+
+    // State set before a draw is kept in these slots and applied by
+    // _ApplyPendingUpdates once the pipeline is set and the render pass has
+    // begun. Only the last value of each state matters, so recording a draw
+    // does not allocate.
+    enum _DirtyBits : uint32_t
+    {
+        _DirtyViewport  = 1 << 0,
+        _DirtyScissor   = 1 << 1,
+        _DirtyResources = 1 << 2,
+    };
+
+    static constexpr uint32_t _MaxVertexBuffers = 32;
+
+    uint32_t _dirtyBits;
+    VkViewport _viewport;
+    VkRect2D _scissor;
+    BgiResourceBindingsHandle _resourceBindings;
+    std::vector<uint32_t> _dynamicOffsets;
+    VkBuffer _vertexBuffers[_MaxVertexBuffers];
+    VkDeviceSize _vertexBufferOffsets[_MaxVertexBuffers];
+    uint32_t _vertexBuffersDirtyBegin;
+    uint32_t _vertexBuffersDirtyEnd;
+    BgiVulkanPushConstants _pushConstants;
+
+    // The state last recorded into the command buffer. Commands that would
+    // not change it are skipped. Bits of _boundBits tell which of the
+    // viewport and scissor are known.
+    uint32_t _boundBits;
+    VkViewport _boundViewport;
+    VkRect2D _boundScissor;
+    BgiResourceBindingsHandle _boundResourceBindings;
+    uint64_t _boundResourceUpdateCount;
+    VkPipelineLayout _boundResourceLayout;
+    std::vector<uint32_t> _boundDynamicOffsets;
+    VkBuffer _boundIndexBuffer;
+    VkIndexType _boundIndexType;
 
     // GraphicsCmds is used only one frame so storing multi-frame state on
     // GraphicsCmds will not survive.
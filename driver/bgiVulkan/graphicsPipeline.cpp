@@ -1,19 +1,65 @@
 #include "common/utils/diagnostic.h"
 #include "driver/bgiVulkan/graphicsPipeline.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
 #include "driver/bgiVulkan/capabilities.h"
 #include "driver/bgiVulkan/conversions.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/layoutCache.h"
+#include "driver/bgiVulkan/memoryTracker.h"
 #include "driver/bgiVulkan/pipelineCache.h"
 #include "driver/bgiVulkan/shaderFunction.h"
 #include "driver/bgiVulkan/texture.h"
 
+#include <algorithm>
+#include <cstdint>
+
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
 
 using BgiAttachmentDescConstPtrVector = std::vector<BgiAttachmentDesc const*>;
 
+// Vulkan allows each shader stage in at most one push constant range of a
+// pipeline layout. A stage that reads several of the requested ranges gets
+// one range spanning all of them, and stages with identical spans share a
+// range. The cmds split pushes on range boundaries, so widening a range only
+// makes pushes of the bytes in between name that stage as well.
+static VkPushConstantRangeVector
+_MergePushConstantRanges(VkPushConstantRangeVector const& requested)
+{
+    VkPushConstantRangeVector merged;
+
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        VkShaderStageFlags const stage = 1u << bit;
+
+        uint32_t begin = UINT32_MAX;
+        uint32_t end = 0;
+        for (VkPushConstantRange const& range : requested) {
+            if (range.stageFlags & stage) {
+                begin = std::min(begin, range.offset);
+                end = std::max(end, range.offset + range.size);
+            }
+        }
+        if (end <= begin) {
+            continue;
+        }
+
+        auto it = std::find_if(merged.begin(), merged.end(),
+            [begin, end](VkPushConstantRange const& range) {
+                return range.offset == begin &&
+                    range.offset + range.size == end;
+            });
+        if (it != merged.end()) {
+            it->stageFlags |= stage;
+        } else {
+            merged.push_back({stage, begin, end - begin});
+        }
+    }
+
+    return merged;
+}
+
 BgiVulkanGraphicsPipeline::BgiVulkanGraphicsPipeline(
     BgiVulkanDevice* device,
     BgiGraphicsPipelineDesc const& desc)
@@ -23,6 +69,7 @@ BgiVulkanGraphicsPipeline::BgiVulkanGraphicsPipeline(
     , _vkPipeline(nullptr)
     , _vkRenderPass(nullptr)
     , _vkPipelineLayout(nullptr)
+    , _usesBindlessHeap(false)
 {
     VkGraphicsPipelineCreateInfo pipeCreateInfo =
         {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
@@ -119,7 +166,12 @@ BgiVulkanGraphicsPipeline::BgiVulkanGraphicsPipeline(
     vertexInput.vertexAttributeDescriptionCount = (uint32_t) vertAttrs.size();
     vertexInput.pVertexBindingDescriptions = vertBufs.data();
     vertexInput.vertexBindingDescriptionCount = (uint32_t) vertBufs.size();
-    vertexInput.pNext = &vertexInputDivisor;
+
+    // The divisor state may only be chained when it has divisors, which is
+    // never the case for pipelines that pull vertices in the shader.
+    if (!vertBindingDivisors.empty()) {
+        vertexInput.pNext = &vertexInputDivisor;
+    }
     
     pipeCreateInfo.pVertexInputState = &vertexInput;
 
@@ -298,47 +350,55 @@ BgiVulkanGraphicsPipeline::BgiVulkanGraphicsPipeline(
     //
     // Generate Pipeline layout
     //
-    bool usePushConstants = desc.shaderConstantsDesc.byteSize > 0;
-    VkPushConstantRange pcRanges;
-    if (usePushConstants) {
-        UTILS_VERIFY(desc.shaderConstantsDesc.byteSize % 4 == 0,
+    BgiGraphicsShaderConstantsDesc const& constants = desc.shaderConstantsDesc;
+    if (constants.byteSize > 0) {
+        UTILS_VERIFY(constants.byteSize % 4 == 0,
             "Push constants not multipes of 4");
-        pcRanges.offset = 0;
-        pcRanges.size = desc.shaderConstantsDesc.byteSize;
-        pcRanges.stageFlags = BgiVulkanConversions::GetShaderStages(
-            desc.shaderConstantsDesc.stageUsage);
     }
+    if (constants.ranges.empty() && constants.byteSize > 0) {
+        VkPushConstantRange pcRange;
+        pcRange.offset = 0;
+        pcRange.size = constants.byteSize;
+        pcRange.stageFlags = BgiVulkanConversions::GetShaderStages(
+            constants.stageUsage);
+        _pushConstantRanges.push_back(pcRange);
+    }
+    for (BgiGraphicsShaderConstantsRange const& range : constants.ranges) {
+        if (range.byteSize == 0) {
+            continue;
+        }
+        UTILS_VERIFY(range.byteOffset % 4 == 0 && range.byteSize % 4 == 0,
+            "Push constant range not multipes of 4");
+        UTILS_VERIFY(range.byteOffset + range.byteSize <= constants.byteSize,
+            "Push constant range exceeds the constants byteSize");
+        VkPushConstantRange pcRange;
+        pcRange.offset = range.byteOffset;
+        pcRange.size = range.byteSize;
+        pcRange.stageFlags = BgiVulkanConversions::GetShaderStages(
+            range.stageUsage);
+        _pushConstantRanges.push_back(pcRange);
+    }
+    _pushConstantRanges = _MergePushConstantRanges(_pushConstantRanges);
 
-    VkPipelineLayoutCreateInfo pipeLayCreateInfo =
-        {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-    pipeLayCreateInfo.pushConstantRangeCount = usePushConstants ? 1 : 0;
-    pipeLayCreateInfo.pPushConstantRanges = &pcRanges;
-
+    // Pipelines with identical resource layouts share their set layouts and
+    // pipeline layout through the device's layout cache.
     _vkDescriptorSetLayouts = BgiVulkanMakeDescriptorSetLayouts(
         device, descriptorSetInfos, desc.debugName);
-    pipeLayCreateInfo.setLayoutCount= (uint32_t) _vkDescriptorSetLayouts.size();
-    pipeLayCreateInfo.pSetLayouts = _vkDescriptorSetLayouts.data();
+    _vkPipelineLayout = device->GetLayoutCache()->AcquirePipelineLayout(
+        _vkDescriptorSetLayouts, _pushConstantRanges, desc.debugName);
 
-    UTILS_VERIFY(
-        vkCreatePipelineLayout(
-            _device->GetVulkanDevice(),
-            &pipeLayCreateInfo,
-            BgiVulkanAllocator(),
-            &_vkPipelineLayout) == VK_SUCCESS
-    );
-
-    // Debug label
-    if (!desc.debugName.empty()) {
-        std::string debugLabel = "PipelineLayout " + desc.debugName;
-        BgiVulkanSetDebugName(
-            device,
-            (uint64_t)_vkPipelineLayout,
-            VK_OBJECT_TYPE_PIPELINE_LAYOUT,
-            debugLabel.c_str());
-    }
+    BgiVulkanBindlessHeap* heap = device->GetBindlessHeap();
+    _usesBindlessHeap = heap &&
+        _vkDescriptorSetLayouts.size() > BgiVulkanBindlessHeap::SetIndex;
 
     pipeCreateInfo.layout = _vkPipelineLayout;
 
+    // Pipelines read their descriptors from the descriptor buffer when the
+    // device uses one.
+    if (device->GetDescriptorBuffer()) {
+        pipeCreateInfo.flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+    }
+
     //
     // RenderPass
     //
@@ -361,6 +421,11 @@ BgiVulkanGraphicsPipeline::BgiVulkanGraphicsPipeline(
             &_vkPipeline) == VK_SUCCESS
     );
 
+    if (_vkPipeline) {
+        device->GetMemoryTracker()->AddResource(
+            BgiMemoryResourceKindPipeline, 0);
+    }
+
     // Debug label
     if (!desc.debugName.empty()) {
         std::string debugLabel = "Pipeline " + desc.debugName;
@@ -386,21 +451,20 @@ BgiVulkanGraphicsPipeline::~BgiVulkanGraphicsPipeline()
         _vkRenderPass,
         BgiVulkanAllocator());
 
-    vkDestroyPipelineLayout(
-        _device->GetVulkanDevice(),
-        _vkPipelineLayout,
-        BgiVulkanAllocator());
+    if (_vkPipeline) {
+        _device->GetMemoryTracker()->RemoveResource(
+            BgiMemoryResourceKindPipeline, 0);
+    }
 
     vkDestroyPipeline(
         _device->GetVulkanDevice(),
         _vkPipeline,
         BgiVulkanAllocator());
 
+    BgiVulkanLayoutCache* layoutCache = _device->GetLayoutCache();
+    layoutCache->ReleasePipelineLayout(_vkPipelineLayout);
     for (VkDescriptorSetLayout layout : _vkDescriptorSetLayouts) {
-        vkDestroyDescriptorSetLayout(
-            _device->GetVulkanDevice(),
-            layout,
-            BgiVulkanAllocator());
+        layoutCache->ReleaseDescriptorSetLayout(layout);
     }
 }
 
@@ -408,6 +472,13 @@ void
 BgiVulkanGraphicsPipeline::BindPipeline(VkCommandBuffer cb)
 {
     vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, _vkPipeline);
+
+    // The bindless heap is update-after-bind, so it is bound once with the
+    // pipeline instead of per draw.
+    if (_usesBindlessHeap) {
+        _device->GetBindlessHeap()->BindDescriptors(
+            cb, VK_PIPELINE_BIND_POINT_GRAPHICS, _vkPipelineLayout);
+    }
 }
 
 VkPipelineLayout
@@ -416,12 +487,78 @@ BgiVulkanGraphicsPipeline::GetVulkanPipelineLayout() const
     return _vkPipelineLayout;
 }
 
+VkPushConstantRangeVector const&
+BgiVulkanGraphicsPipeline::GetPushConstantRanges() const
+{
+    return _pushConstantRanges;
+}
+
 VkRenderPass
 BgiVulkanGraphicsPipeline::GetVulkanRenderPass() const
 {
     return _vkRenderPass;
 }
 
+static bool
+_IsAttachmentCompatible(
+    BgiAttachmentDesc const& attachment,
+    BgiAttachmentDesc const& other)
+{
+    // The layouts of the render pass are derived from the usage. The store
+    // op of the render pass that was begun is the one that applies.
+    return attachment.format == other.format &&
+           attachment.usage == other.usage &&
+           attachment.storeOp == other.storeOp &&
+           (attachment.format == BgiFormatInvalid ||
+            attachment.loadOp != BgiAttachmentLoadOpClear);
+}
+
+static bool
+_AreAttachmentsCompatible(
+    BgiAttachmentDescVector const& attachments,
+    BgiAttachmentDescVector const& others)
+{
+    if (attachments.size() != others.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < attachments.size(); i++) {
+        if (!_IsAttachmentCompatible(attachments[i], others[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+BgiVulkanGraphicsPipeline::IsRenderPassCompatible(
+    BgiVulkanGraphicsPipeline const* other) const
+{
+    if (!other) {
+        return false;
+    }
+    if (other == this) {
+        return true;
+    }
+
+    BgiGraphicsPipelineDesc const& desc = _descriptor;
+    BgiGraphicsPipelineDesc const& otherDesc = other->_descriptor;
+
+    return desc.multiSampleState.sampleCount ==
+               otherDesc.multiSampleState.sampleCount &&
+           _AreAttachmentsCompatible(
+               desc.colorAttachmentDescs,
+               otherDesc.colorAttachmentDescs) &&
+           _AreAttachmentsCompatible(
+               desc.colorResolveAttachmentDescs,
+               otherDesc.colorResolveAttachmentDescs) &&
+           _IsAttachmentCompatible(
+               desc.depthAttachmentDesc,
+               otherDesc.depthAttachmentDesc) &&
+           _IsAttachmentCompatible(
+               desc.depthResolveAttachmentDesc,
+               otherDesc.depthResolveAttachmentDesc);
+}
+
 VkFramebuffer
 BgiVulkanGraphicsPipeline::AcquireVulkanFramebuffer(
         BgiGraphicsCmdsDesc const& gfxDesc,
@@ -19,6 +19,7 @@ namespace driver {
 class BgiVulkanDevice;
 
 using VkDescriptorSetLayoutVector = std::vector<VkDescriptorSetLayout>;
+using VkPushConstantRangeVector = std::vector<VkPushConstantRange>;
 using VkClearValueVector = std::vector<VkClearValue>;
 
 /// \class HgiVulkanPipeline
@@ -43,10 +44,21 @@ public:
     BGIVULKAN_API
     VkPipelineLayout GetVulkanPipelineLayout() const;
 
+    /// Returns the push constant ranges of the pipeline layout.
+    BGIVULKAN_API
+    VkPushConstantRangeVector const& GetPushConstantRanges() const;
+
     /// Returns the vulkan render pass
     BGIVULKAN_API
     VkRenderPass GetVulkanRenderPass() const;
 
+    /// Returns true if this pipeline can draw in a render pass that was begun
+    /// for 'other', so the render pass does not need to end between them.
+    /// Their attachments must match, and this pipeline must not clear any
+    /// attachment, since clears only happen when a render pass begins.
+    BGIVULKAN_API
+    bool IsRenderPassCompatible(BgiVulkanGraphicsPipeline const* other) const;
+
     /// Returns the vulkan frame buffer, creating it if needed.
     BGIVULKAN_API
     VkFramebuffer AcquireVulkanFramebuffer(
@@ -87,7 +99,9 @@ private:
     VkPipeline _vkPipeline;
     VkRenderPass _vkRenderPass;
     VkPipelineLayout _vkPipelineLayout;
+    VkPushConstantRangeVector _pushConstantRanges;
     VkDescriptorSetLayoutVector _vkDescriptorSetLayouts;
+    bool _usesBindlessHeap;
     VkClearValueVector _vkClearValues;
 
     std::vector<BgiVulkan_Framebuffer> _framebuffers;
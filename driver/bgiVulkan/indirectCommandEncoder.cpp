@@ -0,0 +1,234 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/indirectCommandEncoder.h"
+#include "driver/bgiVulkan/bgi.h"
+#include "driver/bgiVulkan/buffer.h"
+#include "driver/bgiVulkan/commandBuffer.h"
+#include "driver/bgiVulkan/computeCmds.h"
+#include "driver/bgiVulkan/graphicsCmds.h"
+
+#include <algorithm>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+BgiVulkanIndirectCommands::BgiVulkanIndirectCommands(
+    BgiVulkan* bgi,
+    uint32_t drawCount,
+    BgiGraphicsPipelineHandle const& graphicsPipeline,
+    BgiResourceBindingsHandle const& resourceBindings)
+    : BgiIndirectCommands(drawCount, graphicsPipeline, resourceBindings)
+    , bgi(bgi)
+    , stride(0)
+    , patchBaseVertexByteOffset(0)
+{
+}
+
+BgiVulkanIndirectCommands::~BgiVulkanIndirectCommands()
+{
+    // The garbage collector keeps the buffer alive until the command buffers
+    // that draw from it have completed.
+    if (drawParameterBuffer) {
+        bgi->DestroyBuffer(&drawParameterBuffer);
+    }
+}
+
+BgiVulkanIndirectCommandEncoder::BgiVulkanIndirectCommandEncoder(
+    BgiVulkan* bgi)
+    : BgiIndirectCommandEncoder()
+    , _bgi(bgi)
+{
+}
+
+BgiVulkanIndirectCommandEncoder::~BgiVulkanIndirectCommandEncoder() = default;
+
+BgiIndirectCommandsUniquePtr
+BgiVulkanIndirectCommandEncoder::EncodeDraw(
+    BgiComputeCmds * computeCmds,
+    BgiGraphicsPipelineHandle const& pipeline,
+    BgiResourceBindingsHandle const& resourceBindings,
+    BgiVertexBufferBindingVector const& vertexBindings,
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    uint32_t drawCount,
+    uint32_t stride)
+{
+    std::unique_ptr<BgiVulkanIndirectCommands> commands =
+        std::make_unique<BgiVulkanIndirectCommands>(
+            _bgi, drawCount, pipeline, resourceBindings);
+    commands->vertexBindings = vertexBindings;
+    commands->stride = stride;
+
+    _EncodeDrawParameters(
+        computeCmds,
+        drawParameterBuffer,
+        drawBufferByteOffset,
+        commands.get());
+
+    return commands;
+}
+
+BgiIndirectCommandsUniquePtr
+BgiVulkanIndirectCommandEncoder::EncodeDrawIndexed(
+    BgiComputeCmds * computeCmds,
+    BgiGraphicsPipelineHandle const& pipeline,
+    BgiResourceBindingsHandle const& resourceBindings,
+    BgiVertexBufferBindingVector const& vertexBindings,
+    BgiBufferHandle const& indexBuffer,
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    uint32_t drawCount,
+    uint32_t stride,
+    uint32_t patchBaseVertexByteOffset)
+{
+    std::unique_ptr<BgiVulkanIndirectCommands> commands =
+        std::make_unique<BgiVulkanIndirectCommands>(
+            _bgi, drawCount, pipeline, resourceBindings);
+    commands->vertexBindings = vertexBindings;
+    commands->indexBuffer = indexBuffer;
+    commands->stride = stride;
+    commands->patchBaseVertexByteOffset = patchBaseVertexByteOffset;
+
+    _EncodeDrawParameters(
+        computeCmds,
+        drawParameterBuffer,
+        drawBufferByteOffset,
+        commands.get());
+
+    return commands;
+}
+
+void
+BgiVulkanIndirectCommandEncoder::ExecuteDraw(
+    BgiGraphicsCmds * gfxCmds,
+    BgiIndirectCommands const* commands)
+{
+    BgiVulkanIndirectCommands const* vkCommands =
+        static_cast<BgiVulkanIndirectCommands const*>(commands);
+
+    if (!UTILS_VERIFY(gfxCmds && vkCommands)) {
+        return;
+    }
+
+    if (vkCommands->drawCount == 0 || !vkCommands->drawParameterBuffer) {
+        return;
+    }
+
+    gfxCmds->BindPipeline(vkCommands->graphicsPipeline);
+    if (vkCommands->resourceBindings) {
+        gfxCmds->BindResources(vkCommands->resourceBindings);
+    }
+    gfxCmds->BindVertexBuffers(vkCommands->vertexBindings);
+
+    if (vkCommands->indexBuffer) {
+        gfxCmds->DrawIndexedIndirect(
+            vkCommands->indexBuffer,
+            vkCommands->drawParameterBuffer,
+            0, // drawBufferByteOffset
+            vkCommands->drawCount,
+            vkCommands->stride,
+            std::vector<uint32_t>(),
+            vkCommands->patchBaseVertexByteOffset);
+    } else {
+        gfxCmds->DrawIndirect(
+            vkCommands->drawParameterBuffer,
+            0, // drawBufferByteOffset
+            vkCommands->drawCount,
+            vkCommands->stride);
+    }
+}
+
+void
+BgiVulkanIndirectCommandEncoder::_EncodeDrawParameters(
+    BgiComputeCmds * computeCmds,
+    BgiBufferHandle const& drawParameterBuffer,
+    uint32_t drawBufferByteOffset,
+    BgiVulkanIndirectCommands* commands)
+{
+    BgiVulkanComputeCmds* vkComputeCmds =
+        static_cast<BgiVulkanComputeCmds*>(computeCmds);
+    BgiVulkanBuffer* srcBuffer =
+        static_cast<BgiVulkanBuffer*>(drawParameterBuffer.Get());
+
+    if (!UTILS_VERIFY(vkComputeCmds && srcBuffer)) {
+        commands->drawCount = 0;
+        return;
+    }
+
+    size_t const srcByteSize = srcBuffer->GetByteSizeOfResource();
+    if (commands->drawCount == 0 || drawBufferByteOffset >= srcByteSize) {
+        commands->drawCount = 0;
+        return;
+    }
+
+    // Only draws that fit in the source buffer are replayed. The last draw
+    // may be smaller than the stride, so copy up to the end of the source
+    // buffer when the strided size runs past it.
+    VkDeviceSize const drawByteSize = commands->indexBuffer ?
+        sizeof(VkDrawIndexedIndirectCommand) : sizeof(VkDrawIndirectCommand);
+    // ExecuteDraw replays with the stride the copy is laid out with, so a
+    // stride of 0 (allowed for a single draw) still gives a valid one.
+    commands->stride = (uint32_t) std::max<VkDeviceSize>(
+        commands->stride, drawByteSize);
+    VkDeviceSize const stride = commands->stride;
+    VkDeviceSize const srcAvailable = srcByteSize - drawBufferByteOffset;
+    if (srcAvailable < drawByteSize) {
+        commands->drawCount = 0;
+        return;
+    }
+    commands->drawCount = (uint32_t) std::min<VkDeviceSize>(
+        commands->drawCount, (srcAvailable - drawByteSize) / stride + 1);
+
+    VkDeviceSize const byteSize = std::min<VkDeviceSize>(
+        (VkDeviceSize) commands->drawCount * stride, srcAvailable);
+
+    // The buffer is only read by the indirect draws, so it does not take a
+    // slot in the bindless heap.
+    BgiBufferDesc desc;
+    desc.debugName = "IndirectCommands " +
+        srcBuffer->GetDescriptor().debugName;
+    desc.usage = BgiBufferUsageIndirect;
+    desc.byteSize = byteSize;
+    commands->drawParameterBuffer = _bgi->CreateBuffer(desc);
+
+    BgiVulkanBuffer* dstBuffer =
+        static_cast<BgiVulkanBuffer*>(commands->drawParameterBuffer.Get());
+    VkCommandBuffer cb =
+        vkComputeCmds->GetCommandBuffer()->GetVulkanCommandBuffer();
+
+    // Wait for the compute shaders or uploads that wrote the draw parameters.
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask =
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(
+        cb,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = drawBufferByteOffset;
+    copyRegion.dstOffset = 0;
+    copyRegion.size = byteSize;
+    vkCmdCopyBuffer(
+        cb,
+        srcBuffer->GetVulkanBuffer(),
+        dstBuffer->GetVulkanBuffer(),
+        1,
+        &copyRegion);
+
+    // Make the copy visible to the indirect draws that replay the commands.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+        cb,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/indirectCommandEncoder.h"
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkan;
+
+/// \struct BgiVulkanIndirectCommands
+///
+/// The state of a batch of draws encoded by BgiVulkanIndirectCommandEncoder.
+/// The draw parameters are held in a GPU buffer that belongs to the
+/// commands and is destroyed with them.
+///
+struct BgiVulkanIndirectCommands final : public BgiIndirectCommands
+{
+    BGIVULKAN_API
+    BgiVulkanIndirectCommands(
+        BgiVulkan* bgi,
+        uint32_t drawCount,
+        BgiGraphicsPipelineHandle const& graphicsPipeline,
+        BgiResourceBindingsHandle const& resourceBindings);
+
+    BGIVULKAN_API
+    ~BgiVulkanIndirectCommands() override;
+
+    BgiVulkan* bgi;
+    BgiVertexBufferBindingVector vertexBindings;
+    BgiBufferHandle indexBuffer;
+    BgiBufferHandle drawParameterBuffer;
+    uint32_t stride;
+    uint32_t patchBaseVertexByteOffset;
+};
+
+/// \class BgiVulkanIndirectCommandEncoder
+///
+/// Vulkan implementation of BgiIndirectCommandEncoder.
+///
+/// Encoding copies the draw parameters, which may have been written by
+/// compute shaders, into a GPU buffer of the commands on the command buffer
+/// of the compute cmds. No data goes back to the CPU. ExecuteDraw binds the
+/// captured pipeline, resources and vertex buffers and replays all draws
+/// with a single vkCmdDrawIndirect or vkCmdDrawIndexedIndirect.
+///
+class BgiVulkanIndirectCommandEncoder final : public BgiIndirectCommandEncoder
+{
+public:
+    BGIVULKAN_API
+    ~BgiVulkanIndirectCommandEncoder() override;
+
+    BGIVULKAN_API
+    BgiIndirectCommandsUniquePtr EncodeDraw(
+        BgiComputeCmds * computeCmds,
+        BgiGraphicsPipelineHandle const& pipeline,
+        BgiResourceBindingsHandle const& resourceBindings,
+        BgiVertexBufferBindingVector const& vertexBindings,
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        uint32_t drawCount,
+        uint32_t stride) override;
+
+    BGIVULKAN_API
+    BgiIndirectCommandsUniquePtr EncodeDrawIndexed(
+        BgiComputeCmds * computeCmds,
+        BgiGraphicsPipelineHandle const& pipeline,
+        BgiResourceBindingsHandle const& resourceBindings,
+        BgiVertexBufferBindingVector const& vertexBindings,
+        BgiBufferHandle const& indexBuffer,
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        uint32_t drawCount,
+        uint32_t stride,
+        uint32_t patchBaseVertexByteOffset) override;
+
+    BGIVULKAN_API
+    void ExecuteDraw(
+        BgiGraphicsCmds * gfxCmds,
+        BgiIndirectCommands const* commands) override;
+
+protected:
+    friend class BgiVulkan;
+
+    BGIVULKAN_API
+    BgiVulkanIndirectCommandEncoder(BgiVulkan* bgi);
+
+private:
+    BgiVulkanIndirectCommandEncoder() = delete;
+    BgiVulkanIndirectCommandEncoder & operator=(
+        const BgiVulkanIndirectCommandEncoder&) = delete;
+    BgiVulkanIndirectCommandEncoder(
+        const BgiVulkanIndirectCommandEncoder&) = delete;
+
+    // Copies the draw parameters into a buffer owned by 'commands'.
+    void _EncodeDrawParameters(
+        BgiComputeCmds * computeCmds,
+        BgiBufferHandle const& drawParameterBuffer,
+        uint32_t drawBufferByteOffset,
+        BgiVulkanIndirectCommands* commands);
+
+    BgiVulkan* _bgi;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -3,6 +3,8 @@
 #include "driver/bgiVulkan/instance.h"
 #include "driver/bgiVulkan/diagnostic.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
@@ -14,7 +16,12 @@ BgiVulkanInstance::BgiVulkanInstance()
     , vkCreateDebugUtilsMessengerEXT(nullptr)
     , vkDestroyDebugUtilsMessengerEXT(nullptr)
     , _vkInstance(nullptr)
+    , _headless(false)
 {
+    if (const char* headless = std::getenv("GUNGNIR_VULKAN_HEADLESS")) {
+        _headless = std::strcmp(headless, "0") != 0;
+    }
+
     VkApplicationInfo appInfo = {VK_STRUCTURE_TYPE_APPLICATION_INFO};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName = "GungnirEngine";
@@ -28,25 +35,27 @@ BgiVulkanInstance::BgiVulkanInstance()
 
     // Setup instance extensions.
     std::vector<const char*> extensions = {
-        VK_KHR_SURFACE_EXTENSION_NAME,
+        // Extensions for interop with OpenGL
+        VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME,
+        VK_KHR_EXTERNAL_SEMAPHORE_CAPABILITIES_EXTENSION_NAME,
+
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
+    };
+
+    if (!_headless) {
+        extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 
         // Pick platform specific surface extension
         #if defined(VK_USE_PLATFORM_WIN32_KHR)
-            VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
+            extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
         #elif defined(VK_USE_PLATFORM_XLIB_KHR)
-            VK_KHR_XLIB_SURFACE_EXTENSION_NAME,
+            extensions.push_back(VK_KHR_XLIB_SURFACE_EXTENSION_NAME);
         #elif defined(VK_USE_PLATFORM_MACOS_MVK)
-            VK_MVK_MACOS_SURFACE_EXTENSION_NAME,
+            extensions.push_back(VK_MVK_MACOS_SURFACE_EXTENSION_NAME);
         #else
             #error Unsupported Platform
         #endif
-
-        // Extensions for interop with OpenGL
-        VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME,
-        VK_KHR_EXTERNAL_SEMAPHORE_CAPABILITIES_EXTENSION_NAME,
-
-        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
-    };
+    }
 
     // Enable validation layers extension.
     // Requires VK_LAYER_PATH to be set.
@@ -83,6 +92,12 @@ BgiVulkanInstance::GetVulkanInstance() const
     return _vkInstance;
 }
 
+bool
+BgiVulkanInstance::IsHeadless() const
+{
+    return _headless;
+}
+
 }
 
 GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -26,6 +26,14 @@ public:
     BGIVULKAN_API
     VkInstance const& GetVulkanInstance() const;
 
+    /// Returns true if the instance was created without surface extensions
+    /// because the GUNGNIR_VULKAN_HEADLESS environment variable is set to a
+    /// value other than 0. Devices of a headless instance do not need to
+    /// support presentation, e.g. software implementations like lavapipe
+    /// without a display.
+    BGIVULKAN_API
+    bool IsHeadless() const;
+
     /// Instance Extension function pointers
     VkDebugUtilsMessengerEXT vkDebugMessenger = 0;
     PFN_vkCreateDebugUtilsMessengerEXT vkCreateDebugUtilsMessengerEXT = 0;
@@ -33,6 +41,7 @@ public:
 
 private:
     VkInstance _vkInstance;
+    bool _headless;
 };
 
 }
@@ -0,0 +1,421 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/layoutCache.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/device.h"
+#include "driver/bgiVulkan/diagnostic.h"
+
+#include <algorithm>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+size_t
+BgiVulkanLayoutCache::_KeyHash::operator()(_Key const& key) const
+{
+    // FNV-1a over the key words.
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t word : key) {
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    return (size_t)hash;
+}
+
+BgiVulkanLayoutCache::BgiVulkanLayoutCache(BgiVulkanDevice* device)
+    : _device(device)
+{
+}
+
+BgiVulkanLayoutCache::~BgiVulkanLayoutCache()
+{
+    // Pipelines and resource bindings the client never destroyed still hold
+    // references. Clean those layouts up before the device goes away.
+    for (auto const& pair : _templates) {
+        vkDestroyDescriptorUpdateTemplate(
+            _device->GetVulkanDevice(),
+            pair.second,
+            BgiVulkanAllocator());
+    }
+
+    for (auto const& pair : _pipelineLayouts) {
+        vkDestroyPipelineLayout(
+            _device->GetVulkanDevice(),
+            pair.second.handle,
+            BgiVulkanAllocator());
+    }
+
+    for (auto const& pair : _setLayouts) {
+        vkDestroyDescriptorSetLayout(
+            _device->GetVulkanDevice(),
+            pair.second.handle,
+            BgiVulkanAllocator());
+    }
+}
+
+VkDescriptorSetLayout
+BgiVulkanLayoutCache::AcquireDescriptorSetLayout(
+    VkDescriptorSetLayoutBindingVector const& bindings,
+    VkDescriptorSetLayoutCreateFlags flags,
+    std::string const& debugName,
+    VkDescriptorBindingFlagsVector const& bindingFlags)
+{
+    UTILS_VERIFY(bindingFlags.empty() ||
+        bindingFlags.size() == bindings.size());
+
+    // Sort the bindings so that the same set of bindings provided in a
+    // different order resolves to the same layout.
+    std::vector<size_t> order(bindings.size());
+    for (size_t i=0; i<order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+        [&bindings](size_t a, size_t b) {
+            return bindings[a].binding < bindings[b].binding;
+        });
+
+    VkDescriptorSetLayoutBindingVector sorted;
+    VkDescriptorBindingFlagsVector sortedFlags;
+    sorted.reserve(bindings.size());
+    for (size_t i : order) {
+        sorted.push_back(bindings[i]);
+        if (!bindingFlags.empty()) {
+            sortedFlags.push_back(bindingFlags[i]);
+        }
+    }
+
+    // Descriptor buffer layouts have no pool to update after bind from and
+    // their descriptors are always read at execution time. They cannot hold
+    // dynamic buffers either, BgiVulkanResourceBindings emulates those.
+    if (_device->GetDeviceCapabilities().supportsDescriptorBuffer) {
+        flags &= ~VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+        for (VkDescriptorBindingFlags& bindingFlag : sortedFlags) {
+            bindingFlag &= ~VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        }
+        for (VkDescriptorSetLayoutBinding& bi : sorted) {
+            if (bi.descriptorType ==
+                    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+                bi.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            } else if (bi.descriptorType ==
+                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) {
+                bi.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+        }
+    }
+
+    _Key key;
+    key.reserve(1 + sorted.size() * 5);
+    key.push_back(flags);
+    for (size_t i=0; i<sorted.size(); i++) {
+        VkDescriptorSetLayoutBinding const& bi = sorted[i];
+        // Immutable samplers are not part of the key.
+        UTILS_VERIFY(!bi.pImmutableSamplers,
+            "Immutable samplers are not supported by the layout cache");
+        key.push_back(bi.binding);
+        key.push_back(bi.descriptorType);
+        key.push_back(bi.descriptorCount);
+        key.push_back(bi.stageFlags);
+        key.push_back(sortedFlags.empty() ? 0 : sortedFlags[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _setLayouts.find(key);
+    if (it != _setLayouts.end()) {
+        it->second.refCount++;
+        return it->second.handle;
+    }
+
+    VkDescriptorSetLayoutCreateInfo createInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    createInfo.flags = flags;
+    createInfo.bindingCount = (uint32_t) sorted.size();
+    createInfo.pBindings = sorted.data();
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsCreateInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+    if (!sortedFlags.empty()) {
+        flagsCreateInfo.bindingCount = (uint32_t) sortedFlags.size();
+        flagsCreateInfo.pBindingFlags = sortedFlags.data();
+        createInfo.pNext = &flagsCreateInfo;
+    }
+
+    VkDescriptorSetLayout layout = nullptr;
+    UTILS_VERIFY(
+        vkCreateDescriptorSetLayout(
+            _device->GetVulkanDevice(),
+            &createInfo,
+            BgiVulkanAllocator(),
+            &layout) == VK_SUCCESS
+    );
+
+    // Debug label
+    if (!debugName.empty()) {
+        std::string debugLabel = "DescriptorSetLayout " + debugName;
+        BgiVulkanSetDebugName(
+            _device,
+            (uint64_t)layout,
+            VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+            debugLabel.c_str());
+    }
+
+    _setLayoutKeys.emplace(layout, key);
+    _setLayouts.emplace(
+        std::move(key), _Entry<VkDescriptorSetLayout>{layout, 1});
+
+    return layout;
+}
+
+void
+BgiVulkanLayoutCache::ReleaseDescriptorSetLayout(VkDescriptorSetLayout layout)
+{
+    if (!layout) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto keyIt = _setLayoutKeys.find(layout);
+    if (!UTILS_VERIFY(keyIt != _setLayoutKeys.end(),
+            "Releasing descriptor set layout not owned by the cache")) {
+        return;
+    }
+
+    auto it = _setLayouts.find(keyIt->second);
+    if (--it->second.refCount > 0) {
+        return;
+    }
+
+    _DestroyTemplates(layout, nullptr);
+
+    vkDestroyDescriptorSetLayout(
+        _device->GetVulkanDevice(),
+        layout,
+        BgiVulkanAllocator());
+
+    _setLayouts.erase(it);
+    _setLayoutKeys.erase(keyIt);
+}
+
+VkPipelineLayout
+BgiVulkanLayoutCache::AcquirePipelineLayout(
+    VkDescriptorSetLayoutVector const& setLayouts,
+    VkPushConstantRangeVector const& pushConstantRanges,
+    std::string const& debugName)
+{
+    // Set layouts are deduplicated by this cache, so their handles identify
+    // their contents. The order of the sets is significant.
+    _Key key;
+    key.reserve(2 + setLayouts.size() + pushConstantRanges.size() * 3);
+    key.push_back(setLayouts.size());
+    for (VkDescriptorSetLayout setLayout : setLayouts) {
+        key.push_back((uint64_t)setLayout);
+    }
+    key.push_back(pushConstantRanges.size());
+    for (VkPushConstantRange const& range : pushConstantRanges) {
+        key.push_back(range.stageFlags);
+        key.push_back(range.offset);
+        key.push_back(range.size);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _pipelineLayouts.find(key);
+    if (it != _pipelineLayouts.end()) {
+        it->second.refCount++;
+        return it->second.handle;
+    }
+
+    VkPipelineLayoutCreateInfo createInfo =
+        {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    createInfo.setLayoutCount = (uint32_t) setLayouts.size();
+    createInfo.pSetLayouts = setLayouts.data();
+    createInfo.pushConstantRangeCount = (uint32_t) pushConstantRanges.size();
+    createInfo.pPushConstantRanges = pushConstantRanges.data();
+
+    VkPipelineLayout layout = nullptr;
+    UTILS_VERIFY(
+        vkCreatePipelineLayout(
+            _device->GetVulkanDevice(),
+            &createInfo,
+            BgiVulkanAllocator(),
+            &layout) == VK_SUCCESS
+    );
+
+    // Debug label
+    if (!debugName.empty()) {
+        std::string debugLabel = "PipelineLayout " + debugName;
+        BgiVulkanSetDebugName(
+            _device,
+            (uint64_t)layout,
+            VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+            debugLabel.c_str());
+    }
+
+    _pipelineLayoutKeys.emplace(layout, key);
+    _pipelineLayouts.emplace(
+        std::move(key), _Entry<VkPipelineLayout>{layout, 1});
+
+    return layout;
+}
+
+void
+BgiVulkanLayoutCache::ReleasePipelineLayout(VkPipelineLayout layout)
+{
+    if (!layout) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto keyIt = _pipelineLayoutKeys.find(layout);
+    if (!UTILS_VERIFY(keyIt != _pipelineLayoutKeys.end(),
+            "Releasing pipeline layout not owned by the cache")) {
+        return;
+    }
+
+    auto it = _pipelineLayouts.find(keyIt->second);
+    if (--it->second.refCount > 0) {
+        return;
+    }
+
+    _DestroyTemplates(nullptr, layout);
+
+    vkDestroyPipelineLayout(
+        _device->GetVulkanDevice(),
+        layout,
+        BgiVulkanAllocator());
+
+    _pipelineLayouts.erase(it);
+    _pipelineLayoutKeys.erase(keyIt);
+}
+
+VkDescriptorSetLayoutCreateFlags
+BgiVulkanLayoutCache::GetResourceSetLayoutFlags(
+    VkDescriptorSetLayoutBindingVector const& bindings) const
+{
+    BgiVulkanCapabilities const& caps = _device->GetDeviceCapabilities();
+    if (!caps.supportsPushDescriptors || caps.supportsDescriptorBuffer) {
+        return 0;
+    }
+
+    // Push descriptor sets cannot hold dynamic buffers.
+    uint32_t descriptorCount = 0;
+    for (VkDescriptorSetLayoutBinding const& bi : bindings) {
+        if (bi.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+            bi.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) {
+            return 0;
+        }
+        descriptorCount += bi.descriptorCount;
+    }
+
+    if (descriptorCount == 0 ||
+        descriptorCount > caps.vkPushDescriptorProperties.maxPushDescriptors) {
+        return 0;
+    }
+
+    return VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+}
+
+VkDescriptorUpdateTemplate
+BgiVulkanLayoutCache::GetDescriptorUpdateTemplate(
+    VkDescriptorSetLayout setLayout,
+    VkPipelineBindPoint bindPoint,
+    VkPipelineLayout pipelineLayout)
+{
+    // The bind point only matters for push templates.
+    const _TemplateKey templateKey(
+        setLayout,
+        pipelineLayout,
+        pipelineLayout ? bindPoint : VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _templates.find(templateKey);
+    if (it != _templates.end()) {
+        return it->second;
+    }
+
+    auto keyIt = _setLayoutKeys.find(setLayout);
+    if (!UTILS_VERIFY(keyIt != _setLayoutKeys.end(),
+            "Descriptor set layout not owned by the cache")) {
+        return nullptr;
+    }
+
+    // The set layout key holds the flags followed by the sorted bindings, see
+    // AcquireDescriptorSetLayout.
+    _Key const& key = keyIt->second;
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+    size_t offset = 0;
+    for (size_t i=1; i+4<key.size(); i+=5) {
+        const uint32_t count = (uint32_t) key[i+2];
+        if (count == 0) {
+            continue;
+        }
+        VkDescriptorUpdateTemplateEntry entry;
+        entry.dstBinding = (uint32_t) key[i];
+        entry.dstArrayElement = 0;
+        entry.descriptorCount = count;
+        entry.descriptorType = (VkDescriptorType) key[i+1];
+        entry.offset = offset * sizeof(BgiVulkanDescriptorInfo);
+        entry.stride = sizeof(BgiVulkanDescriptorInfo);
+        entries.push_back(entry);
+        offset += count;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo =
+        {VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO};
+    createInfo.descriptorUpdateEntryCount = (uint32_t) entries.size();
+    createInfo.pDescriptorUpdateEntries = entries.data();
+    createInfo.descriptorSetLayout = setLayout;
+    if (pipelineLayout) {
+        createInfo.templateType =
+            VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+        createInfo.pipelineBindPoint = bindPoint;
+        createInfo.pipelineLayout = pipelineLayout;
+        createInfo.set = 0;
+    } else {
+        createInfo.templateType =
+            VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    }
+
+    VkDescriptorUpdateTemplate updateTemplate = nullptr;
+    UTILS_VERIFY(
+        vkCreateDescriptorUpdateTemplate(
+            _device->GetVulkanDevice(),
+            &createInfo,
+            BgiVulkanAllocator(),
+            &updateTemplate) == VK_SUCCESS
+    );
+
+    _templates.emplace(templateKey, updateTemplate);
+
+    return updateTemplate;
+}
+
+void
+BgiVulkanLayoutCache::_DestroyTemplates(
+    VkDescriptorSetLayout setLayout,
+    VkPipelineLayout pipelineLayout)
+{
+    for (auto it = _templates.begin(); it != _templates.end(); ) {
+        const bool matches =
+            (setLayout && std::get<0>(it->first) == setLayout) ||
+            (pipelineLayout && std::get<1>(it->first) == pipelineLayout);
+        if (matches) {
+            vkDestroyDescriptorUpdateTemplate(
+                _device->GetVulkanDevice(),
+                it->second,
+                BgiVulkanAllocator());
+            it = _templates.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
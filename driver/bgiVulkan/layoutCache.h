@@ -0,0 +1,167 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkanDevice;
+
+using VkDescriptorSetLayoutBindingVector =
+    std::vector<VkDescriptorSetLayoutBinding>;
+using VkDescriptorSetLayoutVector = std::vector<VkDescriptorSetLayout>;
+using VkPushConstantRangeVector = std::vector<VkPushConstantRange>;
+using VkDescriptorBindingFlagsVector = std::vector<VkDescriptorBindingFlags>;
+
+/// One descriptor of the packed data read by the descriptor update templates
+/// of the layout cache. Buffer and image infos share a slot, so the data of a
+/// set is a flat array with one entry per descriptor, ordered by binding.
+union BgiVulkanDescriptorInfo
+{
+    VkDescriptorBufferInfo buffer;
+    VkDescriptorImageInfo image;
+};
+
+using BgiVulkanDescriptorInfoVector = std::vector<BgiVulkanDescriptorInfo>;
+
+/// \class BgiVulkanLayoutCache
+///
+/// Device-level cache of descriptor set layouts and pipeline layouts.
+///
+/// Layouts are keyed by a hash of their contents (bindings, descriptor types,
+/// counts, stage flags and push constant ranges) and are reference counted.
+/// Identical layouts resolve to the same vulkan handle, so pipelines built
+/// from shaders with matching resources share one VkPipelineLayout and stay
+/// compatible: descriptor sets bound for one pipeline remain bound when
+/// switching to another.
+///
+/// Every Acquire must be balanced by a Release of the returned handle. The
+/// vulkan object is destroyed when its last reference is released, so callers
+/// must only release once the GPU no longer uses the layout (i.e. from
+/// objects destroyed by the garbage collector).
+///
+/// Thread safety: Acquire and Release may be called from multiple threads.
+///
+class BgiVulkanLayoutCache final
+{
+public:
+    BGIVULKAN_API
+    BgiVulkanLayoutCache(BgiVulkanDevice* device);
+
+    BGIVULKAN_API
+    ~BgiVulkanLayoutCache();
+
+    /// Returns a descriptor set layout for the provided bindings, creating it
+    /// if no identical layout exists yet. The order of the bindings does not
+    /// matter. 'debugName' is only used when the layout is created.
+    /// 'bindingFlags' is either empty or holds the descriptor indexing flags
+    /// of each of the bindings.
+    /// When the device uses descriptor buffers every layout is created as a
+    /// descriptor buffer layout and update-after-bind flags are dropped.
+    BGIVULKAN_API
+    VkDescriptorSetLayout AcquireDescriptorSetLayout(
+        VkDescriptorSetLayoutBindingVector const& bindings,
+        VkDescriptorSetLayoutCreateFlags flags,
+        std::string const& debugName,
+        VkDescriptorBindingFlagsVector const& bindingFlags = {});
+
+    /// Releases a reference obtained with AcquireDescriptorSetLayout.
+    BGIVULKAN_API
+    void ReleaseDescriptorSetLayout(VkDescriptorSetLayout layout);
+
+    /// Returns a pipeline layout for the provided set layouts and push
+    /// constant ranges, creating it if no identical layout exists yet.
+    /// 'debugName' is only used when the layout is created.
+    BGIVULKAN_API
+    VkPipelineLayout AcquirePipelineLayout(
+        VkDescriptorSetLayoutVector const& setLayouts,
+        VkPushConstantRangeVector const& pushConstantRanges,
+        std::string const& debugName);
+
+    /// Releases a reference obtained with AcquirePipelineLayout.
+    BGIVULKAN_API
+    void ReleasePipelineLayout(VkPipelineLayout layout);
+
+    /// Returns the create flags of the resource set (set 0) layout with the
+    /// provided bindings. Small sets are push descriptor sets when the device
+    /// supports VK_KHR_push_descriptor and does not use descriptor buffers.
+    /// Pipelines and resource bindings both derive the flags from the
+    /// bindings, so their layouts stay identical.
+    BGIVULKAN_API
+    VkDescriptorSetLayoutCreateFlags GetResourceSetLayoutFlags(
+        VkDescriptorSetLayoutBindingVector const& bindings) const;
+
+    /// Returns a descriptor update template for a set layout acquired from
+    /// this cache. The template reads a BgiVulkanDescriptorInfoVector holding
+    /// descriptorCount infos for each binding of the layout, in increasing
+    /// binding order.
+    /// If 'pipelineLayout' is null the template updates descriptor sets,
+    /// otherwise it pushes descriptors for set 0 of 'pipelineLayout' at
+    /// 'bindPoint'.
+    /// The template is owned by the cache and remains valid while the set
+    /// layout (and pipeline layout) are referenced.
+    BGIVULKAN_API
+    VkDescriptorUpdateTemplate GetDescriptorUpdateTemplate(
+        VkDescriptorSetLayout setLayout,
+        VkPipelineBindPoint bindPoint,
+        VkPipelineLayout pipelineLayout);
+
+private:
+    BgiVulkanLayoutCache() = delete;
+    BgiVulkanLayoutCache & operator=(const BgiVulkanLayoutCache&) = delete;
+    BgiVulkanLayoutCache(const BgiVulkanLayoutCache&) = delete;
+
+    // The contents of a layout flattened into words. Used as the map key so
+    // hash collisions fall back to a full comparison.
+    using _Key = std::vector<uint64_t>;
+
+    struct _KeyHash
+    {
+        size_t operator()(_Key const& key) const;
+    };
+
+    template <class T>
+    struct _Entry
+    {
+        T handle;
+        uint32_t refCount;
+    };
+
+    using _SetLayoutMap =
+        std::unordered_map<_Key, _Entry<VkDescriptorSetLayout>, _KeyHash>;
+    using _PipelineLayoutMap =
+        std::unordered_map<_Key, _Entry<VkPipelineLayout>, _KeyHash>;
+
+    BgiVulkanDevice* _device;
+
+    std::mutex _mutex;
+    _SetLayoutMap _setLayouts;
+    std::unordered_map<VkDescriptorSetLayout, _Key> _setLayoutKeys;
+    _PipelineLayoutMap _pipelineLayouts;
+    std::unordered_map<VkPipelineLayout, _Key> _pipelineLayoutKeys;
+
+    using _TemplateKey = std::tuple<
+        VkDescriptorSetLayout, VkPipelineLayout, VkPipelineBindPoint>;
+    std::map<_TemplateKey, VkDescriptorUpdateTemplate> _templates;
+
+    // Destroys the templates of a layout that is being destroyed.
+    // Must be called with _mutex held.
+    void _DestroyTemplates(
+        VkDescriptorSetLayout setLayout,
+        VkPipelineLayout pipelineLayout);
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
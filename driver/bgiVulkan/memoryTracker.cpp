@@ -0,0 +1,157 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/memoryTracker.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/device.h"
+
+#include <algorithm>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+static void
+_AtomicMax(std::atomic<uint64_t>& value, uint64_t candidate)
+{
+    uint64_t current = value.load(std::memory_order_relaxed);
+    while (current < candidate &&
+           !value.compare_exchange_weak(
+               current, candidate, std::memory_order_relaxed)) {
+    }
+}
+
+BgiVulkanMemoryTracker::BgiVulkanMemoryTracker(
+    BgiVulkanDevice* device,
+    bool budgetQueried)
+    : _device(device)
+    , _budgetQueried(budgetQueried)
+    , _frameNumber(0)
+{
+    std::fill_n(_peakHeapUsage, VK_MAX_MEMORY_HEAPS, 0);
+}
+
+BgiVulkanMemoryTracker::~BgiVulkanMemoryTracker() = default;
+
+void
+BgiVulkanMemoryTracker::AddResource(
+    BgiMemoryResourceKind kind,
+    uint64_t byteSize)
+{
+    _Counter& counter = _counters[kind];
+
+    uint64_t const count =
+        counter.count.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t const bytes = counter.byteSize.fetch_add(
+        byteSize, std::memory_order_relaxed) + byteSize;
+
+    _AtomicMax(counter.frameHighWaterCount, count);
+    _AtomicMax(counter.frameHighWaterByteSize, bytes);
+    _AtomicMax(counter.peakCount, count);
+    _AtomicMax(counter.peakByteSize, bytes);
+}
+
+void
+BgiVulkanMemoryTracker::RemoveResource(
+    BgiMemoryResourceKind kind,
+    uint64_t byteSize)
+{
+    _Counter& counter = _counters[kind];
+    counter.count.fetch_sub(1, std::memory_order_relaxed);
+    counter.byteSize.fetch_sub(byteSize, std::memory_order_relaxed);
+}
+
+uint64_t
+BgiVulkanMemoryTracker::GetAllocationByteSize(VmaAllocation allocation) const
+{
+    if (!allocation) {
+        return 0;
+    }
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(
+        _device->GetVulkanMemoryAllocator(), allocation, &info);
+    return info.size;
+}
+
+void
+BgiVulkanMemoryTracker::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // The next frame starts at the current values, the high-water marks of
+    // the frame that ended are kept for GetStats.
+    for (int i = 0; i < BgiMemoryResourceKindCount; i++) {
+        _Counter& counter = _counters[i];
+        _FrameHighWater& highWater = _frameHighWaters[i];
+        highWater.count = counter.frameHighWaterCount.exchange(
+            counter.count.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+        highWater.byteSize = counter.frameHighWaterByteSize.exchange(
+            counter.byteSize.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+    }
+
+    // VMA refreshes its cached budgets when the frame index changes.
+    _frameNumber++;
+    VmaAllocator const vma = _device->GetVulkanMemoryAllocator();
+    vmaSetCurrentFrameIndex(vma, uint32_t(_frameNumber));
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(vma, budgets);
+    uint32_t const heapCount =
+        _device->GetDeviceCapabilities().vkMemoryProperties.memoryHeapCount;
+    for (uint32_t i = 0; i < heapCount; i++) {
+        _peakHeapUsage[i] = std::max(_peakHeapUsage[i], budgets[i].usage);
+    }
+}
+
+void
+BgiVulkanMemoryTracker::GetStats(BgiMemoryStats* stats) const
+{
+    if (!UTILS_VERIFY(stats)) {
+        return;
+    }
+
+    VkPhysicalDeviceMemoryProperties const& memoryProperties =
+        _device->GetDeviceCapabilities().vkMemoryProperties;
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(_device->GetVulkanMemoryAllocator(), budgets);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    stats->frameNumber = _frameNumber;
+    stats->budgetQueried = _budgetQueried;
+
+    stats->heaps.resize(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        VkMemoryHeap const& vkHeap = memoryProperties.memoryHeaps[i];
+        VmaBudget const& budget = budgets[i];
+        _peakHeapUsage[i] = std::max(_peakHeapUsage[i], budget.usage);
+
+        BgiMemoryHeapStats& heap = stats->heaps[i];
+        heap.deviceLocal =
+            (vkHeap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heap.size = vkHeap.size;
+        heap.budget = budget.budget;
+        heap.usage = budget.usage;
+        heap.blockBytes = budget.statistics.blockBytes;
+        heap.allocationBytes = budget.statistics.allocationBytes;
+        heap.peakUsage = _peakHeapUsage[i];
+    }
+
+    for (int i = 0; i < BgiMemoryResourceKindCount; i++) {
+        _Counter const& counter = _counters[i];
+        BgiMemoryResourceStats& resource = stats->resources[i];
+        resource.count = counter.count.load(std::memory_order_relaxed);
+        resource.byteSize = counter.byteSize.load(std::memory_order_relaxed);
+        resource.frameHighWaterCount = _frameHighWaters[i].count;
+        resource.frameHighWaterByteSize = _frameHighWaters[i].byteSize;
+        resource.peakCount = counter.peakCount.load(std::memory_order_relaxed);
+        resource.peakByteSize =
+            counter.peakByteSize.load(std::memory_order_relaxed);
+    }
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
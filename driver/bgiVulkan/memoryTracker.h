@@ -0,0 +1,99 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/memoryStats.h"
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+#include <atomic>
+#include <mutex>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkanDevice;
+
+/// \class BgiVulkanMemoryTracker
+///
+/// Accounts the memory of a device. Resources report their creation and
+/// destruction per BgiMemoryResourceKind, heap usage and budgets are read
+/// from the VMA allocator, which queries VK_EXT_memory_budget if the device
+/// supports it.
+///
+/// Counting takes no locks, so resources can be created and destroyed from
+/// any thread.
+///
+class BgiVulkanMemoryTracker final
+{
+public:
+    BGIVULKAN_API
+    BgiVulkanMemoryTracker(BgiVulkanDevice* device, bool budgetQueried);
+
+    BGIVULKAN_API
+    ~BgiVulkanMemoryTracker();
+
+    /// Counts a resource of 'kind' that holds 'byteSize' bytes.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void AddResource(BgiMemoryResourceKind kind, uint64_t byteSize);
+
+    /// Removes a resource counted by AddResource with the same arguments.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void RemoveResource(BgiMemoryResourceKind kind, uint64_t byteSize);
+
+    /// Returns the bytes of device memory held by 'allocation'.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    uint64_t GetAllocationByteSize(VmaAllocation allocation) const;
+
+    /// Keeps the high-water marks of the frame that ended, starts those of
+    /// the next frame and refreshes the heap budgets.
+    /// Thread safety: No. Must be called from the main thread.
+    BGIVULKAN_API
+    void EndFrame();
+
+    /// Fills 'stats' with the current heap usage and live resources.
+    /// Thread safety: Yes.
+    BGIVULKAN_API
+    void GetStats(BgiMemoryStats* stats) const;
+
+private:
+    BgiVulkanMemoryTracker() = delete;
+    BgiVulkanMemoryTracker & operator=(const BgiVulkanMemoryTracker&) = delete;
+    BgiVulkanMemoryTracker(const BgiVulkanMemoryTracker&) = delete;
+
+    // The live resources of one kind. The frame high-water marks are those
+    // of the frame in progress.
+    struct _Counter
+    {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> byteSize{0};
+        std::atomic<uint64_t> frameHighWaterCount{0};
+        std::atomic<uint64_t> frameHighWaterByteSize{0};
+        std::atomic<uint64_t> peakCount{0};
+        std::atomic<uint64_t> peakByteSize{0};
+    };
+
+    // The high-water marks of the last completed frame.
+    struct _FrameHighWater
+    {
+        uint64_t count = 0;
+        uint64_t byteSize = 0;
+    };
+
+    BgiVulkanDevice* _device;
+    bool _budgetQueried;
+    _Counter _counters[BgiMemoryResourceKindCount];
+
+    mutable std::mutex _mutex;
+    uint64_t _frameNumber;
+    _FrameHighWater _frameHighWaters[BgiMemoryResourceKindCount];
+    mutable uint64_t _peakHeapUsage[VK_MAX_MEMORY_HEAPS];
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
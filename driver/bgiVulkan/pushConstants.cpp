@@ -0,0 +1,146 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/pushConstants.h"
+
+#include <algorithm>
+#include <cstring>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+static void
+_PushValues(
+    VkCommandBuffer cb,
+    VkPipelineLayout layout,
+    VkShaderStageFlags stages,
+    uint32_t begin,
+    uint32_t end,
+    const uint8_t* data)
+{
+    if (stages && end > begin) {
+        vkCmdPushConstants(cb, layout, stages, begin, end - begin, data+begin);
+    }
+}
+
+// Returns the bits of the 4 byte words overlapping [begin, end).
+static uint64_t
+_GetWordBits(uint32_t begin, uint32_t end)
+{
+    uint32_t const first = begin / 4;
+    uint32_t const count = (end + 3) / 4 - first;
+    if (count >= 64) {
+        return ~uint64_t(0);
+    }
+    return ((uint64_t(1) << count) - 1) << first;
+}
+
+BgiVulkanPushConstants::BgiVulkanPushConstants()
+    : _setWords(0)
+    , _byteSize(0)
+    , _dirtyBegin(0)
+    , _dirtyEnd(0)
+{
+}
+
+void
+BgiVulkanPushConstants::SetValues(
+    uint32_t byteOffset,
+    uint32_t byteSize,
+    const void* data)
+{
+    if (byteSize == 0) {
+        return;
+    }
+
+    if (!UTILS_VERIFY(byteOffset + byteSize <= MaxByteSize,
+            "Push constants exceed %u bytes", MaxByteSize)) {
+        return;
+    }
+
+    UTILS_VERIFY(byteOffset % 4 == 0 && byteSize % 4 == 0,
+        "Push constants not multipes of 4");
+
+    // Values that did not change are not pushed again. Words that were
+    // never set are always pushed.
+    uint32_t const end = byteOffset + byteSize;
+    uint64_t const words = _GetWordBits(byteOffset, end);
+    if ((_setWords & words) == words &&
+        memcmp(_data + byteOffset, data, byteSize) == 0) {
+        return;
+    }
+
+    memcpy(_data + byteOffset, data, byteSize);
+    _setWords |= words;
+
+    if (IsDirty()) {
+        _dirtyBegin = std::min(_dirtyBegin, byteOffset);
+        _dirtyEnd = std::max(_dirtyEnd, end);
+    } else {
+        _dirtyBegin = byteOffset;
+        _dirtyEnd = end;
+    }
+    _byteSize = std::max(_byteSize, end);
+}
+
+void
+BgiVulkanPushConstants::Invalidate()
+{
+    _dirtyBegin = 0;
+    _dirtyEnd = _byteSize;
+}
+
+bool
+BgiVulkanPushConstants::IsDirty() const
+{
+    return _dirtyEnd > _dirtyBegin;
+}
+
+void
+BgiVulkanPushConstants::Flush(
+    VkCommandBuffer cb,
+    VkPipelineLayout layout,
+    VkPushConstantRangeVector const& ranges)
+{
+    if (!IsDirty() || !layout) {
+        return;
+    }
+
+    // Walk the dirty bytes in pieces that start and end on range boundaries,
+    // so all bytes of a piece are read by the same stages. Adjacent pieces
+    // read by the same stages are merged into one push.
+    uint32_t pushBegin = _dirtyBegin;
+    uint32_t pushEnd = _dirtyBegin;
+    VkShaderStageFlags pushStages = 0;
+
+    uint32_t offset = _dirtyBegin;
+    while (offset < _dirtyEnd) {
+        uint32_t end = _dirtyEnd;
+        VkShaderStageFlags stages = 0;
+        for (VkPushConstantRange const& range : ranges) {
+            uint32_t const rangeEnd = range.offset + range.size;
+            if (range.offset > offset) {
+                end = std::min(end, range.offset);
+            } else if (rangeEnd > offset) {
+                end = std::min(end, rangeEnd);
+                stages |= range.stageFlags;
+            }
+        }
+
+        if (stages != pushStages) {
+            _PushValues(cb, layout, pushStages, pushBegin, pushEnd, _data);
+            pushBegin = offset;
+            pushStages = stages;
+        }
+        pushEnd = end;
+        offset = end;
+    }
+    _PushValues(cb, layout, pushStages, pushBegin, pushEnd, _data);
+
+    _dirtyBegin = 0;
+    _dirtyEnd = 0;
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/layoutCache.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+/// \class BgiVulkanPushConstants
+///
+/// Shadow copy of the push constants of a graphics or compute cmds.
+///
+/// SetValues copies the values into a small inline buffer and marks the
+/// written bytes dirty. Right before a draw or dispatch, Flush pushes the
+/// dirty bytes with vkCmdPushConstants. The bytes are split along the push
+/// constant ranges of the bound pipeline, so each push names exactly the
+/// stages that may read those bytes. Nothing is allocated while recording.
+///
+class BgiVulkanPushConstants final
+{
+public:
+    /// The most bytes of push constants Bgi supports.
+    static constexpr uint32_t MaxByteSize = 256;
+
+    BGIVULKAN_API
+    BgiVulkanPushConstants();
+
+    /// Copies 'byteSize' bytes of 'data' to 'byteOffset' and marks them
+    /// dirty, unless they equal the values already set.
+    BGIVULKAN_API
+    void SetValues(uint32_t byteOffset, uint32_t byteSize, const void* data);
+
+    /// Marks all values set so far dirty. Called when a pipeline is bound,
+    /// since its layout may not be compatible with the previous one.
+    BGIVULKAN_API
+    void Invalidate();
+
+    /// Returns true if some values need to be pushed.
+    BGIVULKAN_API
+    bool IsDirty() const;
+
+    /// Pushes the dirty values into 'cb'. 'ranges' are the push constant
+    /// ranges of 'layout'. Bytes outside of these ranges are skipped.
+    BGIVULKAN_API
+    void Flush(
+        VkCommandBuffer cb,
+        VkPipelineLayout layout,
+        VkPushConstantRangeVector const& ranges);
+
+private:
+    BgiVulkanPushConstants & operator=(const BgiVulkanPushConstants&) = delete;
+    BgiVulkanPushConstants(const BgiVulkanPushConstants&) = delete;
+
+    uint8_t _data[MaxByteSize] = {};
+
+    // One bit per 4 byte word of _data that was set. Only words that were
+    // set can skip a push because the new values equal the old ones.
+    uint64_t _setWords;
+    static_assert(MaxByteSize / 4 <= 64, "");
+
+    // End of the bytes that were set so far.
+    uint32_t _byteSize;
+
+    // Dirty bytes [begin, end).
+    uint32_t _dirtyBegin;
+    uint32_t _dirtyEnd;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
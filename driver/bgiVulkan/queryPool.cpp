@@ -0,0 +1,125 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/queryPool.h"
+#include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/conversions.h"
+#include "driver/bgiVulkan/device.h"
+#include "driver/bgiVulkan/diagnostic.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+BgiVulkanQueryPool::BgiVulkanQueryPool(
+    BgiVulkanDevice* device,
+    BgiQueryPoolDesc const& desc)
+    : BgiQueryPool(desc)
+    , _vkQueryPool(nullptr)
+    , _device(device)
+    , _inflightBits(0)
+{
+    if (desc.queryCount == 0) {
+        UTILS_CODING_ERROR("The query count of query pool [%p] is zero.",
+            this);
+        return;
+    }
+
+    BgiVulkanCapabilities const& caps = device->GetDeviceCapabilities();
+
+    if (desc.type == BgiQueryTypeOcclusionPrecise &&
+        !caps.vkDeviceFeatures.occlusionQueryPrecise) {
+        UTILS_CODING_ERROR("Query pool %s requires a device with precise "
+            "occlusion query support", desc.debugName.c_str());
+        return;
+    }
+    if (desc.type == BgiQueryTypePipelineStatistics &&
+        !caps.vkDeviceFeatures.pipelineStatisticsQuery) {
+        UTILS_CODING_ERROR("Query pool %s requires a device with pipeline "
+            "statistics query support", desc.debugName.c_str());
+        return;
+    }
+    if (desc.type == BgiQueryTypeTimestamp && !caps.supportsTimeStamps) {
+        UTILS_CODING_ERROR("Query pool %s requires a device with timestamp "
+            "support", desc.debugName.c_str());
+        return;
+    }
+
+    VkQueryPoolCreateInfo poolInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    poolInfo.queryType = BgiVulkanConversions::GetQueryType(desc.type);
+    poolInfo.queryCount = desc.queryCount;
+    if (desc.type == BgiQueryTypePipelineStatistics) {
+        poolInfo.pipelineStatistics =
+            BgiVulkanConversions::GetPipelineStatistics(
+                desc.pipelineStatistics);
+    }
+
+    UTILS_VERIFY(
+        vkCreateQueryPool(
+            device->GetVulkanDevice(),
+            &poolInfo,
+            BgiVulkanAllocator(),
+            &_vkQueryPool) == VK_SUCCESS
+    );
+
+    // Debug label
+    if (!_descriptor.debugName.empty()) {
+        std::string debugLabel = "QueryPool " + _descriptor.debugName;
+        BgiVulkanSetDebugName(
+            device,
+            (uint64_t)_vkQueryPool,
+            VK_OBJECT_TYPE_QUERY_POOL,
+            debugLabel.c_str());
+    }
+}
+
+BgiVulkanQueryPool::~BgiVulkanQueryPool()
+{
+    if (_vkQueryPool) {
+        vkDestroyQueryPool(
+            _device->GetVulkanDevice(),
+            _vkQueryPool,
+            BgiVulkanAllocator());
+    }
+}
+
+double
+BgiVulkanQueryPool::GetTimestampPeriod() const
+{
+    return _device->GetDeviceCapabilities().
+        vkDeviceProperties.limits.timestampPeriod;
+}
+
+uint64_t
+BgiVulkanQueryPool::GetRawResource() const
+{
+    return (uint64_t) _vkQueryPool;
+}
+
+VkQueryPool
+BgiVulkanQueryPool::GetVulkanQueryPool() const
+{
+    return _vkQueryPool;
+}
+
+VkQueryControlFlags
+BgiVulkanQueryPool::GetVulkanQueryControlFlags() const
+{
+    return _descriptor.type == BgiQueryTypeOcclusionPrecise ?
+        VK_QUERY_CONTROL_PRECISE_BIT : 0;
+}
+
+BgiVulkanDevice*
+BgiVulkanQueryPool::GetDevice() const
+{
+    return _device;
+}
+
+uint64_t &
+BgiVulkanQueryPool::GetInflightBits()
+{
+    return _inflightBits;
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
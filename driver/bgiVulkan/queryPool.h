@@ -0,0 +1,68 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/queryPool.h"
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/vulkanBridge.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+class BgiVulkanDevice;
+
+///
+/// \class BgiVulkanQueryPool
+///
+/// Vulkan implementation of BgiQueryPool
+///
+class BgiVulkanQueryPool final : public BgiQueryPool
+{
+public:
+    BGIVULKAN_API
+    ~BgiVulkanQueryPool() override;
+
+    BGIVULKAN_API
+    double GetTimestampPeriod() const override;
+
+    BGIVULKAN_API
+    uint64_t GetRawResource() const override;
+
+    /// Returns the vulkan query pool object.
+    BGIVULKAN_API
+    VkQueryPool GetVulkanQueryPool() const;
+
+    /// Returns the flags queries of the pool are begun with.
+    BGIVULKAN_API
+    VkQueryControlFlags GetVulkanQueryControlFlags() const;
+
+    /// Returns the device used to create this object.
+    BGIVULKAN_API
+    BgiVulkanDevice* GetDevice() const;
+
+    /// Returns the (writable) inflight bits of when this object was trashed.
+    BGIVULKAN_API
+    uint64_t & GetInflightBits();
+
+protected:
+    friend class BgiVulkan;
+
+    BGIVULKAN_API
+    BgiVulkanQueryPool(
+        BgiVulkanDevice* device,
+        BgiQueryPoolDesc const& desc);
+
+private:
+    BgiVulkanQueryPool() = delete;
+    BgiVulkanQueryPool & operator=(const BgiVulkanQueryPool&) = delete;
+    BgiVulkanQueryPool(const BgiVulkanQueryPool&) = delete;
+
+    VkQueryPool _vkQueryPool;
+    BgiVulkanDevice* _device;
+    uint64_t _inflightBits;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
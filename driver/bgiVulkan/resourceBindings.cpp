@@ -3,12 +3,18 @@
 #include "driver/bgiVulkan/resourceBindings.h"
 #include "driver/bgiVulkan/buffer.h"
 #include "driver/bgiVulkan/capabilities.h"
+#include "driver/bgiVulkan/commandBuffer.h"
+#include "driver/bgiVulkan/commandQueue.h"
 #include "driver/bgiVulkan/conversions.h"
+#include "driver/bgiVulkan/descriptorAllocator.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/layoutCache.h"
 #include "driver/bgiVulkan/sampler.h"
 #include "driver/bgiVulkan/texture.h"
 
+#include <algorithm>
+
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
@@ -17,39 +23,42 @@ namespace {
     static const uint8_t _descriptorSetCnt = 1;
 }
 
-static VkDescriptorSetLayout
-_CreateDescriptorSetLayout(
-    BgiVulkanDevice* device,
-    std::vector<VkDescriptorSetLayoutBinding> const& bindings,
-    std::string const& debugName)
+// Returns the descriptor type of a buffer binding. Buffers with dynamic
+// offsets are dynamic descriptors, unless they are emulated in a descriptor
+// buffer.
+static VkDescriptorType
+_GetBufferDescriptorType(
+    BgiBufferBindingDesc const& bufDesc,
+    bool descriptorBuffer)
 {
-    // Create descriptor
-    VkDescriptorSetLayoutCreateInfo setCreateInfo =
-        {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
-    setCreateInfo.bindingCount = (uint32_t) bindings.size();
-    setCreateInfo.pBindings = bindings.data();
-    setCreateInfo.pNext = nullptr;
-
-    VkDescriptorSetLayout layout = nullptr;
-    UTILS_VERIFY(
-        vkCreateDescriptorSetLayout(
-            device->GetVulkanDevice(),
-            &setCreateInfo,
-            BgiVulkanAllocator(),
-            &layout) == VK_SUCCESS
-    );
-
-    // Debug label
-    if (!debugName.empty()) {
-        std::string debugLabel = "DescriptorSetLayout " + debugName;
-        BgiVulkanSetDebugName(
-            device,
-            (uint64_t)layout,
-            VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
-            debugLabel.c_str());
+    VkDescriptorType const type =
+        BgiVulkanConversions::GetDescriptorType(bufDesc.resourceType);
+    if (!bufDesc.dynamicOffset || descriptorBuffer) {
+        return type;
+    }
+    if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     }
+    if (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    }
+    UTILS_CODING_ERROR("Only uniform and storage buffers can be dynamic");
+    return type;
+}
 
-    return layout;
+static void
+_AddPoolSize(
+    VkDescriptorPoolSizeVector* poolSizes,
+    VkDescriptorType type,
+    uint32_t count)
+{
+    for (VkDescriptorPoolSize& p : *poolSizes) {
+        if (p.type == type) {
+            p.descriptorCount += count;
+            return;
+        }
+    }
+    poolSizes->push_back({type, count});
 }
 
 BgiVulkanResourceBindings::BgiVulkanResourceBindings(
@@ -58,20 +67,23 @@ BgiVulkanResourceBindings::BgiVulkanResourceBindings(
     : BgiResourceBindings(desc)
     , _device(device)
     , _inflightBits(0)
-    , _vkDescriptorPool(nullptr)
     , _vkDescriptorSetLayout(nullptr)
     , _vkDescriptorSet(nullptr)
+    , _pushDescriptors(false)
+    , _textureBindIndexStart(0)
+    , _dynamicOffsetCount(0)
+    , _updateCount(0)
+    , _boundInflightBits(0)
 {
     // Initialize the pool sizes for each descriptor type we support
-    std::vector<VkDescriptorPoolSize> poolSizes;
-    poolSizes.resize(BgiBindResourceTypeCount);
+    _poolSizes.resize(BgiBindResourceTypeCount);
 
     for (size_t i=0; i<BgiBindResourceTypeCount; i++) {
         BgiBindResourceType bt = BgiBindResourceType(i);
         VkDescriptorPoolSize p;
         p.descriptorCount = 0;
         p.type = BgiVulkanConversions::GetDescriptorType(bt);
-        poolSizes[i] = p;
+        _poolSizes[i] = p;
     }
 
     // OpenGL (and Metal) have separate bindings for each buffer and image type.
@@ -90,8 +102,6 @@ BgiVulkanResourceBindings::BgiVulkanResourceBindings(
     // E.g. If HgiResourceBindingDesc indicates the following binding indices:
     // UBO1: 0, SSBO1: 1, SSB02: 2, TEX1: 0, TEX2: 1, here we change that to:
     // UBO1: 0, SSBO1: 1, SSB02: 2, TEX1: 3, TEX2: 4.
-
-    uint32_t textureBindIndexStart = 0;
     
     // XXX We need to overspecify the stage usage here so we can match the 
     // VkDescriptorSetLayout that is created with spirv-reflect for the 
@@ -105,6 +115,8 @@ BgiVulkanResourceBindings::BgiVulkanResourceBindings(
         BgiVulkanConversions::GetShaderStages(
             BgiShaderStageGeometry | BgiShaderStageFragment);
 
+    const bool descriptorBuffer = _device->GetDescriptorBuffer() != nullptr;
+
     // Create DescriptorSetLayout to describe resource bindings.
     //
     // Buffers
@@ -113,28 +125,30 @@ BgiVulkanResourceBindings::BgiVulkanResourceBindings(
     for (BgiBufferBindingDesc const& b : desc.buffers) {
         VkDescriptorSetLayoutBinding d = {};
         d.binding = b.bindingIndex;
-        d.descriptorType =
-            BgiVulkanConversions::GetDescriptorType(b.resourceType);
-        poolSizes[b.resourceType].descriptorCount++;
+        d.descriptorType = _GetBufferDescriptorType(b, descriptorBuffer);
         d.descriptorCount = (uint32_t) b.buffers.size();
+        _AddPoolSize(&_poolSizes, d.descriptorType, d.descriptorCount);
+        if (b.dynamicOffset) {
+            _dynamicOffsetCount += d.descriptorCount;
+        }
         d.stageFlags = (b.stageUsage == BgiShaderStageCompute) ?
             BgiVulkanConversions::GetShaderStages(b.stageUsage) :
             bufferShaderStageFlags;
         d.pImmutableSamplers = nullptr;
         bindings.push_back(std::move(d));
 
-        textureBindIndexStart =
-            std::max(textureBindIndexStart, b.bindingIndex + 1);
+        _textureBindIndexStart =
+            std::max(_textureBindIndexStart, b.bindingIndex + 1);
     }
 
     // Textures
     for (BgiTextureBindingDesc const& t : desc.textures) {
         VkDescriptorSetLayoutBinding d = {};
-        d.binding = textureBindIndexStart + t.bindingIndex;
+        d.binding = _textureBindIndexStart + t.bindingIndex;
         d.descriptorType =
             BgiVulkanConversions::GetDescriptorType(t.resourceType);
-        poolSizes[t.resourceType].descriptorCount++;
         d.descriptorCount = (uint32_t) t.textures.size();
+        _AddPoolSize(&_poolSizes, d.descriptorType, d.descriptorCount);
         d.stageFlags = (t.stageUsage == BgiShaderStageCompute) ?
             BgiVulkanConversions::GetShaderStages(t.stageUsage) :
             textureShaderStageFlags;
@@ -143,73 +157,20 @@ BgiVulkanResourceBindings::BgiVulkanResourceBindings(
     }
 
     // Create descriptor set layout
-    _vkDescriptorSetLayout =
-        _CreateDescriptorSetLayout(_device, bindings, _descriptor.debugName);
-
-    //
-    // Create the descriptor pool.
-    //
-    // XXX For now each resource bindings gets its own pool to allocate its
-    // descriptor sets from to simplify multi-threading support.
-    for (size_t i=poolSizes.size(); i-- > 0;) {
-        // Vulkan validation will complain if any descriptorCount is 0.
-        // Instead of removing them we set a minimum of 1. An empty poolSize
-        // will not let us create the pool, which prevents us from creating
-        // the descriptorSets.
-        poolSizes[i].descriptorCount=std::max(poolSizes[i].descriptorCount, 1u);
-    }
-
-    VkDescriptorPoolCreateInfo pool_info = {};
-    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    pool_info.maxSets = _descriptorSetCnt;
-    pool_info.poolSizeCount = (uint32_t) poolSizes.size();
-    pool_info.pPoolSizes = poolSizes.data();
-
-    UTILS_VERIFY(
-        vkCreateDescriptorPool(
-            _device->GetVulkanDevice(),
-            &pool_info,
-            BgiVulkanAllocator(),
-            &_vkDescriptorPool) == VK_SUCCESS
-    );
-
-    // Debug label
-    if (!_descriptor.debugName.empty()) {
-        std::string debugLabel = "Descriptor Pool " + _descriptor.debugName;
-        BgiVulkanSetDebugName(
-            device,
-            (uint64_t)_vkDescriptorPool,
-            VK_OBJECT_TYPE_DESCRIPTOR_POOL,
-            debugLabel.c_str());
-    }
+    // Acquired from the layout cache, so it is the same handle as the set
+    // layout of pipelines with matching resources.
+    BgiVulkanLayoutCache* layoutCache = _device->GetLayoutCache();
+    VkDescriptorSetLayoutCreateFlags const layoutFlags =
+        layoutCache->GetResourceSetLayoutFlags(bindings);
+    _pushDescriptors = (layoutFlags &
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR) != 0;
+    _vkDescriptorSetLayout = layoutCache->AcquireDescriptorSetLayout(
+        bindings, layoutFlags, _descriptor.debugName);
 
     //
-    // Create Descriptor Set
+    // Allocate the descriptor set.
     //
-    VkDescriptorSetAllocateInfo allocateInfo =
-        {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
-
-    allocateInfo.descriptorPool = _vkDescriptorPool;
-    allocateInfo.descriptorSetCount = _descriptorSetCnt;
-    allocateInfo.pSetLayouts = &_vkDescriptorSetLayout;
-
-    UTILS_VERIFY(
-        vkAllocateDescriptorSets(
-            _device->GetVulkanDevice(),
-            &allocateInfo,
-            &_vkDescriptorSet) == VK_SUCCESS
-    );
-
-    // Debug label
-    if (!_descriptor.debugName.empty()) {
-        std::string dbgLbl = "Descriptor Set Buffers " + _descriptor.debugName;
-        BgiVulkanSetDebugName(
-            _device,
-            (uint64_t)_vkDescriptorSet,
-            VK_OBJECT_TYPE_DESCRIPTOR_SET,
-            dbgLbl.c_str());
-    }
+    _AllocateVersion();
 
     //
     // Setup limits for each resource type
@@ -236,158 +197,221 @@ BgiVulkanResourceBindings::BgiVulkanResourceBindings(
     };
     static_assert(BgiBindResourceTypeCount==7, "");
 
-    //
-    // Buffers
-    //
-
-    std::vector<VkWriteDescriptorSet> writeSets;
-
-    std::vector<VkDescriptorBufferInfo> bufferInfos;
-    bufferInfos.reserve(desc.buffers.size());
+    uint32_t dynamicUniformBuffers = 0;
+    uint32_t dynamicStorageBuffers = 0;
+    for (VkDescriptorSetLayoutBinding const& bi : bindings) {
+        if (bi.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+            dynamicUniformBuffers += bi.descriptorCount;
+        } else if (bi.descriptorType ==
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) {
+            dynamicStorageBuffers += bi.descriptorCount;
+        }
+    }
+    UTILS_VERIFY(
+        dynamicUniformBuffers <= limits.maxDescriptorSetUniformBuffersDynamic,
+        "Maximum dynamic uniform buffers exceeded");
+    UTILS_VERIFY(
+        dynamicStorageBuffers <= limits.maxDescriptorSetStorageBuffersDynamic,
+        "Maximum dynamic storage buffers exceeded");
+
+    // The update templates read the descriptors of each binding in
+    // increasing binding order (see BgiVulkanLayoutCache), so sort the
+    // buffer and texture bindings by their final binding index.
+    struct _Binding
+    {
+        uint32_t index;
+        BgiBufferBindingDesc const* buffer;
+        BgiTextureBindingDesc const* texture;
+    };
+    std::vector<_Binding> sortedBindings;
+    sortedBindings.reserve(desc.buffers.size() + desc.textures.size());
 
     for (BgiBufferBindingDesc const& bufDesc : desc.buffers) {
         uint32_t & limit = bindLimits[bufDesc.resourceType][1];
-        if (!UTILS_VERIFY(limit>0, "Maximum size array-of-buffers exceeded")) {
-            break;
-        }
-        limit -= 1;
-
-        UTILS_VERIFY(bufDesc.buffers.size() == bufDesc.offsets.size());
-
-        // Each buffer can be an array of buffers (usually one)
-        for (size_t i=0; i<bufDesc.buffers.size(); i++) {
-            BgiBufferHandle const& bufHandle = bufDesc.buffers[i];
-            BgiVulkanBuffer* buf =
-                static_cast<BgiVulkanBuffer*>(bufHandle.Get());
-            if (!UTILS_VERIFY(buf)) continue;
-            VkDescriptorBufferInfo bufferInfo;
-            bufferInfo.buffer = buf->GetVulkanBuffer();
-            bufferInfo.offset = bufDesc.offsets[i];
-            bufferInfo.range = VK_WHOLE_SIZE;
-            bufferInfos.push_back(std::move(bufferInfo));
+        if (UTILS_VERIFY(limit>0, "Maximum size array-of-buffers exceeded")) {
+            limit -= 1;
         }
+        sortedBindings.push_back({bufDesc.bindingIndex, &bufDesc, nullptr});
     }
 
-    size_t bufInfoOffset = 0;
-    for (BgiBufferBindingDesc const& bufDesc : desc.buffers) {
-        VkWriteDescriptorSet writeSet= {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        writeSet.dstBinding = bufDesc.bindingIndex;
-        writeSet.dstArrayElement = 0;
-        writeSet.descriptorCount = (uint32_t) bufDesc.buffers.size(); // 0 ok
-        writeSet.dstSet = _vkDescriptorSet;
-        writeSet.pBufferInfo = bufferInfos.data() + bufInfoOffset;
-        writeSet.pImageInfo = nullptr;
-        writeSet.pTexelBufferView = nullptr;
-        writeSet.descriptorType =
-            BgiVulkanConversions::GetDescriptorType(bufDesc.resourceType);
-        writeSets.push_back(std::move(writeSet));
-        bufInfoOffset += bufDesc.buffers.size();
+    for (BgiTextureBindingDesc const& texDesc : desc.textures) {
+        uint32_t & limit = bindLimits[texDesc.resourceType][1];
+        if (UTILS_VERIFY(limit>0,
+                "Maximum array-of-texture/samplers exceeded")) {
+            limit -= 1;
+        }
+        sortedBindings.push_back(
+            {_textureBindIndexStart + texDesc.bindingIndex, nullptr, &texDesc});
     }
 
+    std::sort(sortedBindings.begin(), sortedBindings.end(),
+        [](_Binding const& a, _Binding const& b) {
+            return a.index < b.index;
+        });
+
     //
-    // Textures
+    // Gather the descriptors
     //
+    // Every binding of the layout must provide all of its descriptors, so
+    // invalid resources leave an empty descriptor in their slot.
+    _bindingRanges.reserve(sortedBindings.size());
+    for (_Binding const& binding : sortedBindings) {
+        _BindingRange range;
+        range.binding = binding.index;
+        range.firstInfo = (uint32_t) _descriptorInfos.size();
+
+        if (BgiBufferBindingDesc const* bufDesc = binding.buffer) {
+            range.type = _GetBufferDescriptorType(*bufDesc, descriptorBuffer);
+            range.count = (uint32_t) bufDesc->buffers.size();
+            range.dynamicOffset = bufDesc->dynamicOffset;
+            _descriptorInfos.resize(range.firstInfo + range.count);
+            _GetBufferInfos(*bufDesc, &_descriptorInfos[range.firstInfo]);
+        } else {
+            BgiTextureBindingDesc const* texDesc = binding.texture;
+            range.type = BgiVulkanConversions::GetDescriptorType(
+                texDesc->resourceType);
+            range.count = (uint32_t) texDesc->textures.size();
+            range.dynamicOffset = false;
+            _descriptorInfos.resize(range.firstInfo + range.count);
+            _GetTextureInfos(*texDesc, &_descriptorInfos[range.firstInfo]);
+        }
 
-    std::vector<VkDescriptorImageInfo> imageInfos;
-    imageInfos.reserve(desc.textures.size());
+        _bindingRanges.push_back(range);
+    }
 
-    for (BgiTextureBindingDesc const& texDesc : desc.textures) {
+    // Push descriptors are written when the resources are bound.
+    if (!_pushDescriptors) {
+        _WriteDescriptors();
+    }
+}
 
-        uint32_t & limit = bindLimits[texDesc.resourceType][1];
-        if (!UTILS_VERIFY(limit>0, "Maximum array-of-texture/samplers exceeded")) {
-            break;
-        }
-        limit -= 1;
-
-        // Each texture can be an array of textures
-        for (size_t i=0; i< texDesc.textures.size(); i++) {
-            BgiTextureHandle const& texHandle = texDesc.textures[i];
-            BgiVulkanTexture* tex =
-                static_cast<BgiVulkanTexture*>(texHandle.Get());
-            if (!UTILS_VERIFY(tex)) continue;
-
-            // Not having a sampler is ok only for StorageImage.
-            BgiVulkanSampler* smp = nullptr;
-            if (i < texDesc.samplers.size()) {
-                BgiSamplerHandle const& smpHandle = texDesc.samplers[i];
-                smp = static_cast<BgiVulkanSampler*>(smpHandle.Get());
-            }
+BgiVulkanResourceBindings::~BgiVulkanResourceBindings()
+{
+    _device->GetLayoutCache()->ReleaseDescriptorSetLayout(
+        _vkDescriptorSetLayout);
+
+    // The garbage collector only destroys the bindings once no command
+    // buffer uses them, so every version of the set can be released.
+    _retiredVersions.push_back(
+        {0, _descriptorAllocation, _descriptorBufferAllocation});
+    _ReleaseRetiredVersions(0);
+}
 
-            VkDescriptorImageInfo imageInfo;
-            imageInfo.sampler = smp ? smp->GetVulkanSampler() : nullptr;
-            imageInfo.imageLayout = tex->GetImageLayout();
-            imageInfo.imageView = tex->GetImageView();
-            imageInfos.push_back(std::move(imageInfo));
-        }
+void
+BgiVulkanResourceBindings::UpdateBuffers(BgiBufferBindingDesc const& bufferDesc)
+{
+    _BindingRange const* range = _FindBindingRange(
+        bufferDesc.bindingIndex,
+        _GetBufferDescriptorType(
+            bufferDesc, _device->GetDescriptorBuffer() != nullptr));
+    if (!range || range->count != bufferDesc.buffers.size() ||
+        range->dynamicOffset != bufferDesc.dynamicOffset) {
+        UTILS_CODING_ERROR("Buffer binding %u does not match the bindings",
+            bufferDesc.bindingIndex);
+        return;
     }
 
-    size_t texInfoOffset = 0;
-    for (BgiTextureBindingDesc const& texDesc : desc.textures) {
-        // For dstBinding we must provided an index in descriptor set.
-        // Must be one of the bindings specified in VkDescriptorSetLayoutBinding
-        VkWriteDescriptorSet writeSet= {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        writeSet.dstBinding = textureBindIndexStart + texDesc.bindingIndex;
-        writeSet.dstArrayElement = 0;
-        writeSet.descriptorCount = (uint32_t) texDesc.textures.size(); // 0 ok
-        writeSet.dstSet = _vkDescriptorSet;
-        writeSet.pBufferInfo = nullptr;
-        writeSet.pImageInfo = imageInfos.data() + texInfoOffset;
-        writeSet.pTexelBufferView = nullptr;
-        writeSet.descriptorType =
-            BgiVulkanConversions::GetDescriptorType(texDesc.resourceType);
-        writeSets.push_back(std::move(writeSet));
-        texInfoOffset += texDesc.textures.size();
+    for (BgiBufferBindingDesc& b : _descriptor.buffers) {
+        if (b.bindingIndex == bufferDesc.bindingIndex) {
+            b = bufferDesc;
+            break;
+        }
     }
 
-    // Note: this update is immediate. It is not recorded via a command.
-    // This means we should only do this if the descriptorSet is not currently
-    // in use on GPU. With 'descriptor indexing' extension this has relaxed a
-    // little and we are allowed to use vkUpdateDescriptorSets before
-    // vkBeginCommandBuffer and after vkEndCommandBuffer, just not during the
-    // command buffer recording.
-    vkUpdateDescriptorSets(
-        _device->GetVulkanDevice(),
-        (uint32_t) writeSets.size(),
-        writeSets.data(),
-        0,        // copy count
-        nullptr); // copy_desc
+    _GetBufferInfos(bufferDesc, &_descriptorInfos[range->firstInfo]);
+    _UpdateBinding(*range);
 }
 
-BgiVulkanResourceBindings::~BgiVulkanResourceBindings()
+void
+BgiVulkanResourceBindings::UpdateTextures(
+    BgiTextureBindingDesc const& textureDesc)
 {
-    vkDestroyDescriptorSetLayout(
-        _device->GetVulkanDevice(),
-        _vkDescriptorSetLayout,
-        BgiVulkanAllocator());
+    _BindingRange const* range = _FindBindingRange(
+        _textureBindIndexStart + textureDesc.bindingIndex,
+        BgiVulkanConversions::GetDescriptorType(textureDesc.resourceType));
+    if (!range || range->count != textureDesc.textures.size()) {
+        UTILS_CODING_ERROR("Texture binding %u does not match the bindings",
+            textureDesc.bindingIndex);
+        return;
+    }
 
-    // Since we have one pool for this resourceBindings we can reset the pool
-    // instead of freeing the descriptorSets (vkFreeDescriptorSets).
-    vkDestroyDescriptorPool(
-        _device->GetVulkanDevice(),
-        _vkDescriptorPool,
-        BgiVulkanAllocator());
+    for (BgiTextureBindingDesc& t : _descriptor.textures) {
+        if (t.bindingIndex == textureDesc.bindingIndex) {
+            t = textureDesc;
+            break;
+        }
+    }
+
+    _GetTextureInfos(textureDesc, &_descriptorInfos[range->firstInfo]);
+    _UpdateBinding(*range);
 }
 
 void
 BgiVulkanResourceBindings::BindResources(
-    VkCommandBuffer cb,
+    BgiVulkanCommandBuffer* cb,
     VkPipelineBindPoint bindPoint,
-    VkPipelineLayout layout)
+    VkPipelineLayout layout,
+    std::vector<uint32_t> const& dynamicOffsets)
 {
+    if (!UTILS_VERIFY(dynamicOffsets.size() == _dynamicOffsetCount,
+            "Expected %u dynamic offsets", _dynamicOffsetCount)) {
+        return;
+    }
+
+    // Track the command buffers that use this version of the set, so an
+    // update knows whether it can write the set in place.
+    _boundInflightBits.fetch_or(1ULL << cb->GetInflightId());
+
+    VkCommandBuffer vkCommandBuffer = cb->GetVulkanCommandBuffer();
+
     // When binding new resources for the currently bound pipeline it may
     // 'disturb' previously bound resources (for a previous pipeline) that
     // are no longer compatible with the layout for the new pipeline.
     // This essentially unbinds the old resources.
 
+    if (BgiVulkanDescriptorBuffer* descriptorBuffer =
+            _device->GetDescriptorBuffer()) {
+        descriptorBuffer->SetOffset(
+            vkCommandBuffer,
+            bindPoint,
+            layout,
+            0, // set - Hgi does not provide slot index, assume 0.
+            _dynamicOffsetCount > 0 ?
+                _WriteDynamicOffsets(dynamicOffsets) :
+                _descriptorBufferAllocation.offset);
+        return;
+    }
+
+    if (_pushDescriptors) {
+        // The template is created once per pipeline layout and cached.
+        VkDescriptorUpdateTemplate updateTemplate =
+            _device->GetLayoutCache()->GetDescriptorUpdateTemplate(
+                _vkDescriptorSetLayout, bindPoint, layout);
+
+        _device->vkCmdPushDescriptorSetWithTemplateKHR(
+            vkCommandBuffer,
+            updateTemplate,
+            layout,
+            0, // set - Hgi does not provide slot index, assume 0.
+            _descriptorInfos.data());
+        return;
+    }
+
     vkCmdBindDescriptorSets(
-        cb,
+        vkCommandBuffer,
         bindPoint,
         layout,
         0, // firstSet/slot - Hgi does not provide slot index, assume 0.
         _descriptorSetCnt,
         &_vkDescriptorSet,
-        0, // dynamicOffset
-        nullptr);
+        (uint32_t) dynamicOffsets.size(),
+        dynamicOffsets.data());
+}
+
+uint64_t
+BgiVulkanResourceBindings::GetUpdateCount() const
+{
+    return _updateCount;
 }
 
 BgiVulkanDevice*
@@ -402,6 +426,313 @@ BgiVulkanResourceBindings::GetInflightBits()
     return _inflightBits;
 }
 
+BgiVulkanResourceBindings::_BindingRange const*
+BgiVulkanResourceBindings::_FindBindingRange(
+    uint32_t binding,
+    VkDescriptorType type) const
+{
+    for (_BindingRange const& range : _bindingRanges) {
+        if (range.binding == binding) {
+            return range.type == type ? &range : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void
+BgiVulkanResourceBindings::_GetBufferInfos(
+    BgiBufferBindingDesc const& bufDesc,
+    BgiVulkanDescriptorInfo* infos) const
+{
+    UTILS_VERIFY(bufDesc.buffers.size() == bufDesc.offsets.size());
+
+    const bool descriptorBuffer = _device->GetDescriptorBuffer() != nullptr;
+
+    // Each buffer can be an array of buffers (usually one)
+    for (size_t i=0; i<bufDesc.buffers.size(); i++) {
+        BgiBufferHandle const& bufHandle = bufDesc.buffers[i];
+        BgiVulkanBuffer* buf = static_cast<BgiVulkanBuffer*>(bufHandle.Get());
+        BgiVulkanDescriptorInfo info = {};
+        if (UTILS_VERIFY(buf)) {
+            info.buffer.buffer = buf->GetVulkanBuffer();
+            info.buffer.offset = i < bufDesc.offsets.size() ?
+                bufDesc.offsets[i] : 0;
+
+            // Dynamic offsets move the range within the buffer, so its size
+            // must be known. Descriptor buffers address the buffer memory
+            // directly and always need an explicit range.
+            const uint32_t size = i < bufDesc.sizes.size() ?
+                bufDesc.sizes[i] : 0;
+            UTILS_VERIFY(size > 0 || !bufDesc.dynamicOffset,
+                "Buffers bound with dynamic offsets need a size");
+            if (size > 0) {
+                info.buffer.range = size;
+            } else {
+                info.buffer.range = descriptorBuffer ?
+                    buf->GetDescriptor().byteSize - info.buffer.offset :
+                    VK_WHOLE_SIZE;
+            }
+        }
+        infos[i] = info;
+    }
+}
+
+void
+BgiVulkanResourceBindings::_GetTextureInfos(
+    BgiTextureBindingDesc const& texDesc,
+    BgiVulkanDescriptorInfo* infos) const
+{
+    // Each texture can be an array of textures
+    for (size_t i=0; i< texDesc.textures.size(); i++) {
+        BgiTextureHandle const& texHandle = texDesc.textures[i];
+        BgiVulkanTexture* tex = static_cast<BgiVulkanTexture*>(texHandle.Get());
+        BgiVulkanDescriptorInfo info = {};
+        if (!UTILS_VERIFY(tex)) {
+            infos[i] = info;
+            continue;
+        }
+
+        // Not having a sampler is ok only for StorageImage.
+        BgiVulkanSampler* smp = nullptr;
+        if (i < texDesc.samplers.size()) {
+            BgiSamplerHandle const& smpHandle = texDesc.samplers[i];
+            smp = static_cast<BgiVulkanSampler*>(smpHandle.Get());
+        }
+
+        info.image.sampler = smp ? smp->GetVulkanSampler() : nullptr;
+        info.image.imageLayout = tex->GetImageLayout();
+        info.image.imageView = tex->GetImageView();
+        infos[i] = info;
+    }
+}
+
+void
+BgiVulkanResourceBindings::_AllocateVersion()
+{
+    // Push descriptor sets are written into the command buffer when they are
+    // bound and need no descriptor set.
+    // With descriptor buffers the set is a range of the descriptor buffer.
+    // Transient ranges come from a ring that is reclaimed with the frame.
+    // Other sets come from pages shared by all resource bindings. Transient
+    // bindings are allocated from per-thread pages that are recycled
+    // wholesale once the frame retires, so they are cheap to create per draw.
+    if (BgiVulkanDescriptorBuffer* descriptorBuffer =
+            _device->GetDescriptorBuffer()) {
+        _descriptorBufferAllocation = descriptorBuffer->Allocate(
+            descriptorBuffer->GetLayoutSize(_vkDescriptorSetLayout),
+            _descriptor.transient);
+        return;
+    }
+
+    if (_pushDescriptors) {
+        return;
+    }
+
+    _descriptorAllocation = _device->GetDescriptorAllocator()->Allocate(
+        _vkDescriptorSetLayout, _poolSizes, _descriptor.transient);
+    _vkDescriptorSet = _descriptorAllocation.set;
+
+    // Debug label
+    if (!_descriptor.debugName.empty()) {
+        std::string dbgLbl = "Descriptor Set Buffers " + _descriptor.debugName;
+        BgiVulkanSetDebugName(
+            _device,
+            (uint64_t)_vkDescriptorSet,
+            VK_OBJECT_TYPE_DESCRIPTOR_SET,
+            dbgLbl.c_str());
+    }
+}
+
+void
+BgiVulkanResourceBindings::_WriteDescriptors()
+{
+    if (_device->GetDescriptorBuffer()) {
+        for (_BindingRange const& range : _bindingRanges) {
+            _WriteDescriptors(range);
+        }
+        return;
+    }
+
+    if (_descriptorInfos.empty()) {
+        return;
+    }
+
+    // Note: this update is immediate. It is not recorded via a command.
+    // This means we should only do this if the descriptorSet is not currently
+    // in use on GPU. With 'descriptor indexing' extension this has relaxed a
+    // little and we are allowed to use vkUpdateDescriptorSets before
+    // vkBeginCommandBuffer and after vkEndCommandBuffer, just not during the
+    // command buffer recording.
+    VkDescriptorUpdateTemplate updateTemplate =
+        _device->GetLayoutCache()->GetDescriptorUpdateTemplate(
+            _vkDescriptorSetLayout,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            nullptr);
+
+    vkUpdateDescriptorSetWithTemplate(
+        _device->GetVulkanDevice(),
+        _vkDescriptorSet,
+        updateTemplate,
+        _descriptorInfos.data());
+}
+
+void
+BgiVulkanResourceBindings::_WriteDescriptors(_BindingRange const& range)
+{
+    BgiVulkanDescriptorInfo const* infos = &_descriptorInfos[range.firstInfo];
+
+    // Write the descriptors straight into the descriptor buffer. Elements
+    // of an array are descriptor-size bytes apart from the binding offset.
+    if (BgiVulkanDescriptorBuffer* descriptorBuffer =
+            _device->GetDescriptorBuffer()) {
+        VkDeviceSize const offset = _descriptorBufferAllocation.offset +
+            descriptorBuffer->GetBindingOffset(
+                _vkDescriptorSetLayout, range.binding);
+        size_t const stride = descriptorBuffer->GetDescriptorSize(range.type);
+
+        for (uint32_t i=0; i<range.count; i++) {
+            descriptorBuffer->WriteDescriptor(
+                offset + i * stride, range.type, infos[i]);
+        }
+        return;
+    }
+
+    if (range.count == 0) {
+        return;
+    }
+
+    // The packed infos share a slot between buffer and image infos, so they
+    // are unpacked into the arrays vkUpdateDescriptorSets expects.
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+
+    VkWriteDescriptorSet w = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    w.dstSet = _vkDescriptorSet;
+    w.dstBinding = range.binding;
+    w.dstArrayElement = 0;
+    w.descriptorCount = range.count;
+    w.descriptorType = range.type;
+
+    if (range.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+        range.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+        range.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+        range.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) {
+        for (uint32_t i=0; i<range.count; i++) {
+            bufferInfos.push_back(infos[i].buffer);
+        }
+        w.pBufferInfo = bufferInfos.data();
+    } else {
+        for (uint32_t i=0; i<range.count; i++) {
+            imageInfos.push_back(infos[i].image);
+        }
+        w.pImageInfo = imageInfos.data();
+    }
+
+    vkUpdateDescriptorSets(_device->GetVulkanDevice(), 1, &w, 0, nullptr);
+}
+
+void
+BgiVulkanResourceBindings::_UpdateBinding(_BindingRange const& range)
+{
+    _updateCount++;
+
+    // Push descriptors are read from _descriptorInfos on every bind.
+    if (_pushDescriptors) {
+        return;
+    }
+
+    uint64_t const queueInflightBits =
+        _device->GetCommandQueue()->GetInflightCommandBuffersBits();
+
+    _ReleaseRetiredVersions(queueInflightBits);
+
+    // No command buffer that is recording or in-flight uses the set, so it
+    // can be written in place.
+    uint64_t const boundBits = _boundInflightBits.load();
+    if ((boundBits & queueInflightBits) == 0) {
+        _WriteDescriptors(range);
+        return;
+    }
+
+    // Otherwise keep the current version alive for its command buffers and
+    // continue with a fresh copy that has all descriptors written.
+    _retiredVersions.push_back(
+        {boundBits, _descriptorAllocation, _descriptorBufferAllocation});
+    _boundInflightBits.store(0);
+
+    _AllocateVersion();
+    _WriteDescriptors();
+}
+
+VkDeviceSize
+BgiVulkanResourceBindings::_WriteDynamicOffsets(
+    std::vector<uint32_t> const& dynamicOffsets)
+{
+    BgiVulkanDescriptorBuffer* descriptorBuffer =
+        _device->GetDescriptorBuffer();
+
+    // The copy is only used by this bind, so it lives in the frame ring.
+    BgiVulkanDescriptorBufferAllocation const allocation =
+        descriptorBuffer->Allocate(_descriptorBufferAllocation.size, true);
+    if (!UTILS_VERIFY(allocation.transient,
+            "Descriptor buffer ring is out of memory")) {
+        descriptorBuffer->Free(allocation);
+        return _descriptorBufferAllocation.offset;
+    }
+
+    descriptorBuffer->CopyDescriptors(
+        allocation.offset,
+        _descriptorBufferAllocation.offset,
+        _descriptorBufferAllocation.size);
+
+    size_t dynamicIndex = 0;
+    for (_BindingRange const& range : _bindingRanges) {
+        if (!range.dynamicOffset) {
+            continue;
+        }
+
+        VkDeviceSize const offset = allocation.offset +
+            descriptorBuffer->GetBindingOffset(
+                _vkDescriptorSetLayout, range.binding);
+        size_t const stride = descriptorBuffer->GetDescriptorSize(range.type);
+
+        for (uint32_t i=0; i<range.count; i++) {
+            BgiVulkanDescriptorInfo info = _descriptorInfos[range.firstInfo+i];
+            info.buffer.offset += dynamicOffsets[dynamicIndex++];
+            descriptorBuffer->WriteDescriptor(
+                offset + i * stride, range.type, info);
+        }
+    }
+
+    return allocation.offset;
+}
+
+void
+BgiVulkanResourceBindings::_ReleaseRetiredVersions(uint64_t queueInflightBits)
+{
+    BgiVulkanDescriptorBuffer* descriptorBuffer =
+        _device->GetDescriptorBuffer();
+    BgiVulkanDescriptorAllocator* descriptorAllocator =
+        _device->GetDescriptorAllocator();
+
+    // Transient versions are reclaimed by the allocators when the frame
+    // retires, Free ignores them.
+    auto it = _retiredVersions.begin();
+    while (it != _retiredVersions.end()) {
+        if ((it->inflightBits & queueInflightBits) != 0) {
+            ++it;
+            continue;
+        }
+
+        if (descriptorBuffer) {
+            descriptorBuffer->Free(it->descriptorBufferAllocation);
+        } else {
+            descriptorAllocator->Free(it->descriptorAllocation);
+        }
+        it = _retiredVersions.erase(it);
+    }
+}
+
 }
 
 GUNGNIR_NAMESPACE_CLOSE_SCOPE
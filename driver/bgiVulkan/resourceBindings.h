@@ -4,12 +4,19 @@
 
 #include "driver/bgiBase/resourceBindings.h"
 #include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/descriptorAllocator.h"
+#include "driver/bgiVulkan/descriptorBuffer.h"
+#include "driver/bgiVulkan/layoutCache.h"
 #include "driver/bgiVulkan/vulkanBridge.h"
 
+#include <atomic>
+#include <vector>
+
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
 
+class BgiVulkanCommandBuffer;
 class BgiVulkanDevice;
 
 ///
@@ -17,6 +24,23 @@ class BgiVulkanDevice;
 ///
 /// Vulkan implementation of HgiResourceBindings.
 ///
+/// Descriptors are gathered into a packed array that is written with a
+/// descriptor update template. Small sets are not allocated at all when the
+/// device supports push descriptors: the packed array is pushed into the
+/// command buffer each time the resources are bound.
+///
+/// On devices that use descriptor buffers the descriptors are written into a
+/// range of the device's BgiVulkanDescriptorBuffer and bound by offset.
+///
+/// Bindings can be updated in place. When the current descriptor set (or
+/// descriptor buffer range) is not used by any command buffer that is
+/// recording or in-flight, only the descriptors of the updated binding are
+/// rewritten. Otherwise a new version of the set is allocated and written,
+/// and the previous version is released once its command buffers completed.
+///
+/// Buffers with dynamic offsets are dynamic uniform and storage buffer
+/// descriptors. Descriptor buffers have no dynamic descriptors, so there the
+/// set is copied into a transient range with the offsets applied on bind.
 ///
 class BgiVulkanResourceBindings final : public BgiResourceBindings
 {
@@ -24,12 +48,27 @@ public:
     BGIVULKAN_API
     ~BgiVulkanResourceBindings() override;
 
+    BGIVULKAN_API
+    void UpdateBuffers(BgiBufferBindingDesc const& bufferDesc) override;
+
+    BGIVULKAN_API
+    void UpdateTextures(BgiTextureBindingDesc const& textureDesc) override;
+
     /// Binds the resources to GPU.
+    /// 'dynamicOffsets' holds an offset for each buffer bound with a dynamic
+    /// offset, ordered by binding.
+    /// Thread safety: Yes, the bindings may be bound by multiple threads.
     BGIVULKAN_API
     void BindResources(
-        VkCommandBuffer cb,
+        BgiVulkanCommandBuffer* cb,
         VkPipelineBindPoint bindPoint,
-        VkPipelineLayout layout);
+        VkPipelineLayout layout,
+        std::vector<uint32_t> const& dynamicOffsets);
+
+    /// Returns the number of updates of the bindings. Cmds compare it to
+    /// skip binding the same resources again when nothing changed.
+    BGIVULKAN_API
+    uint64_t GetUpdateCount() const;
 
     /// Returns the device used to create this object.
     BGIVULKAN_API
@@ -52,12 +91,84 @@ private:
     BgiVulkanResourceBindings & operator=(const BgiVulkanResourceBindings&) = delete;
     BgiVulkanResourceBindings(const BgiVulkanResourceBindings&) = delete;
 
+    // A binding of the set and the range of its descriptors in
+    // _descriptorInfos.
+    struct _BindingRange
+    {
+        uint32_t binding;
+        VkDescriptorType type;
+        uint32_t firstInfo;
+        uint32_t count;
+        bool dynamicOffset;
+    };
+
+    // A previous version of the set and the in-flight bits of the command
+    // buffers that bound it.
+    struct _RetiredVersion
+    {
+        uint64_t inflightBits;
+        BgiVulkanDescriptorAllocation descriptorAllocation;
+        BgiVulkanDescriptorBufferAllocation descriptorBufferAllocation;
+    };
+
+    // Returns the range of 'binding', or nullptr if the set does not have a
+    // binding of 'type' at that index.
+    _BindingRange const* _FindBindingRange(
+        uint32_t binding,
+        VkDescriptorType type) const;
+
+    // Gathers the descriptors of a buffer or texture binding into 'infos'.
+    void _GetBufferInfos(
+        BgiBufferBindingDesc const& bufDesc,
+        BgiVulkanDescriptorInfo* infos) const;
+    void _GetTextureInfos(
+        BgiTextureBindingDesc const& texDesc,
+        BgiVulkanDescriptorInfo* infos) const;
+
+    // Allocates a new version of the descriptor set.
+    void _AllocateVersion();
+
+    // Writes all descriptors, or those of one binding, into the current
+    // version of the set.
+    void _WriteDescriptors();
+    void _WriteDescriptors(_BindingRange const& range);
+
+    // Writes an updated binding, versioning the set if it is in use.
+    void _UpdateBinding(_BindingRange const& range);
+
+    // Copies the set into a transient descriptor buffer range with the
+    // dynamic offsets applied and returns the offset of the range.
+    VkDeviceSize _WriteDynamicOffsets(
+        std::vector<uint32_t> const& dynamicOffsets);
+
+    // Frees the versions that none of 'queueInflightBits' used.
+    void _ReleaseRetiredVersions(uint64_t queueInflightBits);
+
     BgiVulkanDevice* _device;
     uint64_t _inflightBits;
 
-    VkDescriptorPool _vkDescriptorPool;
+    BgiVulkanDescriptorAllocation _descriptorAllocation;
     VkDescriptorSetLayout _vkDescriptorSetLayout;
     VkDescriptorSet _vkDescriptorSet;
+
+    // The range holding the descriptors when the device uses descriptor
+    // buffers.
+    BgiVulkanDescriptorBufferAllocation _descriptorBufferAllocation;
+
+    // The descriptors of all bindings, ordered by binding. Push descriptor
+    // sets push them on bind, the others rewrite them into new versions.
+    bool _pushDescriptors;
+    BgiVulkanDescriptorInfoVector _descriptorInfos;
+    std::vector<_BindingRange> _bindingRanges;
+
+    VkDescriptorPoolSizeVector _poolSizes;
+    uint32_t _textureBindIndexStart;
+    uint32_t _dynamicOffsetCount;
+    uint64_t _updateCount;
+
+    // The command buffers that bound the current version of the set.
+    std::atomic<uint64_t> _boundInflightBits;
+    std::vector<_RetiredVersion> _retiredVersions;
 };
 
 }
@@ -1,6 +1,7 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/sampler.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
 #include "driver/bgiVulkan/capabilities.h"
 #include "driver/bgiVulkan/conversions.h"
 #include "driver/bgiVulkan/device.h"
@@ -18,6 +19,7 @@ BgiVulkanSampler::BgiVulkanSampler(
     , _vkSampler(nullptr)
     , _device(device)
     , _inflightBits(0)
+    , _bindlessIndex(BgiBindlessIndexInvalid)
 {
     VkSamplerCreateInfo sampler = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
     sampler.magFilter = BgiVulkanConversions::GetMinMagFilter(desc.magFilter);
@@ -53,10 +55,18 @@ BgiVulkanSampler::BgiVulkanSampler(
             BgiVulkanAllocator(),
             &_vkSampler) == VK_SUCCESS
     );
+
+    if (BgiVulkanBindlessHeap* heap = device->GetBindlessHeap()) {
+        _bindlessIndex = heap->RegisterSampler(_vkSampler);
+    }
 }
 
 BgiVulkanSampler::~BgiVulkanSampler()
 {
+    if (_bindlessIndex != BgiBindlessIndexInvalid) {
+        _device->GetBindlessHeap()->UnregisterSampler(_bindlessIndex);
+    }
+
     vkDestroySampler(
         _device->GetVulkanDevice(),
         _vkSampler,
@@ -69,6 +79,12 @@ BgiVulkanSampler::GetRawResource() const
     return (uint64_t) _vkSampler;
 }
 
+uint32_t
+BgiVulkanSampler::GetBindlessIndex() const
+{
+    return _bindlessIndex;
+}
+
 VkSampler
 BgiVulkanSampler::GetVulkanSampler() const
 {
@@ -26,6 +26,9 @@ public:
     BGIVULKAN_API
     uint64_t GetRawResource() const override;
 
+    BGIVULKAN_API
+    uint32_t GetBindlessIndex() const override;
+
     /// Returns the vulkan sampler object.
     BGIVULKAN_API
     VkSampler GetVulkanSampler() const;
@@ -55,6 +58,7 @@ private:
 
     BgiVulkanDevice* _device;
     uint64_t _inflightBits;
+    uint32_t _bindlessIndex;
 };
 
 }
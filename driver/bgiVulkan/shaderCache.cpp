@@ -0,0 +1,421 @@
+#include "common/arch/defines.h"
+#include "common/utils/diagnostic.h"
+
+#include "driver/bgiVulkan/shaderCache.h"
+#include "driver/bgiVulkan/shaderCompiler.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if defined(ARCH_OS_WINDOWS)
+#   include <process.h>
+#else
+#   include <unistd.h>
+#endif
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+static const uint32_t _spirvEntryMagic = 0x56505347; // 'GSPV'
+static const uint32_t _reflectionEntryMagic = 0x4c465247; // 'GRFL'
+static const uint32_t _entryVersion = 1;
+static const uint32_t _spirvMagicNumber = 0x07230203;
+
+// Entries larger than this are treated as corrupt rather than allocated.
+static const uint64_t _maxEntryByteSize = 64 * 1024 * 1024;
+
+struct _EntryHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t byteSize;
+};
+
+// Minimal little helpers to (de)serialize the reflection sidecar. All values
+// are stored as 32 bit integers in host byte order; the cache is local to the
+// machine that wrote it.
+static void
+_Write(std::vector<uint8_t>* data, uint32_t value)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data->insert(data->end(), bytes, bytes + sizeof(value));
+}
+
+static bool
+_Read(std::vector<uint8_t> const& data, size_t* offset, uint32_t* value)
+{
+    if (*offset + sizeof(uint32_t) > data.size()) {
+        return false;
+    }
+    memcpy(value, data.data() + *offset, sizeof(uint32_t));
+    *offset += sizeof(uint32_t);
+    return true;
+}
+
+// Reads an element count and checks that 'count' elements of at least
+// 'elementByteSize' bytes fit in the rest of the data, so a corrupt count is
+// a cache miss instead of a huge allocation.
+static bool
+_ReadCount(
+    std::vector<uint8_t> const& data,
+    size_t* offset,
+    size_t elementByteSize,
+    uint32_t* count)
+{
+    if (!_Read(data, offset, count)) {
+        return false;
+    }
+    return uint64_t(*count) * elementByteSize <= data.size() - *offset;
+}
+
+static long
+_GetProcessId()
+{
+#if defined(ARCH_OS_WINDOWS)
+    return (long) _getpid();
+#else
+    return (long) getpid();
+#endif
+}
+
+static uint64_t
+_HashBytes(uint64_t hash, const void* data, size_t byteSize)
+{
+    // 64 bit FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < byteSize; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+BgiVulkanShaderCache::BgiVulkanShaderCache()
+    : _compilerIdentifier(BgiVulkanGetShaderCompilerIdentifier())
+    , _enabled(false)
+{
+    if (const char* dir = std::getenv("GUNGNIR_SHADER_CACHE_DIR")) {
+        _directory = dir;
+    } else {
+        std::error_code ec;
+        _directory = std::filesystem::temp_directory_path(ec);
+        if (ec) {
+            return;
+        }
+        _directory /= "gungnir";
+        _directory /= "shaderCache";
+    }
+
+    if (_directory.empty()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(_directory, ec);
+    if (ec) {
+        UTILS_WARN("Unable to create shader cache directory %s\n",
+            _directory.string().c_str());
+        return;
+    }
+
+    _enabled = true;
+}
+
+BgiVulkanShaderCache::~BgiVulkanShaderCache()
+{
+}
+
+bool
+BgiVulkanShaderCache::IsEnabled() const
+{
+    return _enabled;
+}
+
+uint64_t
+BgiVulkanShaderCache::ComputeKey(
+    const char* shaderCode,
+    BgiShaderStage stage) const
+{
+    return ComputeKey(
+        shaderCode, shaderCode ? strlen(shaderCode) : 0, stage);
+}
+
+uint64_t
+BgiVulkanShaderCache::ComputeKey(
+    const void* data,
+    size_t byteSize,
+    BgiShaderStage stage) const
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = _HashBytes(
+        hash, _compilerIdentifier.data(), _compilerIdentifier.size());
+    hash = _HashBytes(hash, &stage, sizeof(stage));
+    if (data) {
+        hash = _HashBytes(hash, data, byteSize);
+    }
+    return hash;
+}
+
+bool
+BgiVulkanShaderCache::LoadSpirv(
+    uint64_t key,
+    std::vector<unsigned int>* spirvOUT) const
+{
+    if (!spirvOUT) {
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    if (!_ReadEntry(key, ".spv", _spirvEntryMagic, &data) ||
+        data.size() < sizeof(uint32_t) ||
+        data.size() % sizeof(unsigned int) != 0) {
+        return false;
+    }
+
+    std::vector<unsigned int> spirv(data.size() / sizeof(unsigned int));
+    memcpy(spirv.data(), data.data(), data.size());
+
+    if (spirv[0] != _spirvMagicNumber) {
+        return false;
+    }
+
+    *spirvOUT = std::move(spirv);
+    return true;
+}
+
+void
+BgiVulkanShaderCache::StoreSpirv(
+    uint64_t key,
+    std::vector<unsigned int> const& spirv)
+{
+    if (spirv.empty()) {
+        return;
+    }
+
+    _WriteEntry(key, ".spv", _spirvEntryMagic,
+                spirv.data(), spirv.size() * sizeof(unsigned int));
+}
+
+bool
+BgiVulkanShaderCache::LoadReflection(
+    uint64_t key,
+    BgiVulkanShaderReflection* reflectionOUT) const
+{
+    if (!reflectionOUT) {
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    if (!_ReadEntry(key, ".refl", _reflectionEntryMagic, &data)) {
+        return false;
+    }
+
+    BgiVulkanShaderReflection reflection;
+    size_t offset = 0;
+
+    // A set holds its number and binding count, a binding and a push
+    // constant range hold 4 and 3 values.
+    uint32_t setCount = 0;
+    if (!_ReadCount(data, &offset, 2 * sizeof(uint32_t), &setCount)) {
+        return false;
+    }
+
+    reflection.descriptorSetInfo.resize(setCount);
+    for (BgiVulkanDescriptorSetInfo& info : reflection.descriptorSetInfo) {
+        uint32_t bindingCount = 0;
+        if (!_Read(data, &offset, &info.setNumber) ||
+            !_ReadCount(
+                data, &offset, 4 * sizeof(uint32_t), &bindingCount)) {
+            return false;
+        }
+
+        info.bindings.resize(bindingCount);
+        for (VkDescriptorSetLayoutBinding& binding : info.bindings) {
+            uint32_t descriptorType = 0;
+            if (!_Read(data, &offset, &binding.binding) ||
+                !_Read(data, &offset, &descriptorType) ||
+                !_Read(data, &offset, &binding.descriptorCount) ||
+                !_Read(data, &offset, &binding.stageFlags)) {
+                return false;
+            }
+            binding.descriptorType = (VkDescriptorType) descriptorType;
+        }
+    }
+
+    uint32_t rangeCount = 0;
+    if (!_ReadCount(data, &offset, 3 * sizeof(uint32_t), &rangeCount)) {
+        return false;
+    }
+
+    reflection.pushConstantRanges.resize(rangeCount);
+    for (VkPushConstantRange& range : reflection.pushConstantRanges) {
+        if (!_Read(data, &offset, &range.stageFlags) ||
+            !_Read(data, &offset, &range.offset) ||
+            !_Read(data, &offset, &range.size)) {
+            return false;
+        }
+    }
+
+    for (uint32_t& size : reflection.localSize) {
+        if (!_Read(data, &offset, &size)) {
+            return false;
+        }
+    }
+
+    if (offset != data.size()) {
+        return false;
+    }
+
+    *reflectionOUT = std::move(reflection);
+    return true;
+}
+
+void
+BgiVulkanShaderCache::StoreReflection(
+    uint64_t key,
+    BgiVulkanShaderReflection const& reflection)
+{
+    std::vector<uint8_t> data;
+
+    _Write(&data, (uint32_t) reflection.descriptorSetInfo.size());
+    for (BgiVulkanDescriptorSetInfo const& info :
+            reflection.descriptorSetInfo) {
+        _Write(&data, info.setNumber);
+        _Write(&data, (uint32_t) info.bindings.size());
+        for (VkDescriptorSetLayoutBinding const& binding : info.bindings) {
+            _Write(&data, binding.binding);
+            _Write(&data, (uint32_t) binding.descriptorType);
+            _Write(&data, binding.descriptorCount);
+            _Write(&data, binding.stageFlags);
+        }
+    }
+
+    _Write(&data, (uint32_t) reflection.pushConstantRanges.size());
+    for (VkPushConstantRange const& range : reflection.pushConstantRanges) {
+        _Write(&data, range.stageFlags);
+        _Write(&data, range.offset);
+        _Write(&data, range.size);
+    }
+
+    for (uint32_t size : reflection.localSize) {
+        _Write(&data, size);
+    }
+
+    _WriteEntry(key, ".refl", _reflectionEntryMagic, data.data(), data.size());
+}
+
+bool
+BgiVulkanShaderCache::_ReadEntry(
+    uint64_t key,
+    const char* extension,
+    uint32_t magic,
+    std::vector<uint8_t>* dataOUT) const
+{
+    if (!_enabled) {
+        return false;
+    }
+
+    std::ifstream file(_GetEntryPath(key, extension), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    std::streamoff const fileByteSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (fileByteSize < std::streamoff(sizeof(_EntryHeader))) {
+        return false;
+    }
+
+    // The payload must fill the rest of the file exactly. A truncated or
+    // corrupt entry is a cache miss.
+    _EntryHeader header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != magic ||
+        header.version != _entryVersion ||
+        header.key != key ||
+        header.byteSize == 0 ||
+        header.byteSize > _maxEntryByteSize ||
+        header.byteSize != uint64_t(fileByteSize) - sizeof(header)) {
+        return false;
+    }
+
+    dataOUT->resize(header.byteSize);
+    if (!file.read(reinterpret_cast<char*>(dataOUT->data()),
+                   dataOUT->size())) {
+        return false;
+    }
+
+    return true;
+}
+
+void
+BgiVulkanShaderCache::_WriteEntry(
+    uint64_t key,
+    const char* extension,
+    uint32_t magic,
+    const void* data,
+    size_t byteSize)
+{
+    if (!_enabled || byteSize == 0) {
+        return;
+    }
+
+    _EntryHeader header = {};
+    header.magic = magic;
+    header.version = _entryVersion;
+    header.key = key;
+    header.byteSize = byteSize;
+
+    // Write to a file unique to this process and thread and rename it into
+    // place so that concurrent readers never see a partially written entry.
+    // Thread ids and the counter are only unique within a process, so the
+    // process id keeps processes sharing the directory apart.
+    static std::atomic<uint32_t> tmpCounter(0);
+    std::ostringstream tmpExt;
+    tmpExt << ".tmp" << _GetProcessId() << "_"
+           << std::this_thread::get_id() << "_" << tmpCounter++;
+
+    std::filesystem::path const tmpPath =
+        _GetEntryPath(key, tmpExt.str().c_str());
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data), byteSize);
+        if (!file) {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, _GetEntryPath(key, extension), ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+
+std::filesystem::path
+BgiVulkanShaderCache::_GetEntryPath(
+    uint64_t key,
+    const char* extension) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return _directory / (std::string(name) + extension);
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/enums.h"
+#include "driver/bgiVulkan/api.h"
+#include "driver/bgiVulkan/shaderCompiler.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+/// \class BgiVulkanShaderCache
+///
+/// Content-addressed on-disk cache of compiled spirv.
+///
+/// Next to each spirv blob the cache keeps a small binary sidecar with the
+/// module's reflection data (descriptor sets, push constant ranges and local
+/// work group size), so cache hits also skip spirv reflection.
+///
+/// Entries are keyed by a hash of the generated shader source, the shader
+/// stage and the compiler identifier (compiler version and target
+/// environment). A relaunch that generates the same shader source loads the
+/// spirv from disk and never calls the compiler.
+///
+/// The cache directory is taken from the GUNGNIR_SHADER_CACHE_DIR environment
+/// variable, or defaults to 'gungnir/shaderCache' in the temp directory.
+/// Setting GUNGNIR_SHADER_CACHE_DIR to an empty string disables the cache.
+///
+/// Thread safety: Load and Store may be called from multiple threads (and
+/// multiple processes). Entries are written to a temporary file and renamed
+/// into place so readers never observe partially written entries.
+///
+class BgiVulkanShaderCache final
+{
+public:
+    BGIVULKAN_API
+    BgiVulkanShaderCache();
+
+    BGIVULKAN_API
+    ~BgiVulkanShaderCache();
+
+    /// Returns true if the cache has a usable directory.
+    BGIVULKAN_API
+    bool IsEnabled() const;
+
+    /// Returns the content-address for the provided generated shader source.
+    BGIVULKAN_API
+    uint64_t ComputeKey(const char* shaderCode, BgiShaderStage stage) const;
+
+    /// Returns the content-address for an arbitrary blob identifying the
+    /// shader (e.g. the hash of a linked slang program).
+    BGIVULKAN_API
+    uint64_t ComputeKey(
+        const void* data,
+        size_t byteSize,
+        BgiShaderStage stage) const;
+
+    /// Loads the spirv stored for 'key'. Returns false on a cache miss or when
+    /// the stored entry is corrupt.
+    BGIVULKAN_API
+    bool LoadSpirv(uint64_t key, std::vector<unsigned int>* spirvOUT) const;
+
+    /// Stores the spirv for 'key'.
+    BGIVULKAN_API
+    void StoreSpirv(uint64_t key, std::vector<unsigned int> const& spirv);
+
+    /// Loads the reflection sidecar stored next to the spirv for 'key'.
+    /// Returns false on a cache miss or when the stored entry is corrupt.
+    BGIVULKAN_API
+    bool LoadReflection(
+        uint64_t key,
+        BgiVulkanShaderReflection* reflectionOUT) const;
+
+    /// Stores the reflection sidecar for 'key'.
+    BGIVULKAN_API
+    void StoreReflection(
+        uint64_t key,
+        BgiVulkanShaderReflection const& reflection);
+
+private:
+    BgiVulkanShaderCache & operator=(const BgiVulkanShaderCache&) = delete;
+    BgiVulkanShaderCache(const BgiVulkanShaderCache&) = delete;
+
+    // Reads the payload of an entry, verifying its header.
+    bool _ReadEntry(
+        uint64_t key,
+        const char* extension,
+        uint32_t magic,
+        std::vector<uint8_t>* dataOUT) const;
+
+    // Writes an entry to a temporary file and renames it into place.
+    void _WriteEntry(
+        uint64_t key,
+        const char* extension,
+        uint32_t magic,
+        const void* data,
+        size_t byteSize);
+
+    // Returns the path of the file holding the entry for key.
+    std::filesystem::path _GetEntryPath(
+        uint64_t key,
+        const char* extension) const;
+
+    std::filesystem::path _directory;
+    std::string _compilerIdentifier;
+    bool _enabled;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -1,40 +1,66 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/shaderCompiler.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
 #include "driver/bgiVulkan/conversions.h"
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
+#include "driver/bgiVulkan/layoutCache.h"
 #include "driver/bgiVulkan/spirv_reflect.h"
 
-//#include <shaderc/shaderc.hpp>
+#include <shaderc/shaderc.hpp>
+#if __has_include(<glslang/build_info.h>)
+#   include <glslang/build_info.h>
+#endif
 
-#include <unordered_map>
+#include <cstdio>
+#include <map>
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
 
-//static shaderc_shader_kind
-//_GetShaderStage(BgiShaderStage stage)
-//{
-//    switch(stage) {
-//        case BgiShaderStageVertex:
-//            return shaderc_glsl_vertex_shader;
-//        case BgiShaderStageTessellationControl:
-//            return shaderc_glsl_tess_control_shader;
-//        case BgiShaderStageTessellationEval:
-//            return shaderc_glsl_tess_evaluation_shader;
-//        case BgiShaderStageGeometry:
-//            return shaderc_glsl_geometry_shader;
-//        case BgiShaderStageFragment:
-//            return shaderc_glsl_fragment_shader;
-//        case BgiShaderStageCompute:
-//            return shaderc_glsl_compute_shader;
-//    }
-//
-//    UTILS_CODING_ERROR("Unknown stage");
-//    return shaderc_glsl_infer_from_source;
-//}
+// The target environment the GLSL is compiled for. These are part of the
+// shader cache key, so bumping them invalidates previously cached spirv.
+static const shaderc_env_version _targetEnvVersion =
+    shaderc_env_version_vulkan_1_0;
+static const shaderc_spirv_version _targetSpirvVersion =
+    shaderc_spirv_version_1_0;
+
+// The options every GLSL compile uses. The compiler identifier is derived
+// from them, so they can not drift apart.
+static shaderc::CompileOptions
+_GetCompileOptions()
+{
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_vulkan,
+                                 _targetEnvVersion);
+    options.SetTargetSpirv(_targetSpirvVersion);
+    options.SetOptimizationLevel(shaderc_optimization_level_zero);
+    return options;
+}
+
+static shaderc_shader_kind
+_GetShaderStage(BgiShaderStage stage)
+{
+    switch(stage) {
+        case BgiShaderStageVertex:
+            return shaderc_glsl_vertex_shader;
+        case BgiShaderStageTessellationControl:
+            return shaderc_glsl_tess_control_shader;
+        case BgiShaderStageTessellationEval:
+            return shaderc_glsl_tess_evaluation_shader;
+        case BgiShaderStageGeometry:
+            return shaderc_glsl_geometry_shader;
+        case BgiShaderStageFragment:
+            return shaderc_glsl_fragment_shader;
+        case BgiShaderStageCompute:
+            return shaderc_glsl_compute_shader;
+    }
+
+    UTILS_CODING_ERROR("Unknown stage");
+    return shaderc_glsl_infer_from_source;
+}
 
 bool
 BgiVulkanCompileGLSL(
@@ -47,7 +73,8 @@ BgiVulkanCompileGLSL(
 {
     if (numShaderCodes==0 || !spirvOUT) {
         if (errors) {
-            errors->append("No shader to compile %s", name);
+            errors->append("No shader to compile ");
+            errors->append(name);
         }
         return false;
     }
@@ -57,10 +84,7 @@ BgiVulkanCompileGLSL(
         source += shaderCodes[i];
     }
 
-    /*shaderc::CompileOptions options;
-    options.SetTargetEnvironment(shaderc_target_env_vulkan,
-                                 shaderc_env_version_vulkan_1_0);
-    options.SetTargetSpirv(shaderc_spirv_version_1_0);
+    shaderc::CompileOptions const options = _GetCompileOptions();
 
     shaderc_shader_kind const kind = _GetShaderStage(stage);
 
@@ -69,15 +93,76 @@ BgiVulkanCompileGLSL(
         compiler.CompileGlslToSpv(source, kind, name, options);
 
     if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
-        *errors = result.GetErrorMessage();
+        if (errors) {
+            *errors = result.GetErrorMessage();
+        }
         return false;
-    }*/
+    }
 
-    //spirvOUT->assign(result.cbegin(), result.cend());
+    spirvOUT->assign(result.cbegin(), result.cend());
 
     return true;
 }
 
+static std::string
+_ComputeShaderCompilerIdentifier()
+{
+    std::string identifier = "shaderc";
+
+#if defined(GLSLANG_VERSION_MAJOR)
+    identifier += "-glslang" + std::to_string(GLSLANG_VERSION_MAJOR) +
+        "." + std::to_string(GLSLANG_VERSION_MINOR) +
+        "." + std::to_string(GLSLANG_VERSION_PATCH) +
+        GLSLANG_VERSION_FLAVOR;
+#endif
+
+    identifier += "-env" + std::to_string((uint32_t)_targetEnvVersion) +
+        "-spirv" + std::to_string((uint32_t)_targetSpirvVersion) +
+        "-opt" + std::to_string((uint32_t)shaderc_optimization_level_zero);
+
+    // shaderc does not report its own build, and the glslang header is not
+    // always installed. Compile a fixed probe shader instead: its spirv
+    // carries the generator version of glslang and changes with the code
+    // generation, so an upgraded compiler never hits stale cache entries.
+    static const char* probe =
+        "#version 450\n"
+        "layout(location = 0) in vec4 inValue;\n"
+        "layout(location = 0) out vec4 outValue;\n"
+        "layout(set = 0, binding = 0) uniform sampler2D tex;\n"
+        "void main() {\n"
+        "    outValue = texture(tex, inValue.xy) * inValue.z + inValue.w;\n"
+        "}\n";
+
+    shaderc::Compiler compiler;
+    shaderc::SpvCompilationResult const result = compiler.CompileGlslToSpv(
+        probe, shaderc_glsl_fragment_shader, "probe", _GetCompileOptions());
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+        UTILS_CODING_ERROR("Failed to compile the shader compiler probe");
+        return identifier;
+    }
+
+    // 64 bit FNV-1a over the probe spirv words.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint32_t word : result) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (word >> (i * 8)) & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    char hashString[17];
+    snprintf(hashString, sizeof(hashString), "%016llx",
+        (unsigned long long)hash);
+    return identifier + "-probe" + hashString;
+}
+
+std::string
+BgiVulkanGetShaderCompilerIdentifier()
+{
+    static const std::string identifier = _ComputeShaderCompilerIdentifier();
+    return identifier;
+}
+
 static bool
 _VerifyResults(SpvReflectShaderModule* module, SpvReflectResult const& result)
 {
@@ -89,62 +174,41 @@ _VerifyResults(SpvReflectShaderModule* module, SpvReflectResult const& result)
     return true;
 }
 
-static VkDescriptorSetLayout
-_CreateDescriptorSetLayout(
-    BgiVulkanDevice* device,
-    VkDescriptorSetLayoutCreateInfo const& createInfo,
-    std::string const& debugName)
-{
-    VkDescriptorSetLayout layout = nullptr;
-    UTILS_VERIFY(
-        vkCreateDescriptorSetLayout(
-            device->GetVulkanDevice(),
-            &createInfo,
-            BgiVulkanAllocator(),
-            &layout) == VK_SUCCESS
-    );
-
-    // Debug label
-    if (!debugName.empty()) {
-        std::string debugLabel = "DescriptorSetLayout " + debugName;
-        BgiVulkanSetDebugName(
-            device,
-            (uint64_t)layout,
-            VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
-            debugLabel.c_str());
-    }
-
-    return layout;
-}
-
-BgiVulkanDescriptorSetInfoVector
-BgiVulkanGatherDescriptorSetInfo(
-    std::vector<unsigned int> const& spirv)
+bool
+BgiVulkanReflectSpirv(
+    std::vector<unsigned int> const& spirv,
+    BgiVulkanShaderReflection* reflectionOUT)
 {
     // This code is based on main_descriptors.cpp in the SPIRV-Reflect repo.
 
+    if (!reflectionOUT) {
+        return false;
+    }
+
     SpvReflectShaderModule module = {};
     SpvReflectResult result = spvReflectCreateShaderModule(
         spirv.size()*sizeof(uint32_t), spirv.data(), &module);
     if (!_VerifyResults(&module, result)) {
-        return BgiVulkanDescriptorSetInfoVector();
+        return false;
     }
 
     uint32_t count = 0;
     result = spvReflectEnumerateDescriptorSets(&module, &count, NULL);
     if (!_VerifyResults(&module, result)) {
-        return BgiVulkanDescriptorSetInfoVector();
+        return false;
     }
 
     std::vector<SpvReflectDescriptorSet*> sets(count);
     result = spvReflectEnumerateDescriptorSets(&module, &count, sets.data());
     if (!_VerifyResults(&module, result)) {
-        return BgiVulkanDescriptorSetInfoVector();
+        return false;
     }
 
     // Generate all necessary data structures to create a VkDescriptorSetLayout
     // for each descriptor set in this shader.
-    std::vector<BgiVulkanDescriptorSetInfo> infos(sets.size());
+    BgiVulkanDescriptorSetInfoVector& infos = reflectionOUT->descriptorSetInfo;
+    infos.clear();
+    infos.resize(sets.size());
 
     for (size_t s = 0; s < sets.size(); s++) {
         SpvReflectDescriptorSet const& reflSet = *(sets[s]);
@@ -171,9 +235,44 @@ BgiVulkanGatherDescriptorSetInfo(
         info.setNumber = reflSet.set;
     }
 
+    // Push constant blocks
+    count = 0;
+    result = spvReflectEnumeratePushConstantBlocks(&module, &count, NULL);
+    if (!_VerifyResults(&module, result)) {
+        return false;
+    }
+
+    std::vector<SpvReflectBlockVariable*> blocks(count);
+    result = spvReflectEnumeratePushConstantBlocks(
+        &module, &count, blocks.data());
+    if (!_VerifyResults(&module, result)) {
+        return false;
+    }
+
+    reflectionOUT->pushConstantRanges.clear();
+    for (SpvReflectBlockVariable const* block : blocks) {
+        VkPushConstantRange range = {};
+        range.stageFlags =
+            static_cast<VkShaderStageFlagBits>(module.shader_stage);
+        range.offset = block->offset;
+        range.size = block->size;
+        reflectionOUT->pushConstantRanges.push_back(range);
+    }
+
+    // Local work group size
+    reflectionOUT->localSize[0] = 0;
+    reflectionOUT->localSize[1] = 0;
+    reflectionOUT->localSize[2] = 0;
+    if (module.entry_point_count > 0 &&
+        module.shader_stage == SPV_REFLECT_SHADER_STAGE_COMPUTE_BIT) {
+        reflectionOUT->localSize[0] = module.entry_points[0].local_size.x;
+        reflectionOUT->localSize[1] = module.entry_points[0].local_size.y;
+        reflectionOUT->localSize[2] = module.entry_points[0].local_size.z;
+    }
+
     spvReflectDestroyShaderModule(&module);
 
-    return infos;
+    return true;
 }
 
 static bool
@@ -190,7 +289,8 @@ BgiVulkanMakeDescriptorSetLayouts(
     std::vector<BgiVulkanDescriptorSetInfoVector> const& infos,
     std::string const& debugName)
 {
-    std::unordered_map<uint32_t, BgiVulkanDescriptorSetInfo> mergedInfos;
+    // Ordered by set number so the layouts are returned in set order.
+    std::map<uint32_t, BgiVulkanDescriptorSetInfo> mergedInfos;
 
     // Merge the binding info of each of the infos such that the resource
     // bindings information for each of the shader stage modules is merged
@@ -226,6 +326,14 @@ BgiVulkanMakeDescriptorSetLayouts(
                     dst = &trg.bindings.back();
                 }
 
+                // A buffer is dynamic if any stage declared it so.
+                if (bi.descriptorType ==
+                        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+                    bi.descriptorType ==
+                        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) {
+                    dst->descriptorType = bi.descriptorType;
+                }
+
                 // These need to match the shader stages used when creating the
                 // VkDescriptorSetLayout in HgiVulkanResourceBindings.
                 if (dst->stageFlags != BgiVulkanConversions::GetShaderStages(
@@ -250,22 +358,41 @@ BgiVulkanMakeDescriptorSetLayouts(
         }
     }
 
-    // Generate the VkDescriptorSetLayoutCreateInfos for the bindings we merged.
-    for (auto& pair : mergedInfos) {
-        BgiVulkanDescriptorSetInfo& info = pair.second;
-        info.createInfo.sType =
-            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        info.createInfo.bindingCount = info.bindings.size();
-        info.createInfo.pBindings = info.bindings.data();
+    // Get the VkDescriptorSetLayouts for the merged infos from the device's
+    // layout cache, so identical layouts are shared between pipelines.
+    BgiVulkanLayoutCache* layoutCache = device->GetLayoutCache();
+    BgiVulkanBindlessHeap* heap = device->GetBindlessHeap();
+    VkDescriptorSetLayoutVector layouts;
+
+    if (mergedInfos.empty()) {
+        return layouts;
     }
 
-    // Create VkDescriptorSetLayouts out of the merge infos above.
-    VkDescriptorSetLayoutVector layouts;
+    // The index of a layout in the pipeline layout is its set number, so
+    // sets the shaders do not use get an empty layout.
+    const uint32_t setCount = mergedInfos.rbegin()->first + 1;
+    for (uint32_t set=0; set<setCount; set++) {
+        // Shaders access the bindless heap at a fixed set. Use the heap's
+        // layout (with its update-after-bind flags) instead of the reflected
+        // bindings so the heap's descriptor set is compatible.
+        if (heap && set == BgiVulkanBindlessHeap::SetIndex) {
+            layouts.push_back(heap->AcquireDescriptorSetLayout());
+            continue;
+        }
+
+        auto it = mergedInfos.find(set);
+        VkDescriptorSetLayoutBindingVector const bindings =
+            it != mergedInfos.end() ? it->second.bindings :
+                VkDescriptorSetLayoutBindingVector();
+
+        // Set 0 holds the resource bindings. It is a push descriptor set
+        // when BgiVulkanResourceBindings would push the same bindings.
+        VkDescriptorSetLayoutCreateFlags const flags = (set == 0) ?
+            layoutCache->GetResourceSetLayoutFlags(bindings) : 0;
 
-    for (auto const& pair : mergedInfos) {
-        BgiVulkanDescriptorSetInfo const& info = pair.second;
-        VkDescriptorSetLayout layout = _CreateDescriptorSetLayout(
-            device, info.createInfo, debugName);
+        VkDescriptorSetLayout layout =
+            layoutCache->AcquireDescriptorSetLayout(
+                bindings, flags, debugName);
         layouts.push_back(layout);
     }
 
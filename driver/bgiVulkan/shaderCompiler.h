@@ -29,6 +29,29 @@ using BgiVulkanDescriptorSetInfoVector =
 
 using VkDescriptorSetLayoutVector = std::vector<VkDescriptorSetLayout>;
 
+using VkPushConstantRangeVector = std::vector<VkPushConstantRange>;
+
+/// \struct BgiVulkanShaderReflection
+///
+/// Everything the Vulkan backend needs to know about a spirv module to create
+/// pipeline layouts, obtained via spirv reflection.
+///
+/// <ul>
+/// <li>descriptorSetInfo:
+///   The descriptor set layout bindings used by the module.</li>
+/// <li>pushConstantRanges:
+///   The push constant blocks used by the module.</li>
+/// <li>localSize:
+///   The local work group size of compute modules, zero otherwise.</li>
+/// </ul>
+///
+struct BgiVulkanShaderReflection
+{
+    BgiVulkanDescriptorSetInfoVector descriptorSetInfo;
+    VkPushConstantRangeVector pushConstantRanges;
+    uint32_t localSize[3] = {0, 0, 0};
+};
+
 
 /// Compiles ascii shader code (glsl) into spirv binary code (spirvOut).
 /// Returns true if successful. Errors can optionally be captured.
@@ -43,21 +66,27 @@ bool BgiVulkanCompileGLSL(
     std::vector<unsigned int>* spirvOUT,
     std::string* errors = nullptr);
 
-/// Uses spirv-reflection to create new descriptor set layout information for
-/// the provided spirv.
-/// This information can be merged with the info of the other shader stage
-/// modules to create the pipeline layout.
-/// During Hgi pipeline layout creation we know the shader modules
-/// (HgiShaderProgram), but not the HgiResourceBindings so we must use
-/// spirv reflection to discover the descriptorSet info for the module.
+/// Returns a string identifying the compiler build and the compile options
+/// used by BgiVulkanCompileGLSL. The shader cache mixes this into its keys so
+/// that spirv cached by a different compiler version is never reused.
+/// The first call compiles a small probe shader.
+BGIVULKAN_API
+std::string BgiVulkanGetShaderCompilerIdentifier();
+
+/// Uses spirv-reflection to gather the descriptor sets, push constant ranges
+/// and local work group size of the provided spirv in a single pass.
+/// Returns false if the spirv could not be reflected.
 BGIVULKAN_API
-BgiVulkanDescriptorSetInfoVector BgiVulkanGatherDescriptorSetInfo(
-    std::vector<unsigned int> const& spirv);
+bool BgiVulkanReflectSpirv(
+    std::vector<unsigned int> const& spirv,
+    BgiVulkanShaderReflection* reflectionOUT);
 
 /// Given all of the DescriptorSetInfos of all of the shader modules in a
 /// shader program, this function merges them and creates the descriptorSet
 /// layouts needed during pipeline layout creation.
-/// The caller takes ownership of the returned layouts and must destroy them.
+/// The layouts are acquired from the device's BgiVulkanLayoutCache and are
+/// returned in set order. The caller must release each of them with
+/// BgiVulkanLayoutCache::ReleaseDescriptorSetLayout.
 BGIVULKAN_API
 VkDescriptorSetLayoutVector BgiVulkanMakeDescriptorSetLayouts(
     BgiVulkanDevice* device,
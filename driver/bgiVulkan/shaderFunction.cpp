@@ -1,4 +1,5 @@
 #include "common/utils/diagnostic.h"
+#include "common/utils/trace.h"
 
 #include "driver/bgiVulkan/shaderFunction.h"
 #include "driver/bgiVulkan/conversions.h"
@@ -6,13 +7,47 @@
 #include "driver/bgiVulkan/diagnostic.h"
 #include "driver/bgiVulkan/garbageCollector.h"
 #include "driver/bgiVulkan/bgi.h"
+#include "driver/bgiVulkan/shaderCache.h"
 #include "driver/bgiVulkan/shaderCompiler.h"
 #include "driver/bgiVulkan/shaderGenerator.h"
+#include "driver/slangDriver/slangDriver.h"
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
 namespace driver {
 
+static void
+_ApplyDynamicOffsets(
+    BgiShaderFunctionDesc const& desc,
+    BgiVulkanShaderReflection* reflection)
+{
+    for (BgiShaderFunctionBufferDesc const& buffer : desc.buffers) {
+        if (!buffer.dynamicOffset || buffer.bindless) {
+            continue;
+        }
+
+        // Resource bindings are always in set 0.
+        for (BgiVulkanDescriptorSetInfo& info : reflection->descriptorSetInfo) {
+            if (info.setNumber != 0) {
+                continue;
+            }
+            for (VkDescriptorSetLayoutBinding& bi : info.bindings) {
+                if (bi.binding != buffer.bindIndex) {
+                    continue;
+                }
+                if (bi.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+                    bi.descriptorType =
+                        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                } else if (bi.descriptorType ==
+                        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+                    bi.descriptorType =
+                        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+                }
+            }
+        }
+    }
+}
+
 BgiVulkanShaderFunction::BgiVulkanShaderFunction(
     BgiVulkanDevice* device,
     Bgi const* bgi,
@@ -29,21 +64,12 @@ BgiVulkanShaderFunction::BgiVulkanShaderFunction(
 
     std::vector<unsigned int> spirv;
 
-    const char* debugLbl = _descriptor.debugName.empty() ?
-        "unknown" : _descriptor.debugName.c_str();
-
-    BgiVulkanShaderGenerator shaderGenerator(bgi, desc);
-    shaderGenerator.Execute();
-    const char *shaderCode = shaderGenerator.GetGeneratedShaderCode();
-
-    // Compile shader and capture errors
-    bool result = BgiVulkanCompileGLSL(
-        debugLbl,
-        &shaderCode,
-        1,
-        desc.shaderStage,
-        &spirv,
-        &_errors);
+    // Slang functions are compiled from a module loaded in the slang session,
+    // all other functions from the glsl emitted by the shader generator.
+    uint64_t cacheKey = 0;
+    const bool result = _descriptor.slangModule.empty() ?
+        _CompileGLSL(bgi, desc, &spirv, &cacheKey) :
+        _CompileSlang(&spirv, &cacheKey);
 
     // Create vulkan module if there were no errors.
     if (result) {
@@ -77,14 +103,115 @@ BgiVulkanShaderFunction::BgiVulkanShaderFunction(
         // for its HgiPipeline descriptor, but does provide the shader program.
         // We mimic Metal where the resource binding info is inferred from the
         // Metal shader program.
-        _descriptorSetInfo = BgiVulkanGatherDescriptorSetInfo(spirv);
+        // The reflection results are cached next to the spirv, so only
+        // reflect when the sidecar is missing.
+        BgiVulkanShaderCache* shaderCache = device->GetShaderCache();
+        if (!shaderCache->LoadReflection(cacheKey, &_reflection)) {
+            if (BgiVulkanReflectSpirv(spirv, &_reflection)) {
+                shaderCache->StoreReflection(cacheKey, _reflection);
+            }
+        }
+
+        // Spirv does not tell dynamic uniform and storage buffers apart
+        // from regular ones, so apply the buffers declared with dynamic
+        // offsets to the reflected resource set.
+        _ApplyDynamicOffsets(desc, &_reflection);
     }
+}
+
+bool
+BgiVulkanShaderFunction::_CompileGLSL(
+    Bgi const* bgi,
+    BgiShaderFunctionDesc const& desc,
+    std::vector<unsigned int>* spirvOUT,
+    uint64_t* cacheKeyOUT)
+{
+    UTILS_TRACE_FUNCTION();
+
+    const char* debugLbl = _descriptor.debugName.empty() ?
+        "unknown" : _descriptor.debugName.c_str();
+
+    BgiVulkanShaderGenerator shaderGenerator(bgi, desc);
+    shaderGenerator.Execute();
+    const char *shaderCode = shaderGenerator.GetGeneratedShaderCode();
 
-    // Clear these pointers in our copy of the descriptor since we
-    // have to assume they could become invalid after we return.
-    _descriptor.shaderCodeDeclarations = nullptr;
-    _descriptor.shaderCode = nullptr;
-    _descriptor.generatedShaderCodeOut = nullptr;
+    // Look for previously compiled spirv of the same generated source before
+    // invoking the compiler.
+    BgiVulkanShaderCache* shaderCache = _device->GetShaderCache();
+    const uint64_t cacheKey =
+        shaderCache->ComputeKey(shaderCode, desc.shaderStage);
+    *cacheKeyOUT = cacheKey;
+
+    if (shaderCache->LoadSpirv(cacheKey, spirvOUT)) {
+        return true;
+    }
+
+    // Compile shader and capture errors
+    const bool result = BgiVulkanCompileGLSL(
+        debugLbl,
+        &shaderCode,
+        1,
+        desc.shaderStage,
+        spirvOUT,
+        &_errors);
+
+    if (result) {
+        shaderCache->StoreSpirv(cacheKey, *spirvOUT);
+    }
+
+    return result;
+}
+
+bool
+BgiVulkanShaderFunction::_CompileSlang(
+    std::vector<unsigned int>* spirvOUT,
+    uint64_t* cacheKeyOUT)
+{
+    UTILS_TRACE_FUNCTION();
+
+    SlangDriver* slangDriver = _device->GetSlangDriver();
+    if (!slangDriver || !slangDriver->IsValid()) {
+        _errors = "Slang is not available to compile " +
+                _descriptor.slangModule;
+        return false;
+    }
+
+    // Linking reuses modules already loaded in the slang session, so shared
+    // libraries are only parsed and checked once.
+    SlangDriverProgram program;
+    if (!slangDriver->Link(
+            _descriptor.slangModule.c_str(),
+            _descriptor.slangEntryPoint.c_str(),
+            &program,
+            &_errors)) {
+        if (_errors.empty()) {
+            _errors = "Failed to link slang module " +
+                _descriptor.slangModule;
+        }
+        return false;
+    }
+
+    // Code generation is the expensive step. Skip it when the spirv of an
+    // identical linked program is in the cache.
+    BgiVulkanShaderCache* shaderCache = _device->GetShaderCache();
+    const uint64_t cacheKey = shaderCache->ComputeKey(
+        program.hash.data(), program.hash.size(), _descriptor.shaderStage);
+    *cacheKeyOUT = cacheKey;
+
+    if (shaderCache->LoadSpirv(cacheKey, spirvOUT)) {
+        return true;
+    }
+
+    if (!slangDriver->GenerateSpirv(program, spirvOUT, &_errors)) {
+        if (_errors.empty()) {
+            _errors = "Failed to generate spirv for " +
+                _descriptor.slangModule;
+        }
+        return false;
+    }
+
+    shaderCache->StoreSpirv(cacheKey, *spirvOUT);
+    return true;
 }
 
 BgiVulkanShaderFunction::~BgiVulkanShaderFunction()
@@ -144,7 +271,19 @@ BgiVulkanShaderFunction::GetRawResource() const
 BgiVulkanDescriptorSetInfoVector const&
 BgiVulkanShaderFunction::GetDescriptorSetInfo() const
 {
-    return _descriptorSetInfo;
+    return _reflection.descriptorSetInfo;
+}
+
+VkPushConstantRangeVector const&
+BgiVulkanShaderFunction::GetPushConstantRanges() const
+{
+    return _reflection.pushConstantRanges;
+}
+
+const uint32_t*
+BgiVulkanShaderFunction::GetLocalSize() const
+{
+    return _reflection.localSize;
 }
 
 BgiVulkanDevice*
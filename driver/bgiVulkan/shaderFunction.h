@@ -56,6 +56,15 @@ public:
     BGIVULKAN_API
     BgiVulkanDescriptorSetInfoVector const& GetDescriptorSetInfo() const;
 
+    /// Returns the push constant ranges used by this module.
+    BGIVULKAN_API
+    VkPushConstantRangeVector const& GetPushConstantRanges() const;
+
+    /// Returns the local work group size (x, y, z) of a compute module.
+    /// All zero for other stages.
+    BGIVULKAN_API
+    const uint32_t* GetLocalSize() const;
+
     /// Returns the device used to create this object.
     BGIVULKAN_API
     BgiVulkanDevice* GetDevice() const;
@@ -79,11 +88,23 @@ private:
     BgiVulkanShaderFunction& operator=(const BgiVulkanShaderFunction&) = delete;
     BgiVulkanShaderFunction(const BgiVulkanShaderFunction&) = delete;
 
+    // Generates glsl for the descriptor and compiles it to spirv.
+    bool _CompileGLSL(
+        Bgi const* bgi,
+        BgiShaderFunctionDesc const& desc,
+        std::vector<unsigned int>* spirvOUT,
+        uint64_t* cacheKeyOUT);
+
+    // Compiles the slang entry point named in the descriptor to spirv.
+    bool _CompileSlang(
+        std::vector<unsigned int>* spirvOUT,
+        uint64_t* cacheKeyOUT);
+
     BgiVulkanDevice* _device;
     std::string _errors;
     size_t _spirvByteSize;
     VkShaderModule _vkShaderModule;
-    BgiVulkanDescriptorSetInfoVector _descriptorSetInfo;
+    BgiVulkanShaderReflection _reflection;
     uint64_t _inflightBits;
 };
 
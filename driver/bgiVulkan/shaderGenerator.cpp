@@ -1,7 +1,9 @@
+#include "common/utils/diagnostic.h"
 #include "common/utils/tokens.h"
 
 #include "driver/bgiVulkan/shaderGenerator.h"
 #include "driver/bgiVulkan/bgi.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
 #include "driver/bgiVulkan/conversions.h"
 
 #include <set>
@@ -43,6 +45,8 @@ BgiVulkanShaderGenerator::BgiVulkanShaderGenerator(
   : BgiShaderGenerator(descriptor)
   , _bgi(bgi)
   , _textureBindIndexStart(0)
+  , _hasBindlessResources(false)
+  , _hasDeviceAddressBuffers(false)
   , _inLocationIndex(0)
   , _outLocationIndex(0)
 {
@@ -182,6 +186,17 @@ BgiVulkanShaderGenerator::_WriteExtensions(std::ostream &ss)
     const bool builtinBarycentricsEnabled = _bgi->GetCapabilities()->
         IsSet(BgiDeviceCapabilitiesBitsBuiltinBarycentrics);
 
+    if (_hasBindlessResources) {
+        ss << "#extension GL_EXT_nonuniform_qualifier : require\n";
+        ss << "#extension GL_EXT_samplerless_texture_functions : require\n";
+    }
+
+    if (_hasDeviceAddressBuffers) {
+        ss << "#extension GL_EXT_buffer_reference : require\n";
+        ss << "#extension GL_EXT_shader_explicit_arithmetic_types_int64 : "
+              "require\n";
+    }
+
     if (_GetShaderStage() & BgiShaderStageVertex) {
         if (glslVersion < 460 && shaderDrawParametersEnabled) {
             ss << "#extension GL_ARB_shader_draw_parameters : require\n";
@@ -249,6 +264,11 @@ BgiVulkanShaderGenerator::_WriteTextures(
     const BgiShaderFunctionTextureDescVector& textures)
 {
     for (const BgiShaderFunctionTextureDesc& desc : textures) {
+        if (desc.bindless) {
+            _WriteBindlessTexture(desc);
+            continue;
+        }
+
         BgiShaderSectionAttributeVector attrs = {
             BgiShaderSectionAttribute{
                 "binding",
@@ -269,10 +289,44 @@ BgiVulkanShaderGenerator::_WriteTextures(
             desc.textureType,
             desc.arraySize,
             desc.writable,
+            false,
             attrs);
     }
 }
 
+void
+BgiVulkanShaderGenerator::_WriteBindlessTexture(
+    const BgiShaderFunctionTextureDesc& desc)
+{
+    if (!_bgi->GetCapabilities()->
+            IsSet(BgiDeviceCapabilitiesBitsBindlessTextures)) {
+        UTILS_CODING_ERROR("Bindless texture %s requires a device with "
+            "descriptor indexing support", desc.nameInShader.c_str());
+    }
+
+    // The set and binding are fixed by the bindless heap, only the image
+    // format of storage images is needed.
+    BgiShaderSectionAttributeVector attrs;
+    if (desc.writable) {
+        attrs.push_back(BgiShaderSectionAttribute{
+            BgiVulkanConversions::GetImageLayoutFormatQualifier(desc.format),
+            ""});
+    }
+
+    CreateShaderSection<BgiVulkanTextureShaderSection>(
+        desc.nameInShader,
+        BgiVulkanBindlessHeap::SetIndex,
+        desc.dimensions,
+        desc.format,
+        desc.textureType,
+        0,
+        desc.writable,
+        true,
+        attrs);
+
+    _hasBindlessResources = true;
+}
+
 void
 BgiVulkanShaderGenerator::_WriteBuffers(
     const BgiShaderFunctionBufferDescVector &buffers)
@@ -291,7 +345,76 @@ BgiVulkanShaderGenerator::_WriteBuffers(
                 : std::string();
 
         const uint32_t bindIndex = bufferDescription.bindIndex;
+
+        if (bufferDescription.deviceAddress) {
+            if (!_bgi->GetCapabilities()->
+                    IsSet(BgiDeviceCapabilitiesBitsBufferDeviceAddress)) {
+                UTILS_CODING_ERROR("Buffer %s requires a device with buffer "
+                    "device address support",
+                    bufferDescription.nameInShader.c_str());
+            }
+
+            // Only 4 byte alignment is assumed, so the address may point
+            // anywhere into a buffer of merged data.
+            const BgiShaderSectionAttributeVector attrs = {
+                BgiShaderSectionAttribute{"buffer_reference", ""},
+                BgiShaderSectionAttribute{"std430", ""},
+                BgiShaderSectionAttribute{"buffer_reference_align", "4"}};
+
+            CreateShaderSection<BgiVulkanBufferShaderSection>(
+                bufferDescription.nameInShader,
+                bindIndex,
+                bufferDescription.type,
+                bufferDescription.binding,
+                arraySize,
+                bufferDescription.writable,
+                false,
+                true,
+                attrs);
+
+            // Buffer references do not occupy a binding of the resource set.
+            _hasDeviceAddressBuffers = true;
+            continue;
+        }
+
+        if (bufferDescription.bindless && isUniformBufferBinding) {
+            UTILS_CODING_ERROR("Bindless buffer %s must be a storage buffer, "
+                "binding it as a uniform buffer instead",
+                bufferDescription.nameInShader.c_str());
+        }
         
+        if (bufferDescription.bindless && !isUniformBufferBinding) {
+            if (!_bgi->GetCapabilities()->
+                    IsSet(BgiDeviceCapabilitiesBitsBindlessBuffers)) {
+                UTILS_CODING_ERROR("Bindless buffer %s requires a device with "
+                    "descriptor indexing support",
+                    bufferDescription.nameInShader.c_str());
+            }
+
+            const BgiShaderSectionAttributeVector attrs = {
+                BgiShaderSectionAttribute{"std430", ""},
+                BgiShaderSectionAttribute{"set",
+                    std::to_string(BgiVulkanBindlessHeap::SetIndex)},
+                BgiShaderSectionAttribute{"binding",
+                    std::to_string(
+                        BgiVulkanBindlessHeap::StorageBufferBinding)}};
+
+            CreateShaderSection<BgiVulkanBufferShaderSection>(
+                bufferDescription.nameInShader,
+                BgiVulkanBindlessHeap::StorageBufferBinding,
+                bufferDescription.type,
+                bufferDescription.binding,
+                arraySize,
+                bufferDescription.writable,
+                true,
+                false,
+                attrs);
+
+            // Heap buffers do not occupy a binding of the resource set.
+            _hasBindlessResources = true;
+            continue;
+        }
+
         if (isUniformBufferBinding) {
             const BgiShaderSectionAttributeVector attrs = {
                 BgiShaderSectionAttribute{"std140", ""},
@@ -305,6 +428,8 @@ BgiVulkanShaderGenerator::_WriteBuffers(
                 bufferDescription.binding,
                 arraySize,
                 false,
+                false,
+                false,
                 attrs);
         } else {
             const BgiShaderSectionAttributeVector attrs = {
@@ -319,6 +444,8 @@ BgiVulkanShaderGenerator::_WriteBuffers(
                 bufferDescription.binding,
                 arraySize,
                 bufferDescription.writable,
+                false,
+                false,
                 attrs);
         }
 				
@@ -56,6 +56,8 @@ private:
         const BgiShaderFunctionParamDescVector &parameters);
 
     void _WriteTextures(const BgiShaderFunctionTextureDescVector& textures);
+
+    void _WriteBindlessTexture(const BgiShaderFunctionTextureDesc& desc);
 	
     void _WriteBuffers(const BgiShaderFunctionBufferDescVector &buffers);
 
@@ -70,6 +72,8 @@ private:
     BgiVulkanShaderSectionUniquePtrVector _shaderSections;
     Bgi const *_bgi;
     uint32_t _textureBindIndexStart;
+    bool _hasBindlessResources;
+    bool _hasDeviceAddressBuffers;
     uint32_t _inLocationIndex;
     uint32_t _outLocationIndex;
     std::vector<std::string> _shaderLayoutAttributes;
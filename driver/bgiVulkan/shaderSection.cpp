@@ -1,6 +1,9 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/shaderSection.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
+
+#include <sstream>
 
 GUNGNIR_NAMESPACE_OPEN_SCOPE
 
@@ -213,6 +216,7 @@ BgiVulkanTextureShaderSection::BgiVulkanTextureShaderSection(
     const BgiShaderTextureType textureType,
     const uint32_t arraySize,
     const bool writable,
+    const bool bindless,
     const BgiShaderSectionAttributeVector &attributes,
     const std::string &defaultValue)
   : BgiVulkanShaderSection( identifier,
@@ -227,6 +231,7 @@ BgiVulkanTextureShaderSection::BgiVulkanTextureShaderSection(
   , _textureType(textureType)
   , _arraySize(arraySize)
   , _writable(writable)
+  , _bindless(bindless)
 {
 }
 
@@ -289,13 +294,66 @@ BgiVulkanTextureShaderSection::WriteType(std::ostream &ss) const
 bool
 BgiVulkanTextureShaderSection::VisitGlobalMemberDeclarations(std::ostream &ss)
 {
-    WriteDeclaration(ss);
+    if (_bindless) {
+        _WriteBindlessDeclarations(ss);
+    } else {
+        WriteDeclaration(ss);
+    }
     return true;
 }
 
+void
+BgiVulkanTextureShaderSection::_WriteBindlessDeclarations(
+    std::ostream &ss) const
+{
+    const std::string arraySuffix =
+        (_textureType == BgiShaderTextureTypeArrayTexture) ? "Array" : "";
+
+    if (_writable) {
+        // e.g. layout(set = 1, binding = 2, rgba8) uniform image2D
+        //          bgiHeapImg_texName[];
+        ss << "layout(set = " << BgiVulkanBindlessHeap::SetIndex
+           << ", binding = " << BgiVulkanBindlessHeap::StorageImageBinding;
+        for (const BgiShaderSectionAttribute &a : GetAttributes()) {
+            ss << ", " << a.identifier;
+            if (!a.index.empty()) {
+                ss << " = " << a.index;
+            }
+        }
+        ss << ") uniform image" << _dimensions << "D" << arraySuffix
+           << " bgiHeapImg_";
+        WriteIdentifier(ss);
+        ss << "[];\n";
+        return;
+    }
+
+    // Separate images and samplers so that any registered texture can be
+    // combined with any registered sampler.
+    ss << "layout(set = " << BgiVulkanBindlessHeap::SetIndex
+       << ", binding = " << BgiVulkanBindlessHeap::SampledImageBinding
+       << ") uniform " << _GetTextureTypePrefix(_format) << "texture"
+       << _dimensions << "D" << arraySuffix << " bgiHeapTex_";
+    WriteIdentifier(ss);
+    ss << "[];\n";
+
+    ss << "layout(set = " << BgiVulkanBindlessHeap::SetIndex
+       << ", binding = " << BgiVulkanBindlessHeap::SamplerBinding
+       << ") uniform "
+       << ((_textureType == BgiShaderTextureTypeShadowTexture) ?
+           "samplerShadow" : "sampler")
+       << " bgiHeapSmp_";
+    WriteIdentifier(ss);
+    ss << "[];\n";
+}
+
 bool
 BgiVulkanTextureShaderSection::VisitGlobalFunctionDefinitions(std::ostream &ss)
 {
+    if (_bindless) {
+        _WriteBindlessFunctionDefinitions(ss);
+        return true;
+    }
+
     // Used to unify texture sampling and writing across platforms that depend 
     // on samplers and don't store textures in global space.
     const uint32_t sizeDim = 
@@ -411,6 +469,107 @@ BgiVulkanTextureShaderSection::VisitGlobalFunctionDefinitions(std::ostream &ss)
     return true;
 }
 
+void
+BgiVulkanTextureShaderSection::_WriteBindlessFunctionDefinitions(
+    std::ostream &ss) const
+{
+    // Same signatures as the bound accessors, with the heap indices of the
+    // texture (and sampler) as leading arguments. The indices may diverge
+    // within a draw, so every heap access is qualified with nonuniformEXT.
+    const uint32_t sizeDim = 
+        (_textureType == BgiShaderTextureTypeArrayTexture) ? 
+        (_dimensions + 1) : _dimensions;
+    const uint32_t coordDim = 
+        (_textureType == BgiShaderTextureTypeShadowTexture ||
+         _textureType == BgiShaderTextureTypeArrayTexture) ? 
+        (_dimensions + 1) : _dimensions;
+
+    const std::string sizeType = sizeDim == 1 ? 
+        "int" :
+        "ivec" + std::to_string(sizeDim);
+    const std::string intCoordType = coordDim == 1 ? 
+        "int" :
+        "ivec" + std::to_string(coordDim);
+    const std::string floatCoordType = coordDim == 1 ? 
+        "float" :
+        "vec" + std::to_string(coordDim);
+
+    std::ostringstream identifier;
+    WriteIdentifier(identifier);
+
+    if (_writable) {
+        const std::string image = "bgiHeapImg_" + identifier.str() +
+            "[nonuniformEXT(texIndex)]";
+
+        // BgiSet_texName(texIndex, uv, data)
+        ss << "void BgiSet_";
+        WriteIdentifier(ss);
+        ss << "(uint texIndex, " << intCoordType << " uv, vec4 data) {\n";
+        ss << "    imageStore(" << image << ", uv, data);\n";
+        ss << "}\n";
+
+        // BgiGetSize_texName(texIndex)
+        ss << sizeType << " BgiGetSize_";
+        WriteIdentifier(ss);
+        ss << "(uint texIndex) {\n";
+        ss << "    return imageSize(" << image << ");\n";
+        ss << "}\n";
+        return;
+    }
+
+    const std::string texture = "bgiHeapTex_" + identifier.str() +
+        "[nonuniformEXT(texIndex)]";
+
+    // BgiGetSampler_texName(texIndex, smpIndex)
+    ss << "#define BgiGetSampler_";
+    WriteIdentifier(ss);
+    ss << "(texIndex, smpIndex) ";
+    _WriteSamplerType(ss);
+    ss << "(bgiHeapTex_";
+    WriteIdentifier(ss);
+    ss << "[nonuniformEXT(texIndex)], bgiHeapSmp_";
+    WriteIdentifier(ss);
+    ss << "[nonuniformEXT(smpIndex)])\n";
+
+    // BgiGet_texName(texIndex, smpIndex, uv)
+    _WriteSampledDataType(ss);
+    ss << " BgiGet_";
+    WriteIdentifier(ss);
+    ss << "(uint texIndex, uint smpIndex, " << floatCoordType << " uv) {\n";
+    ss << "    return texture(BgiGetSampler_";
+    WriteIdentifier(ss);
+    ss << "(texIndex, smpIndex), uv);\n";
+    ss << "}\n";
+
+    // BgiGetSize_texName(texIndex), samplerless
+    ss << sizeType << " BgiGetSize_";
+    WriteIdentifier(ss);
+    ss << "(uint texIndex) {\n";
+    ss << "    return textureSize(" << texture << ", 0);\n";
+    ss << "}\n";
+
+    // BgiTextureLod_texName(texIndex, smpIndex, coord, lod)
+    _WriteSampledDataType(ss);
+    ss << " BgiTextureLod_";
+    WriteIdentifier(ss);
+    ss << "(uint texIndex, uint smpIndex, " << floatCoordType
+       << " coord, float lod) {\n";
+    ss << "    return textureLod(BgiGetSampler_";
+    WriteIdentifier(ss);
+    ss << "(texIndex, smpIndex), coord, lod);\n";
+    ss << "}\n";
+
+    // BgiTexelFetch_texName(texIndex, coord), samplerless
+    if (_textureType != BgiShaderTextureTypeShadowTexture) {
+        _WriteSampledDataType(ss);
+        ss << " BgiTexelFetch_";
+        WriteIdentifier(ss);
+        ss << "(uint texIndex, " << intCoordType << " coord) {\n";
+        ss << "    return texelFetch(" << texture << ", coord, 0);\n";
+        ss << "}\n";
+    }
+}
+
 BgiVulkanBufferShaderSection::BgiVulkanBufferShaderSection(
     const std::string &identifier,
     const uint32_t layoutIndex,
@@ -418,6 +577,8 @@ BgiVulkanBufferShaderSection::BgiVulkanBufferShaderSection(
     const BgiBindingType binding,
     const std::string arraySize,
     const bool writable,
+    const bool bindless,
+    const bool deviceAddress,
     const BgiShaderSectionAttributeVector &attributes)
   : BgiVulkanShaderSection( identifier,
                             attributes,
@@ -427,6 +588,8 @@ BgiVulkanBufferShaderSection::BgiVulkanBufferShaderSection(
   , _binding(binding)
   , _arraySize(arraySize)
   , _writable(writable)
+  , _bindless(bindless)
+  , _deviceAddress(deviceAddress)
 {
 }
 
@@ -461,6 +624,25 @@ BgiVulkanBufferShaderSection::VisitGlobalMemberDeclarations(std::ostream &ss)
         ss << ") ";
     }
 
+    // Device address buffers only declare the buffer reference type.
+    if (_deviceAddress) {
+        if (!_writable) {
+            ss << "readonly ";
+        }
+        ss << "buffer bgiBufRef_";
+        WriteIdentifier(ss);
+        ss << " { ";
+        WriteType(ss);
+        ss << " ";
+        WriteIdentifier(ss);
+        if (_binding == BgiBindingTypeValue) {
+            ss << "; };\n";
+        } else {
+            ss << "[]; };\n";
+        }
+        return true;
+    }
+
     // If it has a storage qualifier, declare it
     if (_binding == BgiBindingTypeUniformValue ||
         _binding == BgiBindingTypeUniformArray) {
@@ -479,11 +661,54 @@ BgiVulkanBufferShaderSection::VisitGlobalMemberDeclarations(std::ostream &ss)
 
     if (_binding == BgiBindingTypeValue ||
         _binding == BgiBindingTypeUniformValue) {
-        ss << "; };\n";
+        ss << "; }";
+    } else if (_bindless) {
+        ss << "[]; }";
     } else {
-        ss << "[" << _arraySize << "]; };\n";
+        ss << "[" << _arraySize << "]; }";
+    }
+
+    // Bindless buffers are a runtime array of blocks, one per heap entry.
+    if (_bindless) {
+        ss << " bgiHeapBuf_";
+        WriteIdentifier(ss);
+        ss << "[]";
+    }
+    ss << ";\n";
+
+    return true;
+}
+
+bool
+BgiVulkanBufferShaderSection::VisitGlobalFunctionDefinitions(std::ostream &ss)
+{
+    if (_deviceAddress) {
+        // BgiGetDeviceAddress_bufName(address) evaluates to the member of
+        // the buffer at 'address', a uint64_t from GetDeviceAddress.
+        ss << "#define BgiGetDeviceAddress_";
+        WriteIdentifier(ss);
+        ss << "(address) bgiBufRef_";
+        WriteIdentifier(ss);
+        ss << "(address).";
+        WriteIdentifier(ss);
+        ss << "\n";
+        return true;
     }
 
+    if (!_bindless) {
+        return false;
+    }
+
+    // BgiGetBindless_bufName(index) evaluates to the buffer's member, so it
+    // can be indexed or written to like a bound buffer.
+    ss << "#define BgiGetBindless_";
+    WriteIdentifier(ss);
+    ss << "(index) bgiHeapBuf_";
+    WriteIdentifier(ss);
+    ss << "[nonuniformEXT(index)].";
+    WriteIdentifier(ss);
+    ss << "\n";
+
     return true;
 }
 
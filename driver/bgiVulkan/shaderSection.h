@@ -157,6 +157,8 @@ private:
 /// \class HgiVulkanMemberShaderSection
 ///
 /// Declares OpenGL textures, and their cross language function
+/// Bindless textures are declared as runtime arrays aliasing the bindings
+/// of BgiVulkanBindlessHeap and their functions take heap indices.
 ///
 class BgiVulkanTextureShaderSection final: public BgiVulkanShaderSection
 {
@@ -170,6 +172,7 @@ public:
         const BgiShaderTextureType textureType,
         const uint32_t arraySize,
         const bool writable,
+        const bool bindless,
         const BgiShaderSectionAttributeVector &attributes,
         const std::string &defaultValue = std::string());
 
@@ -192,18 +195,25 @@ private:
 
     void _WriteSamplerType(std::ostream &ss) const;
     void _WriteSampledDataType(std::ostream &ss) const;
+    void _WriteBindlessDeclarations(std::ostream &ss) const;
+    void _WriteBindlessFunctionDefinitions(std::ostream &ss) const;
 
     const uint32_t _dimensions;
     const BgiFormat _format;
     const BgiShaderTextureType _textureType;
     const uint32_t _arraySize;
     const bool _writable;
+    const bool _bindless;
     static const std::string _storageQualifier;
 };
 
 /// \class HgiVulkanBufferShaderSection
 ///
 /// Declares Vulkan buffers, and their cross language function
+/// Bindless storage buffers are declared as a runtime array of blocks
+/// aliasing the storage buffer binding of BgiVulkanBindlessHeap.
+/// Device address buffers are declared as a buffer reference type that
+/// shaders construct from the GPU address of the buffer.
 ///
 class BgiVulkanBufferShaderSection final: public BgiVulkanShaderSection
 {
@@ -216,6 +226,8 @@ public:
         const BgiBindingType binding,
         const std::string arraySize,
         const bool writable,
+        const bool bindless,
+        const bool deviceAddress,
         const BgiShaderSectionAttributeVector &attributes);
 
     BGIVULKAN_API
@@ -226,6 +238,8 @@ public:
 
     BGIVULKAN_API
     bool VisitGlobalMemberDeclarations(std::ostream &ss) override;
+    BGIVULKAN_API
+    bool VisitGlobalFunctionDefinitions(std::ostream &ss) override;
 
 private:
     BgiVulkanBufferShaderSection() = delete;
@@ -237,6 +251,8 @@ private:
     const BgiBindingType _binding;
     const std::string _arraySize;
     const bool _writable;
+    const bool _bindless;
+    const bool _deviceAddress;
 };
 
 /// \class HgiVulkanKeywordShaderSection
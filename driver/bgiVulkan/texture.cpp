@@ -1,6 +1,7 @@
 #include "common/utils/diagnostic.h"
 
 #include "driver/bgiVulkan/texture.h"
+#include "driver/bgiVulkan/bindlessHeap.h"
 #include "driver/bgiVulkan/buffer.h"
 #include "driver/bgiVulkan/capabilities.h"
 #include "driver/bgiVulkan/commandBuffer.h"
@@ -9,6 +10,7 @@
 #include "driver/bgiVulkan/device.h"
 #include "driver/bgiVulkan/diagnostic.h"
 #include "driver/bgiVulkan/garbageCollector.h"
+#include "driver/bgiVulkan/memoryTracker.h"
 #include "driver/bgiVulkan/bgi.h"
 
 #include <algorithm>
@@ -42,6 +44,8 @@ BgiVulkanTexture::BgiVulkanTexture(
     , _inflightBits(0)
     , _stagingBuffer(nullptr)
     , _cpuStagingAddress(nullptr)
+    , _bindlessIndex(BgiBindlessIndexInvalid)
+    , _memoryByteSize(0)
 {
     Vector3i const& dimensions = desc.dimensions;
     bool const isDepthBuffer = desc.usage & BgiTextureUsageBitsDepthTarget;
@@ -121,6 +125,10 @@ BgiVulkanTexture::BgiVulkanTexture(
 
     UTILS_VERIFY(_vkImage, "Failed to create image");
 
+    BgiVulkanMemoryTracker* tracker = device->GetMemoryTracker();
+    _memoryByteSize = tracker->GetAllocationByteSize(_vmaImageAllocation);
+    tracker->AddResource(BgiMemoryResourceKindTexture, _memoryByteSize);
+
     // Debug label
     if (!_descriptor.debugName.empty()) {
         std::string debugLabel = "Image " + _descriptor.debugName;
@@ -184,6 +192,8 @@ BgiVulkanTexture::BgiVulkanTexture(
             debugLabel.c_str());
     }
 
+    _RegisterBindless();
+
     //
     // Upload data
     //
@@ -250,6 +260,8 @@ BgiVulkanTexture::BgiVulkanTexture(
     , _inflightBits(0)
     , _stagingBuffer(nullptr)
     , _cpuStagingAddress(nullptr)
+    , _bindlessIndex(BgiBindlessIndexInvalid)
+    , _memoryByteSize(0)
 {
     // Update the texture descriptor to reflect the view desc
     _descriptor.debugName = desc.debugName;
@@ -305,10 +317,16 @@ BgiVulkanTexture::BgiVulkanTexture(
             VK_OBJECT_TYPE_IMAGE_VIEW,
             debugLabel.c_str());
     }
+
+    _RegisterBindless();
 }
 
 BgiVulkanTexture::~BgiVulkanTexture()
 {
+    if (_bindlessIndex != BgiBindlessIndexInvalid) {
+        _device->GetBindlessHeap()->UnregisterTexture(_bindlessIndex);
+    }
+
     if (_cpuStagingAddress && _stagingBuffer) {
         vmaUnmapMemory(
             _device->GetVulkanMemoryAllocator(),
@@ -329,6 +347,8 @@ BgiVulkanTexture::~BgiVulkanTexture()
     // This texture may be a 'TextureView' into another Texture's image.
     // In that case we do not own the image.
     if (!_isTextureView && _vkImage) {
+        _device->GetMemoryTracker()->RemoveResource(
+            BgiMemoryResourceKindTexture, _memoryByteSize);
         vmaDestroyImage(
             _device->GetVulkanMemoryAllocator(),
             _vkImage,
@@ -348,6 +368,12 @@ BgiVulkanTexture::GetRawResource() const
     return (uint64_t) _vkImage;
 }
 
+uint32_t
+BgiVulkanTexture::GetBindlessIndex() const
+{
+    return _bindlessIndex;
+}
+
 void*
 BgiVulkanTexture::GetCPUStagingAddress()
 {
@@ -579,6 +605,25 @@ BgiVulkanTexture::GetDefaultAccessFlags(BgiTextureUsage usage)
     return VK_ACCESS_SHADER_READ_BIT;
 }
 
+void
+BgiVulkanTexture::_RegisterBindless()
+{
+    BgiVulkanBindlessHeap* heap = _device->GetBindlessHeap();
+    if (!heap || !_vkImageView) {
+        return;
+    }
+
+    BgiTextureUsage const usage = _descriptor.usage;
+    bool const sampled = usage & BgiTextureUsageBitsShaderRead;
+    bool const storage = usage & BgiTextureUsageBitsShaderWrite;
+    if (!sampled && !storage) {
+        return;
+    }
+
+    _bindlessIndex = heap->RegisterTexture(
+        _vkImageView, GetDefaultImageLayout(usage), sampled, storage);
+}
+
 }
 
 GUNGNIR_NAMESPACE_CLOSE_SCOPE
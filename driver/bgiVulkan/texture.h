@@ -36,6 +36,9 @@ public:
     BGIVULKAN_API
     uint64_t GetRawResource() const override;
 
+    BGIVULKAN_API
+    uint32_t GetBindlessIndex() const override;
+
     /// Creates (on first use) and returns the CPU staging buffer that can be
     /// used to upload new texture data to the image.
     /// After memcpy-ing new data into the returned address the client
@@ -128,6 +131,9 @@ private:
     BgiVulkanTexture & operator=(const BgiVulkanTexture&) = delete;
     BgiVulkanTexture(const BgiVulkanTexture&) = delete;
 
+    // Registers the image view with the device's bindless heap, if any.
+    void _RegisterBindless();
+
     bool _isTextureView;
     VkImage _vkImage;
     VkImageView _vkImageView;
@@ -137,6 +143,8 @@ private:
     uint64_t _inflightBits;
     BgiVulkanBuffer* _stagingBuffer;
     void* _cpuStagingAddress;
+    uint32_t _bindlessIndex;
+    uint64_t _memoryByteSize;
 };
 
 }
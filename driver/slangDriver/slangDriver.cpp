@@ -0,0 +1,177 @@
+#include "common/utils/diagnostic.h"
+
+#include "driver/slangDriver/slangDriver.h"
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+static void
+_AppendDiagnostics(slang::IBlob* diagnostics, std::string* errors)
+{
+    if (diagnostics && errors) {
+        errors->append(
+            static_cast<const char*>(diagnostics->getBufferPointer()),
+            diagnostics->getBufferSize());
+    }
+}
+
+SlangDriver::SlangDriver(std::vector<std::string> const& searchPaths)
+{
+    if (SLANG_FAILED(slang::createGlobalSession(
+            _globalSession.writeRef()))) {
+        UTILS_CODING_ERROR("Unable to create slang global session\n");
+        return;
+    }
+
+    slang::TargetDesc targetDesc;
+    targetDesc.format = SLANG_SPIRV;
+    targetDesc.profile = _globalSession->findProfile("glsl_450");
+
+    std::vector<const char*> paths;
+    for (std::string const& path : searchPaths) {
+        paths.push_back(path.c_str());
+    }
+
+    slang::SessionDesc sessionDesc;
+    sessionDesc.targets = &targetDesc;
+    sessionDesc.targetCount = 1;
+    sessionDesc.searchPaths = paths.data();
+    sessionDesc.searchPathCount = (SlangInt) paths.size();
+    // Match the column major matrices of the glsl the Bgi shader generator
+    // emits so constant data can be shared between both front ends.
+    sessionDesc.defaultMatrixLayoutMode = SLANG_MATRIX_LAYOUT_COLUMN_MAJOR;
+
+    if (SLANG_FAILED(_globalSession->createSession(
+            sessionDesc, _session.writeRef()))) {
+        UTILS_CODING_ERROR("Unable to create slang session\n");
+        _session.setNull();
+    }
+}
+
+SlangDriver::~SlangDriver()
+{
+    // Modules are owned by the session.
+    _modules.clear();
+    _session.setNull();
+    _globalSession.setNull();
+}
+
+bool
+SlangDriver::IsValid() const
+{
+    return _session.get() != nullptr;
+}
+
+bool
+SlangDriver::Link(
+    const char* moduleName,
+    const char* entryPointName,
+    SlangDriverProgram* programOUT,
+    std::string* errors)
+{
+    if (!programOUT || !_session) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    slang::IModule* module = _LoadModule(moduleName, errors);
+    if (!module) {
+        return false;
+    }
+
+    Slang::ComPtr<slang::IEntryPoint> entryPoint;
+    if (SLANG_FAILED(module->findEntryPointByName(
+            entryPointName, entryPoint.writeRef()))) {
+        if (errors) {
+            errors->append("Unable to find slang entry point ");
+            errors->append(entryPointName);
+        }
+        return false;
+    }
+
+    // The module's imports are pulled in by link().
+    slang::IComponentType* components[] = { module, entryPoint.get() };
+    Slang::ComPtr<slang::IComponentType> composite;
+    Slang::ComPtr<slang::IBlob> diagnostics;
+    if (SLANG_FAILED(_session->createCompositeComponentType(
+            components, 2, composite.writeRef(), diagnostics.writeRef()))) {
+        _AppendDiagnostics(diagnostics, errors);
+        return false;
+    }
+
+    Slang::ComPtr<slang::IComponentType> linked;
+    if (SLANG_FAILED(composite->link(
+            linked.writeRef(), diagnostics.writeRef()))) {
+        _AppendDiagnostics(diagnostics, errors);
+        return false;
+    }
+
+    Slang::ComPtr<slang::IBlob> hash;
+    linked->getEntryPointHash(0, 0, hash.writeRef());
+
+    // Slang's hash does not cover the compiler itself, so mix in the build
+    // tag to avoid reusing code generated by a different slang version.
+    programOUT->program = linked;
+    programOUT->hash = _globalSession->getBuildTagString();
+    if (hash) {
+        programOUT->hash.append(
+            static_cast<const char*>(hash->getBufferPointer()),
+            hash->getBufferSize());
+    }
+
+    return true;
+}
+
+bool
+SlangDriver::GenerateSpirv(
+    SlangDriverProgram const& program,
+    std::vector<unsigned int>* spirvOUT,
+    std::string* errors)
+{
+    if (!spirvOUT || !program.program) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Slang::ComPtr<slang::IBlob> code;
+    Slang::ComPtr<slang::IBlob> diagnostics;
+    if (SLANG_FAILED(program.program->getEntryPointCode(
+            0, 0, code.writeRef(), diagnostics.writeRef())) || !code) {
+        _AppendDiagnostics(diagnostics, errors);
+        return false;
+    }
+
+    const unsigned int* words =
+        static_cast<const unsigned int*>(code->getBufferPointer());
+    spirvOUT->assign(
+        words, words + code->getBufferSize() / sizeof(unsigned int));
+
+    return true;
+}
+
+slang::IModule*
+SlangDriver::_LoadModule(const char* moduleName, std::string* errors)
+{
+    auto it = _modules.find(moduleName);
+    if (it != _modules.end()) {
+        return it->second;
+    }
+
+    Slang::ComPtr<slang::IBlob> diagnostics;
+    slang::IModule* module =
+        _session->loadModule(moduleName, diagnostics.writeRef());
+    if (!module) {
+        _AppendDiagnostics(diagnostics, errors);
+        return nullptr;
+    }
+
+    _modules[moduleName] = module;
+    return module;
+}
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
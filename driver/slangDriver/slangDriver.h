@@ -0,0 +1,99 @@
+#pragma once
+
+#include "common/base.h"
+
+#include "driver/bgiBase/api.h"
+#include "driver/bgiBase/enums.h"
+
+#include "slang/slang.h"
+#include "slang/slang-com-ptr.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+GUNGNIR_NAMESPACE_OPEN_SCOPE
+
+namespace driver {
+
+/// \struct SlangDriverProgram
+///
+/// A Slang entry point linked against its module and everything the module
+/// imports, ready for code generation.
+///
+/// <ul>
+/// <li>program:
+///   The linked slang component type.</li>
+/// <li>hash:
+///   Slang's hash of the entry point, its dependencies and the target
+///   settings, prefixed by the slang build tag. Suitable as a key for caching
+///   the generated code.</li>
+/// </ul>
+///
+struct SlangDriverProgram
+{
+    Slang::ComPtr<slang::IComponentType> program;
+    std::string hash;
+};
+
+/// \class SlangDriver
+///
+/// Compiles Slang modules to spirv.
+///
+/// All modules are loaded into one long-lived slang session. A module that is
+/// imported by many entry points (e.g. a lighting or brdf library) is parsed
+/// and checked once, and then linked into each entry point that needs it.
+/// Modules are found via the search paths provided at construction.
+///
+/// Thread safety: Slang sessions are not thread safe, all calls are
+/// serialized internally.
+///
+class SlangDriver final
+{
+public:
+    BGI_API
+    SlangDriver(std::vector<std::string> const& searchPaths);
+
+    BGI_API
+    ~SlangDriver();
+
+    /// Returns true if the slang session could be created.
+    BGI_API
+    bool IsValid() const;
+
+    /// Loads the module (if not loaded already) and links the entry point
+    /// 'entryPointName' against it and its imports.
+    /// Returns false and fills in errors if the module or entry point could
+    /// not be found or linking failed.
+    BGI_API
+    bool Link(
+        const char* moduleName,
+        const char* entryPointName,
+        SlangDriverProgram* programOUT,
+        std::string* errors = nullptr);
+
+    /// Generates spirv for a linked program.
+    BGI_API
+    bool GenerateSpirv(
+        SlangDriverProgram const& program,
+        std::vector<unsigned int>* spirvOUT,
+        std::string* errors = nullptr);
+
+private:
+    SlangDriver() = delete;
+    SlangDriver & operator=(const SlangDriver&) = delete;
+    SlangDriver(const SlangDriver&) = delete;
+
+    // Returns the loaded module or loads it.
+    slang::IModule* _LoadModule(const char* moduleName, std::string* errors);
+
+    std::mutex _mutex;
+    Slang::ComPtr<slang::IGlobalSession> _globalSession;
+    Slang::ComPtr<slang::ISession> _session;
+    std::unordered_map<std::string, slang::IModule*> _modules;
+};
+
+}
+
+GUNGNIR_NAMESPACE_CLOSE_SCOPE
@@ -2,8 +2,10 @@ target("driver")
     set_kind("shared")
     add_headerfiles("./**/*.h")
     add_files("./**/*.cpp")
-    add_packages("eigen", "vulkan-hpp", "vulkan-memory-allocator-hpp", "spirv-reflect", "fmt")
+    add_packages("eigen", "vulkan-hpp", "vulkan-memory-allocator-hpp", "spirv-reflect", "shaderc", "fmt")
     add_deps("common")
     add_linkdirs(os.getenv("VK_SDK_PATH").."/Lib/")
     add_links("vulkan-1")
+    add_linkdirs("$(projectdir)/third-party/slang/bin/windows-x64/release/")
+    add_links("slang")
     add_defines("GUNGNIR_STATIC", "GUNGNIR_DLL")
\ No newline at end of file
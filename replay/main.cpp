@@ -0,0 +1,134 @@
+#include "common/base.h"
+
+#include "common/arch/defines.h"
+#include "common/utils/trace.h"
+
+#include "driver/bgiBase/commandStream.h"
+#include "driver/bgiVulkan/bgi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Replays a command stream saved by BgiCommandStream::Save with a resource
+// manifest. The resources are recreated from the manifest, then the stream
+// is replayed and the CPU time of translating and submitting it reported.
+// Like the benchmark, runs are only comparable on the same device, so use a
+// software implementation like lavapipe for regression tracking:
+//
+//   VK_DRIVER_FILES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json \
+//       xmake run replay capture.bgcs --repeat 100
+//
+// Options:
+//   --repeat <n>     Number of replays, one per frame (1).
+//   --trace <path>   Also write a Chrome trace of the run.
+//
+// Exits with 1 if the stream could not be loaded or replayed.
+
+using namespace gungnir;
+
+static void
+_PrintUsage()
+{
+    std::cerr << "usage: replay <stream> [--repeat <n>] [--trace <path>]\n";
+}
+
+int
+main(int argc, char** argv)
+{
+    std::string streamPath;
+    std::string tracePath;
+    int repeat = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        bool const hasValue = i + 1 < argc;
+        if (arg == "--repeat" && hasValue) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (streamPath.empty() && arg.rfind("--", 0) != 0) {
+            streamPath = arg;
+        } else {
+            _PrintUsage();
+            return 1;
+        }
+    }
+
+    if (streamPath.empty()) {
+        _PrintUsage();
+        return 1;
+    }
+
+    driver::BgiCommandStream stream;
+    if (!stream.Load(streamPath)) {
+        std::cerr << "Failed to load " << streamPath << "\n";
+        return 1;
+    }
+    if (!stream.HasManifest()) {
+        std::cerr << streamPath << " was saved without its resources.\n";
+        return 1;
+    }
+
+    // Replays render offscreen only, so they run without a display.
+    if (!std::getenv("GUNGNIR_VULKAN_HEADLESS")) {
+#if defined(ARCH_OS_WINDOWS)
+        _putenv_s("GUNGNIR_VULKAN_HEADLESS", "1");
+#else
+        setenv("GUNGNIR_VULKAN_HEADLESS", "1", 0);
+#endif
+    }
+
+    if (!tracePath.empty()) {
+        utils::Trace::SetEnabled(true);
+    }
+
+    bool ok = true;
+    {
+        driver::BgiVulkan bgi;
+
+        driver::BgiCommandStreamResources resources;
+        if (!stream.CreateResources(&bgi, &resources)) {
+            std::cerr << "Failed to create the resources of "
+                      << streamPath << "\n";
+            return 1;
+        }
+
+        double totalMs = 0.0;
+        double minMs = 0.0;
+        for (int i = 0; i < repeat && ok; i++) {
+            bgi.StartFrame();
+            auto const begin = std::chrono::steady_clock::now();
+            ok = stream.Replay(&bgi, resources);
+            auto const end = std::chrono::steady_clock::now();
+            bgi.EndFrame();
+
+            double const ms =
+                std::chrono::duration<double, std::milli>(end - begin)
+                    .count();
+            totalMs += ms;
+            minMs = i == 0 ? ms : std::min(minMs, ms);
+        }
+
+        if (ok) {
+            std::cout << "Replayed " << stream.GetCmdsCount()
+                      << " cmds " << repeat << " time(s): "
+                      << totalMs / repeat << " ms average, "
+                      << minMs << " ms min\n";
+        } else {
+            std::cerr << "Malformed command stream " << streamPath << "\n";
+        }
+
+        bgi.StartFrame();
+        driver::BgiCommandStream::DestroyResources(&bgi, &resources);
+        bgi.EndFrame();
+    }
+
+    if (!tracePath.empty() && !utils::Trace::WriteChromeTrace(tracePath)) {
+        std::cerr << "Failed to write " << tracePath << "\n";
+    }
+
+    return ok ? 0 : 1;
+}
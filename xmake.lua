@@ -5,7 +5,7 @@ set_arch("x64")
 add_rules("mode.debug", "mode.release")
 set_languages("c++20")
 
-add_requires("vulkan-hpp", "vulkan-memory-allocator-hpp", "assimp", "eigen", "robin-map", "spirv-reflect", "boost", "glfw", "fmt", "zlib")
+add_requires("vulkan-hpp", "vulkan-memory-allocator-hpp", "assimp", "eigen", "robin-map", "spirv-reflect", "shaderc", "boost", "glfw", "fmt", "zlib")
 add_includedirs("$(projectdir)", "$(projectdir)/third-party")
 add_linkdirs("$(projectdir)/third-party")
 
@@ -13,3 +13,5 @@ includes("platform/xmake.lua")
 includes("engine/xmake.lua")
 includes("driver/xmake.lua")
 includes("common/xmake.lua")
+includes("benchmark/xmake.lua")
+includes("replay/xmake.lua")